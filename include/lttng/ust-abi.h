@@ -69,6 +69,8 @@ enum lttng_ust_output {
 enum lttng_ust_chan_type {
 	LTTNG_UST_CHAN_PER_CPU = 0,
 	LTTNG_UST_CHAN_METADATA = 1,
+	/* Event notifier notifications, single stream. */
+	LTTNG_UST_CHAN_NOTIFICATION = 2,
 };
 
 struct lttng_ust_tracer_version {
@@ -154,17 +156,163 @@ struct lttng_ust_event {
 	} u;
 } LTTNG_PACKED;
 
-#define LTTNG_UST_EVENT_NOTIFIER_PADDING	32
+enum lttng_ust_event_notifier_action {
+	/* Send a notification to the sessiond. */
+	LTTNG_UST_EVENT_NOTIFIER_ACTION_NOTIFY = 0,
+	/*
+	 * Update the map counter attached to the event notifier with
+	 * LTTNG_UST_COUNTER. Each capture but the value capture indexes
+	 * one dimension of the counter: integer captures are used as
+	 * index when smaller than the last index of the dimension, which
+	 * is the overflow slot for other values and failed captures.
+	 * Strings are hashed with jhash (seed 0) modulo the size of the
+	 * dimension minus 1.
+	 */
+	LTTNG_UST_EVENT_NOTIFIER_ACTION_MAP = 1,
+	/*
+	 * Run the session actions attached to the event notifier with
+	 * LTTNG_UST_SESSION_ACTION, then send a notification to the
+	 * sessiond with LTTNG_UST_EVENT_NOTIFIER_NOTIFICATION_FLAG_SESSION_ACTION.
+	 */
+	LTTNG_UST_EVENT_NOTIFIER_ACTION_SESSION = 2,
+};
+
+enum lttng_ust_map_op {
+	/* Add 1. */
+	LTTNG_UST_MAP_OP_COUNT = 0,
+	/*
+	 * Add the last capture, which is a number. Failed captures, other
+	 * types and floating point numbers which do not convert to a
+	 * 64-bit integer (NaN, infinities, out of range) are counted as
+	 * errors.
+	 */
+	LTTNG_UST_MAP_OP_SUM = 1,
+	/*
+	 * Add 1 in the last dimension of the counter, indexed by the
+	 * histogram bucket of the last capture: floor(log2(value)) + 1,
+	 * 0 for values below 1, or (value - min) / width, clamped to the
+	 * size of the dimension. Captures which are not numbers as for
+	 * LTTNG_UST_MAP_OP_SUM are counted in the last bucket.
+	 */
+	LTTNG_UST_MAP_OP_HIST_LOG2 = 2,
+	LTTNG_UST_MAP_OP_HIST_LINEAR = 3,
+};
+
+/*
+ * Rate policies of the notify action, evaluated in the traced process
+ * for all the tracepoints matched by the event notifier together.
+ * Suppressed hits are counted in the event notifier group error
+ * counter, at the error counter index of the event notifier.
+ */
+enum lttng_ust_event_notifier_rate_policy {
+	/* Notify every hit. */
+	LTTNG_UST_EVENT_NOTIFIER_RATE_NONE = 0,
+	/*
+	 * Notify at most rate_count hits per window of rate_window_ns.
+	 * rate_count must be lower than 65535 on 32-bit architectures.
+	 */
+	LTTNG_UST_EVENT_NOTIFIER_RATE_LIMIT = 1,
+	/* Notify the first hit, then one hit every rate_count hits. */
+	LTTNG_UST_EVENT_NOTIFIER_RATE_EVERY_NTH = 2,
+	/*
+	 * Notify the first hit of each window of rate_window_ns. Its
+	 * notification carries, in nr_hits, the number of hits since
+	 * the previous notification. Coalesced hits are not counted as
+	 * suppressed, except those not notified yet when the event
+	 * notifier is released.
+	 */
+	LTTNG_UST_EVENT_NOTIFIER_RATE_COALESCE = 3,
+};
+
+/*
+ * Session actions, run in the traced process by the first hit of an
+ * event notifier with LTTNG_UST_EVENT_NOTIFIER_ACTION_SESSION. Later
+ * hits are ignored, and the channels stay frozen, until the action is
+ * re-armed with LTTNG_UST_SESSION_ACTION_REARM. The metadata channel
+ * is left untouched.
+ */
+enum lttng_ust_session_action_op {
+	/* Stop recording in the overwrite-mode channels of the session. */
+	LTTNG_UST_SESSION_ACTION_FREEZE = (1U << 0),
+	/* Switch the current sub-buffer of the buffers of the session. */
+	LTTNG_UST_SESSION_ACTION_SWITCH = (1U << 1),
+	/*
+	 * Sample the consumed and produced positions of the buffers of
+	 * the session, see ustctl_snapshot_sample_trigger_positions().
+	 */
+	LTTNG_UST_SESSION_ACTION_SAMPLE = (1U << 2),
+};
+
+/*
+ * The channels frozen by a session action stay frozen until all the
+ * actions which froze them are re-armed or released. Each action is
+ * identified in the channels by its freeze_id, in [0, 31], which must
+ * be unique among the actions freezing the same buffers, including
+ * across applications for per-UID buffers. The freeze of an application
+ * terminating abnormally is withdrawn with ustctl_channel_thaw().
+ */
+#define LTTNG_UST_SESSION_ACTION_PADDING	20
+struct lttng_ust_session_action {
+	uint32_t session_handle;	/* Session of the same sessiond. */
+	uint32_t ops;			/* Mask of enum lttng_ust_session_action_op */
+	uint32_t freeze_id;		/* Id of the freeze in the channels. */
+	char padding[LTTNG_UST_SESSION_ACTION_PADDING];
+} LTTNG_PACKED;
+
+/*
+ * Threshold on the elements of the map counter of an event notifier,
+ * evaluated in the traced process when the per-CPU counters carry into
+ * the global counter, i.e. only for map counters created with a
+ * non-zero global_sum_step. The first carry at which the sum of an
+ * element is greater than or equal to the threshold sends a
+ * notification with LTTNG_UST_EVENT_NOTIFIER_NOTIFICATION_FLAG_THRESHOLD.
+ * Its captures are the dimension indexes of the element followed by its
+ * sum. The element is re-armed when it is cleared.
+ */
+#define LTTNG_UST_MAP_THRESHOLD_PADDING	24
+struct lttng_ust_map_threshold {
+	int64_t value;
+	char padding[LTTNG_UST_MAP_THRESHOLD_PADDING];
+} LTTNG_PACKED;
+
+#define LTTNG_UST_EVENT_NOTIFIER_PADDING	1
 struct lttng_ust_event_notifier {
 	struct lttng_ust_event event;
 	uint64_t error_counter_index;
+	uint8_t action;			/* enum lttng_ust_event_notifier_action */
+	uint8_t map_op;			/* enum lttng_ust_map_op */
+	int64_t map_bucket_min;		/* LTTNG_UST_MAP_OP_HIST_LINEAR */
+	uint64_t map_bucket_width;	/* LTTNG_UST_MAP_OP_HIST_LINEAR */
+	uint8_t rate_policy;		/* enum lttng_ust_event_notifier_rate_policy */
+	uint32_t rate_count;
+	uint64_t rate_window_ns;
 	char padding[LTTNG_UST_EVENT_NOTIFIER_PADDING];
 } LTTNG_PACKED;
 
-#define LTTNG_EVENT_NOTIFIER_NOTIFICATION_PADDING 32
+/*
+ * Sent on the notification fd instead of the notifications when the
+ * event notifier group has a notification channel: the notifications
+ * are in the channel, and a single wakeup is pending until the reader
+ * acknowledges it with ustctl_ack_notification_wakeup().
+ */
+#define LTTNG_UST_EVENT_NOTIFIER_NOTIFICATION_FLAG_WAKEUP	(1U << 0)
+/*
+ * The session actions of the event notifier ran: the buffers of the
+ * session can be collected before re-arming them.
+ */
+#define LTTNG_UST_EVENT_NOTIFIER_NOTIFICATION_FLAG_SESSION_ACTION	(1U << 1)
+/*
+ * An element of the map counter of the event notifier reached the
+ * threshold set with LTTNG_UST_MAP_THRESHOLD.
+ */
+#define LTTNG_UST_EVENT_NOTIFIER_NOTIFICATION_FLAG_THRESHOLD	(1U << 2)
+
+#define LTTNG_EVENT_NOTIFIER_NOTIFICATION_PADDING 23
 struct lttng_ust_event_notifier_notification {
 	uint64_t token;
 	uint16_t capture_buf_size;
+	uint8_t flags;
+	uint64_t nr_hits;	/* Hits notified, > 1 when coalesced. */
 	char padding[LTTNG_EVENT_NOTIFIER_NOTIFICATION_PADDING];
 } LTTNG_PACKED;
 
@@ -230,6 +378,7 @@ enum lttng_ust_context_type {
 	LTTNG_UST_CONTEXT_VEGID			= 19,
 	LTTNG_UST_CONTEXT_VSGID			= 20,
 	LTTNG_UST_CONTEXT_TIME_NS		= 21,
+	LTTNG_UST_CONTEXT_CALLSTACK		= 22,
 };
 
 struct lttng_ust_perf_counter_ctx {
@@ -388,12 +537,13 @@ struct lttng_ust_event_exclusion {
 #define LTTNG_UST_TRACEPOINT_FIELD_LIST		_UST_CMD(0x45)
 #define LTTNG_UST_EVENT_NOTIFIER_GROUP_CREATE	_UST_CMD(0x46)
 
-/* Session commands */
+/* Session and event notifier group commands */
 #define LTTNG_UST_CHANNEL			\
 	_UST_CMDW(0x51, struct lttng_ust_channel)
 #define LTTNG_UST_SESSION_START			_UST_CMD(0x52)
 #define LTTNG_UST_SESSION_STOP			_UST_CMD(0x53)
 #define LTTNG_UST_SESSION_STATEDUMP		_UST_CMD(0x54)
+#define LTTNG_UST_SESSION_STATEDUMP_INCREMENTAL	_UST_CMD(0x55)
 
 /* Channel commands */
 #define LTTNG_UST_STREAM			_UST_CMD(0x60)
@@ -424,8 +574,18 @@ struct lttng_ust_event_exclusion {
 
 /* Event notifier commands */
 #define LTTNG_UST_CAPTURE			_UST_CMD(0xB6)
+#define LTTNG_UST_SESSION_ACTION		\
+	_UST_CMDW(0xB7, struct lttng_ust_session_action)
+#define LTTNG_UST_SESSION_ACTION_REARM		_UST_CMD(0xB8)
+#define LTTNG_UST_MAP_THRESHOLD			\
+	_UST_CMDW(0xB9, struct lttng_ust_map_threshold)
 
-/* Session and event notifier group commands */
+/*
+ * Session, channel, event notifier group and event notifier commands.
+ * On a channel, the counter has a single dimension, indexed by event
+ * ID, and counts the records lost by each event. Its last index also
+ * counts the events with larger IDs.
+ */
 #define LTTNG_UST_COUNTER			\
 	_UST_CMDW(0xC0, struct lttng_ust_counter)
 
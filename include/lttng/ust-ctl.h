@@ -126,6 +126,39 @@ int ustctl_create_event_notifier(int sock,
 		struct lttng_ust_object_data *event_notifier_group,
 		struct lttng_ust_object_data **event_notifier_data);
 
+/*
+ * Attach the session actions `ops` (mask of enum
+ * lttng_ust_session_action_op) on the session `session_handle` to an
+ * event notifier created with LTTNG_UST_EVENT_NOTIFIER_ACTION_SESSION.
+ * The first hit of the event notifier runs them in the application,
+ * then sends a notification flagged with
+ * LTTNG_UST_EVENT_NOTIFIER_NOTIFICATION_FLAG_SESSION_ACTION. Once the
+ * buffers are collected, ustctl_rearm_session_action() resumes
+ * recording in the channels frozen by the actions, identified by
+ * `freeze_id` (see struct lttng_ust_session_action), and arms the
+ * actions again.
+ */
+int ustctl_set_session_action(int sock,
+		struct lttng_ust_object_data *event_notifier_data,
+		int session_handle, uint32_t ops, uint32_t freeze_id);
+int ustctl_rearm_session_action(int sock,
+		struct lttng_ust_object_data *event_notifier_data);
+
+/*
+ * Set the threshold of the map counter of an event notifier created
+ * with LTTNG_UST_EVENT_NOTIFIER_ACTION_MAP. The map counter must have
+ * been created with USTCTL_COUNTER_ALLOC_PER_CPU |
+ * USTCTL_COUNTER_ALLOC_GLOBAL and a non-zero global_sum_step, and its
+ * global shared memory sent to the application. The application sends
+ * a notification flagged with
+ * LTTNG_UST_EVENT_NOTIFIER_NOTIFICATION_FLAG_THRESHOLD when the sum of
+ * an element reaches the threshold. ustctl_counter_clear() of the
+ * element re-arms it.
+ */
+int ustctl_set_map_threshold(int sock,
+		struct lttng_ust_object_data *event_notifier_data,
+		int64_t threshold);
+
 /*
  * ustctl_tracepoint_list returns a tracepoint list handle, or negative
  * error value.
@@ -209,6 +242,14 @@ int ustctl_channel_close_wait_fd(struct ustctl_consumer_channel *consumer_chan);
 int ustctl_channel_close_wakeup_fd(struct ustctl_consumer_channel *consumer_chan);
 int ustctl_channel_get_wait_fd(struct ustctl_consumer_channel *consumer_chan);
 int ustctl_channel_get_wakeup_fd(struct ustctl_consumer_channel *consumer_chan);
+/*
+ * Withdraw the freezes of the session actions identified by the freeze
+ * ids of `freeze_mask` (bit N for freeze id N) from a channel, e.g.
+ * those of an application which terminated without re-arming or
+ * releasing its actions.
+ */
+int ustctl_channel_thaw(struct ustctl_consumer_channel *consumer_chan,
+		uint32_t freeze_mask);
 
 int ustctl_write_metadata_to_channel(
 		struct ustctl_consumer_channel *channel,
@@ -236,6 +277,27 @@ struct ustctl_consumer_stream *
 			int cpu);
 void ustctl_destroy_stream(struct ustctl_consumer_stream *stream);
 
+/*
+ * Event notifier notification channel (LTTNG_UST_CHAN_NOTIFICATION),
+ * read by the daemon which creates it. The channel and its stream
+ * (created for cpu 0) are sent to the application with
+ * ustctl_send_channel_to_ust() on the event notifier group handle and
+ * ustctl_send_stream_to_ust(), using the object data created below.
+ *
+ * When the application sends a notification flagged with
+ * LTTNG_UST_EVENT_NOTIFIER_NOTIFICATION_FLAG_WAKEUP on the notification
+ * fd, the reader acknowledges it with ustctl_ack_notification_wakeup(),
+ * then flushes the stream with ustctl_flush_buffer(stream, 1) and reads
+ * all its sub-buffers. Each sub-buffer holds a sequence of struct
+ * lttng_ust_event_notifier_notification, each followed by its capture
+ * buffer.
+ */
+int ustctl_create_channel_data(struct ustctl_consumer_channel *channel,
+		struct lttng_ust_object_data **channel_data);
+int ustctl_create_stream_data(struct ustctl_consumer_stream *stream,
+		struct lttng_ust_object_data **stream_data);
+int ustctl_ack_notification_wakeup(struct ustctl_consumer_channel *channel);
+
 /* For mmap mode, readable without "get" operation */
 int ustctl_get_mmap_len(struct ustctl_consumer_stream *stream,
 		unsigned long *len);
@@ -260,6 +322,7 @@ int ustctl_put_next_subbuf(struct ustctl_consumer_stream *stream);
 
 int ustctl_snapshot(struct ustctl_consumer_stream *stream);
 int ustctl_snapshot_sample_positions(struct ustctl_consumer_stream *stream);
+int ustctl_snapshot_sample_trigger_positions(struct ustctl_consumer_stream *stream);
 int ustctl_snapshot_get_consumed(struct ustctl_consumer_stream *stream,
 		unsigned long *pos);
 int ustctl_snapshot_get_produced(struct ustctl_consumer_stream *stream,
@@ -314,6 +377,11 @@ int ustctl_has_perf_counters(void);
 
 /* Regenerate the statedump. */
 int ustctl_regenerate_statedump(int sock, int handle);
+/*
+ * Regenerate the statedump, only for the shared objects loaded since
+ * the previous statedump of the session.
+ */
+int ustctl_regenerate_statedump_incremental(int sock, int handle);
 
 /* event registry management */
 
@@ -326,6 +394,7 @@ enum ustctl_notify_cmd {
 	USTCTL_NOTIFY_CMD_EVENT = 0,
 	USTCTL_NOTIFY_CMD_CHANNEL = 1,
 	USTCTL_NOTIFY_CMD_ENUM = 2,
+	USTCTL_NOTIFY_CMD_EVENTS = 3,
 };
 
 enum ustctl_channel_header {
@@ -559,6 +628,49 @@ int ustctl_reply_register_event(int sock,
 	uint32_t id,			/* event id (input) */
 	int ret_code);			/* return code. 0 ok, negative error */
 
+/*
+ * Event description received through ustctl_recv_register_events().
+ * The signature, fields and model_emf_uri are dynamically allocated,
+ * and released by ustctl_release_register_events().
+ */
+struct ustctl_event_registration {
+	int channel_objd;		/* channel descriptor */
+	char event_name[LTTNG_UST_SYM_NAME_LEN];
+	int loglevel;
+	char *signature;
+	size_t nr_fields;
+	struct ustctl_field *fields;
+	char *model_emf_uri;		/* NULL if none */
+};
+
+/*
+ * Returns 0 on success, negative UST or system error value on error.
+ * Receive a batch of event registrations (USTCTL_NOTIFY_CMD_EVENTS),
+ * all belonging to the same session. On success, "events" is an array
+ * of "nr_events" elements which must be released with
+ * ustctl_release_register_events() by the caller.
+ */
+int ustctl_recv_register_events(int sock,
+	int *session_objd,		/* session descriptor (output) */
+	size_t *nr_events,		/* number of events (output) */
+	struct ustctl_event_registration **events);
+
+void ustctl_release_register_events(size_t nr_events,
+	struct ustctl_event_registration *events);
+
+/*
+ * Returns 0 on success, negative error value on error.
+ * Reply to a batch of event registrations. "ids" and "ret_codes" are
+ * arrays of "nr_events" elements, in the order in which the events
+ * were received. If "ret_code" is negative, the whole batch is refused
+ * and "ids" and "ret_codes" are ignored.
+ */
+int ustctl_reply_register_events(int sock,
+	size_t nr_events,
+	const uint32_t *ids,		/* event ids (input) */
+	const int *ret_codes,		/* per-event return code (input) */
+	int ret_code);			/* return code. 0 ok, negative error */
+
 /*
  * Returns 0 on success, negative UST or system error value on error.
  */
@@ -649,6 +761,13 @@ int ustctl_create_counter_cpu_data(struct ustctl_daemon_counter *counter, int cp
  */
 void ustctl_destroy_counter(struct ustctl_daemon_counter *counter);
 
+/*
+ * The parent is a session, a channel, an event notifier group or an
+ * event notifier. Sent to a channel, a per-CPU counter with a single
+ * dimension counts the records lost by each event ID of the channel,
+ * which can be read with ustctl_counter_read() and
+ * ustctl_counter_aggregate{,_range}().
+ */
 int ustctl_send_counter_data_to_ust(int sock, int parent_handle,
 		struct lttng_ust_object_data *counter_data);
 int ustctl_send_counter_global_data_to_ust(int sock,
@@ -669,4 +788,31 @@ int ustctl_counter_aggregate(struct ustctl_daemon_counter *counter,
 int ustctl_counter_clear(struct ustctl_daemon_counter *counter,
 		const size_t *dimension_indexes);
 
+/*
+ * Read or aggregate @nr_elem consecutive counters starting at
+ * @dimension_indexes, in index order (the last dimension varies
+ * fastest). @values, @overflow and @underflow hold @nr_elem entries.
+ */
+int ustctl_counter_read_range(struct ustctl_daemon_counter *counter,
+		const size_t *dimension_indexes, size_t nr_elem,
+		int cpu, int64_t *values,
+		bool *overflow, bool *underflow);
+int ustctl_counter_aggregate_range(struct ustctl_daemon_counter *counter,
+		const size_t *dimension_indexes, size_t nr_elem,
+		int64_t *values,
+		bool *overflow, bool *underflow);
+
+/*
+ * Aggregate like ustctl_counter_aggregate_range() and reset the
+ * counters, returning in @deltas the counts since the previous reset.
+ * Increments racing with the reset are returned by the next call. A
+ * delta may transiently be off, possibly negative, by half the global
+ * sum step per carry racing with the reset, compensated by the next
+ * delta.
+ */
+int ustctl_counter_aggregate_delta_range(struct ustctl_daemon_counter *counter,
+		const size_t *dimension_indexes, size_t nr_elem,
+		int64_t *deltas,
+		bool *overflow, bool *underflow);
+
 #endif /* _LTTNG_UST_CTL_H */
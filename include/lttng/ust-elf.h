@@ -195,29 +195,8 @@ struct lttng_ust_elf_nhdr {
 	uint32_t n_type;
 };
 
-struct lttng_ust_elf {
-	/* Offset in bytes to start of section names string table. */
-	off_t section_names_offset;
-	/* Size in bytes of section names string table. */
-	size_t section_names_size;
-	char *path;
-	int fd;
-	struct lttng_ust_elf_ehdr *ehdr;
-	uint8_t bitness;
-	uint8_t endianness;
-};
-
-static inline
-int is_elf_32_bit(struct lttng_ust_elf *elf)
-{
-	return elf->bitness == ELFCLASS32;
-}
-
-static inline
-int is_elf_native_endian(struct lttng_ust_elf *elf)
-{
-	return elf->endianness == NATIVE_ELF_ENDIANNESS;
-}
+/* Opaque, see lttng_ust_elf_create(). */
+struct lttng_ust_elf;
 
 struct lttng_ust_elf *lttng_ust_elf_create(const char *path);
 void lttng_ust_elf_destroy(struct lttng_ust_elf *elf);
@@ -227,5 +206,9 @@ int lttng_ust_elf_get_build_id(struct lttng_ust_elf *elf, uint8_t **build_id,
 			size_t *length, int *found);
 int lttng_ust_elf_get_debug_link(struct lttng_ust_elf *elf, char **filename,
 			uint32_t *crc, int *found);
+int lttng_ust_elf_for_each_func_symbol(struct lttng_ust_elf *elf,
+		int (*cb)(const char *name, uint64_t addr, uint64_t size,
+			void *priv),
+		void *priv);
 
 #endif	/* _LTTNG_UST_ELF_H */
@@ -82,6 +82,7 @@ enum lttng_client_types {
 	LTTNG_CLIENT_OVERWRITE = 2,
 	LTTNG_CLIENT_DISCARD_RT = 3,
 	LTTNG_CLIENT_OVERWRITE_RT = 4,
+	LTTNG_CLIENT_NOTIFICATION = 5,
 	LTTNG_NR_CLIENT_TYPES,
 };
 
@@ -438,6 +439,9 @@ enum lttng_bytecode_interpreter_ret {
 };
 
 struct lttng_interpreter_output;
+struct lttng_event_notifier_map;
+struct lttng_event_notifier_rate;
+struct lttng_event_notifier_session_action;
 
 /*
  * This structure is used in the probes. More specifically, the `filter` and
@@ -526,6 +530,10 @@ struct lttng_event_notifier {
 	struct cds_hlist_node hlist;	/* hashtable of event_notifiers */
 	struct cds_list_head node;	/* event_notifier list in session */
 	struct lttng_event_notifier_group *group; /* weak ref */
+	struct lttng_event_notifier_map *map;	/* NULL unless map action */
+	struct lttng_event_notifier_rate *rate;	/* NULL unless rate policy */
+	/* NULL unless session action */
+	struct lttng_event_notifier_session_action *session_action;
 };
 
 struct lttng_enum {
@@ -619,6 +627,10 @@ struct lttng_channel {
 	enum lttng_ust_chan_type type;
 	unsigned char uuid[LTTNG_UST_UUID_LEN]; /* Trace session unique ID */
 	int tstate:1;			/* Transient enable state */
+
+	/* New UST 2.13 */
+	struct lttng_counter *drop_counter;	/* Lost records per event ID, NULL if none. */
+	size_t drop_counter_len;
 };
 
 #define LTTNG_COUNTER_DIMENSION_MAX	8
@@ -649,6 +661,23 @@ struct lttng_counter_ops {
 			const size_t *dimension_indexes, int64_t *value,
 			bool *overflow, bool *underflow);
 	int (*counter_clear)(struct lib_counter *counter, const size_t *dimension_indexes);
+	int (*counter_read_range)(struct lib_counter *counter,
+			const size_t *dimension_indexes, size_t nr_elem,
+			int cpu, int64_t *values,
+			bool *overflow, bool *underflow);
+	int (*counter_aggregate_range)(struct lib_counter *counter,
+			const size_t *dimension_indexes, size_t nr_elem,
+			int64_t *values, bool *overflow, bool *underflow);
+	int (*counter_aggregate_delta_range)(struct lib_counter *counter,
+			const size_t *dimension_indexes, size_t nr_elem,
+			int64_t *deltas, bool *overflow, bool *underflow);
+	/* NULL for counters without carry into a global counter. */
+	int (*counter_set_threshold)(struct lib_counter *counter,
+			int64_t threshold,
+			void (*cb)(struct lib_counter *counter,
+				const size_t *dimension_indexes,
+				int64_t value, void *priv),
+			void *priv);
 };
 
 #define LTTNG_UST_STACK_CTX_PADDING	32
@@ -710,6 +739,10 @@ struct lttng_session {
 	struct lttng_ust_enum_ht enums_ht;	/* ht of enumerations */
 	struct cds_list_head enums_head;
 	struct lttng_ctx *ctx;			/* contexts for filters. */
+
+	/* New UST 2.13 */
+	int statedump_incremental:1;		/* Only dump new objects */
+	uint64_t statedump_generation;		/* Objects covered by last dump */
 };
 
 struct lttng_counter {
@@ -732,6 +765,9 @@ struct lttng_event_notifier_group {
 
 	struct lttng_counter *error_counter;
 	size_t error_counter_len;
+
+	struct lttng_channel *notification_chan;	/* NULL if none */
+	int notification_chan_ready;	/* All streams are mapped. */
 };
 
 struct lttng_transport {
@@ -751,7 +787,7 @@ struct lttng_counter_transport {
 struct lttng_session *lttng_session_create(void);
 int lttng_session_enable(struct lttng_session *session);
 int lttng_session_disable(struct lttng_session *session);
-int lttng_session_statedump(struct lttng_session *session);
+int lttng_session_statedump(struct lttng_session *session, int incremental);
 void lttng_session_destroy(struct lttng_session *session);
 
 struct lttng_channel *lttng_channel_create(struct lttng_session *session,
@@ -778,7 +814,8 @@ void lttng_counter_transport_unregister(struct lttng_counter_transport *transpor
 
 struct lttng_counter *lttng_ust_counter_create(
 		const char *counter_transport_name,
-		size_t number_dimensions, const struct lttng_counter_dimension *dimensions);
+		size_t number_dimensions, const struct lttng_counter_dimension *dimensions,
+		int64_t global_sum_step);
 
 int lttng_probe_register(struct lttng_probe_desc *desc);
 void lttng_probe_unregister(struct lttng_probe_desc *desc);
@@ -814,6 +851,7 @@ int lttng_add_vsuid_to_ctx(struct lttng_ctx **ctx);
 int lttng_add_vgid_to_ctx(struct lttng_ctx **ctx);
 int lttng_add_vegid_to_ctx(struct lttng_ctx **ctx);
 int lttng_add_vsgid_to_ctx(struct lttng_ctx **ctx);
+int lttng_add_callstack_to_ctx(struct lttng_ctx **ctx);
 void lttng_context_vtid_reset(void);
 void lttng_context_vpid_reset(void);
 void lttng_context_procname_reset(void);
@@ -888,6 +926,15 @@ struct lttng_enum *lttng_ust_enum_get_from_desc(struct lttng_session *session,
 		const struct lttng_enum_desc *enum_desc);
 
 void lttng_ust_dl_update(void *ip);
+
+/*
+ * Register a callback invoked each time lttng_ust_dl_update() runs,
+ * i.e. after dlopen() and dlclose() when liblttng-ust-dl is preloaded.
+ * The callback must not register or unregister callbacks. Returns 0 on
+ * success, -1 if too many callbacks are registered.
+ */
+int lttng_ust_dl_register_update_cb(void (*func)(void *priv), void *priv);
+void lttng_ust_dl_unregister_update_cb(void (*func)(void *priv), void *priv);
 void lttng_ust_fixup_fd_tracker_tls(void);
 
 /* For backward compatibility. Leave those exported symbols in place. */
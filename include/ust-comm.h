@@ -110,6 +110,8 @@ struct ustcomm_ust_msg {
 		struct lttng_ust_counter counter;
 		struct lttng_ust_counter_global counter_global;
 		struct lttng_ust_counter_cpu counter_cpu;
+		struct lttng_ust_session_action session_action;
+		struct lttng_ust_map_threshold map_threshold;
 		/*
 		 * For LTTNG_UST_EVENT_NOTIFIER_CREATE, a struct
 		 * lttng_ust_event_notifier implicitly follows struct
@@ -172,6 +174,33 @@ struct ustcomm_notify_event_reply {
 	char padding[USTCOMM_NOTIFY_EVENT_REPLY_PADDING];
 } LTTNG_PACKED;
 
+/*
+ * Maximum number of events carried by a single
+ * USTCTL_NOTIFY_CMD_EVENTS message, and maximum size of its payload.
+ */
+#define USTCOMM_NOTIFY_EVENTS_MAX_BATCH		256
+#define USTCOMM_NOTIFY_EVENTS_MAX_PAYLOAD	(64 * 1024 * 1024)
+
+#define USTCOMM_NOTIFY_EVENTS_MSG_PADDING	32
+struct ustcomm_notify_events_msg {
+	uint32_t session_objd;
+	uint32_t nr_events;
+	uint64_t payload_len;
+	char padding[USTCOMM_NOTIFY_EVENTS_MSG_PADDING];
+	/*
+	 * followed by nr_events times: struct ustcomm_notify_event_msg,
+	 * signature, fields, and model_emf_uri.
+	 */
+} LTTNG_PACKED;
+
+#define USTCOMM_NOTIFY_EVENTS_REPLY_PADDING	32
+struct ustcomm_notify_events_reply {
+	int32_t ret_code;	/* 0: ok, negative: error code */
+	uint32_t nr_events;
+	char padding[USTCOMM_NOTIFY_EVENTS_REPLY_PADDING];
+	/* followed by nr_events struct ustcomm_notify_event_reply */
+} LTTNG_PACKED;
+
 #define USTCOMM_NOTIFY_ENUM_MSG_PADDING		32
 struct ustcomm_notify_enum_msg {
 	uint32_t session_objd;
@@ -273,6 +302,36 @@ int ustcomm_register_event(int sock,
 	const char *model_emf_uri,
 	uint32_t *id);			/* event id (output) */
 
+/*
+ * Event registration request, used as input and output of
+ * ustcomm_register_events().
+ */
+struct ustcomm_event_registration {
+	int channel_objd;		/* channel descriptor */
+	const char *event_name;
+	int loglevel;
+	const char *signature;
+	size_t nr_fields;
+	const struct lttng_event_field *fields;
+	const char *model_emf_uri;
+	int ret_code;			/* registration status (output) */
+	uint32_t id;			/* event id (output) */
+};
+
+/*
+ * Register up to USTCOMM_NOTIFY_EVENTS_MAX_BATCH events of a session
+ * with a single notify round trip.
+ * Returns 0 if the batch was processed by the session daemon, in which
+ * case the per-event status is found in the "ret_code" field of each
+ * registration. Returns a negative error value on error.
+ * Returns -EPIPE or -ECONNRESET if other end has hung up.
+ */
+int ustcomm_register_events(int sock,
+	struct lttng_session *session,
+	int session_objd,		/* session descriptor */
+	size_t nr_events,
+	struct ustcomm_event_registration *events);
+
 /*
  * Returns 0 on success, negative error value on error.
  * Returns -EPIPE or -ECONNRESET if other end has hung up.
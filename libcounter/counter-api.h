@@ -38,6 +38,11 @@
 
 /*
  * Using unsigned arithmetic because overflow is defined.
+ *
+ * Per-CPU counters are updated with a single atomic add. When the
+ * result exceeds the global sum step, half of the step is withdrawn
+ * from the per-CPU counter with a second atomic add, and returned in
+ * @remainder for the caller to carry to the global counter.
  */
 static inline int __lttng_counter_add(const struct lib_counter_config *config,
 				      enum lib_counter_config_alloc alloc,
@@ -79,17 +84,14 @@ static inline int __lttng_counter_add(const struct lib_counter_config *config,
 		switch (sync) {
 		case COUNTER_SYNC_PER_CPU:
 		{
-			do {
-				move_sum = 0;
-				old = res;
-				n = (int8_t) ((uint8_t) old + (uint8_t) v);
-				if (caa_unlikely(n > (int8_t) global_sum_step))
-					move_sum = (int8_t) global_sum_step / 2;
-				else if (caa_unlikely(n < -(int8_t) global_sum_step))
-					move_sum = -((int8_t) global_sum_step / 2);
-				n -= move_sum;
-				res = uatomic_cmpxchg(int_p, old, n);
-			} while (old != res);
+			n = uatomic_add_return(int_p, (int8_t) v);
+			old = (int8_t) ((uint8_t) n - (uint8_t) v);
+			if (caa_unlikely(n > (int8_t) global_sum_step))
+				move_sum = (int8_t) global_sum_step / 2;
+			else if (caa_unlikely(n < -(int8_t) global_sum_step))
+				move_sum = -((int8_t) global_sum_step / 2);
+			if (caa_unlikely(move_sum))
+				uatomic_add(int_p, (int8_t) -move_sum);
 			break;
 		}
 		case COUNTER_SYNC_GLOBAL:
@@ -120,17 +122,14 @@ static inline int __lttng_counter_add(const struct lib_counter_config *config,
 		switch (sync) {
 		case COUNTER_SYNC_PER_CPU:
 		{
-			do {
-				move_sum = 0;
-				old = res;
-				n = (int16_t) ((uint16_t) old + (uint16_t) v);
-				if (caa_unlikely(n > (int16_t) global_sum_step))
-					move_sum = (int16_t) global_sum_step / 2;
-				else if (caa_unlikely(n < -(int16_t) global_sum_step))
-					move_sum = -((int16_t) global_sum_step / 2);
-				n -= move_sum;
-				res = uatomic_cmpxchg(int_p, old, n);
-			} while (old != res);
+			n = uatomic_add_return(int_p, (int16_t) v);
+			old = (int16_t) ((uint16_t) n - (uint16_t) v);
+			if (caa_unlikely(n > (int16_t) global_sum_step))
+				move_sum = (int16_t) global_sum_step / 2;
+			else if (caa_unlikely(n < -(int16_t) global_sum_step))
+				move_sum = -((int16_t) global_sum_step / 2);
+			if (caa_unlikely(move_sum))
+				uatomic_add(int_p, (int16_t) -move_sum);
 			break;
 		}
 		case COUNTER_SYNC_GLOBAL:
@@ -161,17 +160,14 @@ static inline int __lttng_counter_add(const struct lib_counter_config *config,
 		switch (sync) {
 		case COUNTER_SYNC_PER_CPU:
 		{
-			do {
-				move_sum = 0;
-				old = res;
-				n = (int32_t) ((uint32_t) old + (uint32_t) v);
-				if (caa_unlikely(n > (int32_t) global_sum_step))
-					move_sum = (int32_t) global_sum_step / 2;
-				else if (caa_unlikely(n < -(int32_t) global_sum_step))
-					move_sum = -((int32_t) global_sum_step / 2);
-				n -= move_sum;
-				res = uatomic_cmpxchg(int_p, old, n);
-			} while (old != res);
+			n = uatomic_add_return(int_p, (int32_t) v);
+			old = (int32_t) ((uint32_t) n - (uint32_t) v);
+			if (caa_unlikely(n > (int32_t) global_sum_step))
+				move_sum = (int32_t) global_sum_step / 2;
+			else if (caa_unlikely(n < -(int32_t) global_sum_step))
+				move_sum = -((int32_t) global_sum_step / 2);
+			if (caa_unlikely(move_sum))
+				uatomic_add(int_p, (int32_t) -move_sum);
 			break;
 		}
 		case COUNTER_SYNC_GLOBAL:
@@ -203,17 +199,14 @@ static inline int __lttng_counter_add(const struct lib_counter_config *config,
 		switch (sync) {
 		case COUNTER_SYNC_PER_CPU:
 		{
-			do {
-				move_sum = 0;
-				old = res;
-				n = (int64_t) ((uint64_t) old + (uint64_t) v);
-				if (caa_unlikely(n > (int64_t) global_sum_step))
-					move_sum = (int64_t) global_sum_step / 2;
-				else if (caa_unlikely(n < -(int64_t) global_sum_step))
-					move_sum = -((int64_t) global_sum_step / 2);
-				n -= move_sum;
-				res = uatomic_cmpxchg(int_p, old, n);
-			} while (old != res);
+			n = uatomic_add_return(int_p, v);
+			old = (int64_t) ((uint64_t) n - (uint64_t) v);
+			if (caa_unlikely(n > (int64_t) global_sum_step))
+				move_sum = (int64_t) global_sum_step / 2;
+			else if (caa_unlikely(n < -(int64_t) global_sum_step))
+				move_sum = -((int64_t) global_sum_step / 2);
+			if (caa_unlikely(move_sum))
+				uatomic_add(int_p, -move_sum);
 			break;
 		}
 		case COUNTER_SYNC_GLOBAL:
@@ -258,9 +251,14 @@ static inline int __lttng_counter_add_percpu(const struct lib_counter_config *co
 				       counter, dimension_indexes, v, &move_sum);
 	if (caa_unlikely(ret))
 		return ret;
-	if (caa_unlikely(move_sum))
-		return __lttng_counter_add(config, COUNTER_ALLOC_GLOBAL, COUNTER_SYNC_GLOBAL,
-					   counter, dimension_indexes, move_sum, NULL);
+	if (caa_unlikely(move_sum)) {
+		ret = __lttng_counter_add(config, COUNTER_ALLOC_GLOBAL, COUNTER_SYNC_GLOBAL,
+					  counter, dimension_indexes, move_sum, NULL);
+		/* The threshold is only evaluated at carry points. */
+		if (caa_unlikely(CMM_LOAD_SHARED(counter->threshold.cb)) && !ret)
+			lttng_counter_check_threshold(config, counter, dimension_indexes);
+		return ret;
+	}
 	return 0;
 }
 
@@ -52,6 +52,7 @@ struct lib_counter_layout {
 	void *counters;
 	unsigned long *overflow_bitmap;
 	unsigned long *underflow_bitmap;
+	unsigned long *threshold_bitmap;	/* Global layout only. */
 	int shm_fd;
 	size_t shm_len;
 	struct lttng_counter_shm_handle handle;
@@ -62,6 +63,16 @@ enum lib_counter_arithmetic {
 	LIB_COUNTER_ARITHMETIC_SATURATE,
 };
 
+struct lib_counter;
+
+/*
+ * Called by the add which carries the per-CPU counter of an element
+ * into the global counter, when the sum of the element is greater than
+ * or equal to the threshold for the first time since it was cleared.
+ */
+typedef void (*lib_counter_threshold_cb)(struct lib_counter *counter,
+		const size_t *dimension_indexes, int64_t value, void *priv);
+
 struct lib_counter {
 	size_t nr_dimensions;
 	int64_t allocated_elem;
@@ -82,6 +93,11 @@ struct lib_counter {
 		int64_t s64;
 	} global_sum_step;		/* 0 if unused */
 	struct lib_counter_config config;
+	struct {
+		int64_t value;
+		lib_counter_threshold_cb cb;	/* NULL if unused */
+		void *priv;
+	} threshold;
 
 	struct lib_counter_layout global_counters;
 	struct lib_counter_layout *percpu_counters;
@@ -7,6 +7,8 @@
 
 #define _GNU_SOURCE
 #include <errno.h>
+#include <limits.h>
+#include <string.h>
 #include "counter.h"
 #include "counter-internal.h"
 #include <lttng/bitmap.h>
@@ -51,7 +53,8 @@ static int lttng_counter_layout_init(struct lib_counter *counter, int cpu, int s
 	struct lib_counter_layout *layout;
 	size_t counter_size;
 	size_t nr_elem = counter->allocated_elem;
-	size_t shm_length = 0, counters_offset, overflow_offset, underflow_offset;
+	size_t shm_length = 0, counters_offset, overflow_offset, underflow_offset,
+		threshold_offset, bitmap_len;
 	struct lttng_counter_shm_object *shm_object;
 
 	if (shm_fd < 0)
@@ -74,10 +77,23 @@ static int lttng_counter_layout_init(struct lib_counter *counter, int cpu, int s
 	layout->shm_fd = shm_fd;
 	counters_offset = shm_length;
 	shm_length += counter_size * nr_elem;
+	/*
+	 * The bitmaps are accessed one unsigned long at a time, including
+	 * with atomic operations: align and size them on longs.
+	 */
+	bitmap_len = LTTNG_UST_ALIGN(nr_elem, CAA_BITS_PER_LONG) / CHAR_BIT;
+	shm_length = LTTNG_UST_ALIGN(shm_length, sizeof(unsigned long));
 	overflow_offset = shm_length;
-	shm_length += LTTNG_UST_ALIGN(nr_elem, 8) / 8;
+	shm_length += bitmap_len;
 	underflow_offset = shm_length;
-	shm_length += LTTNG_UST_ALIGN(nr_elem, 8) / 8;
+	shm_length += bitmap_len;
+	/*
+	 * The threshold state is shared with the daemon, whose clear of
+	 * an element re-arms it.
+	 */
+	threshold_offset = shm_length;
+	if (cpu == -1)
+		shm_length += bitmap_len;
 	layout->shm_len = shm_length;
 	if (counter->is_daemon) {
 		/* Allocate and clear shared memory. */
@@ -95,6 +111,8 @@ static int lttng_counter_layout_init(struct lib_counter *counter, int cpu, int s
 	layout->counters = shm_object->memory_map + counters_offset;
 	layout->overflow_bitmap = (unsigned long *)(shm_object->memory_map + overflow_offset);
 	layout->underflow_bitmap = (unsigned long *)(shm_object->memory_map + underflow_offset);
+	if (cpu == -1)
+		layout->threshold_bitmap = (unsigned long *)(shm_object->memory_map + threshold_offset);
 	return 0;
 }
 
@@ -452,6 +470,457 @@ int lttng_counter_aggregate(const struct lib_counter_config *config,
 	return 0;
 }
 
+/*
+ * Number of elements summed at once by the range reads. The partial
+ * sums of a chunk stay in cache while the counters of each CPU are
+ * streamed into them. Multiple of CAA_BITS_PER_LONG.
+ */
+#define COUNTER_RANGE_CHUNK	512
+
+static
+struct lib_counter_layout *lttng_counter_get_layout(const struct lib_counter_config *config,
+						    struct lib_counter *counter,
+						    int cpu)
+{
+	switch (config->alloc) {
+	case COUNTER_ALLOC_PER_CPU:
+		if (cpu < 0 || cpu >= lttng_counter_num_possible_cpus())
+			return NULL;
+		return &counter->percpu_counters[cpu];
+	case COUNTER_ALLOC_PER_CPU | COUNTER_ALLOC_GLOBAL:
+		if (cpu >= 0) {
+			if (cpu >= lttng_counter_num_possible_cpus())
+				return NULL;
+			return &counter->percpu_counters[cpu];
+		}
+		return &counter->global_counters;
+	case COUNTER_ALLOC_GLOBAL:
+		if (cpu >= 0)
+			return NULL;
+		return &counter->global_counters;
+	default:
+		return NULL;
+	}
+}
+
+/*
+ * OR bits [start, start + nr_bits) of @src into @dst, one word at a
+ * time. @src holds @nr_src_bits bits; words beyond it are not read.
+ */
+static
+void lttng_counter_bitmap_or_range(unsigned long *dst, unsigned long *src,
+				   size_t nr_src_bits, size_t start, size_t nr_bits)
+{
+	size_t word = start / CAA_BITS_PER_LONG;
+	size_t last_word = (nr_src_bits - 1) / CAA_BITS_PER_LONG;
+	unsigned int shift = start % CAA_BITS_PER_LONG;
+	size_t i, nr_words = (nr_bits + CAA_BITS_PER_LONG - 1) / CAA_BITS_PER_LONG;
+
+	for (i = 0; i < nr_words; i++) {
+		unsigned long v = CMM_LOAD_SHARED(src[word + i]) >> shift;
+
+		if (shift && word + i + 1 <= last_word)
+			v |= CMM_LOAD_SHARED(src[word + i + 1]) << (CAA_BITS_PER_LONG - shift);
+		dst[i] |= v;
+	}
+	if (nr_bits % CAA_BITS_PER_LONG)
+		dst[nr_words - 1] &= (1UL << (nr_bits % CAA_BITS_PER_LONG)) - 1;
+}
+
+/*
+ * Clear bits [start, start + nr_bits) of @src, OR-ing the bits which
+ * were set into @dst (bit 0 of @dst is bit @start of @src) unless it is
+ * NULL. Only the bits seen set are cleared, so bits set concurrently
+ * are returned by the next call.
+ */
+static
+void lttng_counter_bitmap_xchg_range(unsigned long *dst, unsigned long *src,
+				     size_t start, size_t nr_bits)
+{
+	size_t bit = start, end = start + nr_bits;
+
+	while (bit < end) {
+		size_t word = bit / CAA_BITS_PER_LONG;
+		unsigned int shift = bit % CAA_BITS_PER_LONG;
+		size_t n = CAA_BITS_PER_LONG - shift;
+		unsigned long mask, v;
+
+		if (n > end - bit)
+			n = end - bit;
+		mask = (n == CAA_BITS_PER_LONG ? ~0UL : (1UL << n) - 1) << shift;
+		v = CMM_LOAD_SHARED(src[word]) & mask;
+		if (v) {
+			uatomic_and(&src[word], ~v);
+			for (; dst && v; v &= v - 1) {
+				size_t pos = word * CAA_BITS_PER_LONG
+					+ __builtin_ctzl(v) - start;
+
+				dst[pos / CAA_BITS_PER_LONG] |=
+					1UL << (pos % CAA_BITS_PER_LONG);
+			}
+		}
+		bit += n;
+	}
+}
+
+/*
+ * Column sums of the counters of one layout into @sums. The counters
+ * are read with plain loads so the loops can be vectorized; each
+ * element is loaded exactly once. Full chunks are summed with a
+ * constant trip count, which lets the compiler vectorize them without
+ * a scalar epilogue.
+ */
+#define LTTNG_COUNTER_RANGE_SUM(type)						\
+static inline									\
+void lttng_counter_range_sum_##type(int64_t * restrict sums,			\
+		const type * restrict p, size_t nr_elem)			\
+{										\
+	size_t i;								\
+										\
+	if (caa_likely(nr_elem == COUNTER_RANGE_CHUNK)) {			\
+		for (i = 0; i < COUNTER_RANGE_CHUNK; i++)			\
+			sums[i] += p[i];					\
+	} else {								\
+		for (i = 0; i < nr_elem; i++)					\
+			sums[i] += p[i];					\
+	}									\
+}
+
+LTTNG_COUNTER_RANGE_SUM(int8_t)
+LTTNG_COUNTER_RANGE_SUM(int16_t)
+LTTNG_COUNTER_RANGE_SUM(int32_t)
+
+#if CAA_BITS_PER_LONG == 64
+/*
+ * Only 64-bit counters can wrap the 64-bit sums, which is tracked in
+ * @overflow and @underflow.
+ */
+static inline
+void __lttng_counter_range_sum_int64_t(int64_t * restrict sums,
+		const int64_t * restrict p, size_t nr_elem,
+		uint8_t * restrict overflow, uint8_t * restrict underflow)
+{
+	size_t i;
+
+	for (i = 0; i < nr_elem; i++) {
+		/* Overflow is defined on unsigned types. */
+		uint64_t old = (uint64_t) sums[i], v = (uint64_t) p[i];
+		uint64_t sum = old + v;
+		uint8_t wrap = ((old ^ sum) & (v ^ sum)) >> 63;
+
+		overflow[i] |= wrap & ~(v >> 63);
+		underflow[i] |= wrap & (v >> 63);
+		sums[i] = (int64_t) sum;
+	}
+}
+
+static
+void lttng_counter_range_sum_int64_t(int64_t *sums, const int64_t *p,
+		size_t nr_elem, uint8_t *overflow, uint8_t *underflow)
+{
+	if (caa_likely(nr_elem == COUNTER_RANGE_CHUNK))
+		__lttng_counter_range_sum_int64_t(sums, p, COUNTER_RANGE_CHUNK,
+				overflow, underflow);
+	else
+		__lttng_counter_range_sum_int64_t(sums, p, nr_elem,
+				overflow, underflow);
+}
+#endif
+
+/*
+ * Same as the column sums above, exchanging each counter with zero.
+ * Counters which read as zero are not exchanged, which keeps the cache
+ * lines of unused counters shared with the writing CPUs.
+ */
+#define LTTNG_COUNTER_RANGE_XCHG_SUM(type)					\
+static inline									\
+void lttng_counter_range_xchg_sum_##type(int64_t *sums, type *p,		\
+		size_t nr_elem)							\
+{										\
+	size_t i;								\
+										\
+	for (i = 0; i < nr_elem; i++) {						\
+		if (CMM_LOAD_SHARED(p[i]))					\
+			sums[i] += uatomic_xchg(&p[i], 0);			\
+	}									\
+}
+
+LTTNG_COUNTER_RANGE_XCHG_SUM(int8_t)
+LTTNG_COUNTER_RANGE_XCHG_SUM(int16_t)
+LTTNG_COUNTER_RANGE_XCHG_SUM(int32_t)
+
+#if CAA_BITS_PER_LONG == 64
+static
+void lttng_counter_range_xchg_sum_int64_t(int64_t *sums, int64_t *p,
+		size_t nr_elem, uint8_t *overflow, uint8_t *underflow)
+{
+	size_t i;
+
+	for (i = 0; i < nr_elem; i++) {
+		uint64_t old, v, sum;
+		uint8_t wrap;
+
+		if (!CMM_LOAD_SHARED(p[i]))
+			continue;
+		/* Overflow is defined on unsigned types. */
+		old = (uint64_t) sums[i];
+		v = (uint64_t) uatomic_xchg(&p[i], 0);
+		sum = old + v;
+		wrap = ((old ^ sum) & (v ^ sum)) >> 63;
+		overflow[i] |= wrap & ~(v >> 63);
+		underflow[i] |= wrap & (v >> 63);
+		sums[i] = (int64_t) sum;
+	}
+}
+#endif
+
+/*
+ * Add counters [index, index + nr_elem) of @layout to @sums, exchanging
+ * them with zero if @reset is set.
+ */
+static
+int lttng_counter_range_accumulate(const struct lib_counter_config *config,
+				   struct lib_counter_layout *layout,
+				   size_t index, size_t nr_elem, bool reset,
+				   int64_t *sums, uint8_t *overflow,
+				   uint8_t *underflow)
+{
+	if (reset) {
+		switch (config->counter_size) {
+		case COUNTER_SIZE_8_BIT:
+			lttng_counter_range_xchg_sum_int8_t(sums,
+				(int8_t *) layout->counters + index, nr_elem);
+			return 0;
+		case COUNTER_SIZE_16_BIT:
+			lttng_counter_range_xchg_sum_int16_t(sums,
+				(int16_t *) layout->counters + index, nr_elem);
+			return 0;
+		case COUNTER_SIZE_32_BIT:
+			lttng_counter_range_xchg_sum_int32_t(sums,
+				(int32_t *) layout->counters + index, nr_elem);
+			return 0;
+#if CAA_BITS_PER_LONG == 64
+		case COUNTER_SIZE_64_BIT:
+			lttng_counter_range_xchg_sum_int64_t(sums,
+				(int64_t *) layout->counters + index, nr_elem,
+				overflow, underflow);
+			return 0;
+#endif
+		default:
+			return -EINVAL;
+		}
+	}
+	switch (config->counter_size) {
+	case COUNTER_SIZE_8_BIT:
+		lttng_counter_range_sum_int8_t(sums,
+			(const int8_t *) layout->counters + index, nr_elem);
+		break;
+	case COUNTER_SIZE_16_BIT:
+		lttng_counter_range_sum_int16_t(sums,
+			(const int16_t *) layout->counters + index, nr_elem);
+		break;
+	case COUNTER_SIZE_32_BIT:
+		lttng_counter_range_sum_int32_t(sums,
+			(const int32_t *) layout->counters + index, nr_elem);
+		break;
+#if CAA_BITS_PER_LONG == 64
+	case COUNTER_SIZE_64_BIT:
+		lttng_counter_range_sum_int64_t(sums,
+			(const int64_t *) layout->counters + index, nr_elem,
+			overflow, underflow);
+		break;
+#endif
+	default:
+		return -EINVAL;
+	}
+	return 0;
+}
+
+/*
+ * OR the overflow and underflow bits of counters [start, start + len)
+ * of @layout into @of_words and @uf_words, clearing them if @reset is
+ * set.
+ */
+static
+void lttng_counter_range_flags(struct lib_counter *counter,
+			       struct lib_counter_layout *layout,
+			       size_t start, size_t len, bool reset,
+			       unsigned long *of_words, unsigned long *uf_words)
+{
+	if (reset) {
+		lttng_counter_bitmap_xchg_range(of_words,
+				layout->overflow_bitmap, start, len);
+		lttng_counter_bitmap_xchg_range(uf_words,
+				layout->underflow_bitmap, start, len);
+	} else {
+		lttng_counter_bitmap_or_range(of_words, layout->overflow_bitmap,
+				counter->allocated_elem, start, len);
+		lttng_counter_bitmap_or_range(uf_words, layout->underflow_bitmap,
+				counter->allocated_elem, start, len);
+	}
+}
+
+static
+int lttng_counter_range_sum(const struct lib_counter_config *config,
+			    struct lib_counter *counter,
+			    const size_t *dimension_indexes, size_t nr_elem,
+			    int cpu, bool all_cpus, bool reset,
+			    int64_t *values, bool *overflow, bool *underflow)
+{
+	unsigned long of_words[COUNTER_RANGE_CHUNK / CAA_BITS_PER_LONG];
+	unsigned long uf_words[COUNTER_RANGE_CHUNK / CAA_BITS_PER_LONG];
+	uint8_t of_sums[COUNTER_RANGE_CHUNK], uf_sums[COUNTER_RANGE_CHUNK];
+	size_t index, done, len, i;
+	int ret;
+
+	if (caa_unlikely(lttng_counter_validate_indexes(config, counter, dimension_indexes)))
+		return -EOVERFLOW;
+	index = lttng_counter_get_index(config, counter, dimension_indexes);
+	if (nr_elem > (size_t) counter->allocated_elem - index)
+		return -EOVERFLOW;
+
+	for (done = 0; done < nr_elem; done += len) {
+		size_t start = index + done;
+		int64_t *sums = values + done;
+
+		len = nr_elem - done;
+		if (len > COUNTER_RANGE_CHUNK)
+			len = COUNTER_RANGE_CHUNK;
+		memset(sums, 0, len * sizeof(*sums));
+		memset(of_words, 0, sizeof(of_words));
+		memset(uf_words, 0, sizeof(uf_words));
+		memset(of_sums, 0, len);
+		memset(uf_sums, 0, len);
+
+		if (!all_cpus || (config->alloc & COUNTER_ALLOC_GLOBAL)) {
+			struct lib_counter_layout *layout;
+
+			layout = lttng_counter_get_layout(config, counter,
+					all_cpus ? -1 : cpu);
+			if (caa_unlikely(!layout))
+				return -EINVAL;
+			if (caa_unlikely(!layout->counters))
+				return -ENODEV;
+			ret = lttng_counter_range_accumulate(config, layout,
+					start, len, reset, sums, of_sums, uf_sums);
+			if (ret < 0)
+				return ret;
+			lttng_counter_range_flags(counter, layout, start, len,
+					reset, of_words, uf_words);
+		}
+		if (all_cpus && (config->alloc & COUNTER_ALLOC_PER_CPU)) {
+			int c;
+
+			lttng_counter_for_each_possible_cpu(c) {
+				struct lib_counter_layout *layout = &counter->percpu_counters[c];
+
+				if (caa_unlikely(!layout->counters))
+					return -ENODEV;
+				ret = lttng_counter_range_accumulate(config, layout,
+						start, len, reset, sums, of_sums, uf_sums);
+				if (ret < 0)
+					return ret;
+				lttng_counter_range_flags(counter, layout, start, len,
+						reset, of_words, uf_words);
+			}
+		}
+		/* Re-arm the thresholds once the whole sums are reset. */
+		if (reset && counter->global_counters.threshold_bitmap)
+			lttng_counter_bitmap_xchg_range(NULL,
+					counter->global_counters.threshold_bitmap,
+					start, len);
+
+		/* Flags are 0 or 1, the representation of bool. */
+		for (i = 0; i < len; i += CAA_BITS_PER_LONG) {
+			unsigned long of_word = of_words[i / CAA_BITS_PER_LONG];
+			unsigned long uf_word = uf_words[i / CAA_BITS_PER_LONG];
+			size_t j, nr_bits = len - i;
+
+			if (nr_bits > CAA_BITS_PER_LONG)
+				nr_bits = CAA_BITS_PER_LONG;
+			memcpy(overflow + done + i, of_sums + i, nr_bits);
+			memcpy(underflow + done + i, uf_sums + i, nr_bits);
+			for (j = 0; of_word && j < nr_bits; j++, of_word >>= 1)
+				overflow[done + i + j] |= of_word & 0x1;
+			for (j = 0; uf_word && j < nr_bits; j++, uf_word >>= 1)
+				underflow[done + i + j] |= uf_word & 0x1;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Read @nr_elem consecutive counters of @cpu (-1 for the global
+ * counters), starting at @dimension_indexes, in index order: the last
+ * dimension varies fastest. The range may span several rows of the
+ * outer dimensions.
+ */
+int lttng_counter_read_range(const struct lib_counter_config *config,
+			     struct lib_counter *counter,
+			     const size_t *dimension_indexes, size_t nr_elem,
+			     int cpu, int64_t *values,
+			     bool *overflow, bool *underflow)
+{
+	return lttng_counter_range_sum(config, counter, dimension_indexes,
+			nr_elem, cpu, false, false, values, overflow, underflow);
+}
+
+/*
+ * Same as lttng_counter_aggregate() for @nr_elem consecutive counters
+ * starting at @dimension_indexes, in the order of
+ * lttng_counter_read_range().
+ */
+int lttng_counter_aggregate_range(const struct lib_counter_config *config,
+				  struct lib_counter *counter,
+				  const size_t *dimension_indexes, size_t nr_elem,
+				  int64_t *values,
+				  bool *overflow, bool *underflow)
+{
+	switch (config->alloc) {
+	case COUNTER_ALLOC_GLOBAL:
+	case COUNTER_ALLOC_PER_CPU:
+	case COUNTER_ALLOC_PER_CPU | COUNTER_ALLOC_GLOBAL:
+		break;
+	default:
+		return -EINVAL;
+	}
+	return lttng_counter_range_sum(config, counter, dimension_indexes,
+			nr_elem, -1, true, false, values, overflow, underflow);
+}
+
+/*
+ * Aggregate @nr_elem consecutive counters like
+ * lttng_counter_aggregate_range() and reset them: each global and
+ * per-CPU counter is exchanged with zero, so @deltas holds the counts
+ * since the previous reset, in a single pass. Increments racing with
+ * the exchange are returned by the next call, so successive deltas add
+ * up to the exact counts. The overflow and underflow bits are returned
+ * and cleared, and the thresholds of the elements are re-armed.
+ *
+ * A carry of the global sum step racing with the reset may be split
+ * across two calls: the withdrawal from the per-CPU counter and the add
+ * to the global counter are returned by different calls. A delta may
+ * then be off by up to global_sum_step / 2 per carry, possibly
+ * negative, compensated by the next delta.
+ */
+int lttng_counter_aggregate_delta_range(const struct lib_counter_config *config,
+					struct lib_counter *counter,
+					const size_t *dimension_indexes, size_t nr_elem,
+					int64_t *deltas,
+					bool *overflow, bool *underflow)
+{
+	switch (config->alloc) {
+	case COUNTER_ALLOC_GLOBAL:
+	case COUNTER_ALLOC_PER_CPU:
+	case COUNTER_ALLOC_PER_CPU | COUNTER_ALLOC_GLOBAL:
+		break;
+	default:
+		return -EINVAL;
+	}
+	return lttng_counter_range_sum(config, counter, dimension_indexes,
+			nr_elem, -1, true, true, deltas, overflow, underflow);
+}
+
 static
 int lttng_counter_clear_cpu(const struct lib_counter_config *config,
 			    struct lib_counter *counter,
@@ -560,5 +1029,108 @@ int lttng_counter_clear(const struct lib_counter_config *config,
 	default:
 		return -EINVAL;
 	}
+	/* Re-arm the threshold once the whole sum is cleared. */
+	if (counter->global_counters.threshold_bitmap) {
+		size_t index = lttng_counter_get_index(config, counter, dimension_indexes);
+
+		lttng_bitmap_clear_bit(index, counter->global_counters.threshold_bitmap);
+	}
 	return 0;
 }
+
+static
+bool lttng_counter_has_global_sum_step(const struct lib_counter_config *config,
+				       struct lib_counter *counter)
+{
+	switch (config->counter_size) {
+	case COUNTER_SIZE_8_BIT:
+		return counter->global_sum_step.s8 != 0;
+	case COUNTER_SIZE_16_BIT:
+		return counter->global_sum_step.s16 != 0;
+	case COUNTER_SIZE_32_BIT:
+		return counter->global_sum_step.s32 != 0;
+	case COUNTER_SIZE_64_BIT:
+		return counter->global_sum_step.s64 != 0;
+	default:
+		return false;
+	}
+}
+
+int lttng_counter_set_threshold(const struct lib_counter_config *config,
+				struct lib_counter *counter,
+				int64_t threshold,
+				lib_counter_threshold_cb cb, void *priv)
+{
+	if (!cb)
+		return -EINVAL;
+	if (config->alloc != (COUNTER_ALLOC_PER_CPU | COUNTER_ALLOC_GLOBAL))
+		return -EINVAL;
+	/* Without carry, the threshold would never be evaluated. */
+	if (!lttng_counter_has_global_sum_step(config, counter))
+		return -EINVAL;
+	if (counter->threshold.cb)
+		return -EBUSY;
+	counter->threshold.value = threshold;
+	counter->threshold.priv = priv;
+	/*
+	 * Order the threshold before its callback is published. Paired
+	 * with the barrier in lttng_counter_check_threshold().
+	 */
+	cmm_smp_wmb();
+	CMM_STORE_SHARED(counter->threshold.cb, cb);
+	return 0;
+}
+
+/*
+ * Set a bit of a shared bitmap, returning whether it was already set,
+ * so that a single add among the concurrent ones calls the callback.
+ */
+static
+bool lttng_counter_bitmap_test_and_set_bit(size_t index, unsigned long *p)
+{
+	unsigned long *word = p + index / CAA_BITS_PER_LONG;
+	unsigned long mask = 1UL << (index % CAA_BITS_PER_LONG);
+	unsigned long old, v;
+
+	old = uatomic_read(word);
+	do {
+		if (old & mask)
+			return true;
+		v = old;
+		old = uatomic_cmpxchg(word, v, v | mask);
+	} while (old != v);
+	return false;
+}
+
+/*
+ * Called on the add path, after a carry into the global counter. The
+ * per-CPU counters of the element are only summed while its threshold
+ * is armed, once every global_sum_step / 2 adds on each CPU at most.
+ */
+void lttng_counter_check_threshold(const struct lib_counter_config *config,
+				   struct lib_counter *counter,
+				   const size_t *dimension_indexes)
+{
+	unsigned long *bitmap = counter->global_counters.threshold_bitmap;
+	lib_counter_threshold_cb cb;
+	bool overflow, underflow;
+	int64_t value;
+	size_t index;
+
+	cb = CMM_LOAD_SHARED(counter->threshold.cb);
+	/* Paired with the barrier in lttng_counter_set_threshold(). */
+	cmm_smp_rmb();
+	if (caa_unlikely(!cb || !bitmap))
+		return;
+	index = lttng_counter_get_index(config, counter, dimension_indexes);
+	if (lttng_bitmap_test_bit(index, bitmap))
+		return;
+	if (lttng_counter_aggregate(config, counter, dimension_indexes,
+			&value, &overflow, &underflow))
+		return;
+	if (value < counter->threshold.value)
+		return;
+	if (lttng_counter_bitmap_test_and_set_bit(index, bitmap))
+		return;
+	cb(counter, dimension_indexes, value, counter->threshold.priv);
+}
@@ -58,8 +58,38 @@ int lttng_counter_aggregate(const struct lib_counter_config *config,
 			    const size_t *dimension_indexes,
 			    int64_t *value,
 			    bool *overflow, bool *underflow);
+int lttng_counter_read_range(const struct lib_counter_config *config,
+			     struct lib_counter *counter,
+			     const size_t *dimension_indexes, size_t nr_elem,
+			     int cpu, int64_t *values,
+			     bool *overflow, bool *underflow);
+int lttng_counter_aggregate_range(const struct lib_counter_config *config,
+				  struct lib_counter *counter,
+				  const size_t *dimension_indexes, size_t nr_elem,
+				  int64_t *values,
+				  bool *overflow, bool *underflow);
+int lttng_counter_aggregate_delta_range(const struct lib_counter_config *config,
+					struct lib_counter *counter,
+					const size_t *dimension_indexes, size_t nr_elem,
+					int64_t *deltas,
+					bool *overflow, bool *underflow);
 int lttng_counter_clear(const struct lib_counter_config *config,
 			struct lib_counter *counter,
 			const size_t *dimension_indexes);
 
+/*
+ * Only for counters with per-CPU and global allocation, and a non-zero
+ * global sum step: the threshold is evaluated when the per-CPU counter
+ * of an element carries into the global counter, which keeps it off
+ * the other adds. The callback may therefore run up to nr_cpus *
+ * global_sum_step after the sum reached the threshold.
+ */
+int lttng_counter_set_threshold(const struct lib_counter_config *config,
+				struct lib_counter *counter,
+				int64_t threshold,
+				lib_counter_threshold_cb cb, void *priv);
+void lttng_counter_check_threshold(const struct lib_counter_config *config,
+				   struct lib_counter *counter,
+				   const size_t *dimension_indexes);
+
 #endif /* _LTTNG_COUNTER_H */
@@ -30,7 +30,7 @@
 
 #include <urcu/arch.h>
 #include <urcu/system.h>
-#include "futex.h"
+#include "../liblttng-ust/futex.h"
 
 /*
  * Using attribute "weak" for __lttng_ust_compat_futex_lock and
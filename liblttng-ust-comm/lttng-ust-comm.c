@@ -1643,6 +1643,220 @@ error_fields:
 	return ret;
 }
 
+/*
+ * Returns 0 if the batch was processed by the session daemon, negative
+ * error value on error. The status of each registration is returned in
+ * its "ret_code" field.
+ */
+int ustcomm_register_events(int sock,
+	struct lttng_session *session,
+	int session_objd,		/* session descriptor */
+	size_t nr_events,
+	struct ustcomm_event_registration *events)
+{
+	ssize_t len;
+	struct {
+		struct ustcomm_notify_hdr header;
+		struct ustcomm_notify_events_msg m;
+	} msg;
+	struct {
+		struct ustcomm_notify_hdr header;
+		struct ustcomm_notify_events_reply r;
+	} reply;
+	struct {
+		struct ustctl_field *fields;
+		size_t nr_write_fields;
+	} *serialized = NULL;
+	struct ustcomm_notify_event_reply *event_replies = NULL;
+	size_t i, payload_len = 0, offset = 0;
+	char *payload = NULL;
+	int ret;
+
+	if (!nr_events)
+		return 0;
+	if (nr_events > USTCOMM_NOTIFY_EVENTS_MAX_BATCH)
+		return -EINVAL;
+
+	serialized = zmalloc(nr_events * sizeof(*serialized));
+	if (!serialized)
+		return -ENOMEM;
+
+	/* Serialize fields of each event once, and compute payload size. */
+	for (i = 0; i < nr_events; i++) {
+		struct ustcomm_event_registration *event = &events[i];
+
+		if (event->nr_fields > 0) {
+			ret = alloc_serialize_fields(session,
+					&serialized[i].nr_write_fields,
+					&serialized[i].fields,
+					event->nr_fields, event->fields);
+			if (ret)
+				goto error;
+		}
+		payload_len += sizeof(struct ustcomm_notify_event_msg);
+		payload_len += strlen(event->signature) + 1;
+		payload_len += sizeof(struct ustctl_field) * serialized[i].nr_write_fields;
+		if (event->model_emf_uri)
+			payload_len += strlen(event->model_emf_uri) + 1;
+	}
+	if (payload_len > USTCOMM_NOTIFY_EVENTS_MAX_PAYLOAD) {
+		ret = -EMSGSIZE;
+		goto error;
+	}
+
+	payload = zmalloc(payload_len);
+	if (!payload) {
+		ret = -ENOMEM;
+		goto error;
+	}
+	for (i = 0; i < nr_events; i++) {
+		struct ustcomm_event_registration *event = &events[i];
+		struct ustcomm_notify_event_msg m;
+		size_t signature_len, fields_len, model_emf_uri_len = 0;
+
+		signature_len = strlen(event->signature) + 1;
+		fields_len = sizeof(struct ustctl_field) * serialized[i].nr_write_fields;
+		if (event->model_emf_uri)
+			model_emf_uri_len = strlen(event->model_emf_uri) + 1;
+
+		memset(&m, 0, sizeof(m));
+		m.session_objd = session_objd;
+		m.channel_objd = event->channel_objd;
+		strncpy(m.event_name, event->event_name, LTTNG_UST_SYM_NAME_LEN);
+		m.event_name[LTTNG_UST_SYM_NAME_LEN - 1] = '\0';
+		m.loglevel = event->loglevel;
+		m.signature_len = signature_len;
+		m.fields_len = fields_len;
+		m.model_emf_uri_len = model_emf_uri_len;
+
+		memcpy(payload + offset, &m, sizeof(m));
+		offset += sizeof(m);
+		memcpy(payload + offset, event->signature, signature_len);
+		offset += signature_len;
+		if (fields_len) {
+			memcpy(payload + offset, serialized[i].fields, fields_len);
+			offset += fields_len;
+		}
+		if (model_emf_uri_len) {
+			memcpy(payload + offset, event->model_emf_uri,
+				model_emf_uri_len);
+			offset += model_emf_uri_len;
+		}
+	}
+	assert(offset == payload_len);
+
+	memset(&msg, 0, sizeof(msg));
+	msg.header.notify_cmd = USTCTL_NOTIFY_CMD_EVENTS;
+	msg.m.session_objd = session_objd;
+	msg.m.nr_events = nr_events;
+	msg.m.payload_len = payload_len;
+
+	len = ustcomm_send_unix_sock(sock, &msg, sizeof(msg));
+	if (len > 0 && len != sizeof(msg)) {
+		ret = -EIO;
+		goto error;
+	}
+	if (len < 0) {
+		ret = len;
+		goto error;
+	}
+
+	/* send all event descriptions */
+	len = ustcomm_send_unix_sock(sock, payload, payload_len);
+	if (len > 0 && len != payload_len) {
+		ret = -EIO;
+		goto error;
+	}
+	if (len < 0) {
+		ret = len;
+		goto error;
+	}
+
+	/* receive reply */
+	len = ustcomm_recv_unix_sock(sock, &reply, sizeof(reply));
+	switch (len) {
+	case 0:	/* orderly shutdown */
+		ret = -EPIPE;
+		goto error;
+	case sizeof(reply):
+		if (reply.header.notify_cmd != msg.header.notify_cmd) {
+			ERR("Unexpected result message command "
+				"expected: %u vs received: %u\n",
+				msg.header.notify_cmd, reply.header.notify_cmd);
+			ret = -EINVAL;
+			goto error;
+		}
+		if (reply.r.ret_code > 0) {
+			ret = -EINVAL;
+			goto error;
+		}
+		if (reply.r.ret_code < 0) {
+			ret = reply.r.ret_code;
+			goto error;
+		}
+		if (reply.r.nr_events != nr_events) {
+			ERR("Unexpected number of event replies "
+				"expected: %zu vs received: %u\n",
+				nr_events, reply.r.nr_events);
+			ret = -EINVAL;
+			goto error;
+		}
+		break;
+	default:
+		if (len < 0) {
+			/* Transport level error */
+			if (errno == EPIPE || errno == ECONNRESET)
+				len = -errno;
+			ret = len;
+		} else {
+			ERR("incorrect message size: %zd\n", len);
+			ret = -EINVAL;
+		}
+		goto error;
+	}
+
+	event_replies = zmalloc(nr_events * sizeof(*event_replies));
+	if (!event_replies) {
+		ret = -ENOMEM;
+		goto error;
+	}
+	len = ustcomm_recv_unix_sock(sock, event_replies,
+			nr_events * sizeof(*event_replies));
+	if (len == 0) {
+		ret = -EPIPE;
+		goto error;
+	}
+	if (len < 0) {
+		ret = len;
+		goto error;
+	}
+	if (len != nr_events * sizeof(*event_replies)) {
+		ret = -EIO;
+		goto error;
+	}
+	for (i = 0; i < nr_events; i++) {
+		struct ustcomm_event_registration *event = &events[i];
+
+		if (event_replies[i].ret_code > 0)
+			event->ret_code = -EINVAL;
+		else
+			event->ret_code = event_replies[i].ret_code;
+		event->id = event_replies[i].event_id;
+		DBG("Sent bulk register event notification for name \"%s\": ret_code %d, event_id %u\n",
+			event->event_name, event_replies[i].ret_code,
+			event_replies[i].event_id);
+	}
+	ret = 0;
+
+error:
+	free(event_replies);
+	free(payload);
+	for (i = 0; i < nr_events; i++)
+		free(serialized[i].fields);
+	free(serialized);
+	return ret;
+}
+
 /*
  * Returns 0 on success, negative error value on error.
  * Returns -EPIPE or -ECONNRESET if other end has hung up.
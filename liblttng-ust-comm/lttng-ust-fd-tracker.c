@@ -33,9 +33,11 @@
 #include <pthread.h>
 #include <signal.h>
 #include <stdbool.h>
+#include <urcu/arch.h>
 #include <urcu/compiler.h>
 #include <urcu/tls-compat.h>
 #include <urcu/system.h>
+#include <urcu/uatomic.h>
 
 #include <ust-fd.h>
 #include <helper.h>
@@ -43,6 +45,7 @@
 #include <usterr-signal-safe.h>
 
 #include "../liblttng-ust/compat.h"
+#include "../liblttng-ust/futex.h"
 
 /* Operations on the fd set. */
 #define IS_FD_VALID(fd)			((fd) >= 0 && (fd) < lttng_ust_max_fd)
@@ -82,6 +85,40 @@ static int ust_safe_guard_saved_cancelstate;
  */
 static DEFINE_URCU_TLS(int, ust_fd_mutex_nest);
 
+/*
+ * Application close() and fclose() calls do not take the
+ * ust_safe_guard_fd_mutex in the common case. Instead, they announce
+ * themselves in ust_fd_closers, then check ust_fd_tracker_active:
+ *
+ * - If it is not set, lttng-ust is not opening or closing fds. The
+ *   fd set is checked and the fd closed without lock. lttng-ust waits
+ *   for the announced closers to complete before touching its fds.
+ * - Otherwise, the closer withdraws its announcement, and falls back
+ *   to checking the fd set with ust_safe_guard_fd_mutex held.
+ *
+ * ust_fd_tracker_active counts the threads within their outermost
+ * lttng_ust_lock_fd_tracker(), which releases the mutex while waiting
+ * for closers, so that a closer nested in a signal handler interrupting
+ * an announced closer on the same thread can take the mutex rather
+ * than deadlock. Another lttng-ust thread may therefore own the mutex
+ * in the meantime, hence the count.
+ *
+ * The lttng-ust threads waiting for closers sleep on the
+ * ust_fd_closers futex, and announce themselves in
+ * ust_fd_closers_waiters so that closers only issue a futex wake-up
+ * when someone waits.
+ */
+static long ust_fd_tracker_active;
+static int32_t ust_fd_closers;
+static int ust_fd_closers_waiters;
+
+/*
+ * Number of closers announced by the current thread, which may be
+ * interrupted by a signal handler calling fork(). Incremented before
+ * and decremented after ust_fd_closers, so it never under-counts.
+ */
+static DEFINE_URCU_TLS(int, ust_fd_close_nest);
+
 /* fd_set used to book keep fd being used by lttng-ust. */
 static fd_set *lttng_fd_set;
 static int lttng_ust_max_fd;
@@ -94,6 +131,7 @@ static int init_done;
 void lttng_ust_fixup_fd_tracker_tls(void)
 {
 	asm volatile ("" : : "m" (URCU_TLS(ust_fd_mutex_nest)));
+	asm volatile ("" : : "m" (URCU_TLS(ust_fd_close_nest)));
 }
 
 /*
@@ -135,7 +173,8 @@ void lttng_ust_init_fd_tracker(void)
 	CMM_STORE_SHARED(init_done, 1);
 }
 
-void lttng_ust_lock_fd_tracker(void)
+static
+void lock_fd_tracker_mutex(void)
 {
 	sigset_t sig_all_blocked, orig_mask;
 	int ret, oldstate;
@@ -164,7 +203,8 @@ void lttng_ust_lock_fd_tracker(void)
 	}
 }
 
-void lttng_ust_unlock_fd_tracker(void)
+static
+void unlock_fd_tracker_mutex(void)
 {
 	sigset_t sig_all_blocked, orig_mask;
 	int ret, newstate, oldstate;
@@ -197,6 +237,120 @@ void lttng_ust_unlock_fd_tracker(void)
 	}
 }
 
+/*
+ * Wait for the application closers which did not see
+ * ust_fd_tracker_active. Called with ust_safe_guard_fd_mutex held,
+ * which is released while waiting. Closers announced by the current
+ * thread, interrupted by the signal handler we are running from, are
+ * not waited for.
+ */
+static
+void wait_fd_closers(void)
+{
+	int32_t closers;
+	int cancelstate;
+
+	uatomic_inc(&ust_fd_closers_waiters);
+	/*
+	 * Order the ust_fd_tracker_active and ust_fd_closers_waiters
+	 * increments before loading closers.
+	 */
+	cmm_smp_mb();
+	while ((closers = uatomic_read(&ust_fd_closers))
+			> URCU_TLS(ust_fd_close_nest)) {
+		/* Protected by the mutex, which other threads may take. */
+		cancelstate = ust_safe_guard_saved_cancelstate;
+		pthread_mutex_unlock(&ust_safe_guard_fd_mutex);
+		if (lttng_ust_futex_async(&ust_fd_closers, FUTEX_WAIT,
+				closers, NULL, NULL, 0)) {
+			switch (errno) {
+			case EAGAIN:	/* Value changed before waiting. */
+			case EINTR:	/* Retry if interrupted by signal. */
+				break;
+			default:
+				PERROR("futex");
+				break;
+			}
+		}
+		pthread_mutex_lock(&ust_safe_guard_fd_mutex);
+		ust_safe_guard_saved_cancelstate = cancelstate;
+	}
+	uatomic_dec(&ust_fd_closers_waiters);
+}
+
+/*
+ * Withdraw an application closer announcement, and wake up the
+ * lttng-ust threads waiting for closers, if any.
+ */
+static
+void put_fd_closer(void)
+{
+	cmm_smp_mb__before_uatomic_dec();
+	uatomic_dec(&ust_fd_closers);
+	/* Order the closers decrement before loading the waiters. */
+	cmm_smp_mb__after_uatomic_dec();
+	if (caa_unlikely(CMM_LOAD_SHARED(ust_fd_closers_waiters))) {
+		if (lttng_ust_futex_async(&ust_fd_closers, FUTEX_WAKE,
+				INT_MAX, NULL, NULL, 0) < 0)
+			PERROR("futex wake");
+	}
+	cmm_barrier();
+	URCU_TLS(ust_fd_close_nest)--;
+}
+
+void lttng_ust_lock_fd_tracker(void)
+{
+	lock_fd_tracker_mutex();
+	if (URCU_TLS(ust_fd_mutex_nest) == 1) {
+		uatomic_inc(&ust_fd_tracker_active);
+		wait_fd_closers();
+	}
+}
+
+void lttng_ust_unlock_fd_tracker(void)
+{
+	if (URCU_TLS(ust_fd_mutex_nest) == 1) {
+		/* Order the fd set updates before the decrement. */
+		cmm_smp_mb__before_uatomic_dec();
+		uatomic_dec(&ust_fd_tracker_active);
+	}
+	unlock_fd_tracker_mutex();
+}
+
+/*
+ * Announce an application closer. Returns true if the fd set can be
+ * checked without lock, in which case close_fd_end() must be called
+ * after closing. Returns false if the mutex must be taken instead.
+ */
+static
+bool close_fd_begin(void)
+{
+	URCU_TLS(ust_fd_close_nest)++;
+	cmm_barrier();
+	uatomic_inc(&ust_fd_closers);
+	cmm_smp_mb__after_uatomic_inc();
+	if (caa_likely(!CMM_LOAD_SHARED(ust_fd_tracker_active)))
+		return true;
+	put_fd_closer();
+	return false;
+}
+
+static
+void close_fd_end(void *arg __attribute__((unused)))
+{
+	put_fd_closer();
+}
+
+/*
+ * Called in the child after fork, with the fd tracker lock held. Only
+ * the closers announced by the forking thread remain.
+ */
+void lttng_ust_fd_tracker_after_fork_child(void)
+{
+	uatomic_set(&ust_fd_closers, URCU_TLS(ust_fd_close_nest));
+	uatomic_set(&ust_fd_closers_waiters, 0);
+}
+
 static int dup_std_fd(int fd)
 {
 	int ret, i;
@@ -350,14 +504,27 @@ int lttng_ust_safe_close_fd(int fd, int (*close_cb)(int fd))
 	if (URCU_TLS(ust_fd_mutex_nest))
 		return close_cb(fd);
 
-	lttng_ust_lock_fd_tracker();
+	if (close_fd_begin()) {
+		/* close() is a cancellation point. */
+		pthread_cleanup_push(close_fd_end, NULL);
+		if (IS_FD_VALID(fd) && IS_FD_SET(fd, lttng_fd_set)) {
+			ret = -1;
+			errno = EBADF;
+		} else {
+			ret = close_cb(fd);
+		}
+		pthread_cleanup_pop(1);
+		return ret;
+	}
+
+	lock_fd_tracker_mutex();
 	if (IS_FD_VALID(fd) && IS_FD_SET(fd, lttng_fd_set)) {
 		ret = -1;
 		errno = EBADF;
 	} else {
 		ret = close_cb(fd);
 	}
-	lttng_ust_unlock_fd_tracker();
+	unlock_fd_tracker_mutex();
 
 	return ret;
 }
@@ -388,14 +555,27 @@ int lttng_ust_safe_fclose_stream(FILE *stream, int (*fclose_cb)(FILE *stream))
 
 	fd = fileno(stream);
 
-	lttng_ust_lock_fd_tracker();
+	if (close_fd_begin()) {
+		/* fclose() is a cancellation point. */
+		pthread_cleanup_push(close_fd_end, NULL);
+		if (IS_FD_VALID(fd) && IS_FD_SET(fd, lttng_fd_set)) {
+			ret = -1;
+			errno = EBADF;
+		} else {
+			ret = fclose_cb(stream);
+		}
+		pthread_cleanup_pop(1);
+		return ret;
+	}
+
+	lock_fd_tracker_mutex();
 	if (IS_FD_VALID(fd) && IS_FD_SET(fd, lttng_fd_set)) {
 		ret = -1;
 		errno = EBADF;
 	} else {
 		ret = fclose_cb(stream);
 	}
-	lttng_ust_unlock_fd_tracker();
+	unlock_fd_tracker_mutex();
 
 	return ret;
 }
@@ -461,7 +641,7 @@ int lttng_ust_safe_closefrom_fd(int lowfd, int (*close_cb)(int fd))
 			set_close_success(&close_success);
 		}
 	} else {
-		lttng_ust_lock_fd_tracker();
+		lock_fd_tracker_mutex();
 		for (i = lowfd; i < lttng_ust_max_fd; i++) {
 			if (IS_FD_VALID(i) && IS_FD_SET(i, lttng_fd_set))
 				continue;
@@ -472,13 +652,13 @@ int lttng_ust_safe_closefrom_fd(int lowfd, int (*close_cb)(int fd))
 				case EINTR:
 				default:
 					ret = -1;
-					lttng_ust_unlock_fd_tracker();
+					unlock_fd_tracker_mutex();
 					goto end;
 				}
 			}
 			set_close_success(&close_success);
 		}
-		lttng_ust_unlock_fd_tracker();
+		unlock_fd_tracker_mutex();
 	}
 	if (!test_close_success(&close_success)) {
 		/*
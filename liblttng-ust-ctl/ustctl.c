@@ -94,15 +94,21 @@ extern void lttng_ring_buffer_client_overwrite_rt_init(void);
 extern void lttng_ring_buffer_client_discard_init(void);
 extern void lttng_ring_buffer_client_discard_rt_init(void);
 extern void lttng_ring_buffer_metadata_client_init(void);
+extern void lttng_ring_buffer_notification_client_init(void);
 extern void lttng_ring_buffer_client_overwrite_exit(void);
 extern void lttng_ring_buffer_client_overwrite_rt_exit(void);
 extern void lttng_ring_buffer_client_discard_exit(void);
 extern void lttng_ring_buffer_client_discard_rt_exit(void);
 extern void lttng_ring_buffer_metadata_client_exit(void);
+extern void lttng_ring_buffer_notification_client_exit(void);
 extern void lttng_counter_client_percpu_32_modular_init(void);
 extern void lttng_counter_client_percpu_32_modular_exit(void);
 extern void lttng_counter_client_percpu_64_modular_init(void);
 extern void lttng_counter_client_percpu_64_modular_exit(void);
+extern void lttng_counter_client_percpu_global_32_modular_init(void);
+extern void lttng_counter_client_percpu_global_32_modular_exit(void);
+extern void lttng_counter_client_percpu_global_64_modular_init(void);
+extern void lttng_counter_client_percpu_global_64_modular_exit(void);
 
 int ustctl_release_handle(int sock, int handle)
 {
@@ -604,6 +610,73 @@ int ustctl_create_event_notifier(int sock, struct lttng_ust_event_notifier *even
 	return ret;
 }
 
+int ustctl_set_session_action(int sock,
+		struct lttng_ust_object_data *event_notifier_data,
+		int session_handle, uint32_t ops, uint32_t freeze_id)
+{
+	struct ustcomm_ust_msg lum;
+	struct ustcomm_ust_reply lur;
+	int ret;
+
+	if (!event_notifier_data)
+		return -EINVAL;
+
+	memset(&lum, 0, sizeof(lum));
+	lum.handle = event_notifier_data->handle;
+	lum.cmd = LTTNG_UST_SESSION_ACTION;
+	lum.u.session_action.session_handle = session_handle;
+	lum.u.session_action.ops = ops;
+	lum.u.session_action.freeze_id = freeze_id;
+	ret = ustcomm_send_app_cmd(sock, &lum, &lur);
+	if (ret)
+		return ret;
+	DBG("set session action of handle %u on session handle %d",
+		event_notifier_data->handle, session_handle);
+	return 0;
+}
+
+int ustctl_rearm_session_action(int sock,
+		struct lttng_ust_object_data *event_notifier_data)
+{
+	struct ustcomm_ust_msg lum;
+	struct ustcomm_ust_reply lur;
+	int ret;
+
+	if (!event_notifier_data)
+		return -EINVAL;
+
+	memset(&lum, 0, sizeof(lum));
+	lum.handle = event_notifier_data->handle;
+	lum.cmd = LTTNG_UST_SESSION_ACTION_REARM;
+	ret = ustcomm_send_app_cmd(sock, &lum, &lur);
+	if (ret)
+		return ret;
+	DBG("rearmed session action of handle %u", event_notifier_data->handle);
+	return 0;
+}
+
+int ustctl_set_map_threshold(int sock,
+		struct lttng_ust_object_data *event_notifier_data,
+		int64_t threshold)
+{
+	struct ustcomm_ust_msg lum;
+	struct ustcomm_ust_reply lur;
+	int ret;
+
+	if (!event_notifier_data)
+		return -EINVAL;
+
+	memset(&lum, 0, sizeof(lum));
+	lum.handle = event_notifier_data->handle;
+	lum.cmd = LTTNG_UST_MAP_THRESHOLD;
+	lum.u.map_threshold.value = threshold;
+	ret = ustcomm_send_app_cmd(sock, &lum, &lur);
+	if (ret)
+		return ret;
+	DBG("set map threshold of handle %u", event_notifier_data->handle);
+	return 0;
+}
+
 int ustctl_tracepoint_list(int sock)
 {
 	struct ustcomm_ust_msg lum;
@@ -1260,6 +1333,12 @@ struct ustctl_consumer_channel *
 		else
 			return NULL;
 		break;
+	case LTTNG_UST_CHAN_NOTIFICATION:
+		if (attr->output == LTTNG_UST_MMAP)
+			transport_name = "relay-notification-mmap";
+		else
+			return NULL;
+		break;
 	default:
 		transport_name = "<unknown>";
 		return NULL;
@@ -1334,6 +1413,102 @@ int ustctl_send_stream_to_sessiond(int sock,
 			0);
 }
 
+int ustctl_create_channel_data(struct ustctl_consumer_channel *channel,
+		struct lttng_ust_object_data **_channel_data)
+{
+	struct lttng_ust_object_data *channel_data;
+	struct shm_object_table *table;
+	int ret;
+
+	table = channel->chan->handle->table;
+	if (table->size <= 0)
+		return -EINVAL;
+	channel_data = zmalloc(sizeof(*channel_data));
+	if (!channel_data) {
+		ret = -ENOMEM;
+		goto error_alloc;
+	}
+	channel_data->type = LTTNG_UST_OBJECT_TYPE_CHANNEL;
+	channel_data->handle = -1;
+	channel_data->size = table->objects[0].memory_map_size;
+	channel_data->u.channel.type = channel->attr.type;
+	channel_data->u.channel.data = zmalloc(channel_data->size);
+	if (!channel_data->u.channel.data) {
+		ret = -ENOMEM;
+		goto error_alloc_data;
+	}
+	memcpy(channel_data->u.channel.data, table->objects[0].memory_map,
+		channel_data->size);
+	channel_data->u.channel.wakeup_fd = dup(channel->wakeup_fd);
+	if (channel_data->u.channel.wakeup_fd < 0) {
+		ret = -errno;
+		goto error_dup;
+	}
+	*_channel_data = channel_data;
+	return 0;
+
+error_dup:
+	free(channel_data->u.channel.data);
+error_alloc_data:
+	free(channel_data);
+error_alloc:
+	return ret;
+}
+
+int ustctl_create_stream_data(struct ustctl_consumer_stream *stream,
+		struct lttng_ust_object_data **_stream_data)
+{
+	struct lttng_ust_object_data *stream_data;
+	int ret;
+
+	stream_data = zmalloc(sizeof(*stream_data));
+	if (!stream_data) {
+		ret = -ENOMEM;
+		goto error_alloc;
+	}
+	stream_data->type = LTTNG_UST_OBJECT_TYPE_STREAM;
+	stream_data->handle = -1;
+	stream_data->size = stream->memory_map_size;
+	stream_data->u.stream.stream_nr = stream->cpu;
+	stream_data->u.stream.shm_fd = dup(stream->shm_fd);
+	if (stream_data->u.stream.shm_fd < 0) {
+		ret = -errno;
+		goto error_dup_shm;
+	}
+	stream_data->u.stream.wakeup_fd = dup(stream->wakeup_fd);
+	if (stream_data->u.stream.wakeup_fd < 0) {
+		ret = -errno;
+		goto error_dup_wakeup;
+	}
+	*_stream_data = stream_data;
+	return 0;
+
+error_dup_wakeup:
+	(void) close(stream_data->u.stream.shm_fd);
+error_dup_shm:
+	free(stream_data);
+error_alloc:
+	return ret;
+}
+
+int ustctl_ack_notification_wakeup(struct ustctl_consumer_channel *channel)
+{
+	struct lttng_notification_channel *notification_chan;
+
+	if (channel->attr.type != LTTNG_UST_CHAN_NOTIFICATION)
+		return -EINVAL;
+	notification_chan = caa_container_of(channel->chan,
+			struct lttng_notification_channel, parent);
+	uatomic_set(&notification_chan->wakeup_pending, 0);
+	/*
+	 * Order the clear of wakeup_pending before the reads of the
+	 * channel. Paired with the barrier preceding its load in
+	 * notification_channel_wakeup().
+	 */
+	cmm_smp_mb();
+	return 0;
+}
+
 int ustctl_write_metadata_to_channel(
 		struct ustctl_consumer_channel *channel,
 		const char *metadata_str,	/* NOT null-terminated */
@@ -1438,6 +1613,15 @@ int ustctl_channel_close_wakeup_fd(struct ustctl_consumer_channel *consumer_chan
 	return ret;
 }
 
+int ustctl_channel_thaw(struct ustctl_consumer_channel *consumer_chan,
+		uint32_t freeze_mask)
+{
+	if (!consumer_chan)
+		return -EINVAL;
+	lib_ring_buffer_channel_thaw(consumer_chan->chan->chan, freeze_mask);
+	return 0;
+}
+
 int ustctl_stream_close_wait_fd(struct ustctl_consumer_stream *stream)
 {
 	struct channel *chan;
@@ -1745,6 +1929,25 @@ int ustctl_snapshot_sample_positions(struct ustctl_consumer_stream *stream)
 			consumer_chan->chan->handle);
 }
 
+/*
+ * Use the positions sampled by a session action as snapshot positions.
+ * Returns -ENODATA if the positions have not been sampled since the
+ * action was armed.
+ */
+int ustctl_snapshot_sample_trigger_positions(struct ustctl_consumer_stream *stream)
+{
+	struct lttng_ust_lib_ring_buffer *buf;
+	struct ustctl_consumer_channel *consumer_chan;
+
+	if (!stream)
+		return -EINVAL;
+	buf = stream->buf;
+	consumer_chan = stream->chan;
+	return lib_ring_buffer_snapshot_trigger_positions(buf,
+			&buf->cons_snapshot, &buf->prod_snapshot,
+			consumer_chan->chan->handle);
+}
+
 /* Get the consumer position (iteration start) */
 int ustctl_snapshot_get_consumed(struct ustctl_consumer_stream *stream,
 		unsigned long *pos)
@@ -2108,6 +2311,9 @@ int ustctl_recv_notify(int sock, enum ustctl_notify_cmd *notify_cmd)
 	case 2:
 		*notify_cmd = USTCTL_NOTIFY_CMD_ENUM;
 		break;
+	case 3:
+		*notify_cmd = USTCTL_NOTIFY_CMD_EVENTS;
+		break;
 	default:
 		return -EINVAL;
 	}
@@ -2260,6 +2466,222 @@ int ustctl_reply_register_event(int sock,
 	return 0;
 }
 
+void ustctl_release_register_events(size_t nr_events,
+	struct ustctl_event_registration *events)
+{
+	size_t i;
+
+	if (!events)
+		return;
+	for (i = 0; i < nr_events; i++) {
+		free(events[i].signature);
+		free(events[i].fields);
+		free(events[i].model_emf_uri);
+	}
+	free(events);
+}
+
+/*
+ * Copy a NULL-terminated string of length "len" (including the final
+ * \0) from the payload. Returns NULL on allocation error.
+ */
+static
+char *dup_payload_string(const char *src, size_t len)
+{
+	char *str;
+
+	str = zmalloc(len);
+	if (!str)
+		return NULL;
+	memcpy(str, src, len);
+	/* Enforce end of string */
+	str[len - 1] = '\0';
+	return str;
+}
+
+/*
+ * Returns 0 on success, negative UST or system error value on error.
+ */
+int ustctl_recv_register_events(int sock,
+	int *session_objd,
+	size_t *nr_events,
+	struct ustctl_event_registration **events)
+{
+	ssize_t len;
+	struct ustcomm_notify_events_msg msg;
+	struct ustctl_event_registration *a_events = NULL;
+	char *payload = NULL;
+	size_t i, payload_len, offset = 0;
+	int ret;
+
+	len = ustcomm_recv_unix_sock(sock, &msg, sizeof(msg));
+	if (len > 0 && len != sizeof(msg))
+		return -EIO;
+	if (len == 0)
+		return -EPIPE;
+	if (len < 0)
+		return len;
+
+	if (msg.nr_events > USTCOMM_NOTIFY_EVENTS_MAX_BATCH
+			|| msg.payload_len > USTCOMM_NOTIFY_EVENTS_MAX_PAYLOAD)
+		return -EINVAL;
+	payload_len = msg.payload_len;
+
+	/* recv all event descriptions at once. */
+	if (payload_len) {
+		payload = zmalloc(payload_len);
+		if (!payload)
+			return -ENOMEM;
+		len = ustcomm_recv_unix_sock(sock, payload, payload_len);
+		if (len > 0 && len != payload_len) {
+			ret = -EIO;
+			goto error;
+		}
+		if (len == 0) {
+			ret = -EPIPE;
+			goto error;
+		}
+		if (len < 0) {
+			ret = len;
+			goto error;
+		}
+	}
+
+	if (msg.nr_events) {
+		a_events = zmalloc(msg.nr_events * sizeof(*a_events));
+		if (!a_events) {
+			ret = -ENOMEM;
+			goto error;
+		}
+	}
+	for (i = 0; i < msg.nr_events; i++) {
+		struct ustctl_event_registration *event = &a_events[i];
+		struct ustcomm_notify_event_msg m;
+		size_t signature_len, fields_len, model_emf_uri_len;
+
+		if (payload_len - offset < sizeof(m)) {
+			ret = -EINVAL;
+			goto error;
+		}
+		memcpy(&m, payload + offset, sizeof(m));
+		offset += sizeof(m);
+
+		signature_len = m.signature_len;
+		fields_len = m.fields_len;
+		model_emf_uri_len = m.model_emf_uri_len;
+		if (m.session_objd != msg.session_objd
+				|| !signature_len
+				|| fields_len % sizeof(struct ustctl_field) != 0
+				|| payload_len - offset < signature_len
+				|| payload_len - offset - signature_len < fields_len
+				|| payload_len - offset - signature_len - fields_len
+					< model_emf_uri_len) {
+			ret = -EINVAL;
+			goto error;
+		}
+
+		event->channel_objd = m.channel_objd;
+		strncpy(event->event_name, m.event_name, LTTNG_UST_SYM_NAME_LEN);
+		event->event_name[LTTNG_UST_SYM_NAME_LEN - 1] = '\0';
+		event->loglevel = m.loglevel;
+
+		event->signature = dup_payload_string(payload + offset,
+				signature_len);
+		if (!event->signature) {
+			ret = -ENOMEM;
+			goto error;
+		}
+		offset += signature_len;
+
+		if (fields_len) {
+			event->fields = zmalloc(fields_len);
+			if (!event->fields) {
+				ret = -ENOMEM;
+				goto error;
+			}
+			memcpy(event->fields, payload + offset, fields_len);
+			offset += fields_len;
+		}
+		event->nr_fields = fields_len / sizeof(struct ustctl_field);
+
+		if (model_emf_uri_len) {
+			event->model_emf_uri = dup_payload_string(
+					payload + offset, model_emf_uri_len);
+			if (!event->model_emf_uri) {
+				ret = -ENOMEM;
+				goto error;
+			}
+			offset += model_emf_uri_len;
+		}
+	}
+	if (offset != payload_len) {
+		ret = -EINVAL;
+		goto error;
+	}
+	free(payload);
+
+	*session_objd = msg.session_objd;
+	*nr_events = msg.nr_events;
+	*events = a_events;
+	return 0;
+
+error:
+	ustctl_release_register_events(msg.nr_events, a_events);
+	free(payload);
+	return ret;
+}
+
+/*
+ * Returns 0 on success, negative error value on error.
+ */
+int ustctl_reply_register_events(int sock,
+	size_t nr_events,
+	const uint32_t *ids,
+	const int *ret_codes,
+	int ret_code)
+{
+	ssize_t len;
+	struct {
+		struct ustcomm_notify_hdr header;
+		struct ustcomm_notify_events_reply r;
+	} reply;
+	struct ustcomm_notify_event_reply *event_replies = NULL;
+	size_t i;
+	int ret = 0;
+
+	if (nr_events > USTCOMM_NOTIFY_EVENTS_MAX_BATCH)
+		return -EINVAL;
+
+	memset(&reply, 0, sizeof(reply));
+	reply.header.notify_cmd = USTCTL_NOTIFY_CMD_EVENTS;
+	reply.r.ret_code = ret_code;
+	if (ret_code >= 0)
+		reply.r.nr_events = nr_events;
+	len = ustcomm_send_unix_sock(sock, &reply, sizeof(reply));
+	if (len > 0 && len != sizeof(reply))
+		return -EIO;
+	if (len < 0)
+		return len;
+	if (!reply.r.nr_events)
+		return 0;
+
+	event_replies = zmalloc(nr_events * sizeof(*event_replies));
+	if (!event_replies)
+		return -ENOMEM;
+	for (i = 0; i < nr_events; i++) {
+		event_replies[i].ret_code = ret_codes[i];
+		event_replies[i].event_id = ids[i];
+	}
+	len = ustcomm_send_unix_sock(sock, event_replies,
+			nr_events * sizeof(*event_replies));
+	if (len > 0 && len != nr_events * sizeof(*event_replies))
+		ret = -EIO;
+	else if (len < 0)
+		ret = len;
+	free(event_replies);
+	return ret;
+}
+
 /*
  * Returns 0 on success, negative UST or system error value on error.
  */
@@ -2460,6 +2882,23 @@ int ustctl_regenerate_statedump(int sock, int handle)
 	return 0;
 }
 
+/* Regenerate the statedump for newly loaded objects. */
+int ustctl_regenerate_statedump_incremental(int sock, int handle)
+{
+	struct ustcomm_ust_msg lum;
+	struct ustcomm_ust_reply lur;
+	int ret;
+
+	memset(&lum, 0, sizeof(lum));
+	lum.handle = handle;
+	lum.cmd = LTTNG_UST_SESSION_STATEDUMP_INCREMENTAL;
+	ret = ustcomm_send_app_cmd(sock, &lum, &lur);
+	if (ret)
+		return ret;
+	DBG("Regenerated incremental statedump for handle %u", handle);
+	return 0;
+}
+
 /* counter operations */
 
 int ustctl_get_nr_cpu_per_counter(void)
@@ -2486,12 +2925,18 @@ struct ustctl_daemon_counter *
 
 	if (nr_dimensions > LTTNG_COUNTER_DIMENSION_MAX)
 		return NULL;
-	/* Currently, only per-cpu allocation is supported. */
+	/*
+	 * Currently, only per-cpu allocation is supported, and per-cpu
+	 * with global allocation for modular counters.
+	 */
 	switch (alloc_flags) {
 	case USTCTL_COUNTER_ALLOC_PER_CPU:
 		break;
-
 	case USTCTL_COUNTER_ALLOC_PER_CPU | USTCTL_COUNTER_ALLOC_GLOBAL:
+		if (arithmetic != USTCTL_COUNTER_ARITHMETIC_MODULAR)
+			return NULL;
+		break;
+
 	case USTCTL_COUNTER_ALLOC_GLOBAL:
 	default:
 		return NULL;
@@ -2500,7 +2945,10 @@ struct ustctl_daemon_counter *
 	case USTCTL_COUNTER_BITNESS_32:
 		switch (arithmetic) {
 		case USTCTL_COUNTER_ARITHMETIC_MODULAR:
-			transport_name = "counter-per-cpu-32-modular";
+			if (alloc_flags & USTCTL_COUNTER_ALLOC_GLOBAL)
+				transport_name = "counter-per-cpu-global-32-modular";
+			else
+				transport_name = "counter-per-cpu-32-modular";
 			break;
 		case USTCTL_COUNTER_ARITHMETIC_SATURATION:
 			transport_name = "counter-per-cpu-32-saturation";
@@ -2512,7 +2960,10 @@ struct ustctl_daemon_counter *
 	case USTCTL_COUNTER_BITNESS_64:
 		switch (arithmetic) {
 		case USTCTL_COUNTER_ARITHMETIC_MODULAR:
-			transport_name = "counter-per-cpu-64-modular";
+			if (alloc_flags & USTCTL_COUNTER_ALLOC_GLOBAL)
+				transport_name = "counter-per-cpu-global-64-modular";
+			else
+				transport_name = "counter-per-cpu-64-modular";
 			break;
 		case USTCTL_COUNTER_ARITHMETIC_SATURATION:
 			transport_name = "counter-per-cpu-64-saturation";
@@ -2827,6 +3278,36 @@ int ustctl_counter_clear(struct ustctl_daemon_counter *counter,
 	return counter->ops->counter_clear(counter->counter, dimension_indexes);
 }
 
+int ustctl_counter_read_range(struct ustctl_daemon_counter *counter,
+		const size_t *dimension_indexes, size_t nr_elem,
+		int cpu, int64_t *values,
+		bool *overflow, bool *underflow)
+{
+	return counter->ops->counter_read_range(counter->counter,
+			dimension_indexes, nr_elem, cpu, values,
+			overflow, underflow);
+}
+
+int ustctl_counter_aggregate_range(struct ustctl_daemon_counter *counter,
+		const size_t *dimension_indexes, size_t nr_elem,
+		int64_t *values,
+		bool *overflow, bool *underflow)
+{
+	return counter->ops->counter_aggregate_range(counter->counter,
+			dimension_indexes, nr_elem, values,
+			overflow, underflow);
+}
+
+int ustctl_counter_aggregate_delta_range(struct ustctl_daemon_counter *counter,
+		const size_t *dimension_indexes, size_t nr_elem,
+		int64_t *deltas,
+		bool *overflow, bool *underflow)
+{
+	return counter->ops->counter_aggregate_delta_range(counter->counter,
+			dimension_indexes, nr_elem, deltas,
+			overflow, underflow);
+}
+
 static __attribute__((constructor))
 void ustctl_init(void)
 {
@@ -2834,12 +3315,15 @@ void ustctl_init(void)
 	lttng_ust_getenv_init();	/* Needs init_usterr() to be completed. */
 	lttng_ust_clock_init();
 	lttng_ring_buffer_metadata_client_init();
+	lttng_ring_buffer_notification_client_init();
 	lttng_ring_buffer_client_overwrite_init();
 	lttng_ring_buffer_client_overwrite_rt_init();
 	lttng_ring_buffer_client_discard_init();
 	lttng_ring_buffer_client_discard_rt_init();
 	lttng_counter_client_percpu_32_modular_init();
 	lttng_counter_client_percpu_64_modular_init();
+	lttng_counter_client_percpu_global_32_modular_init();
+	lttng_counter_client_percpu_global_64_modular_init();
 	lib_ringbuffer_signal_init();
 }
 
@@ -2850,7 +3334,10 @@ void ustctl_exit(void)
 	lttng_ring_buffer_client_discard_exit();
 	lttng_ring_buffer_client_overwrite_rt_exit();
 	lttng_ring_buffer_client_overwrite_exit();
+	lttng_ring_buffer_notification_client_exit();
 	lttng_ring_buffer_metadata_client_exit();
 	lttng_counter_client_percpu_32_modular_exit();
 	lttng_counter_client_percpu_64_modular_exit();
+	lttng_counter_client_percpu_global_32_modular_exit();
+	lttng_counter_client_percpu_global_64_modular_exit();
 }
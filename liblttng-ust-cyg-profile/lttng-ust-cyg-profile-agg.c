@@ -0,0 +1,252 @@
+/* SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * lttng-ust-cyg-profile-agg.c
+ *
+ * Aggregating function profiler. Rather than recording each function
+ * entry and exit, each thread keeps a shadow stack of the functions it
+ * is executing, and accounts the call count, inclusive time and
+ * exclusive time (inclusive time minus the time spent in instrumented
+ * callees) of each function in per-CPU counters.
+ *
+ * A lttng_ust_cyg_profile_agg:func_summary event is emitted for each
+ * called function every LTTNG_UST_CYG_PROFILE_PERIOD_MS milliseconds,
+ * by a flusher thread woken up on function exit, and at exit. Calls
+ * lasting at least LTTNG_UST_CYG_PROFILE_THRESHOLD_NS nanoseconds are
+ * also recorded as func_call events.
+ */
+
+#define _LGPL_SOURCE
+#include <dlfcn.h>
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <urcu/compiler.h>
+#include <urcu/system.h>
+#include <urcu/uatomic.h>
+
+#define TRACEPOINT_DEFINE
+#define TRACEPOINT_CREATE_PROBES
+#define TP_IP_PARAM func_addr
+#include "lttng-ust-cyg-profile-agg.h"
+#include "lttng-ust-cyg-profile-filter.h"
+#include "wrapper-counter.h"
+#include "wrapper-flusher.h"
+
+#define PROFILE_NR_FUNCTIONS		8192
+#define PROFILE_FUNCTION_MAX_PROBE	32
+#define PROFILE_STACK_DEPTH		256
+#define PROFILE_DEFAULT_PERIOD_MS	1000
+
+enum profile_metric {
+	PROFILE_METRIC_CALLS = 0,
+	PROFILE_METRIC_INCLUSIVE_NS,
+	PROFILE_METRIC_EXCLUSIVE_NS,
+	NR_PROFILE_METRICS,
+};
+
+struct profile_frame {
+	void *func;
+	void *call_site;
+	uint64_t start_ns;
+	uint64_t children_ns;	/* Inclusive time of instrumented callees. */
+};
+
+struct profile_stack {
+	struct profile_frame frames[PROFILE_STACK_DEPTH];
+	unsigned int depth;
+	/* Frames deeper than PROFILE_STACK_DEPTH, not accounted. */
+	unsigned long overflow;
+	int in_profile;
+};
+
+static int profile_enabled;
+static uint64_t profile_threshold_ns;
+static struct wrapper_flusher profile_flusher;
+static struct wrapper_counter profile_counter;
+
+/* Index 0 accounts for functions which do not fit. */
+static void *profile_functions[PROFILE_NR_FUNCTIONS];
+
+static __thread struct profile_stack profile_stack;
+
+void __cyg_profile_func_enter(void *this_fn, void *call_site)
+	__attribute__((no_instrument_function));
+
+void __cyg_profile_func_exit(void *this_fn, void *call_site)
+	__attribute__((no_instrument_function));
+
+static
+uint64_t profile_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static
+unsigned int profile_function_index(void *func)
+{
+	return wrapper_counter_key_index(profile_functions,
+			PROFILE_NR_FUNCTIONS, PROFILE_FUNCTION_MAX_PROBE, func);
+}
+
+static
+void profile_account(void *func, uint64_t inclusive_ns, uint64_t exclusive_ns)
+{
+	size_t indexes[2] = { profile_function_index(func), 0 };
+
+	indexes[1] = PROFILE_METRIC_CALLS;
+	wrapper_counter_add(&profile_counter, indexes, 1);
+	indexes[1] = PROFILE_METRIC_INCLUSIVE_NS;
+	wrapper_counter_add(&profile_counter, indexes, inclusive_ns);
+	indexes[1] = PROFILE_METRIC_EXCLUSIVE_NS;
+	wrapper_counter_add(&profile_counter, indexes, exclusive_ns);
+}
+
+/* Emit the summary of all called functions. */
+static
+void profile_dump(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < PROFILE_NR_FUNCTIONS; i++) {
+		void *func = CMM_LOAD_SHARED(profile_functions[i]);
+		size_t indexes[2] = { i, 0 };
+		int64_t calls, inclusive_ns, exclusive_ns;
+
+		if (i && !func)
+			continue;
+		indexes[1] = PROFILE_METRIC_CALLS;
+		calls = wrapper_counter_read(&profile_counter, indexes);
+		if (!calls)
+			continue;
+		indexes[1] = PROFILE_METRIC_INCLUSIVE_NS;
+		inclusive_ns = wrapper_counter_read(&profile_counter, indexes);
+		indexes[1] = PROFILE_METRIC_EXCLUSIVE_NS;
+		exclusive_ns = wrapper_counter_read(&profile_counter, indexes);
+		tracepoint(lttng_ust_cyg_profile_agg, func_summary, func,
+			calls, inclusive_ns, exclusive_ns);
+	}
+}
+
+/* Dump from the flusher thread, whose functions are not profiled. */
+static
+void profile_flusher_dump(void)
+{
+	profile_stack.in_profile = 1;
+	profile_dump();
+	profile_stack.in_profile = 0;
+}
+
+void __cyg_profile_func_enter(void *this_fn, void *call_site)
+{
+	struct profile_stack *stack = &profile_stack;
+	struct profile_frame *frame;
+
+	if (caa_unlikely(!CMM_LOAD_SHARED(profile_enabled)
+			|| stack->in_profile))
+		return;
+	if (!cyg_profile_filter_match(this_fn))
+		return;
+	if (caa_unlikely(stack->depth == PROFILE_STACK_DEPTH)) {
+		stack->overflow++;
+		return;
+	}
+	frame = &stack->frames[stack->depth++];
+	frame->func = this_fn;
+	frame->call_site = call_site;
+	frame->children_ns = 0;
+	frame->start_ns = profile_now_ns();
+}
+
+void __cyg_profile_func_exit(void *this_fn, void *call_site)
+{
+	struct profile_stack *stack = &profile_stack;
+	struct profile_frame *frame;
+	uint64_t now, duration;
+
+	if (caa_unlikely(!CMM_LOAD_SHARED(profile_enabled)
+			|| stack->in_profile))
+		return;
+	if (!cyg_profile_filter_match(this_fn))
+		return;
+	if (caa_unlikely(stack->overflow)) {
+		stack->overflow--;
+		return;
+	}
+	now = profile_now_ns();
+	/*
+	 * Frames skipped by longjmp() or exceptions never see their exit:
+	 * drop them. Exits without matching entry (e.g. functions entered
+	 * before profiling was enabled) are ignored.
+	 */
+	while (stack->depth
+			&& stack->frames[stack->depth - 1].func != this_fn) {
+		unsigned int i;
+
+		for (i = stack->depth - 1; i > 0; i--) {
+			if (stack->frames[i - 1].func == this_fn)
+				break;
+		}
+		if (!i)
+			return;
+		stack->depth = i;
+	}
+	if (!stack->depth)
+		return;
+	frame = &stack->frames[--stack->depth];
+	duration = now - frame->start_ns;
+	if (stack->depth)
+		stack->frames[stack->depth - 1].children_ns += duration;
+
+	stack->in_profile = 1;
+	profile_account(this_fn, duration,
+		duration - min_t(uint64_t, duration, frame->children_ns));
+	if (profile_threshold_ns && duration >= profile_threshold_ns)
+		tracepoint(lttng_ust_cyg_profile_agg, func_call, this_fn,
+			frame->call_site, duration);
+	wrapper_flusher_maybe_wake(&profile_flusher, now);
+	stack->in_profile = 0;
+}
+
+static __attribute__((constructor))
+void lttng_ust_cyg_profile_agg_init(void)
+{
+	const size_t dimensions[] = {
+		PROFILE_NR_FUNCTIONS, NR_PROFILE_METRICS,
+	};
+	uint64_t period_ns;
+	const char *str;
+
+	cyg_profile_filter_init();
+	if (wrapper_counter_create(&profile_counter, "cyg-profile",
+			CAA_ARRAY_SIZE(dimensions), dimensions)) {
+		fprintf(stderr, "unable to initialize cyg-profile aggregation.\n");
+		return;
+	}
+	str = getenv("LTTNG_UST_CYG_PROFILE_THRESHOLD_NS");
+	if (str)
+		profile_threshold_ns = strtoull(str, NULL, 10);
+	period_ns = PROFILE_DEFAULT_PERIOD_MS * 1000000ULL;
+	str = getenv("LTTNG_UST_CYG_PROFILE_PERIOD_MS");
+	if (str)
+		period_ns = strtoull(str, NULL, 10) * 1000000ULL;
+	if (wrapper_flusher_start(&profile_flusher, period_ns,
+			profile_flusher_dump))
+		fprintf(stderr, "unable to start cyg-profile summary flusher.\n");
+	CMM_STORE_SHARED(profile_enabled, 1);
+}
+
+static __attribute__((destructor))
+void lttng_ust_cyg_profile_agg_exit(void)
+{
+	if (!profile_enabled)
+		return;
+	profile_stack.in_profile = 1;
+	profile_dump();
+	profile_stack.in_profile = 0;
+	cyg_profile_filter_exit();
+}
@@ -0,0 +1,63 @@
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER lttng_ust_cyg_profile_agg
+
+#if !defined(_TRACEPOINT_LTTNG_UST_CYG_PROFILE_AGG_H) || defined(TRACEPOINT_HEADER_MULTI_READ)
+#define _TRACEPOINT_LTTNG_UST_CYG_PROFILE_AGG_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* SPDX-License-Identifier: MIT
+ *
+ * Events of the aggregating function profiler.
+ */
+
+#include <lttng/tracepoint.h>
+
+/*
+ * Cumulative call count, inclusive and exclusive time of a function
+ * since the process started. A NULL function address accounts for the
+ * functions which did not fit in the function table.
+ */
+TRACEPOINT_EVENT(lttng_ust_cyg_profile_agg, func_summary,
+	TP_ARGS(void *, func_addr, uint64_t, calls, uint64_t, inclusive_ns,
+		uint64_t, exclusive_ns),
+	TP_FIELDS(
+		ctf_integer_hex(unsigned long, addr,
+			(unsigned long) func_addr)
+		ctf_integer(uint64_t, calls, calls)
+		ctf_integer(uint64_t, inclusive_ns, inclusive_ns)
+		ctf_integer(uint64_t, exclusive_ns, exclusive_ns)
+	)
+)
+
+TRACEPOINT_LOGLEVEL(lttng_ust_cyg_profile_agg, func_summary,
+	TRACE_DEBUG_FUNCTION)
+
+/* A call which lasted at least the per-call tracing threshold. */
+TRACEPOINT_EVENT(lttng_ust_cyg_profile_agg, func_call,
+	TP_ARGS(void *, func_addr, void *, call_site, uint64_t, duration_ns),
+	TP_FIELDS(
+		ctf_integer_hex(unsigned long, addr,
+			(unsigned long) func_addr)
+		ctf_integer_hex(unsigned long, call_site,
+			(unsigned long) call_site)
+		ctf_integer(uint64_t, duration_ns, duration_ns)
+	)
+)
+
+TRACEPOINT_LOGLEVEL(lttng_ust_cyg_profile_agg, func_call,
+	TRACE_DEBUG_FUNCTION)
+
+#endif /* _TRACEPOINT_LTTNG_UST_CYG_PROFILE_AGG_H */
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "./lttng-ust-cyg-profile-agg.h"
+
+/* This part must be outside ifdef protection */
+#include <lttng/tracepoint-event.h>
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,370 @@
+/* SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * lttng-ust-cyg-profile-filter.c
+ *
+ * Selection of the instrumented functions traced by the cyg-profile
+ * helper libraries.
+ *
+ * LTTNG_UST_CYG_PROFILE_FILTER is a comma-separated list of:
+ *
+ *   START-END     Address range (e.g. 0x401000-0x402000).
+ *   lib:GLOB      Executable segments of the loaded objects whose path
+ *                 or file name matches the glob (e.g. lib:libfoo.so*).
+ *   sym:GLOB      Function symbols matching the glob, from the symbol
+ *                 table of the loaded objects (e.g. sym:foo_*).
+ *
+ * The objects and symbols are resolved into a sorted array of address
+ * ranges when the library is loaded, and again after each dlopen() and
+ * dlclose() through the lttng_ust_dl update callbacks (which requires
+ * preloading liblttng-ust-dl). Range arrays replaced by an update are
+ * only freed at exit, since the function hooks read them without
+ * synchronization.
+ */
+
+#define _GNU_SOURCE
+#include <fnmatch.h>
+#include <link.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <lttng/ust-elf.h>
+#include <lttng/ust-events.h>
+#include <urcu/list.h>
+
+#include "lttng-ust-cyg-profile-filter.h"
+
+enum filter_spec_type {
+	FILTER_SPEC_RANGE,
+	FILTER_SPEC_LIB,
+	FILTER_SPEC_SYM,
+};
+
+struct filter_spec {
+	enum filter_spec_type type;
+	uintptr_t start, end;	/* FILTER_SPEC_RANGE */
+	char *glob;		/* FILTER_SPEC_LIB, FILTER_SPEC_SYM */
+};
+
+/* Ranges array being built by a resolution. */
+struct range_builder {
+	struct cyg_profile_range *ranges;
+	size_t nr_ranges;
+	size_t alloc_ranges;
+	uintptr_t base;		/* Load bias of the object being parsed. */
+	const char *glob;
+	int error;
+};
+
+struct retired_ranges {
+	struct cds_list_head node;
+	struct cyg_profile_ranges *ranges;
+};
+
+struct cyg_profile_ranges *cyg_profile_filter_ranges;
+
+static struct filter_spec *filter_specs;
+static size_t nr_filter_specs;
+static pthread_mutex_t filter_mutex = PTHREAD_MUTEX_INITIALIZER;
+static CDS_LIST_HEAD(retired_ranges);
+
+static
+int range_builder_add(struct range_builder *builder, uintptr_t start,
+		uintptr_t end)
+{
+	if (start >= end)
+		return 0;
+	if (builder->nr_ranges == builder->alloc_ranges) {
+		struct cyg_profile_range *ranges;
+		size_t alloc = builder->alloc_ranges ?
+				2 * builder->alloc_ranges : 64;
+
+		ranges = realloc(builder->ranges, alloc * sizeof(*ranges));
+		if (!ranges) {
+			builder->error = 1;
+			return -1;
+		}
+		builder->ranges = ranges;
+		builder->alloc_ranges = alloc;
+	}
+	builder->ranges[builder->nr_ranges].start = start;
+	builder->ranges[builder->nr_ranges].end = end;
+	builder->nr_ranges++;
+	return 0;
+}
+
+static
+int compare_ranges(const void *a, const void *b)
+{
+	const struct cyg_profile_range *ra = a, *rb = b;
+
+	if (ra->start < rb->start)
+		return -1;
+	return ra->start > rb->start;
+}
+
+static
+int add_symbol_cb(const char *name, uint64_t addr, uint64_t size, void *priv)
+{
+	struct range_builder *builder = priv;
+
+	if (fnmatch(builder->glob, name, 0))
+		return 0;
+	/* Functions of unknown size only match their entry address. */
+	return range_builder_add(builder, builder->base + addr,
+			builder->base + addr + (size ? size : 1));
+}
+
+static
+int object_matches(const char *path, const char *glob)
+{
+	const char *base = strrchr(path, '/');
+
+	base = base ? base + 1 : path;
+	return !fnmatch(glob, path, 0) || !fnmatch(glob, base, 0);
+}
+
+static
+int resolve_object_cb(struct dl_phdr_info *info, size_t size, void *priv)
+{
+	struct range_builder *builder = priv;
+	char exe_path[PATH_MAX];
+	const char *path = info->dlpi_name;
+	size_t i, j;
+
+	/* The executable has an empty name. */
+	if (!path[0]) {
+		ssize_t len;
+
+		len = readlink("/proc/self/exe", exe_path,
+				sizeof(exe_path) - 1);
+		if (len <= 0)
+			return 0;
+		exe_path[len] = '\0';
+		path = exe_path;
+	}
+	/* Skip the vDSO, which has no file. */
+	if (path[0] != '/')
+		return 0;
+
+	for (i = 0; i < nr_filter_specs; i++) {
+		struct filter_spec *spec = &filter_specs[i];
+
+		switch (spec->type) {
+		case FILTER_SPEC_LIB:
+			if (!object_matches(path, spec->glob))
+				break;
+			for (j = 0; j < info->dlpi_phnum; j++) {
+				const ElfW(Phdr) *phdr = &info->dlpi_phdr[j];
+
+				if (phdr->p_type != PT_LOAD
+						|| !(phdr->p_flags & PF_X))
+					continue;
+				if (range_builder_add(builder,
+						info->dlpi_addr + phdr->p_vaddr,
+						info->dlpi_addr + phdr->p_vaddr
+							+ phdr->p_memsz))
+					return 1;
+			}
+			break;
+		case FILTER_SPEC_SYM:
+		{
+			struct lttng_ust_elf *elf;
+
+			elf = lttng_ust_elf_create(path);
+			if (!elf)
+				break;
+			builder->base = info->dlpi_addr;
+			builder->glob = spec->glob;
+			(void) lttng_ust_elf_for_each_func_symbol(elf,
+					add_symbol_cb, builder);
+			lttng_ust_elf_destroy(elf);
+			if (builder->error)
+				return 1;
+			break;
+		}
+		case FILTER_SPEC_RANGE:
+			break;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Resolve the filter specifications against the loaded objects and
+ * publish the resulting ranges. Called with filter_mutex held.
+ */
+static
+void filter_resolve(void)
+{
+	struct range_builder builder;
+	struct cyg_profile_ranges *ranges, *old;
+	struct retired_ranges *retired = NULL;
+	size_t i, nr = 0;
+
+	memset(&builder, 0, sizeof(builder));
+	for (i = 0; i < nr_filter_specs; i++) {
+		if (filter_specs[i].type != FILTER_SPEC_RANGE)
+			continue;
+		if (range_builder_add(&builder, filter_specs[i].start,
+				filter_specs[i].end))
+			goto error;
+	}
+	dl_iterate_phdr(resolve_object_cb, &builder);
+	if (builder.error)
+		goto error;
+
+	/* Sort and merge overlapping ranges. */
+	if (builder.nr_ranges)
+		qsort(builder.ranges, builder.nr_ranges,
+			sizeof(*builder.ranges), compare_ranges);
+	for (i = 0; i < builder.nr_ranges; i++) {
+		if (nr && builder.ranges[i].start <= builder.ranges[nr - 1].end) {
+			builder.ranges[nr - 1].end = max_t(uintptr_t,
+				builder.ranges[nr - 1].end,
+				builder.ranges[i].end);
+			continue;
+		}
+		builder.ranges[nr++] = builder.ranges[i];
+	}
+
+	ranges = malloc(sizeof(*ranges) + nr * sizeof(ranges->ranges[0]));
+	if (!ranges)
+		goto error;
+	old = cyg_profile_filter_ranges;
+	if (old) {
+		retired = malloc(sizeof(*retired));
+		if (!retired) {
+			free(ranges);
+			goto error;
+		}
+	}
+	ranges->nr_ranges = nr;
+	if (nr)
+		memcpy(ranges->ranges, builder.ranges,
+			nr * sizeof(ranges->ranges[0]));
+	/* Publish the ranges after their content. */
+	cmm_smp_wmb();
+	CMM_STORE_SHARED(cyg_profile_filter_ranges, ranges);
+	if (old) {
+		retired->ranges = old;
+		cds_list_add(&retired->node, &retired_ranges);
+	}
+	free(builder.ranges);
+	return;
+
+error:
+	fprintf(stderr, "cyg-profile: unable to resolve the function filter.\n");
+	free(builder.ranges);
+}
+
+static
+void filter_dl_update_cb(void *priv)
+{
+	pthread_mutex_lock(&filter_mutex);
+	filter_resolve();
+	pthread_mutex_unlock(&filter_mutex);
+}
+
+static
+int filter_parse_spec(const char *str, struct filter_spec *spec)
+{
+	char *end;
+
+	memset(spec, 0, sizeof(*spec));
+	if (!strncmp(str, "lib:", 4)) {
+		spec->type = FILTER_SPEC_LIB;
+		spec->glob = strdup(str + 4);
+		return spec->glob ? 0 : -1;
+	}
+	if (!strncmp(str, "sym:", 4)) {
+		spec->type = FILTER_SPEC_SYM;
+		spec->glob = strdup(str + 4);
+		return spec->glob ? 0 : -1;
+	}
+	spec->type = FILTER_SPEC_RANGE;
+	spec->start = strtoull(str, &end, 0);
+	if (*end != '-')
+		return -1;
+	spec->end = strtoull(end + 1, &end, 0);
+	if (*end != '\0' || spec->end <= spec->start)
+		return -1;
+	return 0;
+}
+
+static
+int filter_parse(const char *str)
+{
+	char *copy, *saveptr = NULL, *token;
+	size_t nr = 1;
+	const char *p;
+	int ret = -1;
+
+	for (p = str; *p; p++) {
+		if (*p == ',')
+			nr++;
+	}
+	filter_specs = calloc(nr, sizeof(*filter_specs));
+	copy = strdup(str);
+	if (!filter_specs || !copy)
+		goto end;
+	for (token = strtok_r(copy, ",", &saveptr); token;
+			token = strtok_r(NULL, ",", &saveptr)) {
+		if (filter_parse_spec(token, &filter_specs[nr_filter_specs])) {
+			fprintf(stderr, "cyg-profile: invalid filter \"%s\".\n",
+				token);
+			goto end;
+		}
+		nr_filter_specs++;
+	}
+	ret = 0;
+end:
+	free(copy);
+	return ret;
+}
+
+void cyg_profile_filter_init(void)
+{
+	const char *str;
+
+	str = getenv("LTTNG_UST_CYG_PROFILE_FILTER");
+	if (!str)
+		return;
+	/*
+	 * On error, the functions of the valid specifications parsed so
+	 * far are traced.
+	 */
+	(void) filter_parse(str);
+	pthread_mutex_lock(&filter_mutex);
+	filter_resolve();
+	pthread_mutex_unlock(&filter_mutex);
+	if (lttng_ust_dl_register_update_cb(filter_dl_update_cb, NULL))
+		fprintf(stderr, "cyg-profile: unable to track dlopen() for the function filter.\n");
+}
+
+void cyg_profile_filter_exit(void)
+{
+	struct retired_ranges *retired, *tmp;
+	size_t i;
+
+	if (!filter_specs)
+		return;
+	lttng_ust_dl_unregister_update_cb(filter_dl_update_cb, NULL);
+	/*
+	 * The current ranges stay in place for functions returning after
+	 * this destructor.
+	 */
+	cds_list_for_each_entry_safe(retired, tmp, &retired_ranges, node) {
+		cds_list_del(&retired->node);
+		free(retired->ranges);
+		free(retired);
+	}
+	for (i = 0; i < nr_filter_specs; i++)
+		free(filter_specs[i].glob);
+	free(filter_specs);
+	filter_specs = NULL;
+	nr_filter_specs = 0;
+}
@@ -0,0 +1,68 @@
+/* SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * lttng-ust-cyg-profile-filter.h
+ *
+ * Selection of the instrumented functions traced by the cyg-profile
+ * helper libraries.
+ */
+
+#ifndef _LTTNG_UST_CYG_PROFILE_FILTER_H
+#define _LTTNG_UST_CYG_PROFILE_FILTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <urcu/compiler.h>
+#include <urcu/system.h>
+#include <helper.h>
+
+struct cyg_profile_range {
+	uintptr_t start;
+	uintptr_t end;		/* Exclusive. */
+};
+
+/* Sorted, non-overlapping ranges of selected code addresses. */
+struct cyg_profile_ranges {
+	size_t nr_ranges;
+	struct cyg_profile_range ranges[];
+};
+
+/* NULL when no filter is configured, in which case all functions match. */
+LTTNG_HIDDEN
+extern struct cyg_profile_ranges *cyg_profile_filter_ranges;
+
+/*
+ * Parse LTTNG_UST_CYG_PROFILE_FILTER and resolve it against the loaded
+ * objects. Called from the constructor of the helper libraries.
+ */
+LTTNG_HIDDEN
+void cyg_profile_filter_init(void);
+
+LTTNG_HIDDEN
+void cyg_profile_filter_exit(void);
+
+static inline
+bool cyg_profile_filter_match(void *func)
+{
+	struct cyg_profile_ranges *ranges;
+	uintptr_t addr = (uintptr_t) func;
+	size_t low, high;
+
+	ranges = CMM_LOAD_SHARED(cyg_profile_filter_ranges);
+	if (caa_likely(!ranges))
+		return true;
+	/* Find the last range starting at or before addr. */
+	low = 0;
+	high = ranges->nr_ranges;
+	while (low < high) {
+		size_t mid = low + (high - low) / 2;
+
+		if (ranges->ranges[mid].start <= addr)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return low && addr < ranges->ranges[low - 1].end;
+}
+
+#endif /* _LTTNG_UST_CYG_PROFILE_FILTER_H */
@@ -25,6 +25,7 @@
 #define TRACEPOINT_CREATE_PROBES
 #define TP_IP_PARAM func_addr
 #include "lttng-ust-cyg-profile.h"
+#include "lttng-ust-cyg-profile-filter.h"
 
 void __cyg_profile_func_enter(void *this_fn, void *call_site)
 	__attribute__((no_instrument_function));
@@ -34,10 +35,26 @@ void __cyg_profile_func_exit(void *this_fn, void *call_site)
 
 void __cyg_profile_func_enter(void *this_fn, void *call_site)
 {
+	if (!cyg_profile_filter_match(this_fn))
+		return;
 	tracepoint(lttng_ust_cyg_profile, func_entry, this_fn, call_site);
 }
 
 void __cyg_profile_func_exit(void *this_fn, void *call_site)
 {
+	if (!cyg_profile_filter_match(this_fn))
+		return;
 	tracepoint(lttng_ust_cyg_profile, func_exit, this_fn, call_site);
 }
+
+static __attribute__((constructor))
+void lttng_ust_cyg_profile_init(void)
+{
+	cyg_profile_filter_init();
+}
+
+static __attribute__((destructor))
+void lttng_ust_cyg_profile_exit(void)
+{
+	cyg_profile_filter_exit();
+}
@@ -24,7 +24,10 @@
  */
 #include <lttng/ust-dlfcn.h>
 #include <sys/types.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
 #include <assert.h>
 #include <urcu/system.h>
 #include <urcu/uatomic.h>
@@ -38,11 +41,81 @@
 #define TRACEPOINT_CREATE_PROBES
 #define TP_IP_PARAM ip
 #include "ust_libc.h"
+#include "wrapper-counter.h"
+#include "wrapper-flusher.h"
 
 #define STATIC_CALLOC_LEN 4096
 static char static_calloc_buf[STATIC_CALLOC_LEN];
 static unsigned long static_calloc_buf_offset;
 
+/*
+ * Byte-based sampling mode, enabled by setting
+ * LTTNG_UST_LIBC_SAMPLE_BYTES to the mean number of bytes allocated by
+ * a thread between two sampled allocations. Intervals follow an
+ * exponential distribution so every allocated byte has the same
+ * probability of being sampled.
+ */
+static uint64_t sample_bytes;
+
+struct malloc_sample_state {
+	uint64_t bytes_until_sample;
+	uint64_t interval;		/* Current interval, 0 if not seeded. */
+	uint64_t rand_state;
+};
+
+/*
+ * Set of sampled allocations which are still live, used to only record
+ * the frees matching sampled allocations. Each pointer hashes to a
+ * bucket of one cache line, so looking a pointer up reads a single
+ * cache line. Allocations which do not fit in their bucket are not
+ * sampled. Each pointer has an associated non-zero info word, used by
+ * the aggregation mode.
+ */
+#define SAMPLED_PTRS_BUCKET_LEN		8
+#define SAMPLED_PTRS_NR_BUCKETS		8192
+
+struct sampled_ptrs_bucket {
+	uintptr_t ptrs[SAMPLED_PTRS_BUCKET_LEN];
+	uint64_t info[SAMPLED_PTRS_BUCKET_LEN];
+} __attribute__((aligned(CAA_CACHE_LINE_SIZE)));
+
+static struct sampled_ptrs_bucket sampled_ptrs[SAMPLED_PTRS_NR_BUCKETS];
+static unsigned long nr_sampled_ptrs;
+static unsigned long sample_seed;
+
+/*
+ * Aggregation mode, enabled by setting LTTNG_UST_LIBC_AGGREGATE. Rather
+ * than emitting an event per sampled allocation and free, sampled
+ * allocations are accounted in per-CPU counters indexed by call site,
+ * size class and metric, and an lttng_ust_libc:alloc_summary event is
+ * emitted for each call site and size class every
+ * LTTNG_UST_LIBC_AGGREGATE_PERIOD_MS milliseconds and at exit. The
+ * allocation path only checks the flush deadline and wakes up a
+ * dedicated flusher thread, which emits the summary events.
+ *
+ * Call sites are kept in a fixed open-addressing table of return
+ * addresses. Index 0 accounts for call sites which do not fit.
+ */
+#define AGG_NR_CALLSITES		256
+#define AGG_CALLSITE_MAX_PROBE		16
+#define AGG_NR_SIZE_CLASSES		8	/* < 32, < 128, ..., >= 128k */
+#define AGG_DEFAULT_SAMPLE_BYTES	524288
+#define AGG_DEFAULT_PERIOD_MS		1000
+#define AGG_WEIGHT_BITS			48
+
+enum agg_metric {
+	AGG_METRIC_SAMPLES = 0,
+	AGG_METRIC_BYTES,
+	AGG_METRIC_FREED_SAMPLES,
+	AGG_METRIC_FREED_BYTES,
+	NR_AGG_METRICS,
+};
+
+static struct wrapper_counter agg_counter;
+static int agg_enabled;
+static void *agg_callsites[AGG_NR_CALLSITES];
+static struct wrapper_flusher agg_flusher;
+
 struct alloc_functions {
 	void *(*calloc)(size_t nmemb, size_t size);
 	void *(*malloc)(size_t size);
@@ -95,6 +168,7 @@ void ust_malloc_spin_unlock(pthread_mutex_t *lock)
 #define pthread_mutex_lock ust_malloc_spin_lock
 #define pthread_mutex_unlock ust_malloc_spin_unlock
 static DEFINE_URCU_TLS(int, malloc_nesting);
+static DEFINE_URCU_TLS(struct malloc_sample_state, malloc_sample_state);
 #undef pthread_mutex_unlock
 #undef pthread_mutex_lock
 #undef calloc
@@ -252,6 +326,291 @@ void lookup_all_symbols(void)
 	memcpy(&cur_alloc, &af, sizeof(cur_alloc));
 }
 
+static
+struct sampled_ptrs_bucket *sampled_ptrs_bucket(void *ptr)
+{
+	uint64_t hash = (uintptr_t) ptr;
+
+	/* Allocations are aligned: mix the bits before indexing. */
+	hash ^= hash >> 33;
+	hash *= 0xff51afd7ed558ccdULL;
+	hash ^= hash >> 33;
+	return &sampled_ptrs[hash & (SAMPLED_PTRS_NR_BUCKETS - 1)];
+}
+
+/* Returns 0 on success, -1 if the bucket is full. */
+static
+int sampled_ptrs_add(void *ptr, uint64_t info)
+{
+	struct sampled_ptrs_bucket *bucket = sampled_ptrs_bucket(ptr);
+	unsigned int i;
+
+	for (i = 0; i < SAMPLED_PTRS_BUCKET_LEN; i++) {
+		if (CMM_LOAD_SHARED(bucket->ptrs[i]))
+			continue;
+		if (uatomic_cmpxchg(&bucket->ptrs[i], 0, (uintptr_t) ptr) == 0) {
+			/*
+			 * ptr cannot be freed before it is returned to
+			 * the application, so nobody reads the info
+			 * word concurrently.
+			 */
+			bucket->info[i] = info;
+			uatomic_inc(&nr_sampled_ptrs);
+			return 0;
+		}
+	}
+	return -1;
+}
+
+/*
+ * Returns the info word of ptr if it was a sampled allocation, 0
+ * otherwise.
+ */
+static
+uint64_t sampled_ptrs_del(void *ptr)
+{
+	struct sampled_ptrs_bucket *bucket;
+	unsigned int i;
+
+	if (caa_likely(!CMM_LOAD_SHARED(nr_sampled_ptrs)) || !ptr)
+		return 0;
+	bucket = sampled_ptrs_bucket(ptr);
+	for (i = 0; i < SAMPLED_PTRS_BUCKET_LEN; i++) {
+		uint64_t info;
+
+		if (CMM_LOAD_SHARED(bucket->ptrs[i]) != (uintptr_t) ptr)
+			continue;
+		/* Only the thread freeing ptr can remove it. */
+		info = bucket->info[i];
+		uatomic_set(&bucket->ptrs[i], 0);
+		uatomic_dec(&nr_sampled_ptrs);
+		return info;
+	}
+	return 0;
+}
+
+static
+unsigned int agg_size_class(size_t size)
+{
+	unsigned int bits;
+
+	if (size < 32)
+		return 0;
+	bits = CAA_BITS_PER_LONG - __builtin_clzl(size);
+	return min_t(unsigned int, (bits - 4) / 2, AGG_NR_SIZE_CLASSES - 1);
+}
+
+/* Exclusive upper bound of a size class, 0 if unbounded. */
+static
+uint64_t agg_size_class_max(unsigned int size_class)
+{
+	if (size_class == AGG_NR_SIZE_CLASSES - 1)
+		return 0;
+	return 32ULL << (2 * size_class);
+}
+
+static
+unsigned int agg_callsite_index(void *ip)
+{
+	return wrapper_counter_key_index(agg_callsites, AGG_NR_CALLSITES,
+			AGG_CALLSITE_MAX_PROBE, ip);
+}
+
+static
+void agg_counter_add(unsigned int callsite, unsigned int size_class,
+		enum agg_metric metric, int64_t v)
+{
+	size_t indexes[3] = { callsite, size_class, metric };
+
+	wrapper_counter_add(&agg_counter, indexes, v);
+}
+
+static
+int64_t agg_counter_read(unsigned int callsite, unsigned int size_class,
+		enum agg_metric metric)
+{
+	size_t indexes[3] = { callsite, size_class, metric };
+
+	return wrapper_counter_read(&agg_counter, indexes);
+}
+
+/* Emit the summary events of all call sites. */
+static
+void agg_flush(void)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < AGG_NR_CALLSITES; i++) {
+		void *callsite = CMM_LOAD_SHARED(agg_callsites[i]);
+
+		if (i && !callsite)
+			continue;
+		for (j = 0; j < AGG_NR_SIZE_CLASSES; j++) {
+			int64_t samples, bytes, freed_samples, freed_bytes;
+
+			samples = agg_counter_read(i, j, AGG_METRIC_SAMPLES);
+			if (!samples)
+				continue;
+			bytes = agg_counter_read(i, j, AGG_METRIC_BYTES);
+			freed_samples = agg_counter_read(i, j,
+					AGG_METRIC_FREED_SAMPLES);
+			freed_bytes = agg_counter_read(i, j,
+					AGG_METRIC_FREED_BYTES);
+			tracepoint(lttng_ust_libc, alloc_summary, callsite,
+				agg_size_class_max(j), samples, bytes,
+				freed_samples, bytes - freed_bytes);
+		}
+	}
+}
+
+static
+uint64_t agg_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Flush from the flusher thread, whose allocations are not traced. */
+static
+void agg_flusher_flush(void)
+{
+	URCU_TLS(malloc_nesting)++;
+	agg_flush();
+	URCU_TLS(malloc_nesting)--;
+}
+
+/*
+ * Account a sampled allocation. Returns the info word to associate
+ * with the allocation.
+ */
+static
+uint64_t agg_alloc(size_t size, uint64_t weight, void *ip)
+{
+	unsigned int callsite, size_class;
+
+	callsite = agg_callsite_index(ip);
+	size_class = agg_size_class(size);
+	weight = min_t(uint64_t, weight, (1ULL << AGG_WEIGHT_BITS) - 1);
+	agg_counter_add(callsite, size_class, AGG_METRIC_SAMPLES, 1);
+	agg_counter_add(callsite, size_class, AGG_METRIC_BYTES, weight);
+	return ((uint64_t) (callsite * AGG_NR_SIZE_CLASSES + size_class)
+			<< AGG_WEIGHT_BITS) | weight;
+}
+
+/* Account the free of a sampled allocation from its info word. */
+static
+void agg_free(uint64_t info)
+{
+	unsigned int index = info >> AGG_WEIGHT_BITS;
+	uint64_t weight = info & ((1ULL << AGG_WEIGHT_BITS) - 1);
+
+	agg_counter_add(index / AGG_NR_SIZE_CLASSES,
+		index % AGG_NR_SIZE_CLASSES, AGG_METRIC_FREED_SAMPLES, 1);
+	agg_counter_add(index / AGG_NR_SIZE_CLASSES,
+		index % AGG_NR_SIZE_CLASSES, AGG_METRIC_FREED_BYTES, weight);
+}
+
+/*
+ * Draw the next sampling interval from an exponential distribution of
+ * mean sample_bytes, as -ln(u) * sample_bytes with u uniform in (0, 1].
+ * The logarithm is approximated by a quadratic between powers of two
+ * to avoid depending on libm.
+ */
+static
+uint64_t malloc_sample_next_interval(struct malloc_sample_state *state)
+{
+	uint64_t x, u;
+	double log2_u, m;
+	int e;
+
+	/* xorshift64* */
+	x = state->rand_state;
+	x ^= x >> 12;
+	x ^= x << 25;
+	x ^= x >> 27;
+	state->rand_state = x;
+	u = ((x * 0x2545f4914f6cdd1dULL) >> 11) | 1;	/* 53 bits, non-zero */
+	e = 63 - __builtin_clzll(u);
+	m = (double) u / (double) (1ULL << e) - 1.0;	/* In [0, 1) */
+	log2_u = e + m * (1.3466 - 0.3466 * m);
+	return (uint64_t) ((53.0 - log2_u) * 0.69314718055994530942
+			* (double) sample_bytes) + 1;
+}
+
+/*
+ * Slow path of malloc_sample(), taken when the allocation crosses the
+ * current sampling interval. Returns the weight of the sample, or 0 if
+ * the allocation is not sampled.
+ */
+static __attribute__((noinline))
+uint64_t malloc_sample_slow(struct malloc_sample_state *state, size_t size)
+{
+	uint64_t weight;
+
+	if (!state->interval) {
+		/* First allocation of this thread: seed its generator. */
+		state->rand_state = (uintptr_t) state
+			^ ((uint64_t) uatomic_add_return(&sample_seed, 1) << 32)
+			^ 0x9e3779b97f4a7c15ULL;
+		state->interval = malloc_sample_next_interval(state);
+		state->bytes_until_sample = state->interval;
+		if (state->bytes_until_sample > size) {
+			state->bytes_until_sample -= size;
+			return 0;
+		}
+	}
+	weight = state->interval - state->bytes_until_sample + size;
+	state->interval = malloc_sample_next_interval(state);
+	state->bytes_until_sample = state->interval;
+	if (agg_enabled)
+		wrapper_flusher_maybe_wake(&agg_flusher, agg_now_ns());
+	return weight;
+}
+
+/*
+ * Account for an allocation of `size` bytes returning `ptr` in sampling
+ * mode, and trace it if it is sampled. Unsampled allocations only
+ * decrement a thread-local counter.
+ */
+static inline
+void malloc_sample(size_t size, void *ptr, void *ip)
+{
+	struct malloc_sample_state *state = &URCU_TLS(malloc_sample_state);
+	uint64_t weight;
+
+	if (caa_likely(state->bytes_until_sample > size)) {
+		state->bytes_until_sample -= size;
+		return;
+	}
+	weight = malloc_sample_slow(state, size);
+	if (!weight || !ptr)
+		return;
+	if (agg_enabled) {
+		(void) sampled_ptrs_add(ptr, agg_alloc(size, weight, ip));
+		return;
+	}
+	if (sampled_ptrs_add(ptr, weight))
+		return;
+	tracepoint(lttng_ust_libc, sampled_alloc, size, ptr, weight, ip);
+}
+
+/* Trace the free of `ptr` in sampling mode if it was sampled. */
+static inline
+void malloc_sample_free(void *ptr, void *ip)
+{
+	uint64_t info;
+
+	info = sampled_ptrs_del(ptr);
+	if (!info)
+		return;
+	if (agg_enabled)
+		agg_free(info);
+	else
+		tracepoint(lttng_ust_libc, sampled_free, ptr, ip);
+}
+
 void *malloc(size_t size)
 {
 	void *retval;
@@ -266,8 +625,12 @@ void *malloc(size_t size)
 	}
 	retval = cur_alloc.malloc(size);
 	if (URCU_TLS(malloc_nesting) == 1) {
-		tracepoint(lttng_ust_libc, malloc,
-			size, retval, LTTNG_UST_CALLER_IP());
+		if (sample_bytes) {
+			malloc_sample(size, retval, LTTNG_UST_CALLER_IP());
+		} else {
+			tracepoint(lttng_ust_libc, malloc,
+				size, retval, LTTNG_UST_CALLER_IP());
+		}
 	}
 	URCU_TLS(malloc_nesting)--;
 	return retval;
@@ -286,8 +649,12 @@ void free(void *ptr)
 	}
 
 	if (URCU_TLS(malloc_nesting) == 1) {
-		tracepoint(lttng_ust_libc, free,
-			ptr, LTTNG_UST_CALLER_IP());
+		if (sample_bytes) {
+			malloc_sample_free(ptr, LTTNG_UST_CALLER_IP());
+		} else {
+			tracepoint(lttng_ust_libc, free,
+				ptr, LTTNG_UST_CALLER_IP());
+		}
 	}
 
 	if (cur_alloc.free == NULL) {
@@ -316,8 +683,13 @@ void *calloc(size_t nmemb, size_t size)
 	}
 	retval = cur_alloc.calloc(nmemb, size);
 	if (URCU_TLS(malloc_nesting) == 1) {
-		tracepoint(lttng_ust_libc, calloc,
-			nmemb, size, retval, LTTNG_UST_CALLER_IP());
+		if (sample_bytes) {
+			malloc_sample(nmemb * size, retval,
+				LTTNG_UST_CALLER_IP());
+		} else {
+			tracepoint(lttng_ust_libc, calloc,
+				nmemb, size, retval, LTTNG_UST_CALLER_IP());
+		}
 	}
 	URCU_TLS(malloc_nesting)--;
 	return retval;
@@ -366,11 +738,23 @@ void *realloc(void *ptr, size_t size)
 			abort();
 		}
 	}
+	/*
+	 * In sampling mode, a realloc is accounted as a free of the
+	 * previous allocation followed by a new allocation. The previous
+	 * allocation is removed from the sampled set before it can be
+	 * reused by another thread.
+	 */
+	if (sample_bytes && URCU_TLS(malloc_nesting) == 1)
+		malloc_sample_free(ptr, LTTNG_UST_CALLER_IP());
 	retval = cur_alloc.realloc(ptr, size);
 end:
 	if (URCU_TLS(malloc_nesting) == 1) {
-		tracepoint(lttng_ust_libc, realloc,
-			ptr, size, retval, LTTNG_UST_CALLER_IP());
+		if (sample_bytes) {
+			malloc_sample(size, retval, LTTNG_UST_CALLER_IP());
+		} else {
+			tracepoint(lttng_ust_libc, realloc,
+				ptr, size, retval, LTTNG_UST_CALLER_IP());
+		}
 	}
 	URCU_TLS(malloc_nesting)--;
 	return retval;
@@ -390,9 +774,13 @@ void *memalign(size_t alignment, size_t size)
 	}
 	retval = cur_alloc.memalign(alignment, size);
 	if (URCU_TLS(malloc_nesting) == 1) {
-		tracepoint(lttng_ust_libc, memalign,
-			alignment, size, retval,
-			LTTNG_UST_CALLER_IP());
+		if (sample_bytes) {
+			malloc_sample(size, retval, LTTNG_UST_CALLER_IP());
+		} else {
+			tracepoint(lttng_ust_libc, memalign,
+				alignment, size, retval,
+				LTTNG_UST_CALLER_IP());
+		}
 	}
 	URCU_TLS(malloc_nesting)--;
 	return retval;
@@ -412,9 +800,14 @@ int posix_memalign(void **memptr, size_t alignment, size_t size)
 	}
 	retval = cur_alloc.posix_memalign(memptr, alignment, size);
 	if (URCU_TLS(malloc_nesting) == 1) {
-		tracepoint(lttng_ust_libc, posix_memalign,
-			*memptr, alignment, size,
-			retval, LTTNG_UST_CALLER_IP());
+		if (sample_bytes) {
+			malloc_sample(size, retval ? NULL : *memptr,
+				LTTNG_UST_CALLER_IP());
+		} else {
+			tracepoint(lttng_ust_libc, posix_memalign,
+				*memptr, alignment, size,
+				retval, LTTNG_UST_CALLER_IP());
+		}
 	}
 	URCU_TLS(malloc_nesting)--;
 	return retval;
@@ -424,19 +817,81 @@ static
 void lttng_ust_fixup_malloc_nesting_tls(void)
 {
 	asm volatile ("" : : "m" (URCU_TLS(malloc_nesting)));
+	asm volatile ("" : : "m" (URCU_TLS(malloc_sample_state)));
+}
+
+static
+int setup_aggregation(void)
+{
+	const size_t dimensions[] = {
+		AGG_NR_CALLSITES, AGG_NR_SIZE_CLASSES, NR_AGG_METRICS,
+	};
+	uint64_t period_ns;
+	const char *str;
+
+	if (!getenv("LTTNG_UST_LIBC_AGGREGATE"))
+		return 0;
+	if (wrapper_counter_create(&agg_counter, "libc-agg",
+			CAA_ARRAY_SIZE(dimensions), dimensions)) {
+		fprintf(stderr, "mallocwrap: unable to set up aggregation\n");
+		return -1;
+	}
+	period_ns = AGG_DEFAULT_PERIOD_MS * 1000000ULL;
+	str = getenv("LTTNG_UST_LIBC_AGGREGATE_PERIOD_MS");
+	if (str)
+		period_ns = strtoull(str, NULL, 10) * 1000000ULL;
+	if (wrapper_flusher_start(&agg_flusher, period_ns, agg_flusher_flush))
+		fprintf(stderr, "mallocwrap: unable to start summary flusher\n");
+	if (!sample_bytes)
+		sample_bytes = AGG_DEFAULT_SAMPLE_BYTES;
+	agg_enabled = 1;
+	return 0;
+}
+
+static
+void setup_sampling(void)
+{
+	static int sampling_initialized;
+	const char *str;
+	uint64_t bytes = 0;
+
+	if (sampling_initialized)
+		return;
+	sampling_initialized = 1;
+	str = getenv("LTTNG_UST_LIBC_SAMPLE_BYTES");
+	if (str)
+		bytes = strtoull(str, NULL, 10);
+	/*
+	 * Allocations performed while setting up aggregation are not
+	 * traced.
+	 */
+	URCU_TLS(malloc_nesting)++;
+	sample_bytes = bytes;
+	(void) setup_aggregation();
+	URCU_TLS(malloc_nesting)--;
 }
 
 __attribute__((constructor))
 void lttng_ust_malloc_wrapper_init(void)
 {
-	/* Initialization already done */
-	if (cur_alloc.calloc) {
-		return;
-	}
 	lttng_ust_fixup_malloc_nesting_tls();
 	/*
 	 * Ensure the allocator is in place before the process becomes
-	 * multithreaded.
+	 * multithreaded. It is usually already looked up by allocations
+	 * performed by earlier constructors, e.g. liblttng-ust's, which
+	 * must not prevent sampling from being set up.
 	 */
-	lookup_all_symbols();
+	if (!cur_alloc.calloc)
+		lookup_all_symbols();
+	setup_sampling();
+}
+
+__attribute__((destructor))
+void lttng_ust_malloc_wrapper_exit(void)
+{
+	if (!agg_enabled)
+		return;
+	URCU_TLS(malloc_nesting)++;
+	agg_flush();
+	URCU_TLS(malloc_nesting)--;
 }
@@ -23,15 +23,227 @@
  */
 #include <lttng/ust-dlfcn.h>
 #include <helper.h>
+#include <errno.h>
 #include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+#include <urcu/compiler.h>
+#include <urcu/system.h>
+#include <urcu/uatomic.h>
 
 #define TRACEPOINT_DEFINE
 #define TRACEPOINT_CREATE_PROBES
 #define TP_IP_PARAM ip
 #include "ust_pthread.h"
+#include "wrapper-counter.h"
+#include "wrapper-flusher.h"
 
 static __thread int thread_in_trace;
 
+/*
+ * Contention-only mode, enabled by setting LTTNG_UST_PTHREAD_CONTENTION.
+ * pthread_mutex_lock() first tries to acquire the mutex without
+ * blocking, and only emits lttng_ust_pthread:pthread_mutex_contended
+ * when it had to wait for at least LTTNG_UST_PTHREAD_WAIT_THRESHOLD_NS
+ * nanoseconds. Lock, trylock and unlock events are not emitted.
+ *
+ * Per-mutex log2 histograms of the wait time of contended acquisitions
+ * and of the hold time of all acquisitions are kept in per-CPU
+ * counters, and emitted as pthread_mutex_wait_histogram and
+ * pthread_mutex_hold_histogram events every
+ * LTTNG_UST_PTHREAD_DUMP_PERIOD_MS milliseconds, by a flusher thread
+ * woken up from the lock and unlock paths, and at exit.
+ *
+ * Mutexes are kept in a fixed open-addressing table of addresses.
+ * Index 0 accounts for mutexes which do not fit.
+ */
+#define CONTENTION_NR_MUTEXES		256
+#define CONTENTION_MUTEX_MAX_PROBE	16
+#define CONTENTION_DEFAULT_PERIOD_MS	1000
+#define CONTENTION_MAX_HELD		16
+
+enum contention_histogram {
+	CONTENTION_HISTOGRAM_WAIT = 0,
+	CONTENTION_HISTOGRAM_HOLD,
+	NR_CONTENTION_HISTOGRAMS,
+};
+
+struct held_mutex {
+	pthread_mutex_t *mutex;
+	uint64_t acquire_ns;
+};
+
+static int contention_mode;
+static uint64_t contention_threshold_ns;
+static struct wrapper_flusher contention_flusher;
+static struct wrapper_counter contention_counter;
+static void *contention_mutexes[CONTENTION_NR_MUTEXES];
+
+/* Mutexes held by the current thread, with their acquisition time. */
+static __thread struct held_mutex held_mutexes[CONTENTION_MAX_HELD];
+static __thread unsigned int nr_held_mutexes;
+
+static int (*contention_mutex_lock)(pthread_mutex_t *);
+static int (*contention_mutex_trylock)(pthread_mutex_t *);
+static int (*contention_mutex_unlock)(pthread_mutex_t *);
+
+static
+uint64_t contention_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static
+unsigned int contention_mutex_index(pthread_mutex_t *mutex)
+{
+	return wrapper_counter_key_index(contention_mutexes,
+			CONTENTION_NR_MUTEXES, CONTENTION_MUTEX_MAX_PROBE, mutex);
+}
+
+/* Bucket b counts durations in [2^(b-1), 2^b) ns, the last is unbounded. */
+static
+unsigned int contention_bucket(uint64_t ns)
+{
+	if (!ns)
+		return 0;
+	return min_t(unsigned int, 64 - __builtin_clzll(ns),
+		CONTENTION_HISTOGRAM_BUCKETS - 1);
+}
+
+static
+void contention_account(pthread_mutex_t *mutex,
+		enum contention_histogram histogram, uint64_t ns)
+{
+	size_t indexes[3] = {
+		contention_mutex_index(mutex), histogram, contention_bucket(ns),
+	};
+
+	wrapper_counter_add(&contention_counter, indexes, 1);
+}
+
+/* Emit the histograms of all mutexes. */
+static
+void contention_dump(void)
+{
+	unsigned int i, j;
+
+	for (i = 0; i < CONTENTION_NR_MUTEXES; i++) {
+		void *mutex = CMM_LOAD_SHARED(contention_mutexes[i]);
+
+		if (i && !mutex)
+			continue;
+		for (j = 0; j < NR_CONTENTION_HISTOGRAMS; j++) {
+			uint64_t buckets[CONTENTION_HISTOGRAM_BUCKETS];
+			uint64_t total = 0;
+			unsigned int b;
+
+			for (b = 0; b < CONTENTION_HISTOGRAM_BUCKETS; b++) {
+				size_t indexes[3] = { i, j, b };
+
+				buckets[b] = wrapper_counter_read(
+						&contention_counter, indexes);
+				total += buckets[b];
+			}
+			if (!total)
+				continue;
+			if (j == CONTENTION_HISTOGRAM_WAIT)
+				tracepoint(lttng_ust_pthread,
+					pthread_mutex_wait_histogram,
+					mutex, buckets, NULL);
+			else
+				tracepoint(lttng_ust_pthread,
+					pthread_mutex_hold_histogram,
+					mutex, buckets, NULL);
+		}
+	}
+}
+
+/* Dump from the flusher thread, whose locks are not traced. */
+static
+void contention_flusher_dump(void)
+{
+	thread_in_trace = 1;
+	contention_dump();
+	thread_in_trace = 0;
+}
+
+static
+void contention_acquired(pthread_mutex_t *mutex, uint64_t now)
+{
+	unsigned int nr = nr_held_mutexes;
+
+	if (nr == CONTENTION_MAX_HELD)
+		return;
+	held_mutexes[nr].mutex = mutex;
+	held_mutexes[nr].acquire_ns = now;
+	nr_held_mutexes = nr + 1;
+}
+
+static
+int contention_lock(pthread_mutex_t *mutex, void *ip)
+{
+	uint64_t start, now;
+	int retval;
+
+	retval = contention_mutex_trylock(mutex);
+	if (caa_likely(retval != EBUSY)) {
+		if (!retval)
+			contention_acquired(mutex, contention_now_ns());
+		return retval;
+	}
+	start = contention_now_ns();
+	retval = contention_mutex_lock(mutex);
+	now = contention_now_ns();
+	if (!retval)
+		contention_acquired(mutex, now);
+	contention_account(mutex, CONTENTION_HISTOGRAM_WAIT, now - start);
+	if (now - start >= contention_threshold_ns)
+		tracepoint(lttng_ust_pthread, pthread_mutex_contended, mutex,
+			now - start, retval, ip);
+	wrapper_flusher_maybe_wake(&contention_flusher, now);
+	return retval;
+}
+
+static
+int contention_trylock(pthread_mutex_t *mutex)
+{
+	int retval;
+
+	retval = contention_mutex_trylock(mutex);
+	if (!retval)
+		contention_acquired(mutex, contention_now_ns());
+	return retval;
+}
+
+static
+int contention_unlock(pthread_mutex_t *mutex)
+{
+	unsigned int i;
+	int retval;
+
+	retval = contention_mutex_unlock(mutex);
+	if (retval)
+		return retval;
+	/* Mutexes are usually released in reverse acquisition order. */
+	for (i = nr_held_mutexes; i > 0; i--) {
+		uint64_t now;
+
+		if (held_mutexes[i - 1].mutex != mutex)
+			continue;
+		now = contention_now_ns();
+		contention_account(mutex, CONTENTION_HISTOGRAM_HOLD,
+			now - held_mutexes[i - 1].acquire_ns);
+		held_mutexes[i - 1] = held_mutexes[--nr_held_mutexes];
+		wrapper_flusher_maybe_wake(&contention_flusher, now);
+		break;
+	}
+	return retval;
+}
+
 int pthread_mutex_lock(pthread_mutex_t *mutex)
 {
 	static int (*mutex_lock)(pthread_mutex_t *);
@@ -52,6 +264,11 @@ int pthread_mutex_lock(pthread_mutex_t *mutex)
 	}
 
 	thread_in_trace = 1;
+	if (contention_mode) {
+		retval = contention_lock(mutex, LTTNG_UST_CALLER_IP());
+		thread_in_trace = 0;
+		return retval;
+	}
 	tracepoint(lttng_ust_pthread, pthread_mutex_lock_req, mutex,
 		LTTNG_UST_CALLER_IP());
 	retval = mutex_lock(mutex);
@@ -81,6 +298,11 @@ int pthread_mutex_trylock(pthread_mutex_t *mutex)
 	}
 
 	thread_in_trace = 1;
+	if (contention_mode) {
+		retval = contention_trylock(mutex);
+		thread_in_trace = 0;
+		return retval;
+	}
 	retval = mutex_trylock(mutex);
 	tracepoint(lttng_ust_pthread, pthread_mutex_trylock, mutex,
 		retval, LTTNG_UST_CALLER_IP());
@@ -108,9 +330,71 @@ int pthread_mutex_unlock(pthread_mutex_t *mutex)
 	}
 
 	thread_in_trace = 1;
+	if (contention_mode) {
+		retval = contention_unlock(mutex);
+		thread_in_trace = 0;
+		return retval;
+	}
 	retval = mutex_unlock(mutex);
 	tracepoint(lttng_ust_pthread, pthread_mutex_unlock, mutex,
 		retval, LTTNG_UST_CALLER_IP());
 	thread_in_trace = 0;
 	return retval;
 }
+
+static
+void setup_contention_mode(void)
+{
+	const size_t dimensions[] = {
+		CONTENTION_NR_MUTEXES, NR_CONTENTION_HISTOGRAMS,
+		CONTENTION_HISTOGRAM_BUCKETS,
+	};
+	uint64_t period_ns;
+	const char *str;
+
+	if (!getenv("LTTNG_UST_PTHREAD_CONTENTION"))
+		return;
+	contention_mutex_lock = dlsym(RTLD_NEXT, "pthread_mutex_lock");
+	contention_mutex_trylock = dlsym(RTLD_NEXT, "pthread_mutex_trylock");
+	contention_mutex_unlock = dlsym(RTLD_NEXT, "pthread_mutex_unlock");
+	if (!contention_mutex_lock || !contention_mutex_trylock
+			|| !contention_mutex_unlock)
+		goto error;
+	if (wrapper_counter_create(&contention_counter, "pthread-contention",
+			CAA_ARRAY_SIZE(dimensions), dimensions))
+		goto error;
+	str = getenv("LTTNG_UST_PTHREAD_WAIT_THRESHOLD_NS");
+	if (str)
+		contention_threshold_ns = strtoull(str, NULL, 10);
+	period_ns = CONTENTION_DEFAULT_PERIOD_MS * 1000000ULL;
+	str = getenv("LTTNG_UST_PTHREAD_DUMP_PERIOD_MS");
+	if (str)
+		period_ns = strtoull(str, NULL, 10) * 1000000ULL;
+	if (wrapper_flusher_start(&contention_flusher, period_ns,
+			contention_flusher_dump))
+		goto error;
+	CMM_STORE_SHARED(contention_mode, 1);
+	return;
+
+error:
+	fprintf(stderr, "unable to set up pthread wrapper contention mode.\n");
+}
+
+__attribute__((constructor))
+void lttng_ust_pthread_wrapper_init(void)
+{
+	/* Locks taken while setting up are not traced. */
+	thread_in_trace = 1;
+	setup_contention_mode();
+	thread_in_trace = 0;
+}
+
+__attribute__((destructor))
+void lttng_ust_pthread_wrapper_exit(void)
+{
+	if (!contention_mode)
+		return;
+	thread_in_trace = 1;
+	contention_dump();
+	thread_in_trace = 0;
+}
@@ -84,6 +84,49 @@ TRACEPOINT_EVENT(lttng_ust_libc, posix_memalign,
 	)
 )
 
+/*
+ * Emitted in byte-based sampling mode instead of the events above.
+ * `weight` is the number of bytes allocated by the thread since the
+ * previous sample, including this allocation.
+ */
+TRACEPOINT_EVENT(lttng_ust_libc, sampled_alloc,
+	TP_ARGS(size_t, size, void *, ptr, uint64_t, weight, void *, ip),
+	TP_FIELDS(
+		ctf_integer(size_t, size, size)
+		ctf_integer_hex(void *, ptr, ptr)
+		ctf_integer(uint64_t, weight, weight)
+	)
+)
+
+TRACEPOINT_EVENT(lttng_ust_libc, sampled_free,
+	TP_ARGS(void *, ptr, void *, ip),
+	TP_FIELDS(
+		ctf_integer_hex(void *, ptr, ptr)
+	)
+)
+
+/*
+ * Emitted in aggregation mode, for each allocation call site and size
+ * class, with totals estimated from sampled allocations since the
+ * process started. `size_max` is the exclusive upper bound of the size
+ * class, 0 for the last class. A NULL `callsite` accounts for call
+ * sites which did not fit in the call site table. The call site is
+ * also used as instruction pointer of the ip context.
+ */
+TRACEPOINT_EVENT(lttng_ust_libc, alloc_summary,
+	TP_ARGS(void *, ip, uint64_t, size_max, uint64_t, samples,
+		uint64_t, bytes, uint64_t, freed_samples,
+		uint64_t, live_bytes),
+	TP_FIELDS(
+		ctf_integer_hex(void *, callsite, ip)
+		ctf_integer(uint64_t, size_max, size_max)
+		ctf_integer(uint64_t, samples, samples)
+		ctf_integer(uint64_t, bytes, bytes)
+		ctf_integer(uint64_t, freed_samples, freed_samples)
+		ctf_integer(uint64_t, live_bytes, live_bytes)
+	)
+)
+
 #endif /* _TRACEPOINT_UST_LIBC_H */
 
 #undef TRACEPOINT_INCLUDE
@@ -32,6 +32,9 @@ extern "C" {
 
 #include <lttng/tracepoint.h>
 
+/* Number of log2 buckets of the contention mode histograms. */
+#define CONTENTION_HISTOGRAM_BUCKETS	32
+
 TRACEPOINT_EVENT(lttng_ust_pthread, pthread_mutex_lock_req,
 	TP_ARGS(pthread_mutex_t *, mutex, void *, ip),
 	TP_FIELDS(
@@ -63,6 +66,40 @@ TRACEPOINT_EVENT(lttng_ust_pthread, pthread_mutex_unlock,
 	)
 )
 
+TRACEPOINT_EVENT(lttng_ust_pthread, pthread_mutex_contended,
+	TP_ARGS(pthread_mutex_t *, mutex, uint64_t, wait_ns, int, status,
+		void *, ip),
+	TP_FIELDS(
+		ctf_integer_hex(void *, mutex, mutex)
+		ctf_integer(uint64_t, wait_ns, wait_ns)
+		ctf_integer(int, status, status)
+	)
+)
+
+/*
+ * Cumulative histograms of the contention mode. buckets[b] counts the
+ * durations in [2^(b-1), 2^b) ns, the last bucket being unbounded. A
+ * NULL mutex accounts for mutexes which did not fit in the mutex table.
+ */
+TRACEPOINT_EVENT_CLASS(lttng_ust_pthread, mutex_histogram,
+	TP_ARGS(void *, mutex, const uint64_t *, buckets, void *, ip),
+	TP_FIELDS(
+		ctf_integer_hex(void *, mutex, mutex)
+		ctf_array(uint64_t, buckets, buckets,
+			CONTENTION_HISTOGRAM_BUCKETS)
+	)
+)
+
+TRACEPOINT_EVENT_INSTANCE(lttng_ust_pthread, mutex_histogram,
+	pthread_mutex_wait_histogram,
+	TP_ARGS(void *, mutex, const uint64_t *, buckets, void *, ip)
+)
+
+TRACEPOINT_EVENT_INSTANCE(lttng_ust_pthread, mutex_histogram,
+	pthread_mutex_hold_histogram,
+	TP_ARGS(void *, mutex, const uint64_t *, buckets, void *, ip)
+)
+
 #endif /* _TRACEPOINT_UST_PTHREAD_H */
 
 #undef TRACEPOINT_INCLUDE
@@ -0,0 +1,74 @@
+/* SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * wrapper-counter.c
+ *
+ * Per-CPU counters private to the LTTng-UST helper libraries (libc,
+ * pthread and function tracing wrappers).
+ */
+
+#define _GNU_SOURCE
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "wrapper-counter.h"
+
+/*
+ * The counter uses a per-CPU counter transport of liblttng-ust. Its
+ * per-CPU layout requires shared memory file descriptors: use unlinked
+ * POSIX shared memory, which stays mapped by libcounter after the file
+ * descriptors are closed.
+ */
+int wrapper_counter_create(struct wrapper_counter *counter, const char *name,
+		size_t nr_dimensions, const size_t *dimension_sizes)
+{
+	struct lttng_counter_dimension dimensions[WRAPPER_COUNTER_MAX_DIMENSIONS];
+	int *cpu_fds = NULL, ret = -1;
+	long nr_cpus, i;
+	size_t d;
+
+	if (nr_dimensions > WRAPPER_COUNTER_MAX_DIMENSIONS)
+		return -1;
+	counter->transport = lttng_counter_transport_find(
+			"counter-per-cpu-64-modular");
+	if (!counter->transport)
+		return -1;
+	nr_cpus = sysconf(_SC_NPROCESSORS_CONF);
+	if (nr_cpus <= 0)
+		return -1;
+	cpu_fds = calloc(nr_cpus, sizeof(*cpu_fds));
+	if (!cpu_fds)
+		return -1;
+	for (i = 0; i < nr_cpus; i++)
+		cpu_fds[i] = -1;
+	for (i = 0; i < nr_cpus; i++) {
+		char shm_name[64];
+
+		snprintf(shm_name, sizeof(shm_name), "/lttng-ust-%s-%d-%ld",
+			name, (int) getpid(), i);
+		cpu_fds[i] = shm_open(shm_name, O_RDWR | O_CREAT | O_EXCL,
+				S_IRUSR | S_IWUSR);
+		if (cpu_fds[i] < 0)
+			goto end;
+		(void) shm_unlink(shm_name);
+	}
+	memset(dimensions, 0, sizeof(dimensions));
+	for (d = 0; d < nr_dimensions; d++)
+		dimensions[d].size = dimension_sizes[d];
+	counter->counter = counter->transport->ops.counter_create(nr_dimensions,
+			dimensions, 0, -1, nr_cpus, cpu_fds, true);
+	if (!counter->counter)
+		goto end;
+	ret = 0;
+end:
+	for (i = 0; i < nr_cpus; i++) {
+		if (cpu_fds[i] >= 0)
+			(void) close(cpu_fds[i]);
+	}
+	free(cpu_fds);
+	return ret;
+}
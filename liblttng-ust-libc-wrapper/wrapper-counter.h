@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * wrapper-counter.h
+ *
+ * Per-CPU counters private to the LTTng-UST helper libraries (libc,
+ * pthread and function tracing wrappers).
+ */
+
+#ifndef _LTTNG_UST_WRAPPER_COUNTER_H
+#define _LTTNG_UST_WRAPPER_COUNTER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <urcu/system.h>
+#include <urcu/uatomic.h>
+#include <lttng/ust-events.h>
+#include <helper.h>
+
+#define WRAPPER_COUNTER_MAX_DIMENSIONS	4
+
+struct wrapper_counter {
+	struct lttng_counter_transport *transport;
+	struct lib_counter *counter;
+};
+
+/*
+ * Create a per-CPU 64-bit counter of nr_dimensions dimensions. Returns
+ * 0 on success, -1 on error.
+ */
+LTTNG_HIDDEN
+int wrapper_counter_create(struct wrapper_counter *counter, const char *name,
+		size_t nr_dimensions, const size_t *dimension_sizes);
+
+static inline
+void wrapper_counter_add(struct wrapper_counter *counter,
+		const size_t *indexes, int64_t v)
+{
+	(void) counter->transport->ops.counter_add(counter->counter,
+			indexes, v);
+}
+
+/* Returns the sum of the per-CPU counters at indexes. */
+static inline
+int64_t wrapper_counter_read(struct wrapper_counter *counter,
+		const size_t *indexes)
+{
+	bool overflow, underflow;
+	int64_t value = 0;
+
+	(void) counter->transport->ops.counter_aggregate(counter->counter,
+			indexes, &value, &overflow, &underflow);
+	return value;
+}
+
+/*
+ * Returns the index of the non-NULL key (e.g. an address) in the
+ * open-addressing table keys of nr_keys entries, inserting it if it is
+ * not found. Index 0 is reserved for the keys which do not fit within
+ * max_probe probes, and accounts for all of them.
+ */
+static inline
+unsigned int wrapper_counter_key_index(void **keys, unsigned int nr_keys,
+		unsigned int max_probe, void *key)
+{
+	uint64_t hash = (uintptr_t) key;
+	unsigned int i;
+
+	hash ^= hash >> 29;
+	hash *= 0xbf58476d1ce4e5b9ULL;
+	hash ^= hash >> 32;
+	for (i = 0; i < max_probe; i++) {
+		unsigned int index;
+		void *old;
+
+		index = 1 + (hash + i) % (nr_keys - 1);
+		old = CMM_LOAD_SHARED(keys[index]);
+		if (old == key)
+			return index;
+		if (old)
+			continue;
+		old = uatomic_cmpxchg(&keys[index], NULL, key);
+		if (!old || old == key)
+			return index;
+	}
+	return 0;
+}
+
+#endif /* _LTTNG_UST_WRAPPER_COUNTER_H */
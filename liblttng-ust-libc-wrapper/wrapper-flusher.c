@@ -0,0 +1,111 @@
+/* SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * wrapper-flusher.c
+ *
+ * Periodic flush of the summaries kept by the LTTng-UST helper
+ * libraries (libc, pthread and function tracing wrappers).
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "wrapper-flusher.h"
+
+/* Started flushers, restarted in fork children. */
+static struct wrapper_flusher *flushers;
+
+static
+void *flusher_thread(void *arg)
+{
+	struct wrapper_flusher *flusher = arg;
+
+	for (;;) {
+		if (sem_wait(&flusher->sem)) {
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+		flusher->flush();
+	}
+	return NULL;
+}
+
+/*
+ * Create the flusher thread with all signals blocked, so it does not
+ * steal signals from the application.
+ */
+static
+int flusher_create_thread(struct wrapper_flusher *flusher)
+{
+	sigset_t sig_all_blocked, orig_mask;
+	pthread_attr_t attr;
+	pthread_t thread;
+	int ret;
+
+	if (sem_init(&flusher->sem, 0, 0))
+		return -1;
+	ret = pthread_attr_init(&attr);
+	if (ret)
+		goto error_attr;
+	ret = pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	if (ret)
+		goto error_create;
+	sigfillset(&sig_all_blocked);
+	ret = pthread_sigmask(SIG_SETMASK, &sig_all_blocked, &orig_mask);
+	if (ret)
+		goto error_create;
+	ret = pthread_create(&thread, &attr, flusher_thread, flusher);
+	(void) pthread_sigmask(SIG_SETMASK, &orig_mask, NULL);
+	if (ret)
+		goto error_create;
+	(void) pthread_attr_destroy(&attr);
+	return 0;
+
+error_create:
+	(void) pthread_attr_destroy(&attr);
+error_attr:
+	(void) sem_destroy(&flusher->sem);
+	return -1;
+}
+
+/* Flusher threads do not survive fork: start new ones in the child. */
+static
+void flusher_after_fork_child(void)
+{
+	struct wrapper_flusher *flusher;
+
+	for (flusher = flushers; flusher; flusher = flusher->next) {
+		if (!flusher->period_ns)
+			continue;
+		if (flusher_create_thread(flusher)) {
+			fprintf(stderr, "unable to restart LTTng-UST summary flusher.\n");
+			CMM_STORE_SHARED(flusher->period_ns, 0);
+		}
+	}
+}
+
+int wrapper_flusher_start(struct wrapper_flusher *flusher,
+		uint64_t period_ns, void (*flush)(void))
+{
+	struct timespec ts;
+
+	flusher->period_ns = 0;
+	flusher->flush = flush;
+	if (!period_ns)
+		return 0;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	flusher->next_ns = (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec
+		+ period_ns;
+	if (flusher_create_thread(flusher))
+		return -1;
+	if (!flushers)
+		(void) pthread_atfork(NULL, NULL, flusher_after_fork_child);
+	flusher->next = flushers;
+	flushers = flusher;
+	CMM_STORE_SHARED(flusher->period_ns, period_ns);
+	return 0;
+}
@@ -0,0 +1,61 @@
+/* SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * wrapper-flusher.h
+ *
+ * Periodic flush of the summaries kept by the LTTng-UST helper
+ * libraries (libc, pthread and function tracing wrappers). The
+ * instrumented paths only check the flush deadline and wake up a
+ * dedicated thread, which emits the summary events.
+ */
+
+#ifndef _LTTNG_UST_WRAPPER_FLUSHER_H
+#define _LTTNG_UST_WRAPPER_FLUSHER_H
+
+#include <semaphore.h>
+#include <stdint.h>
+#include <urcu/compiler.h>
+#include <urcu/system.h>
+#include <urcu/uatomic.h>
+#include <helper.h>
+
+struct wrapper_flusher {
+	uint64_t period_ns;		/* 0 if periodic flush is disabled. */
+	uint64_t next_ns;		/* Deadline of the next flush. */
+	void (*flush)(void);
+	sem_t sem;
+	struct wrapper_flusher *next;
+};
+
+/*
+ * Start the flusher thread calling flush() every period_ns nanoseconds
+ * at most, when woken up by wrapper_flusher_maybe_wake(). The thread is
+ * restarted in fork children. flush() must prevent the instrumentation
+ * of its own calls. A period of 0 disables periodic flush. Called from
+ * library constructors. Returns 0 on success, -1 on error.
+ */
+LTTNG_HIDDEN
+int wrapper_flusher_start(struct wrapper_flusher *flusher,
+		uint64_t period_ns, void (*flush)(void));
+
+/*
+ * Wake up the flusher thread if the deadline passed at time now
+ * (CLOCK_MONOTONIC). Only one caller wakes it up per period.
+ */
+static inline
+void wrapper_flusher_maybe_wake(struct wrapper_flusher *flusher,
+		uint64_t now)
+{
+	uint64_t next;
+
+	if (!CMM_LOAD_SHARED(flusher->period_ns))
+		return;
+	next = CMM_LOAD_SHARED(flusher->next_ns);
+	if (caa_likely(now < next))
+		return;
+	if (uatomic_cmpxchg(&flusher->next_ns, next,
+			now + flusher->period_ns) != next)
+		return;
+	(void) sem_post(&flusher->sem);
+}
+
+#endif /* _LTTNG_UST_WRAPPER_FLUSHER_H */
@@ -22,13 +22,20 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <string.h>
+#include <time.h>
 #include <lttng/ust-events.h>
 #include <lttng/ust-endian.h>
 #include <usterr-signal-safe.h>
 
 #include "../libmsgpack/msgpack.h"
+#include "../libringbuffer/frontend_types.h"
 #include "lttng-bytecode.h"
+#include "lttng-rb-clients.h"
+#include "lttng-tracer-core.h"
+#include "jhash.h"
 #include "share.h"
+#include "ust-events-internal.h"
 
 /*
  * We want this write to be atomic AND non-blocking, meaning that we
@@ -43,11 +50,18 @@
 struct lttng_event_notifier_notification {
 	int notification_fd;
 	uint64_t event_notifier_token;
+	struct lttng_event_notifier_group *group;
+	uint64_t error_counter_index;
 	uint8_t capture_buf[CAPTURE_BUFFER_SIZE];
 	struct lttng_msgpack_writer writer;
 	bool has_captures;
+	uint64_t nr_hits;
+	uint8_t flags;
 };
 
+#define RATE_HITS_BITS		LTTNG_EVENT_NOTIFIER_RATE_HITS_BITS
+#define RATE_HITS_MASK		LTTNG_EVENT_NOTIFIER_RATE_HITS_MASK
+
 static
 void capture_enum(struct lttng_msgpack_writer *writer,
 		struct lttng_interpreter_output *output)
@@ -72,118 +86,16 @@ void capture_enum(struct lttng_msgpack_writer *writer,
 	lttng_msgpack_end_map(writer);
 }
 
+/*
+ * Compute the element layout of a captured sequence once, from its
+ * element type, rather than re-reading the type for each element.
+ */
 static
-int64_t capture_sequence_element_signed(uint8_t *ptr,
-		const struct lttng_integer_type *type)
-{
-	int64_t value;
-	unsigned int size = type->size;
-	bool byte_order_reversed = type->reverse_byte_order;
-
-	switch (size) {
-	case 8:
-		value = *ptr;
-		break;
-	case 16:
-	{
-		int16_t tmp;
-		tmp = *(int16_t *) ptr;
-		if (byte_order_reversed)
-			tmp = bswap_16(tmp);
-
-		value = tmp;
-		break;
-	}
-	case 32:
-	{
-		int32_t tmp;
-		tmp = *(int32_t *) ptr;
-		if (byte_order_reversed)
-			tmp = bswap_32(tmp);
-
-		value = tmp;
-		break;
-	}
-	case 64:
-	{
-		int64_t tmp;
-		tmp = *(int64_t *) ptr;
-		if (byte_order_reversed)
-			tmp = bswap_64(tmp);
-
-		value = tmp;
-		break;
-	}
-	default:
-		abort();
-	}
-
-	return value;
-}
-
-static
-uint64_t capture_sequence_element_unsigned(uint8_t *ptr,
-		const struct lttng_integer_type *type)
-{
-	uint64_t value;
-	unsigned int size = type->size;
-	bool byte_order_reversed = type->reverse_byte_order;
-
-	switch (size) {
-	case 8:
-		value = *ptr;
-		break;
-	case 16:
-	{
-		uint16_t tmp;
-		tmp = *(uint16_t *) ptr;
-		if (byte_order_reversed)
-			tmp = bswap_16(tmp);
-
-		value = tmp;
-		break;
-	}
-	case 32:
-	{
-		uint32_t tmp;
-		tmp = *(uint32_t *) ptr;
-		if (byte_order_reversed)
-			tmp = bswap_32(tmp);
-
-		value = tmp;
-		break;
-	}
-	case 64:
-	{
-		uint64_t tmp;
-		tmp = *(uint64_t *) ptr;
-		if (byte_order_reversed)
-			tmp = bswap_64(tmp);
-
-		value = tmp;
-		break;
-	}
-	default:
-		abort();
-	}
-
-	return value;
-}
-
-static
-void capture_sequence(struct lttng_msgpack_writer *writer,
-		struct lttng_interpreter_output *output)
+void capture_sequence_layout(const struct lttng_type *nested_type,
+		struct lttng_msgpack_integer_layout *layout)
 {
 	const struct lttng_integer_type *integer_type;
-	const struct lttng_type *nested_type;
-	uint8_t *ptr;
-	bool signedness;
-	int i;
 
-	lttng_msgpack_begin_array(writer, output->u.sequence.nr_elem);
-
-	ptr = (uint8_t *) output->u.sequence.ptr;
-	nested_type = output->u.sequence.nested_type;
 	switch (nested_type->atype) {
 	case atype_integer:
 		integer_type = &nested_type->u.integer;
@@ -196,30 +108,47 @@ void capture_sequence(struct lttng_msgpack_writer *writer,
 		/* Capture of array of non-integer are not supported. */
 		abort();
 	}
-	signedness = integer_type->signedness;
-	for (i = 0; i < output->u.sequence.nr_elem; i++) {
-		if (signedness) {
-			lttng_msgpack_write_signed_integer(writer,
-				capture_sequence_element_signed(ptr, integer_type));
-		} else {
-			lttng_msgpack_write_unsigned_integer(writer,
-				capture_sequence_element_unsigned(ptr, integer_type));
-		}
 
-		/*
-		 * We assume that alignment is smaller or equal to the size.
-		 * This currently holds true but if it changes in the future,
-		 * we will want to change the pointer arithmetics below to
-		 * take into account that the next element might be further
-		 * away.
-		 */
-		assert(integer_type->alignment <= integer_type->size);
+	/*
+	 * We assume that alignment is smaller or equal to the size, so
+	 * that elements are contiguous. This currently holds true but if
+	 * it changes in the future, the encoder will need a stride.
+	 */
+	assert(integer_type->alignment <= integer_type->size);
 
-		/* Size is in number of bits. */
-		ptr += (integer_type->size / CHAR_BIT) ;
-	}
+	/* Size is in number of bits. */
+	layout->size = integer_type->size / CHAR_BIT;
+	layout->is_signed = integer_type->signedness;
+	layout->reverse_byte_order = integer_type->reverse_byte_order;
+}
+
+static
+void capture_sequence(struct lttng_msgpack_writer *writer,
+		struct lttng_interpreter_output *output)
+{
+	struct lttng_msgpack_integer_layout layout;
+
+	capture_sequence_layout(output->u.sequence.nested_type, &layout);
+	lttng_msgpack_write_integer_sequence(writer, &layout,
+			output->u.sequence.ptr, output->u.sequence.nr_elem);
+}
 
-	lttng_msgpack_end_array(writer);
+/*
+ * String captures of sequence fields carry their length, which spares
+ * the strlen(). Null-terminated strings have a length of SIZE_MAX.
+ */
+static
+void capture_string(struct lttng_msgpack_writer *writer,
+		struct lttng_interpreter_output *output)
+{
+	const char *str = output->u.str.str;
+	size_t len = output->u.str.len;
+
+	if (len == SIZE_MAX)
+		len = strlen(str);
+	else
+		len = strnlen(str, len);
+	lttng_msgpack_write_str_len(writer, str, len);
 }
 
 static
@@ -230,6 +159,8 @@ void notification_init(struct lttng_event_notifier_notification *notif,
 
 	notif->event_notifier_token = event_notifier->user_token;
 	notif->notification_fd = event_notifier->group->notification_fd;
+	notif->group = event_notifier->group;
+	notif->error_counter_index = event_notifier->error_counter_index;
 	notif->has_captures = false;
 
 	if (event_notifier->num_captures > 0) {
@@ -259,7 +190,7 @@ void notification_append_capture(
 		lttng_msgpack_write_double(writer, output->u.d);
 		break;
 	case LTTNG_INTERPRETER_TYPE_STRING:
-		lttng_msgpack_write_str(writer, output->u.str.str);
+		capture_string(writer, output);
 		break;
 	case LTTNG_INTERPRETER_TYPE_SEQUENCE:
 		capture_sequence(writer, output);
@@ -280,10 +211,9 @@ void notification_append_empty_capture(
 	lttng_msgpack_write_nil(&notif->writer);
 }
 
-static void record_error(struct lttng_event_notifier *event_notifier)
+static void record_group_errors(struct lttng_event_notifier_group *event_notifier_group,
+		uint64_t error_counter_index, int64_t nr_errors)
 {
-	struct lttng_event_notifier_group *event_notifier_group =
-			event_notifier->group;
 	struct lttng_counter *error_counter;
 	size_t dimension_index[1];
 	int ret;
@@ -301,16 +231,91 @@ static void record_error(struct lttng_event_notifier *event_notifier)
 	if (!error_counter)
 		return;
 
-	dimension_index[0] = event_notifier->error_counter_index;
+	dimension_index[0] = error_counter_index;
 	ret = event_notifier_group->error_counter->ops->counter_add(
-			error_counter->counter, dimension_index, 1);
+			error_counter->counter, dimension_index, nr_errors);
 	if (ret)
 		WARN_ON_ONCE(1);
 }
 
+static void record_group_error(struct lttng_event_notifier_group *event_notifier_group,
+		uint64_t error_counter_index)
+{
+	record_group_errors(event_notifier_group, error_counter_index, 1);
+}
+
+static void record_error(struct lttng_event_notifier *event_notifier)
+{
+	record_group_error(event_notifier->group,
+		event_notifier->error_counter_index);
+}
+
+/*
+ * Wake up the reader of the notification channel, unless a wakeup is
+ * already pending: the reader drains the channel after acknowledging
+ * the wakeup.
+ */
 static
-void notification_send(struct lttng_event_notifier_notification *notif,
-		struct lttng_event_notifier *event_notifier)
+void notification_channel_wakeup(struct lttng_event_notifier_group *event_notifier_group,
+		struct lttng_notification_channel *notification_chan)
+{
+	struct lttng_ust_event_notifier_notification ust_notif = {0};
+	ssize_t ret;
+
+	/*
+	 * Order the commit of the notification before the load of
+	 * wakeup_pending. Paired with the barrier following its clear
+	 * in ustctl_ack_notification_wakeup().
+	 */
+	cmm_smp_mb();
+	if (CMM_LOAD_SHARED(notification_chan->wakeup_pending))
+		return;
+	if (uatomic_xchg(&notification_chan->wakeup_pending, 1))
+		return;
+
+	ust_notif.flags = LTTNG_UST_EVENT_NOTIFIER_NOTIFICATION_FLAG_WAKEUP;
+	ret = patient_write(event_notifier_group->notification_fd,
+			&ust_notif, sizeof(ust_notif));
+	if (ret != sizeof(ust_notif)) {
+		/* Let the next notification retry. */
+		uatomic_set(&notification_chan->wakeup_pending, 0);
+		DBG("Cannot send event_notifier notification channel wakeup: %s",
+			strerror(errno));
+	}
+}
+
+static
+void notification_channel_send(struct lttng_event_notifier_notification *notif,
+		struct lttng_ust_event_notifier_notification *ust_notif,
+		size_t content_len)
+{
+	struct lttng_event_notifier_group *event_notifier_group = notif->group;
+	struct lttng_channel *chan = event_notifier_group->notification_chan;
+	struct lttng_ust_lib_ring_buffer_ctx ctx;
+	int ret;
+
+	lib_ring_buffer_ctx_init(&ctx, chan->chan, NULL,
+			sizeof(*ust_notif) + content_len, sizeof(char), -1,
+			chan->handle, NULL);
+	ret = chan->ops->event_reserve(&ctx, 0);
+	if (ret) {
+		record_group_error(event_notifier_group, notif->error_counter_index);
+		DBG("Cannot reserve event_notifier notification in channel: %d",
+			ret);
+		return;
+	}
+	chan->ops->event_write(&ctx, ust_notif, sizeof(*ust_notif));
+	if (content_len)
+		chan->ops->event_write(&ctx, notif->capture_buf, content_len);
+	chan->ops->event_commit(&ctx);
+
+	notification_channel_wakeup(event_notifier_group,
+		caa_container_of(chan, struct lttng_notification_channel,
+			parent));
+}
+
+static
+void notification_send(struct lttng_event_notifier_notification *notif)
 {
 	ssize_t ret;
 	size_t content_len;
@@ -320,7 +325,9 @@ void notification_send(struct lttng_event_notifier_notification *notif,
 
 	assert(notif);
 
-	ust_notif.token = event_notifier->user_token;
+	ust_notif.token = notif->event_notifier_token;
+	ust_notif.nr_hits = notif->nr_hits;
+	ust_notif.flags = notif->flags;
 
 	/*
 	 * Prepare sending the notification from multiple buffers using an
@@ -354,11 +361,22 @@ void notification_send(struct lttng_event_notifier_notification *notif,
 	 */
 	ust_notif.capture_buf_size = content_len;
 
+	/*
+	 * load-acquire paired with store-release in
+	 * lttng_notification_channel_cmd orders the mapping of the
+	 * notification channel before its use.
+	 */
+	if (CMM_LOAD_SHARED(notif->group->notification_chan_ready)) {
+		cmm_smp_mb();
+		notification_channel_send(notif, &ust_notif, content_len);
+		return;
+	}
+
 	/* Send all the buffers. */
 	ret = patient_writev(notif->notification_fd, iov, iovec_count);
 	if (ret == -1) {
 		if (errno == EAGAIN) {
-			record_error(event_notifier);
+			record_group_error(notif->group, notif->error_counter_index);
 			DBG("Cannot send event_notifier notification without blocking: %s",
 				strerror(errno));
 		} else {
@@ -369,9 +387,94 @@ void notification_send(struct lttng_event_notifier_notification *notif,
 	}
 }
 
-void lttng_event_notifier_notification_send(
-		struct lttng_event_notifier *event_notifier,
-		const char *stack_data)
+/*
+ * Count a hit in the current window of the rate policy. Returns the
+ * number of hits in the window, including this one, saturated at
+ * RATE_HITS_MASK.
+ */
+static
+unsigned long rate_window_hit(struct lttng_event_notifier_rate *rate)
+{
+	unsigned long window, old, new, cur;
+	struct timespec ts;
+	uint64_t now;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &ts))
+		return 1;
+	now = (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+	window = (now / rate->window_ns) & (~0UL >> RATE_HITS_BITS);
+
+	old = uatomic_read(&rate->window_hits);
+	for (;;) {
+		if ((old >> RATE_HITS_BITS) == window) {
+			if ((old & RATE_HITS_MASK) == RATE_HITS_MASK)
+				return RATE_HITS_MASK;
+			new = old + 1;
+		} else {
+			new = (window << RATE_HITS_BITS) | 1;
+		}
+		cur = uatomic_cmpxchg(&rate->window_hits, old, new);
+		if (cur == old)
+			return new & RATE_HITS_MASK;
+		old = cur;
+	}
+}
+
+/*
+ * Apply the rate policy of the event notifier to a hit. Returns true if
+ * the hit is notified, with the number of hits it stands for in
+ * nr_hits.
+ */
+static
+bool rate_policy_notify(struct lttng_event_notifier *event_notifier,
+		uint64_t *nr_hits)
+{
+	struct lttng_event_notifier_rate *rate = event_notifier->rate;
+	unsigned long hits;
+
+	switch (rate->policy) {
+	case LTTNG_UST_EVENT_NOTIFIER_RATE_LIMIT:
+		if (rate_window_hit(rate) <= rate->count)
+			return true;
+		break;
+	case LTTNG_UST_EVENT_NOTIFIER_RATE_EVERY_NTH:
+		hits = uatomic_add_return(&rate->hits, 1);
+		if ((hits - 1) % rate->count == 0)
+			return true;
+		break;
+	case LTTNG_UST_EVENT_NOTIFIER_RATE_COALESCE:
+		if (rate_window_hit(rate) == 1) {
+			*nr_hits = uatomic_xchg(&rate->coalesced, 0) + 1;
+			return true;
+		}
+		uatomic_inc(&rate->coalesced);
+		return false;
+	default:
+		return true;
+	}
+	/* Suppressed hit. */
+	record_error(event_notifier);
+	return false;
+}
+
+void lttng_event_notifier_enabler_rate_flush(
+		struct lttng_event_notifier_enabler *event_notifier_enabler)
+{
+	struct lttng_event_notifier_rate *rate = &event_notifier_enabler->rate;
+	unsigned long coalesced;
+
+	if (rate->policy != LTTNG_UST_EVENT_NOTIFIER_RATE_COALESCE)
+		return;
+	coalesced = uatomic_xchg(&rate->coalesced, 0);
+	if (coalesced)
+		record_group_errors(event_notifier_enabler->group,
+			event_notifier_enabler->error_counter_index,
+			(int64_t) coalesced);
+}
+
+static
+void notify(struct lttng_event_notifier *event_notifier,
+		const char *stack_data, uint64_t nr_hits, uint8_t flags)
 {
 	/*
 	 * This function is called from the probe, we must do dynamic
@@ -380,6 +483,8 @@ void lttng_event_notifier_notification_send(
 	struct lttng_event_notifier_notification notif = {0};
 
 	notification_init(&notif, event_notifier);
+	notif.nr_hits = nr_hits;
+	notif.flags = flags;
 
 	if (caa_unlikely(!cds_list_empty(&event_notifier->capture_bytecode_runtime_head))) {
 		struct lttng_bytecode_runtime *capture_bc_runtime;
@@ -406,5 +511,252 @@ void lttng_event_notifier_notification_send(
 	 * Send the notification (including the capture buffer) to the
 	 * sessiond.
 	 */
-	notification_send(&notif, event_notifier);
+	notification_send(&notif);
+}
+
+void lttng_event_notifier_notification_send(
+		struct lttng_event_notifier *event_notifier,
+		const char *stack_data)
+{
+	uint64_t nr_hits = 1;
+
+	/* Evaluated before the captures, which suppressed hits skip. */
+	if (event_notifier->rate && !rate_policy_notify(event_notifier, &nr_hits))
+		return;
+
+	notify(event_notifier, stack_data, nr_hits, 0);
+}
+
+/*
+ * Session action: the first hit since the action was armed runs it on
+ * the channels of the session, then tells the sessiond, which collects
+ * the buffers and re-arms the action.
+ */
+void lttng_event_notifier_session_action_run(
+		struct lttng_event_notifier *event_notifier,
+		const char *stack_data)
+{
+	struct lttng_event_notifier_session_action *action =
+		event_notifier->session_action;
+	struct lttng_session *session;
+
+	/* Keep the common case, a disarmed action, free of atomics. */
+	if (!CMM_LOAD_SHARED(action->armed) ||
+			uatomic_cmpxchg(&action->armed, 1, 0) != 1)
+		return;
+	session = CMM_LOAD_SHARED(action->session);
+	if (!session)
+		return;
+	lttng_session_trigger(session, action->ops, action->freeze_id);
+
+	notify(event_notifier, stack_data, 1,
+		LTTNG_UST_EVENT_NOTIFIER_NOTIFICATION_FLAG_SESSION_ACTION);
+}
+
+/*
+ * Index of a key capture in a dimension of the map counter. The last
+ * index of the dimension is the overflow slot.
+ */
+static
+size_t map_key_index(struct lttng_interpreter_output *output, bool captured,
+		size_t dimension_size)
+{
+	size_t overflow_index = dimension_size - 1;
+
+	if (!captured)
+		return overflow_index;
+
+	switch (output->type) {
+	case LTTNG_INTERPRETER_TYPE_S64:
+	case LTTNG_INTERPRETER_TYPE_SIGNED_ENUM:
+		if (output->u.s >= 0 && (uint64_t) output->u.s < overflow_index)
+			return output->u.s;
+		return overflow_index;
+	case LTTNG_INTERPRETER_TYPE_U64:
+	case LTTNG_INTERPRETER_TYPE_UNSIGNED_ENUM:
+		if (output->u.u < overflow_index)
+			return output->u.u;
+		return overflow_index;
+	case LTTNG_INTERPRETER_TYPE_STRING:
+		if (!overflow_index)
+			return 0;
+		return jhash(output->u.str.str,
+			strnlen(output->u.str.str, output->u.str.len), 0)
+				% overflow_index;
+	default:
+		return overflow_index;
+	}
+}
+
+/*
+ * Returns 0 on success, -1 if the capture is not a number, or is a
+ * floating point number which does not convert to int64_t: NaN,
+ * infinities and values out of range.
+ */
+static
+int map_value(struct lttng_interpreter_output *output, int64_t *value)
+{
+	switch (output->type) {
+	case LTTNG_INTERPRETER_TYPE_S64:
+	case LTTNG_INTERPRETER_TYPE_SIGNED_ENUM:
+		*value = output->u.s;
+		return 0;
+	case LTTNG_INTERPRETER_TYPE_U64:
+	case LTTNG_INTERPRETER_TYPE_UNSIGNED_ENUM:
+		*value = (int64_t) output->u.u;
+		return 0;
+	case LTTNG_INTERPRETER_TYPE_DOUBLE:
+		/* -2^63 and 2^63 are exact doubles. False for NaN. */
+		if (!(output->u.d >= -9223372036854775808.0
+				&& output->u.d < 9223372036854775808.0))
+			return -1;
+		*value = (int64_t) output->u.d;
+		return 0;
+	default:
+		return -1;
+	}
+}
+
+static
+size_t map_bucket_index(struct lttng_event_notifier_map *map, int64_t value,
+		size_t dimension_size)
+{
+	uint64_t bucket;
+
+	if (map->op == LTTNG_UST_MAP_OP_HIST_LOG2) {
+		if (value < 1)
+			bucket = 0;
+		else
+			bucket = 64 - __builtin_clzll((uint64_t) value);
+	} else {
+		if (value < map->bucket_min)
+			bucket = 0;
+		else
+			bucket = ((uint64_t) value - (uint64_t) map->bucket_min)
+					/ map->bucket_width;
+	}
+	if (bucket >= dimension_size)
+		bucket = dimension_size - 1;
+	return bucket;
+}
+
+/*
+ * Map action: aggregate the captures of the event notifier into its map
+ * counter instead of sending a notification. Called from the probe,
+ * must not allocate memory.
+ */
+void lttng_event_notifier_map_update(
+		struct lttng_event_notifier *event_notifier,
+		const char *stack_data)
+{
+	struct lttng_event_notifier_map *map = event_notifier->map;
+	size_t dimension_indexes[LTTNG_UST_COUNTER_DIMENSION_MAX];
+	struct lttng_bytecode_runtime *capture_bc_runtime;
+	size_t nr_keys, nr_dimensions, i = 0;
+	struct lttng_counter *counter;
+	int64_t value = 1;
+	bool has_value, value_overflow = false;
+
+	counter = CMM_LOAD_SHARED(map->counter);
+	/*
+	 * load-acquire paired with store-release in
+	 * lttng_event_notifier_enabler_attach_map_counter orders the
+	 * dimensions of the map before the counter is used.
+	 */
+	cmm_smp_mb();
+	/* The counter is attached after the event notifier is enabled. */
+	if (!counter)
+		return;
+
+	has_value = map->op != LTTNG_UST_MAP_OP_COUNT;
+	if (event_notifier->num_captures < has_value)
+		goto error;
+	nr_keys = event_notifier->num_captures - has_value;
+	nr_dimensions = nr_keys;
+	if (map->op == LTTNG_UST_MAP_OP_HIST_LOG2 ||
+			map->op == LTTNG_UST_MAP_OP_HIST_LINEAR)
+		nr_dimensions++;
+	if (nr_dimensions != map->nr_dimensions)
+		goto error;
+
+	cds_list_for_each_entry(capture_bc_runtime,
+			&event_notifier->capture_bytecode_runtime_head, node) {
+		struct lttng_interpreter_output output;
+		bool captured;
+
+		captured = capture_bc_runtime->interpreter_funcs.capture(
+				capture_bc_runtime, stack_data, &output)
+					& LTTNG_INTERPRETER_RECORD_FLAG;
+		if (i < nr_keys) {
+			dimension_indexes[i] = map_key_index(&output, captured,
+					map->dimension_size[i]);
+		} else if (!captured || map_value(&output, &value)) {
+			value_overflow = true;
+		}
+		i++;
+	}
+
+	/* Captures which failed to link are not in the list. */
+	if (i != event_notifier->num_captures)
+		goto error;
+
+	switch (map->op) {
+	case LTTNG_UST_MAP_OP_COUNT:
+		break;
+	case LTTNG_UST_MAP_OP_SUM:
+		if (value_overflow)
+			goto error;
+		break;
+	case LTTNG_UST_MAP_OP_HIST_LOG2:
+	case LTTNG_UST_MAP_OP_HIST_LINEAR:
+		if (value_overflow)
+			dimension_indexes[nr_keys] =
+				map->dimension_size[nr_keys] - 1;
+		else
+			dimension_indexes[nr_keys] = map_bucket_index(map,
+					value, map->dimension_size[nr_keys]);
+		value = 1;
+		break;
+	}
+	(void) counter->ops->counter_add(counter->counter, dimension_indexes,
+			value);
+	return;
+
+error:
+	record_error(event_notifier);
+}
+
+/*
+ * Map threshold: called by the add which carried the per-CPU counter
+ * of an element into the global map counter, when the sum of the
+ * element reaches the threshold. The captures of the notification are
+ * the dimension indexes of the element, then its sum.
+ */
+void lttng_event_notifier_map_threshold_notify(struct lib_counter *counter,
+		const size_t *dimension_indexes, int64_t value, void *priv)
+{
+	struct lttng_event_notifier_enabler *event_notifier_enabler = priv;
+	struct lttng_event_notifier_group *event_notifier_group =
+			event_notifier_enabler->group;
+	struct lttng_event_notifier_notification notif = {0};
+	size_t i;
+
+	notif.event_notifier_token = event_notifier_enabler->user_token;
+	notif.notification_fd = event_notifier_group->notification_fd;
+	notif.group = event_notifier_group;
+	notif.error_counter_index = event_notifier_enabler->error_counter_index;
+	notif.nr_hits = 1;
+	notif.flags = LTTNG_UST_EVENT_NOTIFIER_NOTIFICATION_FLAG_THRESHOLD;
+
+	lttng_msgpack_writer_init(&notif.writer, notif.capture_buf,
+			CAPTURE_BUFFER_SIZE);
+	lttng_msgpack_begin_array(&notif.writer,
+			event_notifier_enabler->map.nr_dimensions + 1);
+	for (i = 0; i < event_notifier_enabler->map.nr_dimensions; i++)
+		lttng_msgpack_write_unsigned_integer(&notif.writer,
+				dimension_indexes[i]);
+	lttng_msgpack_write_signed_integer(&notif.writer, value);
+	notif.has_captures = true;
+
+	notification_send(&notif);
 }
@@ -47,6 +47,14 @@ static struct lttng_env lttng_env[] = {
 	/* Env. var. which can be used in setuid/setgid executables. */
 	{ "LTTNG_UST_WITHOUT_BADDR_STATEDUMP", LTTNG_ENV_NOT_SECURE, NULL, },
 	{ "LTTNG_UST_REGISTER_TIMEOUT", LTTNG_ENV_NOT_SECURE, NULL, },
+	{ "LTTNG_UST_BULK_EVENT_REGISTRATION", LTTNG_ENV_NOT_SECURE, NULL, },
+	{ "LTTNG_UST_REGISTER_ASYNC", LTTNG_ENV_NOT_SECURE, NULL, },
+	{ "LTTNG_UST_SINGLE_LISTENER_THREAD", LTTNG_ENV_NOT_SECURE, NULL, },
+	{ "LTTNG_UST_FORK_REGISTER_DELAY", LTTNG_ENV_NOT_SECURE, NULL, },
+	{ "LTTNG_UST_FORK_MAX_REGISTRATIONS", LTTNG_ENV_NOT_SECURE, NULL, },
+	{ "LTTNG_UST_ELF_CACHE", LTTNG_ENV_NOT_SECURE, NULL, },
+	{ "LTTNG_UST_CALLSTACK_UNWINDER", LTTNG_ENV_NOT_SECURE, NULL, },
+	{ "LTTNG_UST_CALLSTACK_MAX_STACKS", LTTNG_ENV_NOT_SECURE, NULL, },
 
 	/* Env. var. which are not fetched in setuid/setgid executables. */
 	{ "LTTNG_UST_CLOCK_PLUGIN", LTTNG_ENV_SECURE, NULL, },
@@ -0,0 +1,467 @@
+/* SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * lttng-context-callstack.c
+ *
+ * LTTng UST user-space call stack context.
+ *
+ * The call stack of the traced thread is captured when the event
+ * record size is computed, interned in a per-process stack table, and
+ * only its 32-bit identifier is written in the event record. The
+ * return addresses of each stack are emitted once, by the
+ * lttng_ust_callstack:stack event when the stack is first seen, and by
+ * the lttng_ust_statedump:callstack state dump event for the sessions
+ * started later on.
+ *
+ * Two unwinders are available, selected with the
+ * LTTNG_UST_CALLSTACK_UNWINDER environment variable:
+ *
+ *   fp          Walk the frame pointer chain (default, where supported).
+ *               Requires the application and its tracepoint
+ *               providers to be built with -fno-omit-frame-pointer,
+ *               like this file and the ring buffer clients.
+ *   backtrace   Use backtrace(3), based on the unwind tables.
+ *
+ * Identifier 0 means that no stack is available: the stack table is
+ * full, the unwinder found no frame, or the event is the stack
+ * definition event itself.
+ */
+
+#define _LGPL_SOURCE
+#include <errno.h>
+#include <execinfo.h>
+#include <link.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <lttng/ust-events.h>
+#include <lttng/ust-tracer.h>
+#include <lttng/ringbuffer-config.h>
+#include <urcu/tls-compat.h>
+#include <urcu/uatomic.h>
+#include <helper.h>
+#include <usterr-signal-safe.h>
+#include "context-internal.h"
+#include "lttng-tracer-core.h"
+#include "getenv.h"
+#include "jhash.h"
+#include "rculfhash.h"
+
+#define TRACEPOINT_CREATE_PROBES
+#define TRACEPOINT_DEFINE
+#include "lttng-ust-callstack-provider.h"
+
+#define CALLSTACK_MAX_DEPTH		32
+#define CALLSTACK_SKIP_SLACK		16
+#define CALLSTACK_DEFAULT_MAX_STACKS	4096
+/* Same as the ring buffer nesting limit. */
+#define CALLSTACK_MAX_NESTING		4
+
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__)
+#define CALLSTACK_HAVE_FP_UNWINDER
+#endif
+
+enum callstack_unwinder {
+	CALLSTACK_UNWINDER_FP,
+	CALLSTACK_UNWINDER_BACKTRACE,
+};
+
+struct callstack_entry {
+	struct lttng_ust_lfht_node node;
+	uint32_t id;
+	uint32_t nr_ips;
+	int published;
+	unsigned long ips[CALLSTACK_MAX_DEPTH];
+};
+
+struct callstack_key {
+	const unsigned long *ips;
+	uint32_t nr_ips;
+};
+
+struct callstack_tls {
+	void *stack_lo, *stack_hi;
+	int stack_bounds_init;
+	int in_definition;
+	/* Stack identifiers, indexed by ring buffer nesting level. */
+	uint32_t id[CALLSTACK_MAX_NESTING];
+};
+
+static DEFINE_URCU_TLS(struct callstack_tls, callstack_tls);
+
+/* Ring buffer nesting count, see libringbuffer/frontend_internal.h. */
+extern DECLARE_URCU_TLS(unsigned int, lib_ring_buffer_nesting);
+
+/* Protected by ust_lock. */
+static int callstack_initialized;
+
+static enum callstack_unwinder callstack_unwinder;
+static struct lttng_ust_lfht *callstack_ht;
+static struct callstack_entry *callstack_entries;
+static unsigned long callstack_max_stacks;
+static unsigned long callstack_next_entry;
+static uint32_t callstack_seed;
+
+/* Text of liblttng-ust, whose frames are not part of the user stack. */
+static unsigned long ust_text_start, ust_text_end;
+
+static
+int find_ust_text_cb(struct dl_phdr_info *info, size_t size, void *data)
+{
+	unsigned long addr = (unsigned long) data;
+	unsigned long start = ULONG_MAX, end = 0;
+	int i;
+
+	for (i = 0; i < info->dlpi_phnum; i++) {
+		const ElfW(Phdr) *phdr = &info->dlpi_phdr[i];
+		unsigned long seg_start, seg_end;
+
+		if (phdr->p_type != PT_LOAD || !(phdr->p_flags & PF_X))
+			continue;
+		seg_start = info->dlpi_addr + phdr->p_vaddr;
+		seg_end = seg_start + phdr->p_memsz;
+		if (seg_start < start)
+			start = seg_start;
+		if (seg_end > end)
+			end = seg_end;
+	}
+	if (addr < start || addr >= end)
+		return 0;
+	ust_text_start = start;
+	ust_text_end = end;
+	return 1;
+}
+
+static
+int callstack_match(struct lttng_ust_lfht_node *node, const void *key)
+{
+	struct callstack_entry *entry =
+		caa_container_of(node, struct callstack_entry, node);
+	const struct callstack_key *k = key;
+
+	if (entry->nr_ips != k->nr_ips)
+		return 0;
+	return !memcmp(entry->ips, k->ips, k->nr_ips * sizeof(unsigned long));
+}
+
+#ifdef CALLSTACK_HAVE_FP_UNWINDER
+/*
+ * The bounds of the current thread stack, used to validate the frame
+ * pointers before dereferencing them. pthread_getattr_np() may
+ * allocate memory, so a nested event (e.g. from the libc wrapper)
+ * gets an empty stack while they are fetched.
+ */
+static
+int get_stack_bounds(void **lo, void **hi)
+{
+	struct callstack_tls *tls = &URCU_TLS(callstack_tls);
+
+	if (caa_unlikely(tls->stack_bounds_init <= 0)) {
+		pthread_attr_t attr;
+		void *addr;
+		size_t size;
+
+		if (tls->stack_bounds_init < 0)
+			return -1;
+		tls->stack_bounds_init = -1;
+		if (pthread_getattr_np(pthread_self(), &attr))
+			return -1;
+		if (pthread_attr_getstack(&attr, &addr, &size)) {
+			pthread_attr_destroy(&attr);
+			return -1;
+		}
+		pthread_attr_destroy(&attr);
+		tls->stack_lo = addr;
+		tls->stack_hi = (char *) addr + size;
+		tls->stack_bounds_init = 1;
+	}
+	*lo = tls->stack_lo;
+	*hi = tls->stack_hi;
+	return 0;
+}
+
+/*
+ * Each frame starts with the caller frame pointer, followed by the
+ * return address. Stop as soon as the chain leaves the thread stack,
+ * or does not grow towards the stack base.
+ */
+static
+int unwind_fp(unsigned long *ips, int max)
+{
+	void **fp = __builtin_frame_address(0);
+	void *lo, *hi;
+	int nr = 0;
+
+	if (get_stack_bounds(&lo, &hi))
+		return 0;
+	while (nr < max) {
+		void **next;
+
+		if ((void *) fp < lo || (void *) (fp + 2) > hi
+				|| ((unsigned long) fp & (sizeof(void *) - 1)))
+			break;
+		if (!fp[1])
+			break;
+		ips[nr++] = (unsigned long) fp[1];
+		next = fp[0];
+		if (next <= fp)
+			break;
+		fp = next;
+	}
+	return nr;
+}
+#else
+static
+int unwind_fp(unsigned long *ips, int max)
+{
+	return 0;
+}
+#endif
+
+static
+int unwind_backtrace(unsigned long *ips, int max)
+{
+	void *buf[CALLSTACK_MAX_DEPTH + CALLSTACK_SKIP_SLACK];
+	int nr, i;
+
+	nr = backtrace(buf, max);
+	for (i = 0; i < nr; i++)
+		ips[i] = (unsigned long) buf[i];
+	return nr;
+}
+
+/*
+ * Fill @ips with the return addresses of the current thread, skipping
+ * the liblttng-ust frames at the top of the stack.
+ */
+static
+uint32_t callstack_capture(unsigned long *ips)
+{
+	unsigned long raw[CALLSTACK_MAX_DEPTH + CALLSTACK_SKIP_SLACK];
+	int nr, skip = 0;
+
+	if (callstack_unwinder == CALLSTACK_UNWINDER_BACKTRACE)
+		nr = unwind_backtrace(raw, CAA_ARRAY_SIZE(raw));
+	else
+		nr = unwind_fp(raw, CAA_ARRAY_SIZE(raw));
+	while (skip < nr && raw[skip] >= ust_text_start
+			&& raw[skip] < ust_text_end)
+		skip++;
+	nr -= skip;
+	if (nr > CALLSTACK_MAX_DEPTH)
+		nr = CALLSTACK_MAX_DEPTH;
+	memcpy(ips, &raw[skip], nr * sizeof(unsigned long));
+	return nr;
+}
+
+/*
+ * Look up the stack in the table, inserting it if needed. Entries are
+ * never removed, so the lookup does not depend on the RCU read-side
+ * lock. When two threads insert the same stack concurrently, the
+ * entry of the loser stays unused.
+ */
+static
+uint32_t callstack_intern(const unsigned long *ips, uint32_t nr_ips)
+{
+	struct callstack_key key = { .ips = ips, .nr_ips = nr_ips };
+	struct lttng_ust_lfht_iter iter;
+	struct lttng_ust_lfht_node *node;
+	struct callstack_entry *entry;
+	unsigned long hash, index;
+
+	hash = jhash(ips, nr_ips * sizeof(unsigned long), callstack_seed);
+	lttng_ust_lfht_lookup(callstack_ht, hash, callstack_match, &key, &iter);
+	node = lttng_ust_lfht_iter_get_node(&iter);
+	if (caa_likely(node))
+		return caa_container_of(node, struct callstack_entry, node)->id;
+
+	if (CMM_LOAD_SHARED(callstack_next_entry) >= callstack_max_stacks)
+		return 0;
+	index = uatomic_add_return(&callstack_next_entry, 1) - 1;
+	if (index >= callstack_max_stacks)
+		return 0;
+	entry = &callstack_entries[index];
+	entry->id = index + 1;
+	entry->nr_ips = nr_ips;
+	memcpy(entry->ips, ips, nr_ips * sizeof(unsigned long));
+	lttng_ust_lfht_node_init(&entry->node);
+	node = lttng_ust_lfht_add_unique(callstack_ht, hash, callstack_match,
+			&key, &entry->node);
+	if (node != &entry->node)
+		return caa_container_of(node, struct callstack_entry, node)->id;
+
+	URCU_TLS(callstack_tls).in_definition = 1;
+	tracepoint(lttng_ust_callstack, stack, entry->id, entry->ips,
+		entry->nr_ips);
+	URCU_TLS(callstack_tls).in_definition = 0;
+	CMM_STORE_SHARED(entry->published, 1);
+	return entry->id;
+}
+
+/*
+ * The stack is captured when the context size is computed, which
+ * happens before the ring buffer nesting count is incremented by the
+ * reservation. The record callback therefore finds the identifier at
+ * the nesting level below the current one.
+ */
+static
+size_t callstack_get_size(struct lttng_ctx_field *field, size_t offset)
+{
+	struct callstack_tls *tls = &URCU_TLS(callstack_tls);
+	unsigned int nesting = URCU_TLS(lib_ring_buffer_nesting);
+	unsigned long ips[CALLSTACK_MAX_DEPTH];
+	uint32_t id = 0, nr_ips;
+	size_t size = 0;
+
+	if (caa_likely(nesting < CALLSTACK_MAX_NESTING)) {
+		if (!tls->in_definition) {
+			nr_ips = callstack_capture(ips);
+			if (nr_ips)
+				id = callstack_intern(ips, nr_ips);
+		}
+		tls->id[nesting] = id;
+	}
+	size += lib_ring_buffer_align(offset, lttng_alignof(uint32_t));
+	size += sizeof(uint32_t);
+	return size;
+}
+
+static
+void callstack_record(struct lttng_ctx_field *field,
+		 struct lttng_ust_lib_ring_buffer_ctx *ctx,
+		 struct lttng_channel *chan)
+{
+	unsigned int nesting = URCU_TLS(lib_ring_buffer_nesting) - 1;
+	uint32_t id = 0;
+
+	if (caa_likely(nesting < CALLSTACK_MAX_NESTING))
+		id = URCU_TLS(callstack_tls).id[nesting];
+	lib_ring_buffer_align_ctx(ctx, lttng_alignof(id));
+	chan->ops->event_write(ctx, &id, sizeof(id));
+}
+
+static
+int callstack_init(void)
+{
+	const char *str;
+	unsigned long nr_buckets = 1;
+
+	if (callstack_initialized)
+		return 0;
+
+	str = lttng_getenv("LTTNG_UST_CALLSTACK_UNWINDER");
+#ifdef CALLSTACK_HAVE_FP_UNWINDER
+	callstack_unwinder = CALLSTACK_UNWINDER_FP;
+#else
+	callstack_unwinder = CALLSTACK_UNWINDER_BACKTRACE;
+#endif
+	if (str && !strcmp(str, "backtrace")) {
+		callstack_unwinder = CALLSTACK_UNWINDER_BACKTRACE;
+	} else if (str && strcmp(str, "fp")) {
+		ERR("Unknown call stack unwinder \"%s\"", str);
+	}
+	if (callstack_unwinder == CALLSTACK_UNWINDER_BACKTRACE) {
+		void *buf[1];
+
+		/* Load the unwinder now rather than within a probe. */
+		(void) backtrace(buf, 1);
+	}
+
+	callstack_max_stacks = CALLSTACK_DEFAULT_MAX_STACKS;
+	str = lttng_getenv("LTTNG_UST_CALLSTACK_MAX_STACKS");
+	if (str) {
+		char *endptr;
+		unsigned long v;
+
+		errno = 0;
+		v = strtoul(str, &endptr, 10);
+		if (errno || *endptr || !v || v > UINT32_MAX)
+			ERR("Invalid LTTNG_UST_CALLSTACK_MAX_STACKS value \"%s\"", str);
+		else
+			callstack_max_stacks = v;
+	}
+	while (nr_buckets < callstack_max_stacks)
+		nr_buckets <<= 1;
+
+	callstack_entries = zmalloc(callstack_max_stacks
+			* sizeof(struct callstack_entry));
+	if (!callstack_entries)
+		return -ENOMEM;
+	callstack_ht = lttng_ust_lfht_new(nr_buckets, nr_buckets, nr_buckets,
+			0, NULL);
+	if (!callstack_ht) {
+		free(callstack_entries);
+		callstack_entries = NULL;
+		return -ENOMEM;
+	}
+	callstack_seed = (uint32_t) getpid();
+	dl_iterate_phdr(find_ust_text_cb, (void *) &callstack_init);
+	callstack_initialized = 1;
+	return 0;
+}
+
+int lttng_add_callstack_to_ctx(struct lttng_ctx **ctx)
+{
+	struct lttng_ctx_field *field;
+	int ret;
+
+	ret = callstack_init();
+	if (ret)
+		return ret;
+	field = lttng_append_context(ctx);
+	if (!field)
+		return -ENOMEM;
+	if (lttng_find_context(*ctx, "callstack")) {
+		lttng_remove_context_field(ctx, field);
+		return -EEXIST;
+	}
+	field->event_field.name = "callstack";
+	field->event_field.type.atype = atype_integer;
+	field->event_field.type.u.integer.size = sizeof(uint32_t) * CHAR_BIT;
+	field->event_field.type.u.integer.alignment = lttng_alignof(uint32_t) * CHAR_BIT;
+	field->event_field.type.u.integer.signedness = lttng_is_signed_type(uint32_t);
+	field->event_field.type.u.integer.reverse_byte_order = 0;
+	field->event_field.type.u.integer.base = 10;
+	field->event_field.type.u.integer.encoding = lttng_encode_none;
+	field->get_size = callstack_get_size;
+	field->record = callstack_record;
+	lttng_context_update(*ctx);
+	return 0;
+}
+
+/*
+ * Iterate on the stacks defined so far, for the state dump. Called
+ * with the ust_lock held.
+ */
+void lttng_context_callstack_for_each(
+		void (*cb)(uint32_t id, const unsigned long *ips,
+			uint32_t nr_ips, void *priv),
+		void *priv)
+{
+	unsigned long i, nr;
+
+	if (!callstack_initialized)
+		return;
+	nr = CMM_LOAD_SHARED(callstack_next_entry);
+	if (nr > callstack_max_stacks)
+		nr = callstack_max_stacks;
+	for (i = 0; i < nr; i++) {
+		struct callstack_entry *entry = &callstack_entries[i];
+
+		if (!CMM_LOAD_SHARED(entry->published))
+			continue;
+		cb(entry->id, entry->ips, entry->nr_ips, priv);
+	}
+}
+
+/*
+ * Force a read (imply TLS fixup for dlopen) of TLS variables.
+ */
+void lttng_fixup_callstack_tls(void)
+{
+	asm volatile ("" : : "m" (URCU_TLS(callstack_tls)));
+}
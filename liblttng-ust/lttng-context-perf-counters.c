@@ -47,29 +47,54 @@
 
 /*
  * We use a global perf counter key and iterate on per-thread RCU lists
- * of fields in the fast path, even though this is not strictly speaking
+ * of groups in the fast path, even though this is not strictly speaking
  * what would provide the best fast-path complexity, to ensure teardown
  * of sessions vs thread exit is handled racelessly.
  *
- * Updates and traversals of thread_list are protected by UST lock.
- * Updates to rcu_field_list are protected by UST lock.
+ * The perf counter fields of a context are gathered in groups, opened
+ * as one perf event group per thread. All counters of a group are read
+ * at once when the first field of the group is recorded, and the other
+ * fields of the group record the values of this snapshot.
+ *
+ * Updates and traversals of thread_group_list are protected by UST lock.
+ * Updates to rcu_group_list are protected by UST lock.
+ */
+
+/*
+ * Number of generic counters commonly available on PMUs. A larger
+ * group could never be scheduled on the PMU as a whole.
  */
+#define LTTNG_PERF_GROUP_MAX_FIELDS	4
 
-struct lttng_perf_counter_thread_field {
-	struct lttng_perf_counter_field *field;	/* Back reference */
+struct lttng_perf_counter_thread_counter {
 	struct perf_event_mmap_page *pc;
-	struct cds_list_head thread_field_node;	/* Per-field list of thread fields (node) */
-	struct cds_list_head rcu_field_node;	/* RCU per-thread list of fields (node) */
-	int fd;					/* Perf FD */
+	int read_index;				/* Index in group read, -1 if not opened */
+};
+
+struct lttng_perf_counter_thread_group {
+	struct lttng_perf_counter_group *group;	/* Back reference */
+	struct cds_list_head thread_group_node;	/* Per-group list of thread groups (node) */
+	struct cds_list_head rcu_group_node;	/* RCU per-thread list of groups (node) */
+	int fd;					/* Group leader perf FD */
+	unsigned int nr_counters;
+	struct lttng_perf_counter_thread_counter counters[LTTNG_PERF_GROUP_MAX_FIELDS];
+	uint64_t values[LTTNG_PERF_GROUP_MAX_FIELDS];	/* Last snapshot */
 };
 
 struct lttng_perf_counter_thread {
-	struct cds_list_head rcu_field_list;	/* RCU per-thread list of fields */
+	struct cds_list_head rcu_group_list;	/* RCU per-thread list of groups */
+};
+
+struct lttng_perf_counter_group {
+	struct perf_event_attr attr[LTTNG_PERF_GROUP_MAX_FIELDS];
+	unsigned int nr_fields;
+	unsigned int refcount;			/* Protected by UST lock */
+	struct cds_list_head thread_group_list;	/* Per-group list of thread groups */
 };
 
 struct lttng_perf_counter_field {
-	struct perf_event_attr attr;
-	struct cds_list_head thread_field_list;	/* Per-field list of thread fields */
+	struct lttng_perf_counter_group *group;
+	unsigned int index;			/* Index within the group */
 };
 
 static pthread_key_t perf_counter_key;
@@ -176,20 +201,30 @@ size_t perf_counter_get_size(struct lttng_ctx_field *field, size_t offset)
 	return size;
 }
 
+/*
+ * Read all the counters of the group with a single system call on the
+ * group leader.
+ */
 static
-uint64_t read_perf_counter_syscall(
-		struct lttng_perf_counter_thread_field *thread_field)
+void read_perf_group_syscall(
+		struct lttng_perf_counter_thread_group *thread_group)
 {
-	uint64_t count;
-
-	if (caa_unlikely(thread_field->fd < 0))
-		return 0;
-
-	if (caa_unlikely(read(thread_field->fd, &count, sizeof(count))
-				< sizeof(count)))
-		return 0;
-
-	return count;
+	uint64_t buf[1 + LTTNG_PERF_GROUP_MAX_FIELDS];
+	unsigned int i;
+	ssize_t len;
+
+	len = -1;
+	if (caa_likely(thread_group->fd >= 0))
+		len = read(thread_group->fd, buf, sizeof(buf));
+	for (i = 0; i < thread_group->nr_counters; i++) {
+		int read_index = thread_group->counters[i].read_index;
+
+		if (caa_unlikely(read_index < 0 || len < 0
+				|| (size_t) len < (read_index + 2) * sizeof(uint64_t)))
+			thread_group->values[i] = 0;
+		else
+			thread_group->values[i] = buf[read_index + 1];
+	}
 }
 
 #if defined(__x86_64__) || defined(__i386__)
@@ -213,62 +248,92 @@ bool has_rdpmc(struct perf_event_mmap_page *pc)
 	return pc->cap_user_rdpmc;
 }
 
+/*
+ * Read all the counters of the group within a single sequence: retry
+ * if any of them was updated by the kernel (e.g. rescheduled) while
+ * reading, so the snapshot is consistent across the group. Members
+ * which could not be opened read as 0, consistently with
+ * read_perf_group_syscall() and with arch_perf_keep_fd() which does not
+ * keep the group leader file descriptor for them.
+ */
 static
-uint64_t arch_read_perf_counter(
-		struct lttng_perf_counter_thread_field *thread_field)
+void arch_read_perf_group(
+		struct lttng_perf_counter_thread_group *thread_group)
 {
-	uint32_t seq, idx;
-	uint64_t count;
-	struct perf_event_mmap_page *pc = thread_field->pc;
-
-	if (caa_unlikely(!pc))
-		return 0;
-
-	do {
-		seq = CMM_LOAD_SHARED(pc->lock);
-		cmm_barrier();
-
-		idx = pc->index;
-		if (caa_likely(has_rdpmc(pc) && idx)) {
-			int64_t pmcval;
-
-			pmcval = rdpmc(idx - 1);
-			/* Sign-extend the pmc register result. */
-			pmcval <<= 64 - pc->pmc_width;
-			pmcval >>= 64 - pc->pmc_width;
-			count = pc->offset + pmcval;
-		} else {
-			/* Fall-back on system call if rdpmc cannot be used. */
-			return read_perf_counter_syscall(thread_field);
+	uint32_t seq[LTTNG_PERF_GROUP_MAX_FIELDS];
+	unsigned int i, nr = thread_group->nr_counters;
+
+retry:
+	for (i = 0; i < nr; i++) {
+		struct perf_event_mmap_page *pc = thread_group->counters[i].pc;
+
+		if (caa_unlikely(thread_group->counters[i].read_index < 0))
+			continue;
+		if (caa_unlikely(!pc))
+			goto syscall;
+		seq[i] = CMM_LOAD_SHARED(pc->lock);
+	}
+	cmm_barrier();
+	for (i = 0; i < nr; i++) {
+		struct perf_event_mmap_page *pc = thread_group->counters[i].pc;
+		uint32_t idx;
+		int64_t pmcval;
+
+		if (caa_unlikely(thread_group->counters[i].read_index < 0)) {
+			thread_group->values[i] = 0;
+			continue;
 		}
-		cmm_barrier();
-	} while (CMM_LOAD_SHARED(pc->lock) != seq);
+		idx = pc->index;
+		/* Fall-back on system call if rdpmc cannot be used. */
+		if (caa_unlikely(!has_rdpmc(pc) || !idx))
+			goto syscall;
+		pmcval = rdpmc(idx - 1);
+		/* Sign-extend the pmc register result. */
+		pmcval <<= 64 - pc->pmc_width;
+		pmcval >>= 64 - pc->pmc_width;
+		thread_group->values[i] = pc->offset + pmcval;
+	}
+	cmm_barrier();
+	for (i = 0; i < nr; i++) {
+		if (caa_unlikely(thread_group->counters[i].read_index < 0))
+			continue;
+		if (CMM_LOAD_SHARED(thread_group->counters[i].pc->lock) != seq[i])
+			goto retry;
+	}
+	return;
 
-	return count;
+syscall:
+	read_perf_group_syscall(thread_group);
 }
 
 static
-int arch_perf_keep_fd(struct lttng_perf_counter_thread_field *thread_field)
+int arch_perf_keep_fd(struct lttng_perf_counter_thread_group *thread_group)
 {
-	struct perf_event_mmap_page *pc = thread_field->pc;
+	unsigned int i;
 
-	if (!pc)
-		return 0;
-	return !has_rdpmc(pc);
+	for (i = 0; i < thread_group->nr_counters; i++) {
+		struct perf_event_mmap_page *pc = thread_group->counters[i].pc;
+
+		if (thread_group->counters[i].read_index < 0)
+			continue;
+		if (!pc || !has_rdpmc(pc))
+			return 1;
+	}
+	return 0;
 }
 
 #else
 
 /* Generic (slow) implementation using a read system call. */
 static
-uint64_t arch_read_perf_counter(
-		struct lttng_perf_counter_thread_field *thread_field)
+void arch_read_perf_group(
+		struct lttng_perf_counter_thread_group *thread_group)
 {
-	return read_perf_counter_syscall(thread_field);
+	read_perf_group_syscall(thread_group);
 }
 
 static
-int arch_perf_keep_fd(struct lttng_perf_counter_thread_field *thread_field)
+int arch_perf_keep_fd(struct lttng_perf_counter_thread_group *thread_group)
 {
 	return 1;
 }
@@ -285,11 +350,11 @@ int sys_perf_event_open(struct perf_event_attr *attr,
 }
 
 static
-int open_perf_fd(struct perf_event_attr *attr)
+int open_perf_fd(struct perf_event_attr *attr, int group_fd)
 {
 	int fd;
 
-	fd = sys_perf_event_open(attr, 0, -1, -1, 0);
+	fd = sys_perf_event_open(attr, 0, -1, group_fd, 0);
 	if (fd < 0)
 		return -1;
 
@@ -310,20 +375,16 @@ void close_perf_fd(int fd)
 	}
 }
 
-static void setup_perf(struct lttng_perf_counter_thread_field *thread_field)
+static
+struct perf_event_mmap_page *map_perf_page(int fd)
 {
 	void *perf_addr;
 
 	perf_addr = mmap(NULL, sizeof(struct perf_event_mmap_page),
-			PROT_READ, MAP_SHARED, thread_field->fd, 0);
+			PROT_READ, MAP_SHARED, fd, 0);
 	if (perf_addr == MAP_FAILED)
-		perf_addr = NULL;
-	thread_field->pc = perf_addr;
-
-	if (!arch_perf_keep_fd(thread_field)) {
-		close_perf_fd(thread_field->fd);
-		thread_field->fd = -1;
-	}
+		return NULL;
+	return perf_addr;
 }
 
 static
@@ -360,7 +421,7 @@ struct lttng_perf_counter_thread *alloc_perf_counter_thread(void)
 	perf_thread = zmalloc(sizeof(*perf_thread));
 	if (!perf_thread)
 		abort();
-	CDS_INIT_LIST_HEAD(&perf_thread->rcu_field_list);
+	CDS_INIT_LIST_HEAD(&perf_thread->rcu_group_list);
 	ret = pthread_setspecific(perf_counter_key, perf_thread);
 	if (ret)
 		abort();
@@ -371,12 +432,57 @@ skip:
 	return perf_thread;
 }
 
+/*
+ * Open the counters of the group for the current thread. The mapping
+ * of each counter stays valid after its file descriptor is closed, and
+ * only the group leader file descriptor is needed to read the whole
+ * group with a system call.
+ */
 static
-struct lttng_perf_counter_thread_field *
-	add_thread_field(struct lttng_perf_counter_field *perf_field,
+void setup_perf_group(struct lttng_perf_counter_thread_group *thread_group)
+{
+	struct lttng_perf_counter_group *group = thread_group->group;
+	unsigned int i, nr_read = 0;
+
+	thread_group->fd = -1;
+	thread_group->nr_counters = group->nr_fields;
+	for (i = 0; i < group->nr_fields; i++) {
+		struct lttng_perf_counter_thread_counter *counter =
+			&thread_group->counters[i];
+		int fd;
+
+		counter->read_index = -1;
+		if (i && thread_group->fd < 0)
+			continue;
+		fd = open_perf_fd(&group->attr[i], i ? thread_group->fd : -1);
+		if (fd < 0)
+			continue;
+		counter->pc = map_perf_page(fd);
+		if (!i) {
+			thread_group->fd = fd;
+		} else {
+			close_perf_fd(fd);
+			/*
+			 * Without a mapping, closing the file descriptor
+			 * releases the member, which leaves the group read.
+			 */
+			if (!counter->pc)
+				continue;
+		}
+		counter->read_index = nr_read++;
+	}
+	if (thread_group->fd >= 0 && !arch_perf_keep_fd(thread_group)) {
+		close_perf_fd(thread_group->fd);
+		thread_group->fd = -1;
+	}
+}
+
+static
+struct lttng_perf_counter_thread_group *
+	add_thread_group(struct lttng_perf_counter_group *group,
 		struct lttng_perf_counter_thread *perf_thread)
 {
-	struct lttng_perf_counter_thread_field *thread_field;
+	struct lttng_perf_counter_thread_group *thread_group;
 	sigset_t newmask, oldmask;
 	int ret;
 
@@ -387,65 +493,76 @@ struct lttng_perf_counter_thread_field *
 	if (ret)
 		abort();
 	/* Check again with signals disabled */
-	cds_list_for_each_entry_rcu(thread_field, &perf_thread->rcu_field_list,
-			rcu_field_node) {
-		if (thread_field->field == perf_field)
+	cds_list_for_each_entry_rcu(thread_group, &perf_thread->rcu_group_list,
+			rcu_group_node) {
+		if (thread_group->group == group)
 			goto skip;
 	}
-	thread_field = zmalloc(sizeof(*thread_field));
-	if (!thread_field)
+	thread_group = zmalloc(sizeof(*thread_group));
+	if (!thread_group)
 		abort();
-	thread_field->field = perf_field;
-	thread_field->fd = open_perf_fd(&perf_field->attr);
-	if (thread_field->fd >= 0)
-		setup_perf(thread_field);
+	thread_group->group = group;
 	/*
-	 * Note: thread_field->pc can be NULL if setup_perf() fails.
-	 * Also, thread_field->fd can be -1 if open_perf_fd() fails.
+	 * Note: the mapping of a counter can be NULL, and the group
+	 * leader fd can be -1, if opening the counters fails.
 	 */
+	setup_perf_group(thread_group);
 	lttng_perf_lock();
-	cds_list_add_rcu(&thread_field->rcu_field_node,
-			&perf_thread->rcu_field_list);
-	cds_list_add(&thread_field->thread_field_node,
-			&perf_field->thread_field_list);
+	cds_list_add_rcu(&thread_group->rcu_group_node,
+			&perf_thread->rcu_group_list);
+	cds_list_add(&thread_group->thread_group_node,
+			&group->thread_group_list);
 	lttng_perf_unlock();
 skip:
 	ret = pthread_sigmask(SIG_SETMASK, &oldmask, NULL);
 	if (ret)
 		abort();
-	return thread_field;
+	return thread_group;
 }
 
 static
-struct lttng_perf_counter_thread_field *
-		get_thread_field(struct lttng_perf_counter_field *field)
+struct lttng_perf_counter_thread_group *
+		get_thread_group(struct lttng_perf_counter_group *group)
 {
 	struct lttng_perf_counter_thread *perf_thread;
-	struct lttng_perf_counter_thread_field *thread_field;
+	struct lttng_perf_counter_thread_group *thread_group;
 
 	perf_thread = pthread_getspecific(perf_counter_key);
 	if (!perf_thread)
 		perf_thread = alloc_perf_counter_thread();
-	cds_list_for_each_entry_rcu(thread_field, &perf_thread->rcu_field_list,
-			rcu_field_node) {
-		if (thread_field->field == field)
-			return thread_field;
+	cds_list_for_each_entry_rcu(thread_group, &perf_thread->rcu_group_list,
+			rcu_group_node) {
+		if (thread_group->group == group)
+			return thread_group;
 	}
-	/* perf_counter_thread_field not found, need to add one */
-	return add_thread_field(field, perf_thread);
+	/* perf_counter_thread_group not found, need to add one */
+	return add_thread_group(group, perf_thread);
 }
 
+/*
+ * Read the group counters if @refresh is set, else return the value of
+ * the last snapshot taken by this thread.
+ */
 static
-uint64_t wrapper_perf_counter_read(struct lttng_ctx_field *field)
+uint64_t wrapper_perf_counter_read(struct lttng_ctx_field *field,
+		bool refresh)
 {
 	struct lttng_perf_counter_field *perf_field;
-	struct lttng_perf_counter_thread_field *perf_thread_field;
+	struct lttng_perf_counter_thread_group *thread_group;
 
 	perf_field = field->u.perf_counter;
-	perf_thread_field = get_thread_field(perf_field);
-	return arch_read_perf_counter(perf_thread_field);
+	thread_group = get_thread_group(perf_field->group);
+	if (caa_unlikely(perf_field->index >= thread_group->nr_counters))
+		return 0;
+	if (refresh)
+		arch_read_perf_group(thread_group);
+	return thread_group->values[perf_field->index];
 }
 
+/*
+ * The fields of a group are recorded in order: the first one reads
+ * the whole group.
+ */
 static
 void perf_counter_record(struct lttng_ctx_field *field,
 		 struct lttng_ust_lib_ring_buffer_ctx *ctx,
@@ -453,7 +570,8 @@ void perf_counter_record(struct lttng_ctx_field *field,
 {
 	uint64_t value;
 
-	value = wrapper_perf_counter_read(field);
+	value = wrapper_perf_counter_read(field,
+			field->u.perf_counter->index == 0);
 	lib_ring_buffer_align_ctx(ctx, lttng_alignof(value));
 	chan->ops->event_write(ctx, &value, sizeof(value));
 }
@@ -462,31 +580,34 @@ static
 void perf_counter_get_value(struct lttng_ctx_field *field,
 		struct lttng_ctx_value *value)
 {
-	value->u.s64 = wrapper_perf_counter_read(field);
+	value->u.s64 = wrapper_perf_counter_read(field, true);
 }
 
 /* Called with perf lock held */
 static
-void lttng_destroy_perf_thread_field(
-		struct lttng_perf_counter_thread_field *thread_field)
+void lttng_destroy_perf_thread_group(
+		struct lttng_perf_counter_thread_group *thread_group)
 {
-	close_perf_fd(thread_field->fd);
-	unmap_perf_page(thread_field->pc);
-	cds_list_del_rcu(&thread_field->rcu_field_node);
-	cds_list_del(&thread_field->thread_field_node);
-	free(thread_field);
+	unsigned int i;
+
+	close_perf_fd(thread_group->fd);
+	for (i = 0; i < thread_group->nr_counters; i++)
+		unmap_perf_page(thread_group->counters[i].pc);
+	cds_list_del_rcu(&thread_group->rcu_group_node);
+	cds_list_del(&thread_group->thread_group_node);
+	free(thread_group);
 }
 
 static
 void lttng_destroy_perf_thread_key(void *_key)
 {
 	struct lttng_perf_counter_thread *perf_thread = _key;
-	struct lttng_perf_counter_thread_field *pos, *p;
+	struct lttng_perf_counter_thread_group *pos, *p;
 
 	lttng_perf_lock();
-	cds_list_for_each_entry_safe(pos, p, &perf_thread->rcu_field_list,
-			rcu_field_node)
-		lttng_destroy_perf_thread_field(pos);
+	cds_list_for_each_entry_safe(pos, p, &perf_thread->rcu_group_list,
+			rcu_group_node)
+		lttng_destroy_perf_thread_group(pos);
 	lttng_perf_unlock();
 	free(perf_thread);
 }
@@ -496,25 +617,29 @@ static
 void lttng_destroy_perf_counter_field(struct lttng_ctx_field *field)
 {
 	struct lttng_perf_counter_field *perf_field;
-	struct lttng_perf_counter_thread_field *pos, *p;
+	struct lttng_perf_counter_group *group;
+	struct lttng_perf_counter_thread_group *pos, *p;
 
 	free((char *) field->event_field.name);
 	perf_field = field->u.perf_counter;
+	group = perf_field->group;
+	free(perf_field);
+	if (--group->refcount)
+		return;
 	/*
 	 * This put is performed when no threads can concurrently
 	 * perform a "get" concurrently, thanks to urcu-bp grace
 	 * period. Holding the lttng perf lock protects against
-	 * concurrent modification of the per-thread thread field
+	 * concurrent modification of the per-thread thread group
 	 * list.
 	 */
 	lttng_perf_lock();
-	cds_list_for_each_entry_safe(pos, p, &perf_field->thread_field_list,
-			thread_field_node)
-		lttng_destroy_perf_thread_field(pos);
+	cds_list_for_each_entry_safe(pos, p, &group->thread_group_list,
+			thread_group_node)
+		lttng_destroy_perf_thread_group(pos);
 	lttng_perf_unlock();
-	free(perf_field);
+	free(group);
 }
-
 #ifdef __ARM_ARCH_7A__
 
 static
@@ -533,6 +658,60 @@ int perf_get_exclude_kernel(void)
 
 #endif /* __ARM_ARCH_7A__ */
 
+/*
+ * Check that the kernel accepts @attr as an additional member of the
+ * group, e.g. that all counters belong to the same PMU.
+ */
+static
+int perf_group_try_open(struct lttng_perf_counter_group *group,
+		struct perf_event_attr *attr)
+{
+	int fds[LTTNG_PERF_GROUP_MAX_FIELDS];
+	unsigned int i, nr_open = 0;
+	int fd, ret = -1;
+
+	for (i = 0; i < group->nr_fields; i++) {
+		fds[i] = open_perf_fd(&group->attr[i], i ? fds[0] : -1);
+		if (fds[i] < 0)
+			goto end;
+		nr_open++;
+	}
+	fd = open_perf_fd(attr, fds[0]);
+	if (fd < 0)
+		goto end;
+	close_perf_fd(fd);
+	ret = 0;
+end:
+	for (i = 0; i < nr_open; i++)
+		close_perf_fd(fds[i]);
+	return ret;
+}
+
+/*
+ * Find the group of the last perf counter field of the context, if it
+ * can take the counter described by @attr.
+ */
+static
+struct lttng_perf_counter_group *find_perf_group(struct lttng_ctx *ctx,
+		struct perf_event_attr *attr)
+{
+	int i;
+
+	for (i = ctx->nr_fields - 1; i >= 0; i--) {
+		struct lttng_perf_counter_group *group;
+
+		if (ctx->fields[i].destroy != lttng_destroy_perf_counter_field)
+			continue;
+		group = ctx->fields[i].u.perf_counter->group;
+		if (group->nr_fields >= LTTNG_PERF_GROUP_MAX_FIELDS)
+			return NULL;
+		if (perf_group_try_open(group, attr))
+			return NULL;
+		return group;
+	}
+	return NULL;
+}
+
 /* Called with UST lock held */
 int lttng_add_perf_counter_to_ctx(uint32_t type,
 				uint64_t config,
@@ -541,6 +720,8 @@ int lttng_add_perf_counter_to_ctx(uint32_t type,
 {
 	struct lttng_ctx_field *field;
 	struct lttng_perf_counter_field *perf_field;
+	struct lttng_perf_counter_group *group;
+	struct perf_event_attr attr;
 	char *name_alloc;
 	int ret;
 
@@ -564,8 +745,6 @@ int lttng_add_perf_counter_to_ctx(uint32_t type,
 		goto find_error;
 	}
 
-	field->destroy = lttng_destroy_perf_counter_field;
-
 	field->event_field.name = name_alloc;
 	field->event_field.type.atype = atype_integer;
 	field->event_field.type.u.integer.size =
@@ -581,20 +760,36 @@ int lttng_add_perf_counter_to_ctx(uint32_t type,
 	field->record = perf_counter_record;
 	field->get_value = perf_counter_get_value;
 
-	perf_field->attr.type = type;
-	perf_field->attr.config = config;
-	perf_field->attr.exclude_kernel = perf_get_exclude_kernel();
-	CDS_INIT_LIST_HEAD(&perf_field->thread_field_list);
-	field->u.perf_counter = perf_field;
+	memset(&attr, 0, sizeof(attr));
+	attr.type = type;
+	attr.config = config;
+	attr.exclude_kernel = perf_get_exclude_kernel();
+	attr.read_format = PERF_FORMAT_GROUP;
 
 	/* Ensure that this perf counter can be used in this process. */
-	ret = open_perf_fd(&perf_field->attr);
+	ret = open_perf_fd(&attr, -1);
 	if (ret < 0) {
 		ret = -ENODEV;
 		goto setup_error;
 	}
 	close_perf_fd(ret);
 
+	group = find_perf_group(*ctx, &attr);
+	if (!group) {
+		group = zmalloc(sizeof(*group));
+		if (!group) {
+			ret = -ENOMEM;
+			goto setup_error;
+		}
+		CDS_INIT_LIST_HEAD(&group->thread_group_list);
+	}
+	perf_field->group = group;
+	perf_field->index = group->nr_fields;
+	group->attr[group->nr_fields++] = attr;
+	group->refcount++;
+	field->u.perf_counter = perf_field;
+	field->destroy = lttng_destroy_perf_counter_field;
+
 	/*
 	 * Contexts can only be added before tracing is started, so we
 	 * don't have to synchronize against concurrent threads using
@@ -70,6 +70,31 @@ static int counter_clear(struct lib_counter *counter, const size_t *dimension_in
 	return lttng_counter_clear(&client_config, counter, dimension_indexes);
 }
 
+static int counter_read_range(struct lib_counter *counter, const size_t *dimension_indexes,
+			      size_t nr_elem, int cpu, int64_t *values,
+			      bool *overflow, bool *underflow)
+{
+	return lttng_counter_read_range(&client_config, counter, dimension_indexes, nr_elem,
+					cpu, values, overflow, underflow);
+}
+
+static int counter_aggregate_range(struct lib_counter *counter, const size_t *dimension_indexes,
+				   size_t nr_elem, int64_t *values,
+				   bool *overflow, bool *underflow)
+{
+	return lttng_counter_aggregate_range(&client_config, counter, dimension_indexes,
+					     nr_elem, values, overflow, underflow);
+}
+
+static int counter_aggregate_delta_range(struct lib_counter *counter,
+					 const size_t *dimension_indexes, size_t nr_elem,
+					 int64_t *deltas,
+					 bool *overflow, bool *underflow)
+{
+	return lttng_counter_aggregate_delta_range(&client_config, counter, dimension_indexes,
+						   nr_elem, deltas, overflow, underflow);
+}
+
 static struct lttng_counter_transport lttng_counter_transport = {
 	.name = "counter-per-cpu-32-modular",
 	.ops = {
@@ -79,6 +104,9 @@ static struct lttng_counter_transport lttng_counter_transport = {
 		.counter_read = counter_read,
 		.counter_aggregate = counter_aggregate,
 		.counter_clear = counter_clear,
+		.counter_read_range = counter_read_range,
+		.counter_aggregate_range = counter_aggregate_range,
+		.counter_aggregate_delta_range = counter_aggregate_delta_range,
 	},
 	.client_config = &client_config,
 };
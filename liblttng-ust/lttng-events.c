@@ -41,6 +41,7 @@
 #include <urcu/compiler.h>
 #include <urcu/hlist.h>
 #include <urcu/list.h>
+#include <urcu/rculist.h>
 #include <urcu/uatomic.h>
 
 #include <lttng/tracepoint.h>
@@ -67,8 +68,11 @@
 #include "ust-events-internal.h"
 #include "wait.h"
 #include "../libringbuffer/shm.h"
+#include "../libringbuffer/backend.h"
+#include "../libringbuffer/frontend.h"
 #include "../libcounter/counter.h"
 #include "jhash.h"
+#include "getenv.h"
 #include <lttng/ust-abi.h>
 
 /*
@@ -169,7 +173,8 @@ struct lttng_session *lttng_session_create(void)
 
 struct lttng_counter *lttng_ust_counter_create(
 		const char *counter_transport_name,
-		size_t number_dimensions, const struct lttng_counter_dimension *dimensions)
+		size_t number_dimensions, const struct lttng_counter_dimension *dimensions,
+		int64_t global_sum_step)
 {
 	struct lttng_counter_transport *counter_transport = NULL;
 	struct lttng_counter *counter = NULL;
@@ -185,7 +190,7 @@ struct lttng_counter *lttng_ust_counter_create(
 	counter->transport = counter_transport;
 
 	counter->counter = counter->ops->counter_create(
-			number_dimensions, dimensions, 0,
+			number_dimensions, dimensions, global_sum_step,
 			-1, 0, NULL, false);
 	if (!counter->counter) {
 		goto create_error;
@@ -243,6 +248,8 @@ void _lttng_channel_unmap(struct lttng_channel *lttng_chan)
 
 	cds_list_del(&lttng_chan->node);
 	lttng_destroy_context(lttng_chan->ctx);
+	if (lttng_chan->drop_counter)
+		lttng_ust_counter_destroy(lttng_chan->drop_counter);
 	chan = lttng_chan->chan;
 	handle = lttng_chan->handle;
 	/*
@@ -391,6 +398,16 @@ void lttng_event_notifier_group_destroy(
 	if (event_notifier_group->error_counter)
 		lttng_ust_counter_destroy(event_notifier_group->error_counter);
 
+	if (event_notifier_group->notification_chan) {
+		struct lttng_channel *chan = event_notifier_group->notification_chan;
+
+		/*
+		 * note: chan is private data contained within handle. It
+		 * will be freed along with the handle.
+		 */
+		channel_destroy(chan->chan, chan->handle, 0);
+	}
+
 	/* Close the notification fd to the listener of event_notifiers. */
 
 	lttng_ust_lock_fd_tracker();
@@ -440,7 +457,10 @@ void lttng_enabler_destroy(struct lttng_enabler *enabler)
 
 	cds_list_del(&event_notifier_enabler->node);
 
+	lttng_event_notifier_enabler_rate_flush(event_notifier_enabler);
 	lttng_enabler_destroy(lttng_event_notifier_enabler_as_enabler(event_notifier_enabler));
+	if (event_notifier_enabler->map.counter)
+		lttng_ust_counter_destroy(event_notifier_enabler->map.counter);
 
 	free(event_notifier_enabler);
 }
@@ -596,10 +616,17 @@ int lttng_create_all_ctx_enums(size_t nr_fields,
 
 /*
  * Ensure that a state-dump will be performed for this session at the end
- * of the current handle_message().
+ * of the current handle_message(). An incremental state-dump only
+ * covers the shared objects loaded since the previous state-dump of the
+ * session. A full state-dump request takes precedence over an
+ * incremental one.
  */
-int lttng_session_statedump(struct lttng_session *session)
+int lttng_session_statedump(struct lttng_session *session, int incremental)
 {
+	if (!session->statedump_pending)
+		session->statedump_incremental = !!incremental;
+	else if (!incremental)
+		session->statedump_incremental = 0;
 	session->statedump_pending = 1;
 	lttng_ust_sockinfo_session_enabled(session->owner);
 	return 0;
@@ -673,7 +700,7 @@ int lttng_session_enable(struct lttng_session *session)
 	CMM_ACCESS_ONCE(session->active) = 1;
 	CMM_ACCESS_ONCE(session->been_active) = 1;
 
-	ret = lttng_session_statedump(session);
+	ret = lttng_session_statedump(session, 0);
 	if (ret)
 		return ret;
 end:
@@ -751,17 +778,21 @@ struct cds_hlist_head *borrow_hash_table_bucket(
 
 /*
  * Supports event creation while tracing session is active.
+ *
+ * The event is added to the session hash table and to the "pending"
+ * list. It is only added to the session event list once its event ID
+ * has been fetched from sessiond by lttng_session_register_events().
  */
 static
 int lttng_event_create(const struct lttng_event_desc *desc,
-		struct lttng_channel *chan)
+		struct lttng_channel *chan,
+		struct cds_list_head *pending)
 {
 	struct lttng_event *event;
 	struct lttng_session *session = chan->session;
 	struct cds_hlist_head *head;
 	int ret = 0;
-	int notify_socket, loglevel;
-	const char *uri;
+	int notify_socket;
 
 	head = borrow_hash_table_bucket(chan->session->events_ht.table,
 		LTTNG_UST_EVENT_HT_SIZE, desc);
@@ -796,47 +827,177 @@ int lttng_event_create(const struct lttng_event_desc *desc,
 	CDS_INIT_LIST_HEAD(&event->enablers_ref_head);
 	event->desc = desc;
 
+	cds_list_add_tail(&event->node, pending);
+	cds_hlist_add_head(&event->hlist, head);
+	return 0;
+
+cache_error:
+create_enum_error:
+socket_error:
+	return ret;
+}
+
+static
+void lttng_event_fill_registration(struct lttng_event *event,
+		struct ustcomm_event_registration *reg)
+{
+	const struct lttng_event_desc *desc = event->desc;
+
+	memset(reg, 0, sizeof(*reg));
+	reg->channel_objd = event->chan->objd;
+	reg->event_name = desc->name;
 	if (desc->loglevel)
-		loglevel = *(*event->desc->loglevel);
+		reg->loglevel = *(*desc->loglevel);
 	else
-		loglevel = TRACE_DEFAULT;
+		reg->loglevel = TRACE_DEFAULT;
+	reg->signature = desc->signature;
+	reg->nr_fields = desc->nr_fields;
+	reg->fields = desc->fields;
 	if (desc->u.ext.model_emf_uri)
-		uri = *(desc->u.ext.model_emf_uri);
+		reg->model_emf_uri = *(desc->u.ext.model_emf_uri);
 	else
-		uri = NULL;
+		reg->model_emf_uri = NULL;
+}
 
-	/* Fetch event ID from sessiond */
-	ret = ustcomm_register_event(notify_socket,
+/*
+ * Fetch the event ID of a single event from sessiond.
+ */
+static
+int lttng_event_register(int notify_socket, struct lttng_event *event)
+{
+	struct lttng_session *session = event->chan->session;
+	struct ustcomm_event_registration reg;
+
+	lttng_event_fill_registration(event, &reg);
+	return ustcomm_register_event(notify_socket,
 		session,
 		session->objd,
-		chan->objd,
-		desc->name,
-		loglevel,
-		desc->signature,
-		desc->nr_fields,
-		desc->fields,
-		uri,
+		reg.channel_objd,
+		reg.event_name,
+		reg.loglevel,
+		reg.signature,
+		reg.nr_fields,
+		reg.fields,
+		reg.model_emf_uri,
 		&event->id);
+}
+
+/*
+ * Fetch the event IDs of up to USTCOMM_NOTIFY_EVENTS_MAX_BATCH events
+ * from sessiond with a single notify round trip. The registration
+ * status of each event is returned in "ret_codes".
+ */
+static
+int lttng_event_register_batch(int notify_socket,
+		struct lttng_session *session,
+		struct lttng_event **events, int *ret_codes, size_t nr_events)
+{
+	struct ustcomm_event_registration *regs;
+	size_t i;
+	int ret;
+
+	regs = zmalloc(nr_events * sizeof(*regs));
+	if (!regs)
+		return -ENOMEM;
+	for (i = 0; i < nr_events; i++)
+		lttng_event_fill_registration(events[i], &regs[i]);
+	ret = ustcomm_register_events(notify_socket, session, session->objd,
+			nr_events, regs);
+	if (ret)
+		goto end;
+	for (i = 0; i < nr_events; i++) {
+		ret_codes[i] = regs[i].ret_code;
+		if (!regs[i].ret_code)
+			events[i]->id = regs[i].id;
+	}
+end:
+	free(regs);
+	return ret;
+}
+
+static
+void lttng_event_register_done(struct lttng_event *event, int ret)
+{
+	struct lttng_session *session = event->chan->session;
+
 	if (ret < 0) {
-		DBG("Error (%d) registering event to sessiond", ret);
-		goto sessiond_register_error;
+		DBG("Error (%d) registering event %s to sessiond",
+			ret, event->desc->name);
+		cds_list_del(&event->node);
+		cds_hlist_del(&event->hlist);
+		free(event);
+		return;
 	}
+	cds_list_move(&event->node, &session->events_head);
+}
 
-	cds_list_add(&event->node, &chan->session->events_head);
-	cds_hlist_add_head(&event->hlist, head);
-	return 0;
+/*
+ * Bulk registration is only used when requested through the
+ * LTTNG_UST_BULK_EVENT_REGISTRATION environment variable, because
+ * session daemons which do not know about USTCTL_NOTIFY_CMD_EVENTS
+ * close the notify socket when they receive it.
+ */
+static
+bool lttng_event_bulk_registration_enabled(void)
+{
+	return lttng_getenv("LTTNG_UST_BULK_EVENT_REGISTRATION") != NULL;
+}
 
-sessiond_register_error:
-	free(event);
-cache_error:
-create_enum_error:
-socket_error:
-	return ret;
+/*
+ * Fetch the event IDs of all events of the "pending" list from
+ * sessiond. Events successfully registered are moved to the session
+ * event list, the others are destroyed.
+ */
+static
+void lttng_session_register_events(struct lttng_session *session,
+		struct cds_list_head *pending)
+{
+	struct lttng_event *event, *tmp;
+	int notify_socket;
+
+	if (cds_list_empty(pending))
+		return;
+
+	notify_socket = lttng_get_notify_socket(session->owner);
+	if (notify_socket < 0) {
+		cds_list_for_each_entry_safe(event, tmp, pending, node)
+			lttng_event_register_done(event, notify_socket);
+		return;
+	}
+
+	if (lttng_event_bulk_registration_enabled()) {
+		struct lttng_event *batch[USTCOMM_NOTIFY_EVENTS_MAX_BATCH];
+		int ret_codes[USTCOMM_NOTIFY_EVENTS_MAX_BATCH];
+
+		while (!cds_list_empty(pending)) {
+			size_t nr_events = 0, i;
+			int ret;
+
+			cds_list_for_each_entry(event, pending, node) {
+				batch[nr_events++] = event;
+				if (nr_events == USTCOMM_NOTIFY_EVENTS_MAX_BATCH)
+					break;
+			}
+			ret = lttng_event_register_batch(notify_socket,
+					session, batch, ret_codes, nr_events);
+			for (i = 0; i < nr_events; i++)
+				lttng_event_register_done(batch[i],
+					ret ? ret : ret_codes[i]);
+		}
+		return;
+	}
+
+	cds_list_for_each_entry_safe(event, tmp, pending, node)
+		lttng_event_register_done(event,
+			lttng_event_register(notify_socket, event));
 }
 
 static
 int lttng_event_notifier_create(const struct lttng_event_desc *desc,
 		uint64_t token, uint64_t error_counter_index,
+		struct lttng_event_notifier_map *map,
+		struct lttng_event_notifier_rate *rate,
+		struct lttng_event_notifier_session_action *session_action,
 		struct lttng_event_notifier_group *event_notifier_group)
 {
 	struct lttng_event_notifier *event_notifier;
@@ -857,6 +1018,10 @@ int lttng_event_notifier_create(const struct lttng_event_desc *desc,
 		goto error;
 	}
 
+	/* The rate state is shared by the event notifiers of the enabler. */
+	if (rate->policy != LTTNG_UST_EVENT_NOTIFIER_RATE_NONE)
+		event_notifier->rate = rate;
+
 	event_notifier->group = event_notifier_group;
 	event_notifier->user_token = token;
 	event_notifier->error_counter_index = error_counter_index;
@@ -869,7 +1034,14 @@ int lttng_event_notifier_create(const struct lttng_event_desc *desc,
 	CDS_INIT_LIST_HEAD(&event_notifier->capture_bytecode_runtime_head);
 	CDS_INIT_LIST_HEAD(&event_notifier->enablers_ref_head);
 	event_notifier->desc = desc;
-	event_notifier->notification_send = lttng_event_notifier_notification_send;
+	event_notifier->map = map;
+	event_notifier->session_action = session_action;
+	if (map)
+		event_notifier->notification_send = lttng_event_notifier_map_update;
+	else if (session_action)
+		event_notifier->notification_send = lttng_event_notifier_session_action_run;
+	else
+		event_notifier->notification_send = lttng_event_notifier_notification_send;
 
 	cds_list_add(&event_notifier->node,
 			&event_notifier_group->event_notifiers_head);
@@ -1028,10 +1200,12 @@ struct lttng_enabler_ref *lttng_enabler_ref(
 
 /*
  * Create struct lttng_event if it is missing and present in the list of
- * tracepoint probes.
+ * tracepoint probes. Created events are added to the "pending" list,
+ * awaiting registration to sessiond.
  */
 static
-void lttng_create_event_if_missing(struct lttng_event_enabler *event_enabler)
+void lttng_create_event_if_missing(struct lttng_event_enabler *event_enabler,
+		struct cds_list_head *pending)
 {
 	struct lttng_session *session = event_enabler->chan->session;
 	struct lttng_probe_desc *probe_desc;
@@ -1077,7 +1251,7 @@ void lttng_create_event_if_missing(struct lttng_event_enabler *event_enabler)
 			 * event probe.
 			 */
 			ret = lttng_event_create(probe_desc->event_desc[i],
-					event_enabler->chan);
+					event_enabler->chan, pending);
 			if (ret) {
 				DBG("Unable to create event %s, error %d\n",
 					probe_desc->event_desc[i]->name, ret);
@@ -1228,8 +1402,9 @@ void lttng_probe_provider_unregister_events(
 }
 
 /*
- * Create events associated with an event enabler (if not already present),
- * and add backward reference from the event to the enabler.
+ * Add backward reference from the events associated with an event
+ * enabler to the enabler. The events must have been created by
+ * lttng_create_event_if_missing() beforehand.
  */
 static
 int lttng_event_enabler_ref_events(struct lttng_event_enabler *event_enabler)
@@ -1240,9 +1415,6 @@ int lttng_event_enabler_ref_events(struct lttng_event_enabler *event_enabler)
 	if (!lttng_event_enabler_as_enabler(event_enabler)->enabled)
 		goto end;
 
-	/* First ensure that probe events are created for this enabler. */
-	lttng_create_event_if_missing(event_enabler);
-
 	/* For each event matching enabler in session event list. */
 	cds_list_for_each_entry(event, &session->events_head, node) {
 		struct lttng_enabler_ref *enabler_ref;
@@ -1416,6 +1588,13 @@ struct lttng_event_notifier_enabler *lttng_event_notifier_enabler_create(
 	event_notifier_enabler->user_token = event_notifier_param->event.token;
 	event_notifier_enabler->error_counter_index = event_notifier_param->error_counter_index;
 	event_notifier_enabler->num_captures = 0;
+	event_notifier_enabler->action = event_notifier_param->action;
+	event_notifier_enabler->map.op = event_notifier_param->map_op;
+	event_notifier_enabler->map.bucket_min = event_notifier_param->map_bucket_min;
+	event_notifier_enabler->map.bucket_width = event_notifier_param->map_bucket_width;
+	event_notifier_enabler->rate.policy = event_notifier_param->rate_policy;
+	event_notifier_enabler->rate.count = event_notifier_param->rate_count;
+	event_notifier_enabler->rate.window_ns = event_notifier_param->rate_window_ns;
 
 	memcpy(&event_notifier_enabler->base.event_param.name,
 		event_notifier_param->event.name,
@@ -1534,6 +1713,190 @@ int lttng_event_notifier_enabler_attach_capture_bytecode(
 	return 0;
 }
 
+int lttng_event_notifier_enabler_attach_map_counter(
+		struct lttng_event_notifier_enabler *event_notifier_enabler,
+		struct lttng_counter *counter,
+		size_t nr_dimensions,
+		const struct lttng_counter_dimension *dimensions)
+{
+	struct lttng_event_notifier_map *map = &event_notifier_enabler->map;
+	size_t i;
+
+	if (event_notifier_enabler->action != LTTNG_UST_EVENT_NOTIFIER_ACTION_MAP)
+		return -EINVAL;
+	if (map->counter)
+		return -EBUSY;
+	map->nr_dimensions = nr_dimensions;
+	for (i = 0; i < nr_dimensions; i++)
+		map->dimension_size[i] = dimensions[i].size;
+	/*
+	 * store-release to publish the counter matches load-acquire in
+	 * lttng_event_notifier_map_update. Ensures the dimensions are
+	 * set before the counter is used.
+	 */
+	cmm_smp_mb();
+	CMM_STORE_SHARED(map->counter, counter);
+	return 0;
+}
+
+int lttng_channel_attach_drop_counter(struct lttng_channel *lttng_chan,
+		struct lttng_counter *counter, size_t len)
+{
+	if (lttng_chan->drop_counter)
+		return -EBUSY;
+	lttng_chan->drop_counter_len = len;
+	/*
+	 * store-release to publish the counter matches load-acquire in
+	 * the ring buffer client. Ensures the length is set before the
+	 * counter is used.
+	 */
+	cmm_smp_mb();
+	CMM_STORE_SHARED(lttng_chan->drop_counter, counter);
+	return 0;
+}
+
+int lttng_event_notifier_enabler_set_map_threshold(
+		struct lttng_event_notifier_enabler *event_notifier_enabler,
+		int64_t threshold)
+{
+	struct lttng_counter *counter = event_notifier_enabler->map.counter;
+
+	if (!counter)
+		return -EINVAL;
+	/* Map counters without global sum step have no carry. */
+	if (!counter->ops->counter_set_threshold)
+		return -EINVAL;
+	return counter->ops->counter_set_threshold(counter->counter, threshold,
+			lttng_event_notifier_map_threshold_notify,
+			event_notifier_enabler);
+}
+
+/*
+ * Ring buffer trigger actions of the session actions `ops` on a
+ * channel. The metadata channel is left untouched, and only
+ * overwrite-mode channels are frozen.
+ */
+static
+unsigned int session_action_channel_trigger(struct lttng_channel *chan,
+		unsigned int ops)
+{
+	unsigned int actions = 0;
+
+	if (chan->type == LTTNG_UST_CHAN_METADATA)
+		return 0;
+	if ((ops & LTTNG_UST_SESSION_ACTION_FREEZE) &&
+			chan->chan->backend.config.mode == RING_BUFFER_OVERWRITE)
+		actions |= RING_BUFFER_TRIGGER_FREEZE;
+	if (ops & LTTNG_UST_SESSION_ACTION_SWITCH)
+		actions |= RING_BUFFER_TRIGGER_SWITCH;
+	if (ops & LTTNG_UST_SESSION_ACTION_SAMPLE)
+		actions |= RING_BUFFER_TRIGGER_SAMPLE;
+	return actions;
+}
+
+/*
+ * Called from probes, within the tracepoint RCU read-side critical
+ * section: channels are added to the session list with
+ * cds_list_add_rcu.
+ */
+void lttng_session_trigger(struct lttng_session *session, unsigned int ops,
+		unsigned int freeze_id)
+{
+	struct lttng_channel *chan;
+
+	cds_list_for_each_entry_rcu(chan, &session->chan_head, node) {
+		unsigned int actions = session_action_channel_trigger(chan, ops);
+
+		if (actions)
+			lib_ring_buffer_channel_trigger(chan->chan,
+					chan->handle, actions, freeze_id);
+	}
+}
+
+void lttng_session_trigger_reset(struct lttng_session *session,
+		unsigned int ops, unsigned int freeze_id)
+{
+	struct lttng_channel *chan;
+
+	cds_list_for_each_entry(chan, &session->chan_head, node) {
+		unsigned int actions = session_action_channel_trigger(chan, ops);
+
+		if (actions)
+			lib_ring_buffer_channel_trigger_reset(chan->chan,
+					chan->handle, actions, freeze_id);
+	}
+}
+
+int lttng_event_notifier_enabler_attach_session_action(
+		struct lttng_event_notifier_enabler *event_notifier_enabler,
+		struct lttng_session *session, unsigned int ops,
+		unsigned int freeze_id)
+{
+	struct lttng_event_notifier_session_action *action =
+		&event_notifier_enabler->session_action;
+
+	if (event_notifier_enabler->action != LTTNG_UST_EVENT_NOTIFIER_ACTION_SESSION)
+		return -EINVAL;
+	if (freeze_id >= RING_BUFFER_TRIGGER_FREEZE_ID_MAX)
+		return -EINVAL;
+	if (action->session)
+		return -EBUSY;
+	action->ops = ops;
+	action->freeze_id = freeze_id;
+	action->owner_pid = getpid();
+	/*
+	 * store-release to publish the session matches the full barrier
+	 * of the cmpxchg disarming the action in
+	 * lttng_event_notifier_session_action_run.
+	 */
+	cmm_smp_mb();
+	CMM_STORE_SHARED(action->session, session);
+	CMM_STORE_SHARED(action->armed, 1);
+	return 0;
+}
+
+int lttng_event_notifier_enabler_rearm_session_action(
+		struct lttng_event_notifier_enabler *event_notifier_enabler)
+{
+	struct lttng_event_notifier_session_action *action =
+		&event_notifier_enabler->session_action;
+
+	if (!action->session)
+		return -EINVAL;
+	if (CMM_LOAD_SHARED(action->armed))
+		return 0;
+	/* Wait for the probe which disarmed the action to complete it. */
+	lttng_ust_synchronize_trace();
+	lttng_session_trigger_reset(action->session, action->ops,
+			action->freeze_id);
+	cmm_smp_mb();
+	CMM_STORE_SHARED(action->armed, 1);
+	return 0;
+}
+
+struct lttng_session *lttng_event_notifier_enabler_detach_session_action(
+		struct lttng_event_notifier_enabler *event_notifier_enabler)
+{
+	struct lttng_event_notifier_session_action *action =
+		&event_notifier_enabler->session_action;
+	struct lttng_session *session = action->session;
+
+	if (!session)
+		return NULL;
+	CMM_STORE_SHARED(action->armed, 0);
+	CMM_STORE_SHARED(action->session, NULL);
+	/* Wait for the probes running the actions on the session. */
+	lttng_ust_synchronize_trace();
+	/*
+	 * The buffers of a fork child are shared with its parent, which
+	 * owns the actions it inherited and undoes them itself.
+	 */
+	if (action->owner_pid == getpid())
+		lttng_session_trigger_reset(session, action->ops,
+				action->freeze_id);
+	return session;
+}
+
 int lttng_event_notifier_enabler_attach_exclusion(
 		struct lttng_event_notifier_enabler *event_notifier_enabler,
 		struct lttng_ust_excluder_node *excluder)
@@ -1613,6 +1976,8 @@ int lttng_attach_context(struct lttng_ust_context *context_param,
 		return lttng_add_vegid_to_ctx(ctx);
 	case LTTNG_UST_CONTEXT_VSGID:
 		return lttng_add_vsgid_to_ctx(ctx);
+	case LTTNG_UST_CONTEXT_CALLSTACK:
+		return lttng_add_callstack_to_ctx(ctx);
 	default:
 		return -EINVAL;
 	}
@@ -1646,6 +2011,17 @@ void lttng_session_sync_event_enablers(struct lttng_session *session)
 {
 	struct lttng_event_enabler *event_enabler;
 	struct lttng_event *event;
+	CDS_LIST_HEAD(pending);
+
+	/*
+	 * First ensure that probe events are created for all enablers,
+	 * so their event IDs can be fetched from sessiond together.
+	 */
+	cds_list_for_each_entry(event_enabler, &session->enablers_head, node) {
+		if (lttng_event_enabler_as_enabler(event_enabler)->enabled)
+			lttng_create_event_if_missing(event_enabler, &pending);
+	}
+	lttng_session_register_events(session, &pending);
 
 	cds_list_for_each_entry(event_enabler, &session->enablers_head, node)
 		lttng_event_enabler_ref_events(event_enabler);
@@ -1784,6 +2160,11 @@ void lttng_create_event_notifier_if_missing(
 			ret = lttng_event_notifier_create(desc,
 				event_notifier_enabler->user_token,
 				event_notifier_enabler->error_counter_index,
+				event_notifier_enabler->action == LTTNG_UST_EVENT_NOTIFIER_ACTION_MAP ?
+					&event_notifier_enabler->map : NULL,
+				&event_notifier_enabler->rate,
+				event_notifier_enabler->action == LTTNG_UST_EVENT_NOTIFIER_ACTION_SESSION ?
+					&event_notifier_enabler->session_action : NULL,
 				event_notifier_group);
 			if (ret) {
 				DBG("Unable to create event_notifier %s, error %d\n",
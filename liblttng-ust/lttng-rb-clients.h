@@ -20,6 +20,7 @@
  */
 
 #include <stdint.h>
+#include <lttng/ust-events.h>
 
 struct lttng_ust_client_lib_ring_buffer_client_cb {
 	struct lttng_ust_lib_ring_buffer_client_cb parent;
@@ -51,4 +52,15 @@ struct lttng_ust_client_lib_ring_buffer_client_cb {
 			struct lttng_ust_shm_handle *handle, uint64_t *id);
 };
 
+/*
+ * Private data of the channels of the notification client, shared by
+ * the traced application and the reader.
+ */
+struct lttng_notification_channel {
+	struct lttng_channel parent;
+	int wakeup_pending;		/* Wakeup sent, not acknowledged. */
+	/* Not safe to dereference by the reader. */
+	struct lttng_event_notifier_group *group;
+};
+
 #endif /* _LTTNG_RB_CLIENT_H */
@@ -714,6 +714,53 @@ void lttng_channel_destroy(struct lttng_channel *chan)
 	channel_destroy(chan->chan, chan->handle, 1);
 }
 
+/*
+ * Count a record lost by the ring buffer in the drop counter of the
+ * channel, if any, at the index of its event.
+ */
+static
+void lttng_record_lost(struct lttng_channel *lttng_chan, uint32_t event_id)
+{
+	struct lttng_counter *drop_counter;
+	size_t index;
+
+	drop_counter = CMM_LOAD_SHARED(lttng_chan->drop_counter);
+	if (caa_likely(!drop_counter))
+		return;
+	/*
+	 * load-acquire paired with store-release in
+	 * lttng_channel_attach_drop_counter orders the setting of
+	 * drop_counter_len before the drop_counter is used.
+	 */
+	cmm_smp_mb();
+	index = event_id;
+	if (index >= lttng_chan->drop_counter_len)
+		index = lttng_chan->drop_counter_len - 1;
+	/* The per-CPU counters may not be mapped yet. */
+	(void) drop_counter->ops->counter_add(drop_counter->counter, &index, 1);
+}
+
+/*
+ * Whether a reservation failure dropped a record accounted in the
+ * records_lost_* counters of the buffer. Besides a nested wrap-around,
+ * -EIO reports a buffer which is not mapped (ctx->buf is not set) or a
+ * clock read failure (ctx->tsc is -EIO), which are not lost records.
+ */
+static
+bool lttng_reserve_record_lost(struct lttng_ust_lib_ring_buffer_ctx *ctx,
+		int ret)
+{
+	switch (ret) {
+	case -ENOBUFS:	/* Buffer full */
+	case -ENOSPC:	/* Event too big */
+		return true;
+	case -EIO:
+		return ctx->buf && (int64_t) ctx->tsc != -EIO;
+	default:
+		return false;
+	}
+}
+
 static
 int lttng_event_reserve(struct lttng_ust_lib_ring_buffer_ctx *ctx,
 		      uint32_t event_id)
@@ -758,9 +805,13 @@ int lttng_event_reserve(struct lttng_ust_lib_ring_buffer_ctx *ctx,
 		WARN_ON_ONCE(1);
 	}
 
+	ctx->buf = NULL;
 	ret = lib_ring_buffer_reserve(&client_config, ctx, &client_ctx);
-	if (caa_unlikely(ret))
+	if (caa_unlikely(ret)) {
+		if (lttng_reserve_record_lost(ctx, ret))
+			lttng_record_lost(lttng_chan, event_id);
 		goto put;
+	}
 	if (caa_likely(ctx->ctx_len
 			>= sizeof(struct lttng_ust_lib_ring_buffer_ctx))) {
 		if (lib_ring_buffer_backend_get_pages(&client_config, ctx,
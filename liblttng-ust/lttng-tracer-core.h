@@ -58,6 +58,12 @@ void lttng_fixup_ipc_ns_tls(void);
 void lttng_fixup_net_ns_tls(void);
 void lttng_fixup_time_ns_tls(void);
 void lttng_fixup_uts_ns_tls(void);
+void lttng_fixup_callstack_tls(void);
+
+void lttng_context_callstack_for_each(
+		void (*cb)(uint32_t id, const unsigned long *ips,
+			uint32_t nr_ips, void *priv),
+		void *priv);
 
 const char *lttng_ust_obj_get_name(int id);
 
@@ -90,6 +96,40 @@ void lttng_event_notifier_notification_send(
 		struct lttng_event_notifier *event_notifier,
 		const char *stack_data);
 
+LTTNG_HIDDEN
+void lttng_event_notifier_map_update(
+		struct lttng_event_notifier *event_notifier,
+		const char *stack_data);
+
+LTTNG_HIDDEN
+void lttng_event_notifier_session_action_run(
+		struct lttng_event_notifier *event_notifier,
+		const char *stack_data);
+
+struct lib_counter;
+
+/*
+ * Threshold callback of the map counter of an event notifier enabler,
+ * passed as `priv`.
+ */
+LTTNG_HIDDEN
+void lttng_event_notifier_map_threshold_notify(struct lib_counter *counter,
+		const size_t *dimension_indexes, int64_t value, void *priv);
+
+/*
+ * Run the session actions `ops` (mask of enum
+ * lttng_ust_session_action_op) on the channels of a session, and undo
+ * them. The channels frozen by the actions stay frozen until all the
+ * freeze ids which froze them are reset. Running is lock-free and can
+ * be done by a probe.
+ */
+LTTNG_HIDDEN
+void lttng_session_trigger(struct lttng_session *session, unsigned int ops,
+		unsigned int freeze_id);
+LTTNG_HIDDEN
+void lttng_session_trigger_reset(struct lttng_session *session,
+		unsigned int ops, unsigned int freeze_id);
+
 #ifdef LTTNG_UST_HAVE_PERF_EVENT
 void lttng_ust_fixup_perf_counter_tls(void);
 void lttng_perf_lock(void);
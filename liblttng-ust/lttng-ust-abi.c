@@ -44,6 +44,7 @@
 
 #include <urcu/compiler.h>
 #include <urcu/list.h>
+#include <urcu/rculist.h>
 
 #include <helper.h>
 #include <lttng/tracepoint.h>
@@ -59,6 +60,7 @@
 #include "../libcounter/counter.h"
 #include "tracepoint-internal.h"
 #include "lttng-tracer.h"
+#include "lttng-rb-clients.h"
 #include "string-utils.h"
 #include "ust-events-internal.h"
 
@@ -288,6 +290,8 @@ static const struct lttng_ust_objd_ops lttng_session_ops;
 static const struct lttng_ust_objd_ops lttng_channel_ops;
 static const struct lttng_ust_objd_ops lttng_event_enabler_ops;
 static const struct lttng_ust_objd_ops lttng_event_notifier_enabler_ops;
+static const struct lttng_ust_objd_ops lttng_event_notifier_group_error_counter_ops;
+static const struct lttng_ust_objd_ops lttng_notification_channel_ops;
 static const struct lttng_ust_objd_ops lttng_tracepoint_list_ops;
 static const struct lttng_ust_objd_ops lttng_tracepoint_field_list_ops;
 
@@ -558,10 +562,11 @@ int lttng_abi_map_channel(int session_objd,
 	memcpy(&lttng_chan->chan->backend.config,
 		transport->client_config,
 		sizeof(lttng_chan->chan->backend.config));
-	cds_list_add(&lttng_chan->node, &session->chan_head);
 	lttng_chan->header_type = 0;
 	lttng_chan->handle = channel_handle;
 	lttng_chan->type = type;
+	/* Walked by the session actions of event notifiers. */
+	cds_list_add_rcu(&lttng_chan->node, &session->chan_head);
 
 	/*
 	 * We tolerate no failure path after channel creation. It will stay
@@ -638,7 +643,9 @@ long lttng_session_cmd(int objd, unsigned int cmd, unsigned long arg,
 	case LTTNG_UST_DISABLE:
 		return lttng_session_disable(session);
 	case LTTNG_UST_SESSION_STATEDUMP:
-		return lttng_session_statedump(session);
+		return lttng_session_statedump(session, 0);
+	case LTTNG_UST_SESSION_STATEDUMP_INCREMENTAL:
+		return lttng_session_statedump(session, 1);
 	case LTTNG_UST_COUNTER:
 	case LTTNG_UST_COUNTER_GLOBAL:
 	case LTTNG_UST_COUNTER_CPU:
@@ -684,6 +691,56 @@ static int lttng_ust_event_notifier_enabler_create(int event_notifier_group_obj,
 	struct lttng_event_notifier_enabler *event_notifier_enabler;
 	int event_notifier_objd, ret;
 
+	switch (event_notifier_param->action) {
+	case LTTNG_UST_EVENT_NOTIFIER_ACTION_NOTIFY:
+	case LTTNG_UST_EVENT_NOTIFIER_ACTION_SESSION:
+		break;
+	case LTTNG_UST_EVENT_NOTIFIER_ACTION_MAP:
+		switch (event_notifier_param->map_op) {
+		case LTTNG_UST_MAP_OP_COUNT:
+		case LTTNG_UST_MAP_OP_SUM:
+		case LTTNG_UST_MAP_OP_HIST_LOG2:
+			break;
+		case LTTNG_UST_MAP_OP_HIST_LINEAR:
+			if (!event_notifier_param->map_bucket_width)
+				return -EINVAL;
+			break;
+		default:
+			return -EINVAL;
+		}
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	switch (event_notifier_param->rate_policy) {
+	case LTTNG_UST_EVENT_NOTIFIER_RATE_NONE:
+		break;
+	case LTTNG_UST_EVENT_NOTIFIER_RATE_LIMIT:
+		if (!event_notifier_param->rate_count ||
+				!event_notifier_param->rate_window_ns)
+			return -EINVAL;
+		/* The window hit count saturates, e.g. at 65535 on 32-bit. */
+		if (event_notifier_param->rate_count
+				>= LTTNG_EVENT_NOTIFIER_RATE_HITS_MASK)
+			return -EINVAL;
+		break;
+	case LTTNG_UST_EVENT_NOTIFIER_RATE_EVERY_NTH:
+		if (!event_notifier_param->rate_count)
+			return -EINVAL;
+		break;
+	case LTTNG_UST_EVENT_NOTIFIER_RATE_COALESCE:
+		if (!event_notifier_param->rate_window_ns)
+			return -EINVAL;
+		break;
+	default:
+		return -EINVAL;
+	}
+	/* The map action aggregates every hit, the session action one. */
+	if (event_notifier_param->action != LTTNG_UST_EVENT_NOTIFIER_ACTION_NOTIFY &&
+			event_notifier_param->rate_policy != LTTNG_UST_EVENT_NOTIFIER_RATE_NONE)
+		return -EINVAL;
+
 	event_notifier_param->event.name[LTTNG_UST_SYM_NAME_LEN - 1] = '\0';
 	event_notifier_objd = objd_alloc(NULL, &lttng_event_notifier_enabler_ops, owner,
 		"event_notifier enabler");
@@ -716,6 +773,141 @@ objd_error:
 	return ret;
 }
 
+/*
+ * The map counter is owned by the event notifier enabler, and shares
+ * the object operations of the group error counter.
+ */
+static
+int lttng_ust_event_notifier_enabler_create_map_counter(int event_notifier_objd,
+		void *owner, struct lttng_ust_counter_conf *map_counter_conf)
+{
+	struct lttng_event_notifier_enabler *event_notifier_enabler =
+		objd_private(event_notifier_objd);
+	struct lttng_counter_dimension dimensions[LTTNG_UST_COUNTER_DIMENSION_MAX];
+	const char *counter_transport_name;
+	struct lttng_counter *counter;
+	int counter_objd, ret;
+	size_t i;
+
+	if (event_notifier_enabler->action != LTTNG_UST_EVENT_NOTIFIER_ACTION_MAP)
+		return -EINVAL;
+	if (event_notifier_enabler->map.counter)
+		return -EBUSY;
+	if (map_counter_conf->arithmetic != LTTNG_UST_COUNTER_ARITHMETIC_MODULAR)
+		return -EINVAL;
+	if (!map_counter_conf->number_dimensions ||
+			map_counter_conf->number_dimensions > LTTNG_UST_COUNTER_DIMENSION_MAX)
+		return -EINVAL;
+
+	if (map_counter_conf->global_sum_step < 0)
+		return -EINVAL;
+
+	/*
+	 * With a global sum step, the per-CPU counters carry into a
+	 * global counter, at which point the map threshold is checked.
+	 */
+	switch (map_counter_conf->bitness) {
+	case LTTNG_UST_COUNTER_BITNESS_64:
+		if (map_counter_conf->global_sum_step)
+			counter_transport_name = "counter-per-cpu-global-64-modular";
+		else
+			counter_transport_name = "counter-per-cpu-64-modular";
+		break;
+	case LTTNG_UST_COUNTER_BITNESS_32:
+		if (map_counter_conf->global_sum_step)
+			counter_transport_name = "counter-per-cpu-global-32-modular";
+		else
+			counter_transport_name = "counter-per-cpu-32-modular";
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	for (i = 0; i < map_counter_conf->number_dimensions; i++) {
+		if (!map_counter_conf->dimensions[i].size)
+			return -EINVAL;
+		dimensions[i].size = map_counter_conf->dimensions[i].size;
+		dimensions[i].underflow_index = 0;
+		dimensions[i].overflow_index = 0;
+		dimensions[i].has_underflow = 0;
+		dimensions[i].has_overflow = 0;
+	}
+
+	counter_objd = objd_alloc(NULL, &lttng_event_notifier_group_error_counter_ops, owner,
+		"event_notifier map counter");
+	if (counter_objd < 0) {
+		ret = counter_objd;
+		goto objd_error;
+	}
+
+	counter = lttng_ust_counter_create(counter_transport_name,
+			map_counter_conf->number_dimensions, dimensions,
+			map_counter_conf->global_sum_step);
+	if (!counter) {
+		ret = -EINVAL;
+		goto create_error;
+	}
+
+	counter->objd = counter_objd;
+	counter->event_notifier_group = event_notifier_enabler->group;	/* owner */
+
+	ret = lttng_event_notifier_enabler_attach_map_counter(event_notifier_enabler,
+			counter, map_counter_conf->number_dimensions, dimensions);
+	assert(!ret);
+
+	objd_set_private(counter_objd, counter);
+	/* The map counter holds a reference on the event_notifier group. */
+	objd_ref(event_notifier_enabler->group->objd);
+
+	return counter_objd;
+
+create_error:
+	{
+		int err;
+
+		err = lttng_ust_objd_unref(counter_objd, 1);
+		assert(!err);
+	}
+objd_error:
+	return ret;
+}
+
+/*
+ * The session must belong to the sessiond owning the event notifier.
+ * The session action holds a reference on the session until the event
+ * notifier is released.
+ */
+static
+int lttng_ust_event_notifier_enabler_attach_session_action(int event_notifier_objd,
+		void *owner, struct lttng_ust_session_action *session_action_param)
+{
+	struct lttng_event_notifier_enabler *event_notifier_enabler =
+		objd_private(event_notifier_objd);
+	int session_objd = session_action_param->session_handle;
+	struct lttng_ust_obj *session_obj;
+	int ret;
+
+	if (!session_action_param->ops ||
+			(session_action_param->ops & ~(LTTNG_UST_SESSION_ACTION_FREEZE |
+				LTTNG_UST_SESSION_ACTION_SWITCH |
+				LTTNG_UST_SESSION_ACTION_SAMPLE)))
+		return -EINVAL;
+	session_obj = _objd_get(session_objd);
+	if (!session_obj || session_obj->u.s.ops != &lttng_session_ops)
+		return -EINVAL;
+	if (session_obj->u.s.owner != owner)
+		return -EPERM;
+
+	ret = lttng_event_notifier_enabler_attach_session_action(
+			event_notifier_enabler, objd_private(session_objd),
+			session_action_param->ops,
+			session_action_param->freeze_id);
+	if (ret)
+		return ret;
+	objd_ref(session_objd);
+	return 0;
+}
+
 static
 long lttng_event_notifier_enabler_cmd(int objd, unsigned int cmd, unsigned long arg,
 		union ust_args *uargs, void *owner)
@@ -733,6 +925,26 @@ long lttng_event_notifier_enabler_cmd(int objd, unsigned int cmd, unsigned long
 		return lttng_event_notifier_enabler_attach_capture_bytecode(
 			event_notifier_enabler,
 			(struct lttng_ust_bytecode_node *) arg);
+	case LTTNG_UST_COUNTER:
+	{
+		struct lttng_ust_counter_conf *counter_conf =
+			(struct lttng_ust_counter_conf *) uargs->counter.counter_data;
+		return lttng_ust_event_notifier_enabler_create_map_counter(
+				objd, owner, counter_conf);
+	}
+	case LTTNG_UST_SESSION_ACTION:
+		return lttng_ust_event_notifier_enabler_attach_session_action(
+				objd, owner, (struct lttng_ust_session_action *) arg);
+	case LTTNG_UST_SESSION_ACTION_REARM:
+		return lttng_event_notifier_enabler_rearm_session_action(
+				event_notifier_enabler);
+	case LTTNG_UST_MAP_THRESHOLD:
+	{
+		struct lttng_ust_map_threshold *map_threshold =
+			(struct lttng_ust_map_threshold *) arg;
+		return lttng_event_notifier_enabler_set_map_threshold(
+				event_notifier_enabler, map_threshold->value);
+	}
 	case LTTNG_UST_ENABLE:
 		return lttng_event_notifier_enabler_enable(event_notifier_enabler);
 	case LTTNG_UST_DISABLE:
@@ -765,7 +977,9 @@ long lttng_event_notifier_group_error_counter_cmd(int objd, unsigned int cmd, un
 
 	switch (cmd) {
 	case LTTNG_UST_COUNTER_GLOBAL:
-		return -EINVAL;		/* Unimplemented. */
+		/* Only map counters with a global sum step have one. */
+		return lttng_counter_set_global_shm(counter->counter,
+			uargs->counter_shm.shm_fd);
 	case LTTNG_UST_COUNTER_CPU:
 	{
 		struct lttng_ust_counter_cpu *counter_cpu =
@@ -840,7 +1054,7 @@ int lttng_ust_event_notifier_group_create_error_counter(int event_notifier_group
 	dimensions[0].has_underflow = 0;
 	dimensions[0].has_overflow = 0;
 
-	counter = lttng_ust_counter_create(counter_transport_name, 1, dimensions);
+	counter = lttng_ust_counter_create(counter_transport_name, 1, dimensions, 0);
 	if (!counter) {
 		ret = -EINVAL;
 		goto create_error;
@@ -877,6 +1091,119 @@ objd_error:
 	return ret;
 }
 
+/*
+ * Map the channel receiving the notifications of an event notifier
+ * group. The notifications go through the notification fd until all
+ * the streams of the channel are mapped.
+ */
+static
+int lttng_abi_map_notification_channel(int event_notifier_group_objd,
+		struct lttng_ust_channel *ust_chan,
+		union ust_args *uargs,
+		void *owner)
+{
+	struct lttng_event_notifier_group *event_notifier_group =
+		objd_private(event_notifier_group_objd);
+	struct lttng_notification_channel *notification_chan;
+	const struct lttng_transport *transport;
+	struct lttng_ust_shm_handle *channel_handle;
+	struct lttng_channel *lttng_chan;
+	struct channel *chan;
+	void *chan_data;
+	int chan_objd, wakeup_fd;
+	int ret;
+
+	chan_data = uargs->channel.chan_data;
+	wakeup_fd = uargs->channel.wakeup_fd;
+
+	if (ust_chan->type != LTTNG_UST_CHAN_NOTIFICATION) {
+		ret = -EINVAL;
+		goto invalid;
+	}
+	if (event_notifier_group->notification_chan) {
+		ret = -EBUSY;
+		goto busy;
+	}
+
+	channel_handle = channel_handle_create(chan_data, ust_chan->len,
+			wakeup_fd);
+	if (!channel_handle) {
+		ret = -EINVAL;
+		goto handle_error;
+	}
+
+	chan = shmp(channel_handle, channel_handle->chan);
+	assert(chan);
+	chan->handle = channel_handle;
+	lttng_chan = channel_get_private(chan);
+	if (!lttng_chan) {
+		ret = -EINVAL;
+		goto alloc_error;
+	}
+
+	transport = lttng_transport_find("relay-notification-mmap");
+	if (!transport || chan->backend.config.client_type
+			!= transport->client_config->client_type) {
+		DBG("LTTng transport relay-notification-mmap not found\n");
+		ret = -EINVAL;
+		goto notransport;
+	}
+
+	chan_objd = objd_alloc(NULL, &lttng_notification_channel_ops, owner,
+		"notification channel");
+	if (chan_objd < 0) {
+		ret = chan_objd;
+		goto objd_error;
+	}
+
+	notification_chan = caa_container_of(lttng_chan,
+			struct lttng_notification_channel, parent);
+	notification_chan->group = event_notifier_group;
+	lttng_chan->chan = chan;
+	lttng_chan->enabled = 1;
+	lttng_chan->ops = &transport->ops;
+	memcpy(&lttng_chan->chan->backend.config,
+		transport->client_config,
+		sizeof(lttng_chan->chan->backend.config));
+	lttng_chan->handle = channel_handle;
+	lttng_chan->type = LTTNG_UST_CHAN_NOTIFICATION;
+	/* Owned by the group, published when all its streams are mapped. */
+	event_notifier_group->notification_chan = lttng_chan;
+
+	objd_set_private(chan_objd, lttng_chan);
+	lttng_chan->objd = chan_objd;
+	/* The channel holds a reference on the event_notifier group. */
+	objd_ref(event_notifier_group_objd);
+	return chan_objd;
+
+	/* error path after channel was created */
+objd_error:
+notransport:
+alloc_error:
+	channel_destroy(chan, channel_handle, 0);
+	return ret;
+
+	/*
+	 * error path before channel creation (owning chan_data and
+	 * wakeup_fd).
+	 */
+handle_error:
+busy:
+invalid:
+	{
+		int close_ret;
+
+		lttng_ust_lock_fd_tracker();
+		close_ret = close(wakeup_fd);
+		lttng_ust_unlock_fd_tracker();
+		if (close_ret) {
+			PERROR("close");
+		}
+	}
+	free(chan_data);
+	return ret;
+}
+
 static
 long lttng_event_notifier_group_cmd(int objd, unsigned int cmd, unsigned long arg,
 		union ust_args *uargs, void *owner)
@@ -907,6 +1234,10 @@ long lttng_event_notifier_group_cmd(int objd, unsigned int cmd, unsigned long ar
 		return lttng_ust_event_notifier_group_create_error_counter(
 				objd, owner, counter_conf);
 	}
+	case LTTNG_UST_CHANNEL:
+		return lttng_abi_map_notification_channel(objd,
+				(struct lttng_ust_channel *) arg,
+				uargs, owner);
 	default:
 		return -EINVAL;
 	}
@@ -917,8 +1248,18 @@ int lttng_event_notifier_enabler_release(int objd)
 {
 	struct lttng_event_notifier_enabler *event_notifier_enabler = objd_private(objd);
 
-	if (event_notifier_enabler)
-		return lttng_ust_objd_unref(event_notifier_enabler->group->objd, 0);
+	if (event_notifier_enabler) {
+		struct lttng_session *session;
+		int ret, session_ret = 0;
+
+		lttng_event_notifier_enabler_rate_flush(event_notifier_enabler);
+		session = lttng_event_notifier_enabler_detach_session_action(
+				event_notifier_enabler);
+		if (session)
+			session_ret = lttng_ust_objd_unref(session->objd, 0);
+		ret = lttng_ust_objd_unref(event_notifier_enabler->group->objd, 0);
+		return ret ? ret : session_ret;
+	}
 	return 0;
 }
 
@@ -1166,6 +1507,117 @@ objd_error:
 	return ret;
 }
 
+static
+long lttng_channel_drop_counter_cmd(int objd, unsigned int cmd, unsigned long arg,
+	union ust_args *uargs, void *owner)
+{
+	struct lttng_channel *channel = objd_private(objd);
+	struct lttng_counter *counter = channel->drop_counter;
+
+	switch (cmd) {
+	case LTTNG_UST_COUNTER_CPU:
+	{
+		struct lttng_ust_counter_cpu *counter_cpu =
+			(struct lttng_ust_counter_cpu *)arg;
+		return lttng_counter_set_cpu_shm(counter->counter,
+			counter_cpu->cpu_nr, uargs->counter_shm.shm_fd);
+	}
+	default:
+		return -EINVAL;
+	}
+}
+
+static
+int lttng_channel_drop_counter_release(int objd)
+{
+	struct lttng_channel *channel = objd_private(objd);
+
+	if (channel)
+		return lttng_ust_objd_unref(channel->objd, 0);
+	return 0;
+}
+
+static const struct lttng_ust_objd_ops lttng_channel_drop_counter_ops = {
+	.release = lttng_channel_drop_counter_release,
+	.cmd = lttng_channel_drop_counter_cmd,
+};
+
+/*
+ * The drop counter is owned by the channel, and destroyed with it. Its
+ * object holds a reference on the channel.
+ */
+static
+int lttng_abi_create_drop_counter(int channel_objd, void *owner,
+		struct lttng_ust_counter_conf *drop_counter_conf)
+{
+	struct lttng_channel *channel = objd_private(channel_objd);
+	struct lttng_counter_dimension dimensions[1];
+	const char *counter_transport_name;
+	struct lttng_counter *counter;
+	int counter_objd, ret;
+
+	if (channel->type != LTTNG_UST_CHAN_PER_CPU)
+		return -EINVAL;
+	if (channel->drop_counter)
+		return -EBUSY;
+	if (drop_counter_conf->arithmetic != LTTNG_UST_COUNTER_ARITHMETIC_MODULAR)
+		return -EINVAL;
+	if (drop_counter_conf->number_dimensions != 1 ||
+			!drop_counter_conf->dimensions[0].size)
+		return -EINVAL;
+
+	switch (drop_counter_conf->bitness) {
+	case LTTNG_UST_COUNTER_BITNESS_64:
+		counter_transport_name = "counter-per-cpu-64-modular";
+		break;
+	case LTTNG_UST_COUNTER_BITNESS_32:
+		counter_transport_name = "counter-per-cpu-32-modular";
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	dimensions[0].size = drop_counter_conf->dimensions[0].size;
+	dimensions[0].underflow_index = 0;
+	dimensions[0].overflow_index = 0;
+	dimensions[0].has_underflow = 0;
+	dimensions[0].has_overflow = 0;
+
+	counter_objd = objd_alloc(NULL, &lttng_channel_drop_counter_ops, owner,
+		"channel drop counter");
+	if (counter_objd < 0) {
+		ret = counter_objd;
+		goto objd_error;
+	}
+
+	counter = lttng_ust_counter_create(counter_transport_name, 1, dimensions, 0);
+	if (!counter) {
+		ret = -EINVAL;
+		goto create_error;
+	}
+	counter->objd = counter_objd;
+
+	ret = lttng_channel_attach_drop_counter(channel, counter,
+			dimensions[0].size);
+	assert(!ret);
+
+	objd_set_private(counter_objd, channel);
+	/* The drop counter holds a reference on the channel. */
+	objd_ref(channel_objd);
+
+	return counter_objd;
+
+create_error:
+	{
+		int err;
+
+		err = lttng_ust_objd_unref(counter_objd, 1);
+		assert(!err);
+	}
+objd_error:
+	return ret;
+}
+
 /**
  *	lttng_channel_cmd - lttng control through object descriptors
  *
@@ -1187,6 +1639,9 @@ objd_error:
  *		Enable recording for events in this channel (weak enable)
  *	LTTNG_UST_DISABLE
  *		Disable recording for events in this channel (strong disable)
+ *	LTTNG_UST_COUNTER
+ *		Returns the object descriptor of the counter of records
+ *		lost by each event of the channel, or failure.
  *
  * Channel and event file descriptors also hold a reference on the session.
  */
@@ -1240,6 +1695,12 @@ long lttng_channel_cmd(int objd, unsigned int cmd, unsigned long arg,
 		return lttng_channel_disable(channel);
 	case LTTNG_UST_FLUSH_BUFFER:
 		return channel->ops->flush_buffer(channel->chan, channel->handle);
+	case LTTNG_UST_COUNTER:
+	{
+		struct lttng_ust_counter_conf *counter_conf =
+			(struct lttng_ust_counter_conf *) uargs->counter.counter_data;
+		return lttng_abi_create_drop_counter(objd, owner, counter_conf);
+	}
 	default:
 		return -EINVAL;
 	}
@@ -1260,6 +1721,68 @@ static const struct lttng_ust_objd_ops lttng_channel_ops = {
 	.cmd = lttng_channel_cmd,
 };
 
+/**
+ *	lttng_notification_channel_cmd - lttng notification channel object command
+ *
+ *	@obj: the object
+ *	@cmd: the command
+ *	@arg: command arg
+ *	@uargs: UST arguments (internal)
+ *	@owner: objd owner
+ *
+ *	This object descriptor implements lttng commands:
+ *      LTTNG_UST_STREAM
+ *              Map the stream of the channel. The event notifier group
+ *              writes its notifications in the channel once it is mapped.
+ */
+static
+long lttng_notification_channel_cmd(int objd, unsigned int cmd, unsigned long arg,
+		union ust_args *uargs, void *owner)
+{
+	struct lttng_channel *channel = objd_private(objd);
+	struct lttng_notification_channel *notification_chan =
+		caa_container_of(channel, struct lttng_notification_channel,
+			parent);
+	int ret;
+
+	switch (cmd) {
+	case LTTNG_UST_STREAM:
+		ret = lttng_abi_map_stream(objd,
+				(struct lttng_ust_stream *) arg, uargs, owner);
+		if (ret)
+			return ret;
+		if (lttng_is_channel_ready(channel)) {
+			/*
+			 * store-release to publish the channel matches
+			 * load-acquire in notification_send.
+			 */
+			cmm_smp_mb();
+			CMM_STORE_SHARED(notification_chan->group->notification_chan_ready, 1);
+		}
+		return 0;
+	default:
+		return -EINVAL;
+	}
+}
+
+static
+int lttng_notification_channel_release(int objd)
+{
+	struct lttng_channel *channel = objd_private(objd);
+	struct lttng_notification_channel *notification_chan;
+
+	if (!channel)
+		return 0;
+	notification_chan = caa_container_of(channel,
+			struct lttng_notification_channel, parent);
+	return lttng_ust_objd_unref(notification_chan->group->objd, 0);
+}
+
+static const struct lttng_ust_objd_ops lttng_notification_channel_ops = {
+	.release = lttng_notification_channel_release,
+	.cmd = lttng_notification_channel_cmd,
+};
+
 /**
  *	lttng_enabler_cmd - lttng control through object descriptors
  *
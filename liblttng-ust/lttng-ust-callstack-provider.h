@@ -0,0 +1,46 @@
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER lttng_ust_callstack
+
+#if !defined(_TRACEPOINT_LTTNG_UST_CALLSTACK_PROVIDER_H) || defined(TRACEPOINT_HEADER_MULTI_READ)
+#define _TRACEPOINT_LTTNG_UST_CALLSTACK_PROVIDER_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* SPDX-License-Identifier: MIT
+ *
+ * Definition of the call stacks referred to by the `callstack` context.
+ */
+
+#include <stdint.h>
+#include <lttng/tracepoint.h>
+
+/*
+ * Emitted once per process, the first time a call stack is recorded by
+ * the `callstack` context. `ips` holds the return addresses, innermost
+ * caller first.
+ */
+TRACEPOINT_EVENT(lttng_ust_callstack, stack,
+	TP_ARGS(
+		uint32_t, id,
+		const unsigned long *, ips,
+		uint32_t, nr_ips
+	),
+	TP_FIELDS(
+		ctf_integer(uint32_t, id, id)
+		ctf_sequence_hex(unsigned long, ips, ips, uint32_t, nr_ips)
+	)
+)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _TRACEPOINT_LTTNG_UST_CALLSTACK_PROVIDER_H */
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "./lttng-ust-callstack-provider.h"
+
+/* This part must be outside ifdef protection */
+#include <lttng/tracepoint-event.h>
@@ -28,6 +28,7 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/epoll.h>
 #include <dlfcn.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -246,6 +247,35 @@ static int sem_count = sem_count_initial_value;
  */
 static DEFINE_URCU_TLS(int, lttng_ust_nest_count);
 
+/*
+ * Stack size of the shared listener thread, and period at which it
+ * polls the wait shm of sockets waiting for their session daemon while
+ * it has other sockets to handle. The listener runs handle_message()
+ * and the statedump, whose deepest frames hold a few PATH_MAX buffers:
+ * the per-socket listener threads already run them on the 128 KiB
+ * default thread stack of musl.
+ */
+#define LTTNG_UST_SHARED_LISTENER_STACK_SIZE	(256 * 1024)
+#define LTTNG_UST_SHARED_LISTENER_POLL_MS	1000
+
+/*
+ * Period at which the shared listener thread retries to get a
+ * registration slot.
+ */
+#define LTTNG_UST_REGISTER_SLOT_POLL_MS		100
+
+/*
+ * State of a socket handled by the shared listener thread.
+ */
+enum shared_listener_state {
+	SHARED_LISTENER_CONNECT,	/* Connect to the session daemon. */
+	SHARED_LISTENER_SLOT,		/* Wait for a registration slot. */
+	SHARED_LISTENER_WAIT,		/* Wait for the session daemon. */
+	SHARED_LISTENER_BACKOFF,	/* Delay before reconnecting. */
+	SHARED_LISTENER_CONNECTED,	/* Waiting for commands. */
+	SHARED_LISTENER_DONE,		/* Not handled anymore. */
+};
+
 /*
  * Info about socket and associated listener thread.
  */
@@ -269,6 +299,17 @@ struct sock_info {
 	int initial_statedump_done;
 	/* Keep procname for statedump */
 	char procname[LTTNG_UST_ABI_PROCNAME_LEN];
+
+	/* Holds a slot of register_slots. */
+	int register_slot_held;
+	/* Shared listener thread waiting for a slot until register_slot_end. */
+	int register_slot_waiting;
+	struct timespec register_slot_end;	/* CLOCK_MONOTONIC */
+
+	/* State machine of the shared listener thread. */
+	enum shared_listener_state listener_state;
+	int has_waited;
+	struct timespec backoff_end;	/* CLOCK_MONOTONIC */
 };
 
 /* Socket from app (connect) to session daemon (listen) for communication */
@@ -312,6 +353,15 @@ struct sock_info local_apps = {
 
 static int wait_poll_fallback;
 
+/*
+ * Single listener thread handling both the global and per-user session
+ * daemon sockets, used when LTTNG_UST_SINGLE_LISTENER_THREAD is set.
+ * shared_listener_active is protected by ust_exit_mutex.
+ */
+static pthread_t shared_listener;
+static int shared_listener_active;
+static int shared_listener_epoll_fd = -1;
+
 static const char *cmd_name_mapping[] = {
 	[ LTTNG_UST_RELEASE ] = "Release",
 	[ LTTNG_UST_SESSION ] = "Create Session",
@@ -363,20 +413,51 @@ static const char *cmd_name_mapping[] = {
 static const char *str_timeout;
 static int got_timeout_env;
 
+/*
+ * Asynchronous registration mode: the constructor does not wait for
+ * the session daemon, and the wait shm is mapped by the listener
+ * threads.
+ */
+static int register_async;
+
+/*
+ * Lazy registration of fork children, enabled by
+ * LTTNG_UST_FORK_REGISTER_DELAY: the child of a fork does not wait for
+ * the session daemon, and its listener threads only connect once
+ * fork_register_deadline (CLOCK_MONOTONIC) is reached. The deadline is
+ * randomized to spread the registrations of children forked together.
+ */
+static int lazy_fork_child;
+static struct timespec fork_register_deadline;
+
+/*
+ * Semaphore shared by this process and all processes forked from it,
+ * limiting the number of their concurrent registrations to the session
+ * daemons (LTTNG_UST_FORK_MAX_REGISTRATIONS). Never unmapped, so it is
+ * inherited across fork.
+ */
+static sem_t *register_slots;
+
 extern void lttng_ring_buffer_client_overwrite_init(void);
 extern void lttng_ring_buffer_client_overwrite_rt_init(void);
 extern void lttng_ring_buffer_client_discard_init(void);
 extern void lttng_ring_buffer_client_discard_rt_init(void);
 extern void lttng_ring_buffer_metadata_client_init(void);
+extern void lttng_ring_buffer_notification_client_init(void);
 extern void lttng_ring_buffer_client_overwrite_exit(void);
 extern void lttng_ring_buffer_client_overwrite_rt_exit(void);
 extern void lttng_ring_buffer_client_discard_exit(void);
 extern void lttng_ring_buffer_client_discard_rt_exit(void);
 extern void lttng_ring_buffer_metadata_client_exit(void);
+extern void lttng_ring_buffer_notification_client_exit(void);
 extern void lttng_counter_client_percpu_32_modular_init(void);
 extern void lttng_counter_client_percpu_32_modular_exit(void);
 extern void lttng_counter_client_percpu_64_modular_init(void);
 extern void lttng_counter_client_percpu_64_modular_exit(void);
+extern void lttng_counter_client_percpu_global_32_modular_init(void);
+extern void lttng_counter_client_percpu_global_32_modular_exit(void);
+extern void lttng_counter_client_percpu_global_64_modular_init(void);
+extern void lttng_counter_client_percpu_global_64_modular_exit(void);
 
 static char *get_map_shm(struct sock_info *sock_info);
 
@@ -453,6 +534,7 @@ void lttng_ust_fixup_tls(void)
 	lttng_fixup_net_ns_tls();
 	lttng_fixup_time_ns_tls();
 	lttng_fixup_uts_ns_tls();
+	lttng_fixup_callstack_tls();
 }
 
 int lttng_get_notify_socket(void *owner)
@@ -491,6 +573,10 @@ int setup_global_apps(void)
 	int ret = 0;
 	assert(!global_apps.wait_shm_mmap);
 
+	/* Mapped by the listener thread in asynchronous mode. */
+	if (register_async)
+		goto end;
+
 	global_apps.wait_shm_mmap = get_map_shm(&global_apps);
 	if (!global_apps.wait_shm_mmap) {
 		WARN("Unable to get map shm for global apps. Disabling LTTng-UST global tracing.");
@@ -498,6 +584,7 @@ int setup_global_apps(void)
 		ret = -EIO;
 		goto error;
 	}
+end:
 
 	global_apps.allowed = 1;
 	lttng_pthread_getname_np(global_apps.procname, LTTNG_UST_ABI_PROCNAME_LEN);
@@ -538,6 +625,10 @@ int setup_local_apps(void)
 		LTTNG_UST_WAIT_FILENAME,
 		uid);
 
+	/* Mapped by the listener thread in asynchronous mode. */
+	if (register_async)
+		goto end_map;
+
 	local_apps.wait_shm_mmap = get_map_shm(&local_apps);
 	if (!local_apps.wait_shm_mmap) {
 		WARN("Unable to get map shm for local apps. Disabling LTTng-UST per-user tracing.");
@@ -545,7 +636,7 @@ int setup_local_apps(void)
 		ret = -EIO;
 		goto end;
 	}
-
+end_map:
 	lttng_pthread_getname_np(local_apps.procname, LTTNG_UST_ABI_PROCNAME_LEN);
 end:
 	return ret;
@@ -595,6 +686,13 @@ int get_constructor_timeout(struct timespec *constructor_timeout)
 	long constructor_delay_ms;
 	int ret;
 
+	/*
+	 * In asynchronous mode, the constructor never waits. The
+	 * registration timeout only applies to the sockets.
+	 */
+	if (register_async || lazy_fork_child)
+		return 0;
+
 	constructor_delay_ms = get_timeout();
 
 	switch (constructor_delay_ms) {
@@ -624,6 +722,207 @@ int get_constructor_timeout(struct timespec *constructor_timeout)
 	return 1;
 }
 
+static
+void get_fork_register_deadline(void)
+{
+	const char *str_delay;
+	long max_delay_ms, delay_ms = 0;
+	unsigned int seed;
+	int ret;
+
+	ret = clock_gettime(CLOCK_MONOTONIC, &fork_register_deadline);
+	if (ret) {
+		PERROR("clock_gettime");
+		return;
+	}
+	str_delay = lttng_getenv("LTTNG_UST_FORK_REGISTER_DELAY");
+	max_delay_ms = str_delay ? strtol(str_delay, NULL, 10) : 0;
+	if (max_delay_ms > 0) {
+		seed = (unsigned int) getpid() ^
+			(unsigned int) fork_register_deadline.tv_nsec;
+		delay_ms = rand_r(&seed) % (max_delay_ms + 1);
+	}
+	DBG("Delaying registration of fork child by %ld ms", delay_ms);
+	fork_register_deadline.tv_sec += delay_ms / 1000;
+	fork_register_deadline.tv_nsec += (delay_ms % 1000) * 1000000L;
+	if (fork_register_deadline.tv_nsec >= 1000000000L) {
+		fork_register_deadline.tv_sec++;
+		fork_register_deadline.tv_nsec -= 1000000000L;
+	}
+}
+
+/*
+ * Create the registration slots semaphore. Only the first process of a
+ * fork hierarchy creates it, children inherit it.
+ */
+static
+void setup_register_slots(void)
+{
+	const char *str_max;
+	long max_registrations;
+	sem_t *slots;
+	int ret;
+
+	if (register_slots)
+		return;
+	str_max = lttng_getenv("LTTNG_UST_FORK_MAX_REGISTRATIONS");
+	if (!str_max)
+		return;
+	max_registrations = strtol(str_max, NULL, 10);
+	if (max_registrations <= 0 || max_registrations > SEM_VALUE_MAX) {
+		WARN("Invalid LTTNG_UST_FORK_MAX_REGISTRATIONS value %ld",
+			max_registrations);
+		return;
+	}
+	slots = mmap(NULL, sizeof(*slots), PROT_READ | PROT_WRITE,
+			MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (slots == MAP_FAILED) {
+		PERROR("mmap");
+		return;
+	}
+	ret = sem_init(slots, 1, max_registrations);
+	if (ret) {
+		PERROR("sem_init");
+		ret = munmap(slots, sizeof(*slots));
+		if (ret) {
+			PERROR("munmap");
+		}
+		return;
+	}
+	register_slots = slots;
+}
+
+/*
+ * Wait for a registration slot before connecting to the session
+ * daemon. Called without the ust lock held, from the per-socket
+ * listener threads only: the shared listener thread cannot block, see
+ * shared_listener_register_slot_ready(). Slots are held until
+ * registration is done or failed. A process which dies while holding a
+ * slot leaks it, so we give up waiting after the registration timeout
+ * and register anyway.
+ */
+static
+void get_register_slot(struct sock_info *sock_info)
+{
+	struct timespec slot_timeout;
+	long timeout_ms;
+	int ret;
+
+	if (!register_slots || sock_info->register_slot_held)
+		return;
+	timeout_ms = get_timeout();
+	switch (timeout_ms) {
+	case -1:
+		do {
+			ret = sem_wait(register_slots);
+		} while (ret < 0 && errno == EINTR);
+		break;
+	case 0:
+		ret = sem_trywait(register_slots);
+		break;
+	default:
+		ret = clock_gettime(CLOCK_REALTIME, &slot_timeout);
+		if (ret)
+			break;
+		slot_timeout.tv_sec += timeout_ms / 1000;
+		slot_timeout.tv_nsec += (timeout_ms % 1000) * 1000000L;
+		if (slot_timeout.tv_nsec >= 1000000000L) {
+			slot_timeout.tv_sec++;
+			slot_timeout.tv_nsec -= 1000000000L;
+		}
+		do {
+			ret = sem_timedwait(register_slots, &slot_timeout);
+		} while (ret < 0 && errno == EINTR);
+		break;
+	}
+	if (ret) {
+		DBG("No registration slot available for %s apps, registering anyway",
+			sock_info->name);
+		return;
+	}
+	sock_info->register_slot_held = 1;
+}
+
+static
+void put_register_slot(struct sock_info *sock_info)
+{
+	int ret;
+
+	if (!sock_info->register_slot_held)
+		return;
+	sock_info->register_slot_held = 0;
+	ret = sem_post(register_slots);
+	if (ret) {
+		PERROR("sem_post");
+	}
+}
+
+static
+void get_register_async(void)
+{
+	const char *str_register_async =
+		lttng_getenv("LTTNG_UST_REGISTER_ASYNC");
+
+	if (str_register_async) {
+		DBG("%s environment variable is set",
+			"LTTNG_UST_REGISTER_ASYNC");
+		register_async = 1;
+	}
+}
+
+/*
+ * Create the epoll fd of the shared listener thread if it is requested.
+ * Returns 1 if the shared listener thread should be used, 0 otherwise.
+ */
+static
+int setup_shared_listener(void)
+{
+	int fd, ret;
+
+	if (!lttng_getenv("LTTNG_UST_SINGLE_LISTENER_THREAD"))
+		return 0;
+	DBG("%s environment variable is set",
+		"LTTNG_UST_SINGLE_LISTENER_THREAD");
+
+	lttng_ust_lock_fd_tracker();
+	fd = epoll_create1(EPOLL_CLOEXEC);
+	if (fd < 0) {
+		PERROR("epoll_create1");
+		lttng_ust_unlock_fd_tracker();
+		return 0;
+	}
+	ret = lttng_ust_add_fd_to_tracker(fd);
+	if (ret < 0) {
+		ret = close(fd);
+		if (ret) {
+			PERROR("close on epoll fd");
+		}
+		lttng_ust_unlock_fd_tracker();
+		return 0;
+	}
+	shared_listener_epoll_fd = ret;
+	lttng_ust_unlock_fd_tracker();
+	return 1;
+}
+
+static
+void cleanup_shared_listener(void)
+{
+	int ret;
+
+	if (shared_listener_epoll_fd < 0)
+		return;
+	lttng_ust_lock_fd_tracker();
+	ret = close(shared_listener_epoll_fd);
+	if (!ret) {
+		lttng_ust_delete_fd_from_tracker(shared_listener_epoll_fd);
+	} else {
+		PERROR("close on epoll fd");
+	}
+	lttng_ust_unlock_fd_tracker();
+	shared_listener_epoll_fd = -1;
+}
+
 static
 void get_allow_blocking(void)
 {
@@ -693,6 +992,7 @@ void decrement_sem_count(unsigned int count)
 static
 int handle_register_done(struct sock_info *sock_info)
 {
+	put_register_slot(sock_info);
 	if (sock_info->registration_done)
 		return 0;
 	sock_info->registration_done = 1;
@@ -709,6 +1009,7 @@ int handle_register_done(struct sock_info *sock_info)
 static
 int handle_register_failed(struct sock_info *sock_info)
 {
+	put_register_slot(sock_info);
 	if (sock_info->registration_done)
 		return 0;
 	sock_info->registration_done = 1;
@@ -1381,6 +1682,15 @@ void cleanup_sock_info(struct sock_info *sock_info, int exiting)
 	sock_info->registration_done = 0;
 	sock_info->initial_statedump_done = 0;
 
+	/*
+	 * After fork, the slot held by the parent is released by the
+	 * parent.
+	 */
+	if (exiting)
+		put_register_slot(sock_info);
+	else
+		sock_info->register_slot_held = 0;
+
 	/*
 	 * wait_shm_mmap, socket and notify socket are used by listener
 	 * threads outside of the ust lock, so we cannot tear them down
@@ -1701,47 +2011,60 @@ error:
 }
 
 /*
- * This thread does not allocate any resource, except within
- * handle_message, within mutex protection. This mutex protects against
- * fork and exit.
- * The other moment it allocates resources is at socket connection, which
- * is also protected by the mutex.
+ * Outcome of the listener steps, shared by the per-socket listener
+ * threads and the shared listener thread.
+ */
+enum listener_status {
+	LISTENER_OK = 0,
+	LISTENER_RETRY,		/* Reconnect to the session daemon now. */
+	LISTENER_WAIT_RETRY,	/* Wait for the session daemon, then reconnect. */
+	LISTENER_QUIT,		/* The listener should quit. */
+};
+
+/*
+ * In asynchronous mode, the wait shm is not mapped by the constructor.
+ * Its creation may require a fork, which is done from the listener
+ * thread, outside of the ust lock.
  */
 static
-void *ust_listener_thread(void *arg)
+enum listener_status listener_map_wait_shm(struct sock_info *sock_info)
 {
-	struct sock_info *sock_info = arg;
-	int sock, ret, prev_connect_failed = 0, has_waited = 0, fd;
-	long timeout;
+	char *wait_shm_mmap;
+	int ret;
 
-	lttng_ust_fixup_tls();
-	/*
-	 * If available, add '-ust' to the end of this thread's
-	 * process name
-	 */
-	ret = lttng_ust_setustprocname();
-	if (ret) {
-		ERR("Unable to set UST process name");
-	}
+	if (sock_info->wait_shm_mmap)
+		return LISTENER_OK;
 
-	/* Restart trying to connect to the session daemon */
-restart:
-	if (prev_connect_failed) {
-		/* Wait for sessiond availability with pipe */
-		wait_for_sessiond(sock_info);
-		if (has_waited) {
-			has_waited = 0;
-			/*
-			 * Sleep for 5 seconds before retrying after a
-			 * sequence of failure / wait / failure. This
-			 * deals with a killed or broken session daemon.
-			 */
-			sleep(5);
-		} else {
-			has_waited = 1;
-		}
-		prev_connect_failed = 0;
+	wait_shm_mmap = get_map_shm(sock_info);
+	if (ust_lock()) {
+		goto quit;
+	}
+	if (!wait_shm_mmap) {
+		WARN("Unable to get map shm for %s apps. Disabling LTTng-UST %s tracing.",
+			sock_info->name, sock_info->name);
+		sock_info->allowed = 0;
+		ret = handle_register_failed(sock_info);
+		assert(!ret);
+		goto quit;
 	}
+	sock_info->wait_shm_mmap = wait_shm_mmap;
+	ust_unlock();
+	return LISTENER_OK;
+
+quit:
+	ust_unlock();
+	return LISTENER_QUIT;
+}
+
+/*
+ * Connect and register the cmd and notify sockets to the session
+ * daemon. Called without the ust lock held.
+ */
+static
+enum listener_status listener_connect(struct sock_info *sock_info)
+{
+	int ret, fd;
+	long timeout;
 
 	if (ust_lock()) {
 		goto quit;
@@ -1781,16 +2104,7 @@ restart:
 	if (ret < 0) {
 		lttng_ust_unlock_fd_tracker();
 		DBG("Info: sessiond not accepting connections to %s apps socket", sock_info->name);
-		prev_connect_failed = 1;
-
-		/*
-		 * If we cannot find the sessiond daemon, don't delay
-		 * constructor execution.
-		 */
-		ret = handle_register_failed(sock_info);
-		assert(!ret);
-		ust_unlock();
-		goto restart;
+		goto connect_failed;
 	}
 	fd = ret;
 	ret = lttng_ust_add_fd_to_tracker(fd);
@@ -1799,9 +2113,7 @@ restart:
 		if (ret) {
 			PERROR("close on sock_info->socket");
 		}
-		ret = -1;
 		lttng_ust_unlock_fd_tracker();
-		ust_unlock();
 		goto quit;
 	}
 
@@ -1836,15 +2148,7 @@ restart:
 	if (ret < 0) {
 		ERR("Error registering to %s ust cmd socket",
 			sock_info->name);
-		prev_connect_failed = 1;
-		/*
-		 * If we cannot register to the sessiond daemon, don't
-		 * delay constructor execution.
-		 */
-		ret = handle_register_failed(sock_info);
-		assert(!ret);
-		ust_unlock();
-		goto restart;
+		goto connect_failed;
 	}
 
 	ust_unlock();
@@ -1864,16 +2168,7 @@ restart:
 	if (ret < 0) {
 		lttng_ust_unlock_fd_tracker();
 		DBG("Info: sessiond not accepting connections to %s apps socket", sock_info->name);
-		prev_connect_failed = 1;
-
-		/*
-		 * If we cannot find the sessiond daemon, don't delay
-		 * constructor execution.
-		 */
-		ret = handle_register_failed(sock_info);
-		assert(!ret);
-		ust_unlock();
-		goto restart;
+		goto connect_failed;
 	}
 
 	fd = ret;
@@ -1883,9 +2178,7 @@ restart:
 		if (ret) {
 			PERROR("close on sock_info->notify_socket");
 		}
-		ret = -1;
 		lttng_ust_unlock_fd_tracker();
-		ust_unlock();
 		goto quit;
 	}
 
@@ -1929,86 +2222,536 @@ restart:
 	if (ret < 0) {
 		ERR("Error registering to %s ust notify socket",
 			sock_info->name);
-		prev_connect_failed = 1;
-		/*
-		 * If we cannot register to the sessiond daemon, don't
-		 * delay constructor execution.
-		 */
-		ret = handle_register_failed(sock_info);
-		assert(!ret);
-		ust_unlock();
-		goto restart;
+		goto connect_failed;
 	}
-	sock = sock_info->socket;
 
 	ust_unlock();
+	return LISTENER_OK;
 
-	for (;;) {
-		ssize_t len;
-		struct ustcomm_ust_msg lum;
+connect_failed:
+	/*
+	 * If we cannot find or register to the sessiond daemon, don't
+	 * delay constructor execution.
+	 */
+	ret = handle_register_failed(sock_info);
+	assert(!ret);
+	ust_unlock();
+	return LISTENER_WAIT_RETRY;
 
-		len = ustcomm_recv_unix_sock(sock, &lum, sizeof(lum));
-		switch (len) {
-		case 0:	/* orderly shutdown */
-			DBG("%s lttng-sessiond has performed an orderly shutdown", sock_info->name);
-			if (ust_lock()) {
-				goto quit;
-			}
-			/*
-			 * Either sessiond has shutdown or refused us by closing the socket.
-			 * In either case, we don't want to delay construction execution,
-			 * and we need to wait before retry.
-			 */
-			prev_connect_failed = 1;
-			/*
-			 * If we cannot register to the sessiond daemon, don't
-			 * delay constructor execution.
-			 */
-			ret = handle_register_failed(sock_info);
-			assert(!ret);
-			ust_unlock();
-			goto end;
-		case sizeof(lum):
-			print_cmd(lum.cmd, lum.handle);
-			ret = handle_message(sock_info, sock, &lum);
-			if (ret) {
-				ERR("Error handling message for %s socket",
-					sock_info->name);
-				/*
-				 * Close socket if protocol error is
-				 * detected.
-				 */
-				goto end;
-			}
-			continue;
-		default:
-			if (len < 0) {
-				DBG("Receive failed from lttng-sessiond with errno %d", (int) -len);
-			} else {
-				DBG("incorrect message size (%s socket): %zd", sock_info->name, len);
-			}
-			if (len == -ECONNRESET) {
-				DBG("%s remote end closed connection", sock_info->name);
-				goto end;
-			}
-			goto end;
-		}
+quit:
+	ust_unlock();
+	return LISTENER_QUIT;
+}
 
+/*
+ * In a lazily registered fork child, delay the first connection to the
+ * session daemon until the registration deadline.
+ */
+static
+void listener_fork_delay(void)
+{
+	int ret;
+
+	if (!lazy_fork_child)
+		return;
+	do {
+		ret = clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME,
+				&fork_register_deadline, NULL);
+	} while (ret == EINTR);
+}
+
+/*
+ * Receive and handle one command from the session daemon. Called
+ * without the ust lock held.
+ */
+static
+enum listener_status listener_handle_cmd(struct sock_info *sock_info)
+{
+	ssize_t len;
+	struct ustcomm_ust_msg lum;
+	int ret;
+
+	len = ustcomm_recv_unix_sock(sock_info->socket, &lum, sizeof(lum));
+	switch (len) {
+	case 0:	/* orderly shutdown */
+		DBG("%s lttng-sessiond has performed an orderly shutdown", sock_info->name);
+		if (ust_lock()) {
+			ust_unlock();
+			return LISTENER_QUIT;
+		}
+		/*
+		 * Either sessiond has shutdown or refused us by closing the socket.
+		 * In either case, we don't want to delay construction execution,
+		 * and we need to wait before retry.
+		 *
+		 * If we cannot register to the sessiond daemon, don't
+		 * delay constructor execution.
+		 */
+		ret = handle_register_failed(sock_info);
+		assert(!ret);
+		ust_unlock();
+		return LISTENER_WAIT_RETRY;
+	case sizeof(lum):
+		print_cmd(lum.cmd, lum.handle);
+		ret = handle_message(sock_info, sock_info->socket, &lum);
+		if (ret) {
+			ERR("Error handling message for %s socket",
+				sock_info->name);
+			/*
+			 * Close socket if protocol error is
+			 * detected.
+			 */
+			return LISTENER_RETRY;
+		}
+		return LISTENER_OK;
+	default:
+		if (len < 0) {
+			DBG("Receive failed from lttng-sessiond with errno %d", (int) -len);
+		} else {
+			DBG("incorrect message size (%s socket): %zd", sock_info->name, len);
+		}
+		if (len == -ECONNRESET) {
+			DBG("%s remote end closed connection", sock_info->name);
+		}
+		return LISTENER_RETRY;
 	}
-end:
+}
+
+/*
+ * Cleanup socket handles before trying to reconnect.
+ */
+static
+enum listener_status listener_disconnect(struct sock_info *sock_info)
+{
 	if (ust_lock()) {
-		goto quit;
+		ust_unlock();
+		return LISTENER_QUIT;
 	}
-	/* Cleanup socket handles before trying to reconnect */
 	lttng_ust_objd_table_owner_cleanup(sock_info);
 	ust_unlock();
+	return LISTENER_OK;
+}
+
+/*
+ * This thread does not allocate any resource, except within
+ * handle_message, within mutex protection. This mutex protects against
+ * fork and exit.
+ * The other moment it allocates resources is at socket connection, which
+ * is also protected by the mutex.
+ */
+static
+void *ust_listener_thread(void *arg)
+{
+	struct sock_info *sock_info = arg;
+	int ret, prev_connect_failed = 0, has_waited = 0;
+	enum listener_status status;
+
+	lttng_ust_fixup_tls();
+	/*
+	 * If available, add '-ust' to the end of this thread's
+	 * process name
+	 */
+	ret = lttng_ust_setustprocname();
+	if (ret) {
+		ERR("Unable to set UST process name");
+	}
+
+	if (listener_map_wait_shm(sock_info) == LISTENER_QUIT)
+		goto quit;
+
+	listener_fork_delay();
+
+	/* Restart trying to connect to the session daemon */
+restart:
+	if (prev_connect_failed) {
+		/* Wait for sessiond availability with pipe */
+		wait_for_sessiond(sock_info);
+		if (has_waited) {
+			has_waited = 0;
+			/*
+			 * Sleep for 5 seconds before retrying after a
+			 * sequence of failure / wait / failure. This
+			 * deals with a killed or broken session daemon.
+			 */
+			sleep(5);
+		} else {
+			has_waited = 1;
+		}
+		prev_connect_failed = 0;
+	}
+
+	get_register_slot(sock_info);
+	switch (listener_connect(sock_info)) {
+	case LISTENER_OK:
+		break;
+	case LISTENER_QUIT:
+		goto quit;
+	default:
+		prev_connect_failed = 1;
+		goto restart;
+	}
+
+	do {
+		status = listener_handle_cmd(sock_info);
+	} while (status == LISTENER_OK);
+	switch (status) {
+	case LISTENER_QUIT:
+		goto quit;
+	case LISTENER_WAIT_RETRY:
+		prev_connect_failed = 1;
+		break;
+	default:
+		break;
+	}
+
+	if (listener_disconnect(sock_info) == LISTENER_QUIT)
+		goto quit;
 	goto restart;	/* try to reconnect */
 
 quit:
+	pthread_mutex_lock(&ust_exit_mutex);
+	sock_info->thread_active = 0;
+	pthread_mutex_unlock(&ust_exit_mutex);
+	return NULL;
+}
+
+/*
+ * Non-blocking check of the wait shm, used by the shared listener
+ * thread. Returns 1 if the session daemon should be contacted, 0 if it
+ * should be waited for, -1 if the listener should quit.
+ */
+static
+int shared_listener_sessiond_ready(struct sock_info *sock_info)
+{
+	/* Use ust_lock to check if we should quit. */
+	if (ust_lock()) {
+		ust_unlock();
+		return -1;
+	}
+	if (wait_poll_fallback) {
+		ust_unlock();
+		return 1;
+	}
 	ust_unlock();
 
+	assert(sock_info->wait_shm_mmap);
+	return !!uatomic_read((int32_t *) sock_info->wait_shm_mmap);
+}
+
+/*
+ * Milliseconds left before CLOCK_MONOTONIC reaches `end`.
+ */
+static
+long shared_listener_remaining_ms(const struct timespec *end)
+{
+	struct timespec now;
+	long remaining_ms;
+
+	if (clock_gettime(CLOCK_MONOTONIC, &now))
+		return 0;
+	remaining_ms = (end->tv_sec - now.tv_sec) * 1000L
+		+ (end->tv_nsec - now.tv_nsec) / 1000000L;
+	if (remaining_ms < 0)
+		remaining_ms = 0;
+	return remaining_ms;
+}
+
+/*
+ * Milliseconds left before the end of the retry delay of a socket.
+ */
+static
+long shared_listener_backoff_remaining_ms(struct sock_info *sock_info)
+{
+	return shared_listener_remaining_ms(&sock_info->backoff_end);
+}
+
+/*
+ * Non-blocking get_register_slot() for the shared listener thread,
+ * which handles both sockets. Returns 1 once the slot is held, or
+ * once waiting for it timed out, 0 if the slot should be retried after
+ * LTTNG_UST_REGISTER_SLOT_POLL_MS.
+ */
+static
+int shared_listener_register_slot_ready(struct sock_info *sock_info)
+{
+	long timeout_ms;
+
+	if (!register_slots || sock_info->register_slot_held)
+		return 1;
+	if (!sem_trywait(register_slots)) {
+		sock_info->register_slot_held = 1;
+		sock_info->register_slot_waiting = 0;
+		return 1;
+	}
+	if (errno != EAGAIN && errno != EINTR)
+		goto give_up;
+	timeout_ms = get_timeout();
+	if (!timeout_ms)
+		goto give_up;
+	if (!sock_info->register_slot_waiting) {
+		sock_info->register_slot_waiting = 1;
+		if (timeout_ms > 0) {
+			if (clock_gettime(CLOCK_MONOTONIC,
+					&sock_info->register_slot_end)) {
+				PERROR("clock_gettime");
+				goto give_up;
+			}
+			sock_info->register_slot_end.tv_sec += timeout_ms / 1000;
+			sock_info->register_slot_end.tv_nsec +=
+				(timeout_ms % 1000) * 1000000L;
+			if (sock_info->register_slot_end.tv_nsec >= 1000000000L) {
+				sock_info->register_slot_end.tv_sec++;
+				sock_info->register_slot_end.tv_nsec -= 1000000000L;
+			}
+		}
+		return 0;
+	}
+	if (timeout_ms < 0
+			|| shared_listener_remaining_ms(&sock_info->register_slot_end) > 0)
+		return 0;
+
+give_up:
+	sock_info->register_slot_waiting = 0;
+	DBG("No registration slot available for %s apps, registering anyway",
+		sock_info->name);
+	return 1;
+}
+
+/*
+ * Move the state machine of a socket forward until it needs to wait
+ * for the session daemon, for its retry delay, or for a command.
+ */
+static
+enum listener_status shared_listener_advance(struct sock_info *sock_info)
+{
+	struct epoll_event ev;
+	int ret;
+
+	for (;;) {
+		switch (sock_info->listener_state) {
+		case SHARED_LISTENER_WAIT:
+			ret = shared_listener_sessiond_ready(sock_info);
+			if (ret < 0)
+				return LISTENER_QUIT;
+			if (!ret)
+				return LISTENER_OK;
+			if (sock_info->has_waited) {
+				sock_info->has_waited = 0;
+				/*
+				 * Wait for 5 seconds before retrying after a
+				 * sequence of failure / wait / failure. This
+				 * deals with a killed or broken session daemon.
+				 */
+				if (clock_gettime(CLOCK_MONOTONIC,
+						&sock_info->backoff_end)) {
+					PERROR("clock_gettime");
+				}
+				sock_info->backoff_end.tv_sec += 5;
+				sock_info->listener_state = SHARED_LISTENER_BACKOFF;
+			} else {
+				sock_info->has_waited = 1;
+				sock_info->listener_state = SHARED_LISTENER_CONNECT;
+			}
+			break;
+		case SHARED_LISTENER_BACKOFF:
+			if (shared_listener_backoff_remaining_ms(sock_info) > 0)
+				return LISTENER_OK;
+			sock_info->listener_state = SHARED_LISTENER_CONNECT;
+			break;
+		case SHARED_LISTENER_CONNECT:
+		case SHARED_LISTENER_SLOT:
+			if (!shared_listener_register_slot_ready(sock_info)) {
+				sock_info->listener_state = SHARED_LISTENER_SLOT;
+				return LISTENER_OK;
+			}
+			switch (listener_connect(sock_info)) {
+			case LISTENER_OK:
+				break;
+			case LISTENER_QUIT:
+				return LISTENER_QUIT;
+			default:
+				sock_info->listener_state = SHARED_LISTENER_WAIT;
+				continue;
+			}
+			memset(&ev, 0, sizeof(ev));
+			ev.events = EPOLLIN;
+			ev.data.ptr = sock_info;
+			ret = epoll_ctl(shared_listener_epoll_fd, EPOLL_CTL_ADD,
+					sock_info->socket, &ev);
+			if (ret) {
+				PERROR("epoll_ctl add %s apps socket",
+					sock_info->name);
+				if (listener_disconnect(sock_info) == LISTENER_QUIT)
+					return LISTENER_QUIT;
+				sock_info->listener_state = SHARED_LISTENER_WAIT;
+				continue;
+			}
+			sock_info->listener_state = SHARED_LISTENER_CONNECTED;
+			return LISTENER_OK;
+		case SHARED_LISTENER_CONNECTED:
+		case SHARED_LISTENER_DONE:
+			return LISTENER_OK;
+		}
+	}
+}
+
+/*
+ * Handle a command received on a socket polled by the shared listener
+ * thread.
+ */
+static
+enum listener_status shared_listener_handle_cmd(struct sock_info *sock_info)
+{
+	enum listener_status status;
+	int ret;
+
+	status = listener_handle_cmd(sock_info);
+	switch (status) {
+	case LISTENER_OK:
+	case LISTENER_QUIT:
+		return status;
+	default:
+		break;
+	}
+	ret = epoll_ctl(shared_listener_epoll_fd, EPOLL_CTL_DEL,
+			sock_info->socket, NULL);
+	if (ret) {
+		PERROR("epoll_ctl del %s apps socket", sock_info->name);
+	}
+	if (listener_disconnect(sock_info) == LISTENER_QUIT)
+		return LISTENER_QUIT;
+	if (status == LISTENER_WAIT_RETRY)
+		sock_info->listener_state = SHARED_LISTENER_WAIT;
+	else
+		sock_info->listener_state = SHARED_LISTENER_CONNECT;
+	return LISTENER_OK;
+}
+
+/*
+ * Shared listener thread: runs the state machines of both the global
+ * and per-user session daemon sockets. Commands are received through
+ * epoll. When only one socket waits for its session daemon and no
+ * socket is connected, the thread waits on its wait shm futex.
+ * Otherwise, the wait shm of waiting sockets is polled.
+ */
+static
+void *ust_shared_listener_thread(void *arg)
+{
+	struct sock_info *sock_infos[] = { &global_apps, &local_apps };
+	struct epoll_event events[LTTNG_ARRAY_SIZE(sock_infos)];
+	int ret, i;
+
+	lttng_ust_fixup_tls();
+	/*
+	 * If available, add '-ust' to the end of this thread's
+	 * process name
+	 */
+	ret = lttng_ust_setustprocname();
+	if (ret) {
+		ERR("Unable to set UST process name");
+	}
+
+	for (i = 0; i < LTTNG_ARRAY_SIZE(sock_infos); i++) {
+		struct sock_info *sock_info = sock_infos[i];
+
+		sock_info->has_waited = 0;
+		sock_info->register_slot_waiting = 0;
+		if (!sock_info->allowed
+				|| listener_map_wait_shm(sock_info) == LISTENER_QUIT) {
+			sock_info->listener_state = SHARED_LISTENER_DONE;
+		} else if (lazy_fork_child) {
+			/* Delay the first connection of a fork child. */
+			sock_info->backoff_end = fork_register_deadline;
+			sock_info->listener_state = SHARED_LISTENER_BACKOFF;
+		} else {
+			sock_info->listener_state = SHARED_LISTENER_CONNECT;
+		}
+	}
+
+	for (;;) {
+		struct sock_info *waiting = NULL;
+		int nr_waiting = 0, nr_connected = 0, nr_active = 0;
+		long timeout_ms = -1;
+		int nr_events;
+
+		for (i = 0; i < LTTNG_ARRAY_SIZE(sock_infos); i++) {
+			struct sock_info *sock_info = sock_infos[i];
+			long remaining_ms;
+
+			if (shared_listener_advance(sock_info) == LISTENER_QUIT)
+				goto quit;
+			switch (sock_info->listener_state) {
+			case SHARED_LISTENER_WAIT:
+				waiting = sock_info;
+				nr_waiting++;
+				nr_active++;
+				break;
+			case SHARED_LISTENER_BACKOFF:
+				remaining_ms = shared_listener_backoff_remaining_ms(sock_info);
+				if (timeout_ms < 0 || remaining_ms < timeout_ms)
+					timeout_ms = remaining_ms;
+				nr_active++;
+				break;
+			case SHARED_LISTENER_SLOT:
+				if (timeout_ms < 0 || timeout_ms > LTTNG_UST_REGISTER_SLOT_POLL_MS)
+					timeout_ms = LTTNG_UST_REGISTER_SLOT_POLL_MS;
+				nr_active++;
+				break;
+			case SHARED_LISTENER_CONNECTED:
+				nr_connected++;
+				nr_active++;
+				break;
+			default:
+				break;
+			}
+		}
+		if (!nr_active)
+			goto quit;
+
+		if (nr_waiting == 1 && !nr_connected && !wait_poll_fallback) {
+			struct timespec timeout, *ptimeout = NULL;
+
+			if (timeout_ms >= 0) {
+				timeout.tv_sec = timeout_ms / 1000;
+				timeout.tv_nsec = (timeout_ms % 1000) * 1000000L;
+				ptimeout = &timeout;
+			}
+			DBG("Waiting for %s apps sessiond", waiting->name);
+			ret = lttng_ust_futex_async(
+					(int32_t *) waiting->wait_shm_mmap,
+					FUTEX_WAIT, 0, ptimeout, NULL, 0);
+			if (ret && errno == EFAULT) {
+				wait_poll_fallback = 1;
+				DBG("FUTEX_WAIT on read-only memory mappings is not supported by this kernel. LTTng-UST will use polling mode fallback.");
+				if (ust_debug())
+					PERROR("futex");
+			}
+			continue;
+		}
+		if (nr_waiting) {
+			if (timeout_ms < 0 || timeout_ms > LTTNG_UST_SHARED_LISTENER_POLL_MS)
+				timeout_ms = LTTNG_UST_SHARED_LISTENER_POLL_MS;
+		}
+
+		nr_events = epoll_wait(shared_listener_epoll_fd, events,
+				LTTNG_ARRAY_SIZE(events), (int) timeout_ms);
+		if (nr_events < 0) {
+			if (errno == EINTR)
+				continue;
+			PERROR("epoll_wait");
+			goto quit;
+		}
+		for (i = 0; i < nr_events; i++) {
+			struct sock_info *sock_info = events[i].data.ptr;
+
+			if (shared_listener_handle_cmd(sock_info) == LISTENER_QUIT)
+				goto quit;
+		}
+	}
+
+quit:
 	pthread_mutex_lock(&ust_exit_mutex);
-	sock_info->thread_active = 0;
+	shared_listener_active = 0;
 	pthread_mutex_unlock(&ust_exit_mutex);
 	return NULL;
 }
@@ -2080,18 +2823,26 @@ void __attribute__((constructor)) lttng_ust_init(void)
 	lttng_ust_getcpu_init();
 	lttng_ust_statedump_init();
 	lttng_ring_buffer_metadata_client_init();
+	lttng_ring_buffer_notification_client_init();
 	lttng_ring_buffer_client_overwrite_init();
 	lttng_ring_buffer_client_overwrite_rt_init();
 	lttng_ring_buffer_client_discard_init();
 	lttng_ring_buffer_client_discard_rt_init();
 	lttng_counter_client_percpu_32_modular_init();
 	lttng_counter_client_percpu_64_modular_init();
+	lttng_counter_client_percpu_global_32_modular_init();
+	lttng_counter_client_percpu_global_64_modular_init();
 	lttng_perf_counter_init();
 	/*
 	 * Invoke ust malloc wrapper init before starting other threads.
 	 */
 	lttng_ust_malloc_wrapper_init();
 
+	get_register_async();
+	setup_register_slots();
+	if (lazy_fork_child)
+		get_fork_register_deadline();
+
 	timeout_mode = get_constructor_timeout(&constructor_timeout);
 
 	get_allow_blocking();
@@ -2133,6 +2884,31 @@ void __attribute__((constructor)) lttng_ust_init(void)
 		ERR("pthread_attr_setdetachstate: %s", strerror(ret));
 	}
 
+	if ((global_apps.allowed || local_apps.allowed)
+			&& setup_shared_listener()) {
+		size_t stack_size = LTTNG_UST_SHARED_LISTENER_STACK_SIZE;
+
+		if (stack_size < PTHREAD_STACK_MIN)
+			stack_size = PTHREAD_STACK_MIN;
+		ret = pthread_attr_setstacksize(&thread_attr, stack_size);
+		if (ret) {
+			ERR("pthread_attr_setstacksize: %s", strerror(ret));
+		}
+		pthread_mutex_lock(&ust_exit_mutex);
+		ret = pthread_create(&shared_listener, &thread_attr,
+				ust_shared_listener_thread, NULL);
+		if (ret) {
+			ERR("pthread_create shared: %s", strerror(ret));
+		}
+		shared_listener_active = 1;
+		pthread_mutex_unlock(&ust_exit_mutex);
+		if (!global_apps.allowed)
+			handle_register_done(&global_apps);
+		if (!local_apps.allowed)
+			handle_register_done(&local_apps);
+		goto threads_created;
+	}
+
 	if (global_apps.allowed) {
 		pthread_mutex_lock(&ust_exit_mutex);
 		ret = pthread_create(&global_apps.ust_listener, &thread_attr,
@@ -2158,6 +2934,7 @@ void __attribute__((constructor)) lttng_ust_init(void)
 	} else {
 		handle_register_done(&local_apps);
 	}
+threads_created:
 	ret = pthread_attr_destroy(&thread_attr);
 	if (ret) {
 		ERR("pthread_attr_destroy: %s", strerror(ret));
@@ -2214,8 +2991,15 @@ void lttng_ust_cleanup(int exiting)
 {
 	cleanup_sock_info(&global_apps, exiting);
 	cleanup_sock_info(&local_apps, exiting);
+	/* The epoll fd is used by the listener thread, see cleanup_sock_info. */
+	if (!exiting)
+		cleanup_shared_listener();
 	local_apps.allowed = 0;
 	global_apps.allowed = 0;
+	if (!exiting) {
+		register_async = 0;
+		lazy_fork_child = 0;
+	}
 	/*
 	 * The teardown in this function all affect data structures
 	 * accessed under the UST lock by the listener thread. This
@@ -2230,9 +3014,12 @@ void lttng_ust_cleanup(int exiting)
 	lttng_ring_buffer_client_discard_exit();
 	lttng_ring_buffer_client_overwrite_rt_exit();
 	lttng_ring_buffer_client_overwrite_exit();
+	lttng_ring_buffer_notification_client_exit();
 	lttng_ring_buffer_metadata_client_exit();
 	lttng_counter_client_percpu_32_modular_exit();
 	lttng_counter_client_percpu_64_modular_exit();
+	lttng_counter_client_percpu_global_32_modular_exit();
+	lttng_counter_client_percpu_global_64_modular_exit();
 	lttng_ust_statedump_destroy();
 	exit_tracepoint();
 	if (!exiting) {
@@ -2282,6 +3069,15 @@ void __attribute__((destructor)) lttng_ust_exit(void)
 			local_apps.thread_active = 0;
 		}
 	}
+	if (shared_listener_active) {
+		ret = pthread_cancel(shared_listener);
+		if (ret) {
+			ERR("Error cancelling shared ust listener thread: %s",
+				strerror(ret));
+		} else {
+			shared_listener_active = 0;
+		}
+	}
 	pthread_mutex_unlock(&ust_exit_mutex);
 
 	/*
@@ -2419,8 +3215,15 @@ void ust_after_fork_child(sigset_t *restore_sigset)
 	if (lttng_ust_liburcu_bp_after_fork_child)
 		lttng_ust_liburcu_bp_after_fork_child();
 	lttng_ust_cleanup(0);
+	lttng_ust_fd_tracker_after_fork_child();
 	/* Release mutexes and reenable signals */
 	ust_after_fork_common(restore_sigset);
+	/*
+	 * With lazy fork child registration, the child does not wait
+	 * for the session daemon, and registers after a random delay.
+	 */
+	if (lttng_getenv("LTTNG_UST_FORK_REGISTER_DELAY"))
+		lazy_fork_child = 1;
 	lttng_ust_init();
 }
 
@@ -24,6 +24,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -32,24 +33,85 @@
 
 #include "lttng-tracer-core.h"
 
-#define BUF_LEN	4096
-
 #ifndef NT_GNU_BUILD_ID
 # define NT_GNU_BUILD_ID	3
 #endif
 
+struct lttng_ust_elf {
+	/* Offset in bytes to start of section names string table. */
+	off_t section_names_offset;
+	/* Size in bytes of section names string table. */
+	size_t section_names_size;
+	char *path;
+	/* Read-only mapping of the whole file. */
+	const uint8_t *map;
+	size_t map_len;
+	struct lttng_ust_elf_ehdr *ehdr;
+	uint8_t bitness;
+	uint8_t endianness;
+};
+
+static inline
+int is_elf_32_bit(struct lttng_ust_elf *elf)
+{
+	return elf->bitness == ELFCLASS32;
+}
+
+static inline
+int is_elf_native_endian(struct lttng_ust_elf *elf)
+{
+	return elf->endianness == NATIVE_ELF_ENDIANNESS;
+}
+
+/*
+ * Get a pointer to `len` bytes at `offset` within the mapped ELF file.
+ *
+ * Returns NULL if the range is not entirely within the file.
+ */
+static
+const void *lttng_ust_elf_get_range(struct lttng_ust_elf *elf,
+		uint64_t offset, uint64_t len)
+{
+	if (offset > elf->map_len || len > elf->map_len - offset) {
+		return NULL;
+	}
+	return elf->map + offset;
+}
+
+/*
+ * Get the offset of entry `index` of a table of entries of `entsize`
+ * bytes at `table_offset` within the mapped ELF file, without
+ * overflow.
+ *
+ * Returns 0 on success, -1 if the entry starts beyond the file.
+ */
+static
+int lttng_ust_elf_get_entry_offset(struct lttng_ust_elf *elf,
+		uint64_t table_offset, uint16_t index, uint16_t entsize,
+		uint64_t *offset)
+{
+	uint64_t entry_offset = (uint64_t) index * entsize;
+
+	if (table_offset > elf->map_len
+			|| entry_offset > elf->map_len - table_offset) {
+		return -1;
+	}
+	*offset = table_offset + entry_offset;
+	return 0;
+}
+
 /*
  * Retrieve the nth (where n is the `index` argument) phdr (program
- * header) from the given elf instance.
+ * header) from the given elf instance into `phdr`.
  *
- * A pointer to the phdr is returned on success, NULL on failure.
+ * Returns 0 on success, -1 on failure.
  */
 static
-struct lttng_ust_elf_phdr *lttng_ust_elf_get_phdr(struct lttng_ust_elf *elf,
-						uint16_t index)
+int lttng_ust_elf_get_phdr(struct lttng_ust_elf *elf, uint16_t index,
+		struct lttng_ust_elf_phdr *phdr)
 {
-	struct lttng_ust_elf_phdr *phdr = NULL;
-	off_t offset;
+	const void *src;
+	uint64_t offset;
 
 	if (!elf) {
 		goto error;
@@ -59,24 +121,19 @@ struct lttng_ust_elf_phdr *lttng_ust_elf_get_phdr(struct lttng_ust_elf *elf,
 		goto error;
 	}
 
-	phdr = zmalloc(sizeof(struct lttng_ust_elf_phdr));
-	if (!phdr) {
-		goto error;
-	}
-
-	offset = (off_t) elf->ehdr->e_phoff
-			+ (off_t) index * elf->ehdr->e_phentsize;
-	if (lseek(elf->fd, offset, SEEK_SET) < 0) {
+	if (lttng_ust_elf_get_entry_offset(elf, elf->ehdr->e_phoff, index,
+			elf->ehdr->e_phentsize, &offset)) {
 		goto error;
 	}
 
 	if (is_elf_32_bit(elf)) {
 		Elf32_Phdr elf_phdr;
 
-		if (lttng_ust_read(elf->fd, &elf_phdr, sizeof(elf_phdr))
-				< sizeof(elf_phdr)) {
+		src = lttng_ust_elf_get_range(elf, offset, sizeof(elf_phdr));
+		if (!src) {
 			goto error;
 		}
+		memcpy(&elf_phdr, src, sizeof(elf_phdr));
 		if (!is_elf_native_endian(elf)) {
 			bswap_phdr(elf_phdr);
 		}
@@ -84,35 +141,35 @@ struct lttng_ust_elf_phdr *lttng_ust_elf_get_phdr(struct lttng_ust_elf *elf,
 	} else {
 		Elf64_Phdr elf_phdr;
 
-		if (lttng_ust_read(elf->fd, &elf_phdr, sizeof(elf_phdr))
-				< sizeof(elf_phdr)) {
+		src = lttng_ust_elf_get_range(elf, offset, sizeof(elf_phdr));
+		if (!src) {
 			goto error;
 		}
+		memcpy(&elf_phdr, src, sizeof(elf_phdr));
 		if (!is_elf_native_endian(elf)) {
 			bswap_phdr(elf_phdr);
 		}
 		copy_phdr(elf_phdr, *phdr);
 	}
 
-	return phdr;
+	return 0;
 
 error:
-	free(phdr);
-	return NULL;
+	return -1;
 }
 
 /*
  * Retrieve the nth (where n is the `index` argument) shdr (section
- * header) from the given elf instance.
+ * header) from the given elf instance into `shdr`.
  *
- * A pointer to the shdr is returned on success, NULL on failure.
+ * Returns 0 on success, -1 on failure.
  */
 static
-struct lttng_ust_elf_shdr *lttng_ust_elf_get_shdr(struct lttng_ust_elf *elf,
-						uint16_t index)
+int lttng_ust_elf_get_shdr(struct lttng_ust_elf *elf, uint16_t index,
+		struct lttng_ust_elf_shdr *shdr)
 {
-	struct lttng_ust_elf_shdr *shdr = NULL;
-	off_t offset;
+	const void *src;
+	uint64_t offset;
 
 	if (!elf) {
 		goto error;
@@ -122,24 +179,19 @@ struct lttng_ust_elf_shdr *lttng_ust_elf_get_shdr(struct lttng_ust_elf *elf,
 		goto error;
 	}
 
-	shdr = zmalloc(sizeof(struct lttng_ust_elf_shdr));
-	if (!shdr) {
-		goto error;
-	}
-
-	offset = (off_t) elf->ehdr->e_shoff
-			+ (off_t) index * elf->ehdr->e_shentsize;
-	if (lseek(elf->fd, offset, SEEK_SET) < 0) {
+	if (lttng_ust_elf_get_entry_offset(elf, elf->ehdr->e_shoff, index,
+			elf->ehdr->e_shentsize, &offset)) {
 		goto error;
 	}
 
 	if (is_elf_32_bit(elf)) {
 		Elf32_Shdr elf_shdr;
 
-		if (lttng_ust_read(elf->fd, &elf_shdr, sizeof(elf_shdr))
-				< sizeof(elf_shdr)) {
+		src = lttng_ust_elf_get_range(elf, offset, sizeof(elf_shdr));
+		if (!src) {
 			goto error;
 		}
+		memcpy(&elf_shdr, src, sizeof(elf_shdr));
 		if (!is_elf_native_endian(elf)) {
 			bswap_shdr(elf_shdr);
 		}
@@ -147,21 +199,21 @@ struct lttng_ust_elf_shdr *lttng_ust_elf_get_shdr(struct lttng_ust_elf *elf,
 	} else {
 		Elf64_Shdr elf_shdr;
 
-		if (lttng_ust_read(elf->fd, &elf_shdr, sizeof(elf_shdr))
-				< sizeof(elf_shdr)) {
+		src = lttng_ust_elf_get_range(elf, offset, sizeof(elf_shdr));
+		if (!src) {
 			goto error;
 		}
+		memcpy(&elf_shdr, src, sizeof(elf_shdr));
 		if (!is_elf_native_endian(elf)) {
 			bswap_shdr(elf_shdr);
 		}
 		copy_shdr(elf_shdr, *shdr);
 	}
 
-	return shdr;
+	return 0;
 
 error:
-	free(shdr);
-	return NULL;
+	return -1;
 }
 
 /*
@@ -169,82 +221,54 @@ error:
  * sh_name value) in bytes relative to the beginning of the section
  * names string table.
  *
- * If no name is found, NULL is returned.
+ * The returned name points within the mapped file. If no name is
+ * found, NULL is returned.
  */
 static
-char *lttng_ust_elf_get_section_name(struct lttng_ust_elf *elf, off_t offset)
+const char *lttng_ust_elf_get_section_name(struct lttng_ust_elf *elf,
+		uint64_t offset)
 {
-	char *name = NULL;
-	size_t len = 0, to_read;	/* len does not include \0 */
+	const char *names;
 
 	if (!elf) {
-		goto error;
+		return NULL;
 	}
 
 	if (offset >= elf->section_names_size) {
-		goto error;
+		return NULL;
 	}
 
-	if (lseek(elf->fd, elf->section_names_offset + offset, SEEK_SET) < 0) {
-		goto error;
+	names = lttng_ust_elf_get_range(elf, elf->section_names_offset,
+			elf->section_names_size);
+	if (!names) {
+		return NULL;
 	}
 
-	to_read = elf->section_names_size - offset;
-
-	/* Find first \0 after or at current location, remember len. */
-	for (;;) {
-		char buf[BUF_LEN];
-		ssize_t read_len;
-		size_t i;
-
-		if (!to_read) {
-			goto error;
-		}
-		read_len = lttng_ust_read(elf->fd, buf,
-			min_t(size_t, BUF_LEN, to_read));
-		if (read_len <= 0) {
-			goto error;
-		}
-		for (i = 0; i < read_len; i++) {
-			if (buf[i] == '\0') {
-				len += i;
-				goto end;
-			}
-		}
-		len += read_len;
-		to_read -= read_len;
-	}
-end:
-	name = zmalloc(sizeof(char) * (len + 1));	/* + 1 for \0 */
-	if (!name) {
-		goto error;
-	}
-	if (lseek(elf->fd, elf->section_names_offset + offset,
-		SEEK_SET) < 0) {
-		goto error;
-	}
-	if (lttng_ust_read(elf->fd, name, len + 1) < len + 1) {
-		goto error;
+	/* The name must be terminated within the string table. */
+	if (!memchr(names + offset, '\0',
+			elf->section_names_size - offset)) {
+		return NULL;
 	}
-
-	return name;
-
-error:
-	free(name);
-	return NULL;
+	return names + offset;
 }
 
 /*
  * Create an instance of lttng_ust_elf for the ELF file located at
  * `path`.
  *
+ * The file is mapped read-only for the lifetime of the instance, and
+ * headers, notes and sections are parsed in place. The file descriptor
+ * is closed as soon as the file is mapped.
+ *
  * Return a pointer to the instance on success, NULL on failure.
  */
 struct lttng_ust_elf *lttng_ust_elf_create(const char *path)
 {
-	uint8_t e_ident[EI_NIDENT];
-	struct lttng_ust_elf_shdr *section_names_shdr;
+	const uint8_t *e_ident;
+	struct lttng_ust_elf_shdr section_names_shdr;
 	struct lttng_ust_elf *elf = NULL;
+	struct stat st;
+	void *map;
 	int ret, fd;
 
 	elf = zmalloc(sizeof(struct lttng_ust_elf));
@@ -252,9 +276,6 @@ struct lttng_ust_elf *lttng_ust_elf_create(const char *path)
 		goto error;
 	}
 
-	/* Initialize fd field to -1. 0 is a valid fd number */
-	elf->fd = -1;
-
 	elf->path = strdup(path);
 	if (!elf->path) {
 		goto error;
@@ -271,24 +292,41 @@ struct lttng_ust_elf *lttng_ust_elf_create(const char *path)
 	if (ret < 0) {
 		ret = close(fd);
 		if (ret) {
-			PERROR("close on elf->fd");
+			PERROR("close on elf fd");
 		}
-		ret = -1;
 		lttng_ust_unlock_fd_tracker();
 		goto error;
 	}
-	elf->fd = ret;
+	fd = ret;
+	lttng_ust_unlock_fd_tracker();
+
+	map = MAP_FAILED;
+	if (!fstat(fd, &st) && S_ISREG(st.st_mode) && st.st_size > 0) {
+		map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+
+	lttng_ust_lock_fd_tracker();
+	ret = close(fd);
+	if (!ret) {
+		lttng_ust_delete_fd_from_tracker(fd);
+	} else {
+		PERROR("close");
+		abort();
+	}
 	lttng_ust_unlock_fd_tracker();
 
-	if (lttng_ust_read(elf->fd, e_ident, EI_NIDENT) < EI_NIDENT) {
+	if (map == MAP_FAILED) {
 		goto error;
 	}
-	elf->bitness = e_ident[EI_CLASS];
-	elf->endianness = e_ident[EI_DATA];
+	elf->map = map;
+	elf->map_len = st.st_size;
 
-	if (lseek(elf->fd, 0, SEEK_SET) < 0) {
+	e_ident = lttng_ust_elf_get_range(elf, 0, EI_NIDENT);
+	if (!e_ident) {
 		goto error;
 	}
+	elf->bitness = e_ident[EI_CLASS];
+	elf->endianness = e_ident[EI_DATA];
 
 	elf->ehdr = zmalloc(sizeof(struct lttng_ust_elf_ehdr));
 	if (!elf->ehdr) {
@@ -297,37 +335,40 @@ struct lttng_ust_elf *lttng_ust_elf_create(const char *path)
 
 	if (is_elf_32_bit(elf)) {
 		Elf32_Ehdr elf_ehdr;
+		const void *src;
 
-		if (lttng_ust_read(elf->fd, &elf_ehdr, sizeof(elf_ehdr))
-				< sizeof(elf_ehdr)) {
+		src = lttng_ust_elf_get_range(elf, 0, sizeof(elf_ehdr));
+		if (!src) {
 			goto error;
 		}
+		memcpy(&elf_ehdr, src, sizeof(elf_ehdr));
 		if (!is_elf_native_endian(elf)) {
 			bswap_ehdr(elf_ehdr);
 		}
 		copy_ehdr(elf_ehdr, *(elf->ehdr));
 	} else {
 		Elf64_Ehdr elf_ehdr;
+		const void *src;
 
-		if (lttng_ust_read(elf->fd, &elf_ehdr, sizeof(elf_ehdr))
-				< sizeof(elf_ehdr)) {
+		src = lttng_ust_elf_get_range(elf, 0, sizeof(elf_ehdr));
+		if (!src) {
 			goto error;
 		}
+		memcpy(&elf_ehdr, src, sizeof(elf_ehdr));
 		if (!is_elf_native_endian(elf)) {
 			bswap_ehdr(elf_ehdr);
 		}
 		copy_ehdr(elf_ehdr, *(elf->ehdr));
 	}
 
-	section_names_shdr = lttng_ust_elf_get_shdr(elf, elf->ehdr->e_shstrndx);
-	if (!section_names_shdr) {
+	if (lttng_ust_elf_get_shdr(elf, elf->ehdr->e_shstrndx,
+			&section_names_shdr)) {
 		goto error;
 	}
 
-	elf->section_names_offset = section_names_shdr->sh_offset;
-	elf->section_names_size = section_names_shdr->sh_size;
+	elf->section_names_offset = section_names_shdr.sh_offset;
+	elf->section_names_size = section_names_shdr.sh_size;
 
-	free(section_names_shdr);
 	return elf;
 
 error:
@@ -352,22 +393,14 @@ uint8_t lttng_ust_elf_is_pic(struct lttng_ust_elf *elf)
  */
 void lttng_ust_elf_destroy(struct lttng_ust_elf *elf)
 {
-	int ret;
-
 	if (!elf) {
 		return;
 	}
 
-	if (elf->fd >= 0) {
-		lttng_ust_lock_fd_tracker();
-		ret = close(elf->fd);
-		if (!ret) {
-			lttng_ust_delete_fd_from_tracker(elf->fd);
-		} else {
-			PERROR("close");
-			abort();
+	if (elf->map) {
+		if (munmap((void *) elf->map, elf->map_len)) {
+			PERROR("munmap");
 		}
-		lttng_ust_unlock_fd_tracker();
 	}
 
 	free(elf->ehdr);
@@ -391,10 +424,9 @@ int lttng_ust_elf_get_memsz(struct lttng_ust_elf *elf, uint64_t *memsz)
 	}
 
 	for (i = 0; i < elf->ehdr->e_phnum; ++i) {
-		struct lttng_ust_elf_phdr *phdr;
+		struct lttng_ust_elf_phdr phdr;
 
-		phdr = lttng_ust_elf_get_phdr(elf, i);
-		if (!phdr) {
+		if (lttng_ust_elf_get_phdr(elf, i, &phdr)) {
 			goto error;
 		}
 
@@ -402,15 +434,13 @@ int lttng_ust_elf_get_memsz(struct lttng_ust_elf *elf, uint64_t *memsz)
 		 * Only PT_LOAD segments contribute to memsz. Skip
 		 * other segments.
 		 */
-		if (phdr->p_type != PT_LOAD) {
-			goto next_loop;
+		if (phdr.p_type != PT_LOAD) {
+			continue;
 		}
 
-		low_addr = min_t(uint64_t, low_addr, phdr->p_vaddr);
+		low_addr = min_t(uint64_t, low_addr, phdr.p_vaddr);
 		high_addr = max_t(uint64_t, high_addr,
-				phdr->p_vaddr + phdr->p_memsz);
-	next_loop:
-		free(phdr);
+				phdr.p_vaddr + phdr.p_memsz);
 	}
 
 	if (high_addr < low_addr) {
@@ -439,32 +469,25 @@ error:
 static
 int lttng_ust_elf_get_build_id_from_segment(
 	struct lttng_ust_elf *elf, uint8_t **build_id, size_t *length,
-	off_t offset, off_t segment_end)
+	uint64_t offset, uint64_t segment_end)
 {
 	uint8_t *_build_id = NULL;	/* Silence old gcc warning. */
 	size_t _length = 0;		/* Silence old gcc warning. */
 
 	while (offset < segment_end) {
 		struct lttng_ust_elf_nhdr nhdr;
-		size_t read_len;
+		const void *src;
 
 		/* Align start of note entry */
 		offset += lttng_ust_offset_align(offset, ELF_NOTE_ENTRY_ALIGN);
 		if (offset >= segment_end) {
 			break;
 		}
-		/*
-		 * We seek manually because if the note isn't the
-		 * build id the data following the header will not
-		 * have been read.
-		 */
-		if (lseek(elf->fd, offset, SEEK_SET) < 0) {
-			goto error;
-		}
-		if (lttng_ust_read(elf->fd, &nhdr, sizeof(nhdr))
-				< sizeof(nhdr)) {
+		src = lttng_ust_elf_get_range(elf, offset, sizeof(nhdr));
+		if (!src) {
 			goto error;
 		}
+		memcpy(&nhdr, src, sizeof(nhdr));
 
 		if (!is_elf_native_endian(elf)) {
 			nhdr.n_namesz = bswap_32(nhdr.n_namesz);
@@ -486,18 +509,16 @@ int lttng_ust_elf_get_build_id_from_segment(
 		}
 
 		_length = nhdr.n_descsz;
-		_build_id = zmalloc(sizeof(uint8_t) * _length);
-		if (!_build_id) {
+		src = lttng_ust_elf_get_range(elf, offset,
+				sizeof(*_build_id) * _length);
+		if (!src) {
 			goto error;
 		}
-
-		if (lseek(elf->fd, offset, SEEK_SET) < 0) {
-			goto error;
-		}
-		read_len = sizeof(*_build_id) * _length;
-		if (lttng_ust_read(elf->fd, _build_id, read_len) < read_len) {
+		_build_id = zmalloc(sizeof(uint8_t) * _length);
+		if (!_build_id) {
 			goto error;
 		}
+		memcpy(_build_id, src, sizeof(*_build_id) * _length);
 
 		break;
 	}
@@ -538,27 +559,23 @@ int lttng_ust_elf_get_build_id(struct lttng_ust_elf *elf, uint8_t **build_id,
 	}
 
 	for (i = 0; i < elf->ehdr->e_phnum; ++i) {
-		off_t offset, segment_end;
-		struct lttng_ust_elf_phdr *phdr;
-		int ret = 0;
+		uint64_t offset, segment_end;
+		struct lttng_ust_elf_phdr phdr;
 
-		phdr = lttng_ust_elf_get_phdr(elf, i);
-		if (!phdr) {
+		if (lttng_ust_elf_get_phdr(elf, i, &phdr)) {
 			goto error;
 		}
 
 		/* Build ID will be contained in a PT_NOTE segment. */
-		if (phdr->p_type != PT_NOTE) {
-			goto next_loop;
+		if (phdr.p_type != PT_NOTE) {
+			continue;
 		}
 
-		offset = phdr->p_offset;
-		segment_end = offset + phdr->p_filesz;
-		ret = lttng_ust_elf_get_build_id_from_segment(
-			elf, &_build_id, &_length, offset, segment_end);
-	next_loop:
-		free(phdr);
-		if (ret) {
+		offset = phdr.p_offset;
+		segment_end = offset + phdr.p_filesz;
+		if (lttng_ust_elf_get_build_id_from_segment(
+				elf, &_build_id, &_length, offset,
+				segment_end)) {
 			goto error;
 		}
 		if (_build_id) {
@@ -596,7 +613,8 @@ int lttng_ust_elf_get_debug_link_from_section(struct lttng_ust_elf *elf,
 {
 	char *_filename = NULL;		/* Silence old gcc warning. */
 	size_t filename_len;
-	char *section_name = NULL;
+	const char *section_name;
+	const uint8_t *section;
 	uint32_t _crc = 0;		/* Silence old gcc warning. */
 
 	if (!elf || !filename || !crc || !shdr) {
@@ -624,26 +642,30 @@ int lttng_ust_elf_get_debug_link_from_section(struct lttng_ust_elf *elf,
 	 * The length of the filename is the sh_size excluding the CRC
 	 * which comes after it in the section.
 	 */
-	_filename = zmalloc(sizeof(char) * (shdr->sh_size - ELF_CRC_SIZE));
-	if (!_filename) {
+	if (shdr->sh_size <= ELF_CRC_SIZE) {
 		goto error;
 	}
-	if (lseek(elf->fd, shdr->sh_offset, SEEK_SET) < 0) {
+	section = lttng_ust_elf_get_range(elf, shdr->sh_offset,
+			shdr->sh_size);
+	if (!section) {
 		goto error;
 	}
 	filename_len = sizeof(*_filename) * (shdr->sh_size - ELF_CRC_SIZE);
-	if (lttng_ust_read(elf->fd, _filename, filename_len) < filename_len) {
-		goto error;
+	/* The filename must be terminated within the section. */
+	if (!memchr(section, '\0', filename_len)) {
+		goto end;
 	}
-	if (lttng_ust_read(elf->fd, &_crc, sizeof(_crc)) < sizeof(_crc)) {
+	_filename = zmalloc(filename_len);
+	if (!_filename) {
 		goto error;
 	}
+	memcpy(_filename, section, filename_len);
+	memcpy(&_crc, section + filename_len, sizeof(_crc));
 	if (!is_elf_native_endian(elf)) {
 		_crc = bswap_32(_crc);
 	}
 
 end:
-	free(section_name);
 	if (_filename) {
 		*filename = _filename;
 		*crc = _crc;
@@ -653,7 +675,6 @@ end:
 
 error:
 	free(_filename);
-	free(section_name);
 	return -1;
 }
 
@@ -680,17 +701,14 @@ int lttng_ust_elf_get_debug_link(struct lttng_ust_elf *elf, char **filename,
 	}
 
 	for (i = 0; i < elf->ehdr->e_shnum; ++i) {
-		struct lttng_ust_elf_shdr *shdr = NULL;
+		struct lttng_ust_elf_shdr shdr;
 
-		shdr = lttng_ust_elf_get_shdr(elf, i);
-		if (!shdr) {
+		if (lttng_ust_elf_get_shdr(elf, i, &shdr)) {
 			goto error;
 		}
 
 		ret = lttng_ust_elf_get_debug_link_from_section(
-			elf, &_filename, &_crc, shdr);
-		free(shdr);
-
+			elf, &_filename, &_crc, &shdr);
 		if (ret) {
 			goto error;
 		}
@@ -713,3 +731,147 @@ error:
 	free(_filename);
 	return -1;
 }
+
+/*
+ * Read the nth (where n is the `index` argument) symbol of the symbol
+ * table described by `shdr` into the out parameters.
+ *
+ * Returns 0 on success, -1 on failure.
+ */
+static
+int lttng_ust_elf_get_sym(struct lttng_ust_elf *elf,
+		struct lttng_ust_elf_shdr *shdr, uint64_t index,
+		uint32_t *name, uint64_t *value, uint64_t *size,
+		uint8_t *info, uint16_t *shndx)
+{
+	const void *src;
+
+	if (is_elf_32_bit(elf)) {
+		Elf32_Sym sym;
+
+		src = lttng_ust_elf_get_range(elf,
+				shdr->sh_offset + index * sizeof(sym),
+				sizeof(sym));
+		if (!src) {
+			return -1;
+		}
+		memcpy(&sym, src, sizeof(sym));
+		if (!is_elf_native_endian(elf)) {
+			bswap(sym.st_name);
+			bswap(sym.st_value);
+			bswap(sym.st_size);
+			bswap(sym.st_shndx);
+		}
+		*name = sym.st_name;
+		*value = sym.st_value;
+		*size = sym.st_size;
+		*info = sym.st_info;
+		*shndx = sym.st_shndx;
+	} else {
+		Elf64_Sym sym;
+
+		src = lttng_ust_elf_get_range(elf,
+				shdr->sh_offset + index * sizeof(sym),
+				sizeof(sym));
+		if (!src) {
+			return -1;
+		}
+		memcpy(&sym, src, sizeof(sym));
+		if (!is_elf_native_endian(elf)) {
+			bswap(sym.st_name);
+			bswap(sym.st_value);
+			bswap(sym.st_size);
+			bswap(sym.st_shndx);
+		}
+		*name = sym.st_name;
+		*value = sym.st_value;
+		*size = sym.st_size;
+		*info = sym.st_info;
+		*shndx = sym.st_shndx;
+	}
+	return 0;
+}
+
+/*
+ * Call `cb` for each function symbol defined in the ELF file, with its
+ * name, link-time address and size. The symbols are read from the
+ * .symtab section if present, from .dynsym otherwise. The name passed
+ * to `cb` points within the mapped file, and is only valid for the
+ * duration of the call. Iteration stops early if `cb` returns a
+ * non-zero value.
+ *
+ * Returns 0 on success, -1 if an error occurred.
+ */
+int lttng_ust_elf_for_each_func_symbol(struct lttng_ust_elf *elf,
+		int (*cb)(const char *name, uint64_t addr, uint64_t size,
+			void *priv),
+		void *priv)
+{
+	struct lttng_ust_elf_shdr symtab, strtab;
+	const char *strings;
+	uint64_t entsize, nr_syms, i;
+	int found = 0;
+	uint16_t j;
+
+	if (!elf || !cb) {
+		return -1;
+	}
+
+	for (j = 0; j < elf->ehdr->e_shnum; ++j) {
+		struct lttng_ust_elf_shdr shdr;
+
+		if (lttng_ust_elf_get_shdr(elf, j, &shdr)) {
+			return -1;
+		}
+		if (shdr.sh_type == SHT_SYMTAB) {
+			symtab = shdr;
+			found = 1;
+			break;
+		}
+		if (shdr.sh_type == SHT_DYNSYM) {
+			symtab = shdr;
+			found = 1;
+		}
+	}
+	if (!found) {
+		return 0;
+	}
+
+	entsize = is_elf_32_bit(elf) ? sizeof(Elf32_Sym) : sizeof(Elf64_Sym);
+	if (symtab.sh_entsize && symtab.sh_entsize != entsize) {
+		return -1;
+	}
+	if (lttng_ust_elf_get_shdr(elf, symtab.sh_link, &strtab)) {
+		return -1;
+	}
+	strings = lttng_ust_elf_get_range(elf, strtab.sh_offset,
+			strtab.sh_size);
+	if (!strings) {
+		return -1;
+	}
+
+	nr_syms = symtab.sh_size / entsize;
+	for (i = 0; i < nr_syms; i++) {
+		uint32_t name;
+		uint64_t value, size;
+		uint8_t info;
+		uint16_t shndx;
+
+		if (lttng_ust_elf_get_sym(elf, &symtab, i, &name, &value,
+				&size, &info, &shndx)) {
+			return -1;
+		}
+		if (ELF64_ST_TYPE(info) != STT_FUNC || shndx == SHN_UNDEF) {
+			continue;
+		}
+		/* The name must be terminated within the string table. */
+		if (name >= strtab.sh_size || !memchr(strings + name, '\0',
+				strtab.sh_size - name)) {
+			continue;
+		}
+		if (cb(strings + name, value, size, priv)) {
+			break;
+		}
+	}
+	return 0;
+}
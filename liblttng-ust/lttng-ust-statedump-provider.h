@@ -103,6 +103,19 @@ TRACEPOINT_EVENT(lttng_ust_statedump, procname,
 	)
 )
 
+TRACEPOINT_EVENT(lttng_ust_statedump, callstack,
+	TP_ARGS(
+		struct lttng_session *, session,
+		uint32_t, id,
+		const unsigned long *, ips,
+		uint32_t, nr_ips
+	),
+	TP_FIELDS(
+		ctf_integer(uint32_t, id, id)
+		ctf_sequence_hex(unsigned long, ips, ips, uint32_t, nr_ips)
+	)
+)
+
 TRACEPOINT_EVENT(lttng_ust_statedump, end,
 	TP_ARGS(struct lttng_session *, session),
 	TP_FIELDS()
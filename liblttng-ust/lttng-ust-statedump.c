@@ -21,14 +21,18 @@
 #define _LGPL_SOURCE
 #include <link.h>
 #include <limits.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdbool.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 
 #include <lttng/ust-elf.h>
+#include <lttng/ust-compiler.h>
 #include <helper.h>
 #include "lttng-tracer-core.h"
 #include "lttng-ust-statedump.h"
@@ -66,6 +70,7 @@ struct bin_info_data {
 struct lttng_ust_dl_node {
 	struct bin_info_data bin_data;
 	struct cds_hlist_node node;
+	uint64_t generation;	/* Order of insertion in the table. */
 	bool traced;
 	bool marked;
 };
@@ -73,9 +78,141 @@ struct lttng_ust_dl_node {
 #define UST_DL_STATE_HASH_BITS	8
 #define UST_DL_STATE_TABLE_SIZE	(1 << UST_DL_STATE_HASH_BITS)
 struct cds_hlist_head dl_state_table[UST_DL_STATE_TABLE_SIZE];
+static uint64_t dl_state_generation;
+
+/*
+ * Copy of the traced dl_state_table entries, taken under the ust_lock,
+ * from which the base address statedump events are emitted in chunks.
+ */
+struct dl_state_snapshot {
+	struct lttng_ust_dl_node *entries;
+	size_t nr_entries;
+	uint64_t generation;	/* Generation of the table at snapshot time. */
+};
+
+/*
+ * Number of objects for which events are emitted at once, with the
+ * ust_lock held, by the base address statedump.
+ */
+#define UST_DL_STATEDUMP_CHUNK	32
 
 typedef void (*tracepoint_cb)(struct lttng_session *session, void *priv);
 
+/*
+ * Callbacks invoked by lttng_ust_dl_update() once the set of loaded
+ * objects may have changed, e.g. by helper libraries which need to
+ * resolve addresses within loaded objects. Protected by
+ * dl_update_cbs_mutex, which is held while invoking the callbacks.
+ */
+#define UST_DL_UPDATE_MAX_CBS	8
+
+struct dl_update_cb {
+	void (*func)(void *priv);
+	void *priv;
+};
+
+static pthread_mutex_t dl_update_cbs_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct dl_update_cb dl_update_cbs[UST_DL_UPDATE_MAX_CBS];
+
+/*
+ * Cache of the ELF metadata extracted from the executable and shared
+ * objects, keyed by file identity. It saves re-parsing every loaded
+ * object on each statedump and on each dlopen/dlclose. It can be
+ * persisted to a per-user cache file to benefit short-lived processes.
+ * Protected by the ust_lock.
+ */
+#define ELF_CACHE_HASH_BITS		8
+#define ELF_CACHE_TABLE_SIZE		(1 << ELF_CACHE_HASH_BITS)
+#define ELF_CACHE_MAX_ENTRIES		4096
+#define ELF_CACHE_MAX_BUILD_ID_LEN	256
+#define ELF_CACHE_FILE_MAGIC		0x43464c45	/* "ELFC" */
+#define ELF_CACHE_FILE_VERSION		1
+#define ELF_CACHE_FILE_NAME		".lttng/ust-elf-cache"
+
+struct elf_cache_key {
+	uint64_t dev;
+	uint64_t ino;
+	int64_t mtime_sec;
+	int64_t mtime_nsec;
+	uint64_t size;
+};
+
+struct elf_cache_entry {
+	struct elf_cache_key key;
+	uint8_t *build_id;
+	size_t build_id_len;
+	char *dbg_file;
+	uint64_t memsz;
+	uint32_t crc;
+	uint8_t is_pic;
+	uint8_t has_build_id;
+	uint8_t has_debug_link;
+	bool used;		/* Looked up by this process. */
+	struct cds_hlist_node node;
+};
+
+/* On-disk format, native endianness. */
+struct elf_cache_file_header {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t nr_entries;
+	uint32_t padding;
+} LTTNG_PACKED;
+
+struct elf_cache_file_entry {
+	struct elf_cache_key key;
+	uint64_t memsz;
+	uint32_t crc;
+	uint32_t build_id_len;
+	uint32_t dbg_file_len;	/* Without final \0. */
+	uint8_t is_pic;
+	uint8_t has_build_id;
+	uint8_t has_debug_link;
+	/* Followed by build ID bytes and debug link file name. */
+} LTTNG_PACKED;
+
+static struct cds_hlist_head elf_cache_table[ELF_CACHE_TABLE_SIZE];
+static unsigned int elf_cache_nr_entries;
+static bool elf_cache_loaded, elf_cache_dirty;
+static pthread_mutex_t elf_cache_write_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Deep copy of bin_data `src` into zero-initialized `dst`. On error,
+ * `dst` must still be released with free_bin_data().
+ */
+static
+int copy_bin_data(struct bin_info_data *dst, const struct bin_info_data *src)
+{
+	if (src->dbg_file) {
+		dst->dbg_file = strdup(src->dbg_file);
+		if (!dst->dbg_file)
+			return -1;
+	}
+	if (src->build_id) {
+		dst->build_id = zmalloc(src->build_id_len);
+		if (!dst->build_id)
+			return -1;
+		memcpy(dst->build_id, src->build_id, src->build_id_len);
+	}
+	dst->base_addr_ptr = src->base_addr_ptr;
+	memcpy(dst->resolved_path, src->resolved_path, PATH_MAX);
+	dst->memsz = src->memsz;
+	dst->build_id_len = src->build_id_len;
+	dst->vdso = src->vdso;
+	dst->crc = src->crc;
+	dst->is_pic = src->is_pic;
+	dst->has_build_id = src->has_build_id;
+	dst->has_debug_link = src->has_debug_link;
+	return 0;
+}
+
+static
+void free_bin_data(struct bin_info_data *bin_data)
+{
+	free(bin_data->build_id);
+	free(bin_data->dbg_file);
+}
+
 static
 struct lttng_ust_dl_node *alloc_dl_node(const struct bin_info_data *bin_data)
 {
@@ -84,32 +221,12 @@ struct lttng_ust_dl_node *alloc_dl_node(const struct bin_info_data *bin_data)
 	e = zmalloc(sizeof(struct lttng_ust_dl_node));
 	if (!e)
 		return NULL;
-	if (bin_data->dbg_file) {
-		e->bin_data.dbg_file = strdup(bin_data->dbg_file);
-		if (!e->bin_data.dbg_file)
-			goto error;
-	}
-	if (bin_data->build_id) {
-		e->bin_data.build_id = zmalloc(bin_data->build_id_len);
-		if (!e->bin_data.build_id)
-			goto error;
-		memcpy(e->bin_data.build_id, bin_data->build_id,
-				bin_data->build_id_len);
-	}
-	e->bin_data.base_addr_ptr = bin_data->base_addr_ptr;
-	memcpy(e->bin_data.resolved_path, bin_data->resolved_path, PATH_MAX);
-	e->bin_data.memsz = bin_data->memsz;
-	e->bin_data.build_id_len = bin_data->build_id_len;
-	e->bin_data.vdso = bin_data->vdso;
-	e->bin_data.crc = bin_data->crc;
-	e->bin_data.is_pic = bin_data->is_pic;
-	e->bin_data.has_build_id = bin_data->has_build_id;
-	e->bin_data.has_debug_link = bin_data->has_debug_link;
+	if (copy_bin_data(&e->bin_data, bin_data))
+		goto error;
 	return e;
 
 error:
-	free(e->bin_data.build_id);
-	free(e->bin_data.dbg_file);
+	free_bin_data(&e->bin_data);
 	free(e);
 	return NULL;
 }
@@ -117,8 +234,7 @@ error:
 static
 void free_dl_node(struct lttng_ust_dl_node *e)
 {
-	free(e->bin_data.build_id);
-	free(e->bin_data.dbg_file);
+	free_bin_data(&e->bin_data);
 	free(e);
 }
 
@@ -183,6 +299,7 @@ struct lttng_ust_dl_node *find_or_create_dl_node(struct bin_info_data *bin_data)
 		e = alloc_dl_node(bin_data);
 		if (!e)
 			return NULL;
+		e->generation = ++dl_state_generation;
 		cds_hlist_add_head(&e->node, head);
 	}
 	return e;
@@ -253,20 +370,457 @@ void procname_cb(struct lttng_session *session, void *priv)
 	tracepoint(lttng_ust_statedump, procname, session, procname);
 }
 
+struct callstack_data {
+	uint32_t id;
+	const unsigned long *ips;
+	uint32_t nr_ips;
+};
+
+static
+void callstack_cb(struct lttng_session *session, void *priv)
+{
+	struct callstack_data *data = priv;
+
+	tracepoint(lttng_ust_statedump, callstack, session,
+		data->id, data->ips, data->nr_ips);
+}
+
 static
 void trace_start_cb(struct lttng_session *session, void *priv)
 {
 	tracepoint(lttng_ust_statedump, start, session);
 }
 
+/*
+ * `priv` is the generation of the dl_state_table covered by the base
+ * address statedump, or NULL if it was not performed.
+ */
 static
 void trace_end_cb(struct lttng_session *session, void *priv)
 {
+	uint64_t *generation = priv;
+
 	tracepoint(lttng_ust_statedump, end, session);
+	if (generation)
+		session->statedump_generation = *generation;
+	session->statedump_incremental = 0;
 }
 
 static
-int get_elf_info(struct bin_info_data *bin_data)
+int elf_cache_make_key(const char *path, struct elf_cache_key *key)
+{
+	struct stat st;
+
+	if (stat(path, &st))
+		return -1;
+	memset(key, 0, sizeof(*key));
+	key->dev = st.st_dev;
+	key->ino = st.st_ino;
+	key->mtime_sec = st.st_mtim.tv_sec;
+	key->mtime_nsec = st.st_mtim.tv_nsec;
+	key->size = st.st_size;
+	return 0;
+}
+
+static
+struct cds_hlist_head *elf_cache_head(const struct elf_cache_key *key)
+{
+	unsigned int hash;
+
+	hash = jhash(key, sizeof(*key), 0);
+	return &elf_cache_table[hash & (ELF_CACHE_TABLE_SIZE - 1)];
+}
+
+static
+struct elf_cache_entry *elf_cache_lookup(const struct elf_cache_key *key)
+{
+	struct elf_cache_entry *e;
+
+	cds_hlist_for_each_entry_2(e, elf_cache_head(key), node) {
+		if (!memcmp(&e->key, key, sizeof(*key)))
+			return e;
+	}
+	return NULL;
+}
+
+static
+void free_elf_cache_entry(struct elf_cache_entry *e)
+{
+	free(e->build_id);
+	free(e->dbg_file);
+	free(e);
+}
+
+static
+void elf_cache_insert(struct elf_cache_entry *e)
+{
+	cds_hlist_add_head(&e->node, elf_cache_head(&e->key));
+	elf_cache_nr_entries++;
+}
+
+static
+void elf_cache_add(const struct elf_cache_key *key,
+		const struct bin_info_data *bin_data)
+{
+	struct elf_cache_entry *e;
+
+	if (elf_cache_nr_entries >= ELF_CACHE_MAX_ENTRIES)
+		return;
+	if (bin_data->build_id_len > ELF_CACHE_MAX_BUILD_ID_LEN)
+		return;
+	e = zmalloc(sizeof(*e));
+	if (!e)
+		return;
+	if (bin_data->build_id) {
+		e->build_id = zmalloc(bin_data->build_id_len);
+		if (!e->build_id)
+			goto error;
+		memcpy(e->build_id, bin_data->build_id,
+				bin_data->build_id_len);
+	}
+	if (bin_data->dbg_file) {
+		e->dbg_file = strdup(bin_data->dbg_file);
+		if (!e->dbg_file)
+			goto error;
+	}
+	e->key = *key;
+	e->build_id_len = bin_data->build_id_len;
+	e->memsz = bin_data->memsz;
+	e->crc = bin_data->crc;
+	e->is_pic = bin_data->is_pic;
+	e->has_build_id = bin_data->has_build_id;
+	e->has_debug_link = bin_data->has_debug_link;
+	e->used = true;
+	elf_cache_insert(e);
+	elf_cache_dirty = true;
+	return;
+
+error:
+	free_elf_cache_entry(e);
+}
+
+/*
+ * Copy a cache entry into bin_data. The caller owns the build ID and
+ * debug link copies.
+ */
+static
+int elf_cache_fill_bin_data(struct elf_cache_entry *e,
+		struct bin_info_data *bin_data)
+{
+	if (e->build_id) {
+		bin_data->build_id = zmalloc(e->build_id_len);
+		if (!bin_data->build_id)
+			return -1;
+		memcpy(bin_data->build_id, e->build_id, e->build_id_len);
+	}
+	if (e->dbg_file) {
+		bin_data->dbg_file = strdup(e->dbg_file);
+		if (!bin_data->dbg_file)
+			return -1;
+	}
+	bin_data->build_id_len = e->build_id_len;
+	bin_data->memsz = e->memsz;
+	bin_data->crc = e->crc;
+	bin_data->is_pic = e->is_pic;
+	bin_data->has_build_id = e->has_build_id;
+	bin_data->has_debug_link = e->has_debug_link;
+	e->used = true;
+	return 0;
+}
+
+/*
+ * Get the path of the persistent cache file. Returns -1 if persistence
+ * is disabled.
+ */
+static
+int elf_cache_get_path(char *path, size_t len)
+{
+	const char *home_dir;
+	int ret;
+
+	if (!lttng_getenv("LTTNG_UST_ELF_CACHE"))
+		return -1;
+	home_dir = lttng_getenv("LTTNG_HOME");
+	if (!home_dir)
+		home_dir = lttng_getenv("HOME");
+	if (!home_dir)
+		return -1;
+	ret = snprintf(path, len, "%s/" ELF_CACHE_FILE_NAME, home_dir);
+	if (ret < 0 || ret >= len)
+		return -1;
+	return 0;
+}
+
+static
+struct elf_cache_entry *elf_cache_read_entry(FILE *fp)
+{
+	struct elf_cache_file_entry fe;
+	struct elf_cache_entry *e;
+
+	if (fread(&fe, sizeof(fe), 1, fp) != 1)
+		return NULL;
+	if (fe.build_id_len > ELF_CACHE_MAX_BUILD_ID_LEN
+			|| fe.dbg_file_len >= PATH_MAX)
+		return NULL;
+	if (!!fe.build_id_len != !!fe.has_build_id)
+		return NULL;
+	e = zmalloc(sizeof(*e));
+	if (!e)
+		return NULL;
+	if (fe.build_id_len) {
+		e->build_id = zmalloc(fe.build_id_len);
+		if (!e->build_id)
+			goto error;
+		if (fread(e->build_id, fe.build_id_len, 1, fp) != 1)
+			goto error;
+	}
+	if (fe.has_debug_link) {
+		e->dbg_file = zmalloc(fe.dbg_file_len + 1);
+		if (!e->dbg_file)
+			goto error;
+		if (fe.dbg_file_len
+				&& fread(e->dbg_file, fe.dbg_file_len, 1, fp) != 1)
+			goto error;
+	} else if (fe.dbg_file_len) {
+		goto error;
+	}
+	e->key = fe.key;
+	e->build_id_len = fe.build_id_len;
+	e->memsz = fe.memsz;
+	e->crc = fe.crc;
+	e->is_pic = fe.is_pic;
+	e->has_build_id = fe.has_build_id;
+	e->has_debug_link = fe.has_debug_link;
+	return e;
+
+error:
+	free_elf_cache_entry(e);
+	return NULL;
+}
+
+/*
+ * Load the persistent cache file, once. A missing, truncated or corrupted
+ * file only results in fewer cache entries.
+ */
+static
+void elf_cache_load(void)
+{
+	struct elf_cache_file_header hdr;
+	char path[PATH_MAX];
+	uint32_t i;
+	FILE *fp;
+
+	if (elf_cache_loaded)
+		return;
+	elf_cache_loaded = true;
+	if (elf_cache_get_path(path, sizeof(path)))
+		return;
+	fp = fopen(path, "r");
+	if (!fp)
+		return;
+	if (fread(&hdr, sizeof(hdr), 1, fp) != 1)
+		goto end;
+	if (hdr.magic != ELF_CACHE_FILE_MAGIC
+			|| hdr.version != ELF_CACHE_FILE_VERSION) {
+		DBG("Ignoring ELF cache file %s with unknown format", path);
+		goto end;
+	}
+	for (i = 0; i < hdr.nr_entries; i++) {
+		struct elf_cache_entry *e;
+
+		if (elf_cache_nr_entries >= ELF_CACHE_MAX_ENTRIES)
+			break;
+		e = elf_cache_read_entry(fp);
+		if (!e) {
+			DBG("Truncated or corrupted ELF cache file %s", path);
+			break;
+		}
+		if (elf_cache_lookup(&e->key)) {
+			free_elf_cache_entry(e);
+			continue;
+		}
+		elf_cache_insert(e);
+	}
+end:
+	fclose(fp);
+}
+
+static
+int elf_cache_write_entry(FILE *fp, const struct elf_cache_entry *e)
+{
+	struct elf_cache_file_entry fe;
+
+	memset(&fe, 0, sizeof(fe));
+	fe.key = e->key;
+	fe.memsz = e->memsz;
+	fe.crc = e->crc;
+	fe.build_id_len = e->build_id ? e->build_id_len : 0;
+	fe.dbg_file_len = e->dbg_file ? strlen(e->dbg_file) : 0;
+	fe.is_pic = e->is_pic;
+	fe.has_build_id = e->has_build_id && e->build_id;
+	fe.has_debug_link = e->has_debug_link && e->dbg_file;
+	if (fwrite(&fe, sizeof(fe), 1, fp) != 1)
+		return -1;
+	if (fe.build_id_len
+			&& fwrite(e->build_id, fe.build_id_len, 1, fp) != 1)
+		return -1;
+	if (fe.dbg_file_len
+			&& fwrite(e->dbg_file, fe.dbg_file_len, 1, fp) != 1)
+		return -1;
+	return 0;
+}
+
+/*
+ * Write entries used by this process first, so stale entries inherited
+ * from the file are the ones dropped when it is full.
+ */
+static
+int elf_cache_write_entries(FILE *fp, bool used, uint32_t *nr_entries)
+{
+	unsigned int i;
+
+	for (i = 0; i < ELF_CACHE_TABLE_SIZE; i++) {
+		struct elf_cache_entry *e;
+
+		cds_hlist_for_each_entry_2(e, &elf_cache_table[i], node) {
+			if (e->used != used)
+				continue;
+			if (*nr_entries >= ELF_CACHE_MAX_ENTRIES)
+				return 0;
+			if (elf_cache_write_entry(fp, e))
+				return -1;
+			(*nr_entries)++;
+		}
+	}
+	return 0;
+}
+
+/*
+ * Serialize the cache into a buffer allocated in `buf` if this process
+ * added entries to it, or set `buf` to NULL. Called with the ust_lock
+ * held, so the file is written by elf_cache_write() without it.
+ */
+static
+int elf_cache_serialize(char **buf, size_t *len)
+{
+	struct elf_cache_file_header hdr;
+	uint32_t nr_entries = 0;
+	FILE *fp;
+
+	*buf = NULL;
+	*len = 0;
+	if (!elf_cache_dirty)
+		return 0;
+	fp = open_memstream(buf, len);
+	if (!fp)
+		return -1;
+	memset(&hdr, 0, sizeof(hdr));
+	hdr.magic = ELF_CACHE_FILE_MAGIC;
+	hdr.version = ELF_CACHE_FILE_VERSION;
+	/* Number of entries is updated once they are written. */
+	if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1)
+		goto error_close;
+	if (elf_cache_write_entries(fp, true, &nr_entries))
+		goto error_close;
+	if (elf_cache_write_entries(fp, false, &nr_entries))
+		goto error_close;
+	if (fclose(fp))
+		goto error_free;
+	hdr.nr_entries = nr_entries;
+	memcpy(*buf, &hdr, sizeof(hdr));
+	elf_cache_dirty = false;
+	return 0;
+
+error_close:
+	fclose(fp);
+error_free:
+	free(*buf);
+	*buf = NULL;
+	*len = 0;
+	return -1;
+}
+
+/*
+ * Save a serialized cache to the cache file. The file is written aside
+ * and renamed so concurrent processes never read a partial file; the
+ * last writer wins.
+ */
+static
+void elf_cache_write(const char *buf, size_t len)
+{
+	char path[PATH_MAX], tmp_path[PATH_MAX];
+	FILE *fp;
+	int fd, ret;
+
+	if (elf_cache_get_path(path, sizeof(path)))
+		return;
+	ret = snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path,
+			(int) getpid());
+	if (ret < 0 || ret >= sizeof(tmp_path))
+		return;
+	/* The statedumps of both session daemons may save the cache. */
+	pthread_mutex_lock(&elf_cache_write_mutex);
+	fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_NOFOLLOW,
+			S_IRUSR | S_IWUSR);
+	if (fd < 0) {
+		DBG("Unable to create ELF cache file %s", tmp_path);
+		goto end;
+	}
+	fp = fdopen(fd, "w");
+	if (!fp) {
+		close(fd);
+		goto error_unlink;
+	}
+	if (fwrite(buf, len, 1, fp) != 1)
+		goto error_close;
+	if (fclose(fp))
+		goto error_unlink;
+	if (rename(tmp_path, path))
+		goto error_unlink;
+	goto end;
+
+error_close:
+	fclose(fp);
+error_unlink:
+	DBG("Unable to write ELF cache file %s", path);
+	(void) unlink(tmp_path);
+end:
+	pthread_mutex_unlock(&elf_cache_write_mutex);
+}
+
+static
+void elf_cache_save(void)
+{
+	size_t len;
+	char *buf;
+
+	if (elf_cache_serialize(&buf, &len) || !buf)
+		return;
+	elf_cache_write(buf, len);
+	free(buf);
+}
+
+static
+void elf_cache_destroy(void)
+{
+	unsigned int i;
+
+	for (i = 0; i < ELF_CACHE_TABLE_SIZE; i++) {
+		struct cds_hlist_head *head;
+		struct elf_cache_entry *e, *tmp;
+
+		head = &elf_cache_table[i];
+		cds_hlist_for_each_entry_safe_2(e, tmp, head, node)
+			free_elf_cache_entry(e);
+		CDS_INIT_HLIST_HEAD(head);
+	}
+	elf_cache_nr_entries = 0;
+	elf_cache_loaded = false;
+	elf_cache_dirty = false;
+}
+
+static
+int parse_elf_info(struct bin_info_data *bin_data)
 {
 	struct lttng_ust_elf *elf;
 	int ret = 0, found;
@@ -307,15 +861,51 @@ end:
 }
 
 static
-void trace_baddr(struct bin_info_data *bin_data, void *owner)
+int get_elf_info(struct bin_info_data *bin_data)
 {
-	trace_statedump_event(trace_bin_info_cb, owner, bin_data);
+	struct elf_cache_key key;
+	struct elf_cache_entry *e;
+	int ret;
+
+	if (elf_cache_make_key(bin_data->resolved_path, &key))
+		return parse_elf_info(bin_data);
+	elf_cache_load();
+	e = elf_cache_lookup(&key);
+	if (e)
+		return elf_cache_fill_bin_data(e, bin_data);
+	ret = parse_elf_info(bin_data);
+	if (!ret)
+		elf_cache_add(&key, bin_data);
+	return ret;
+}
 
-	if (bin_data->has_build_id)
-		trace_statedump_event(trace_build_id_cb, owner, bin_data);
+/*
+ * Trace the base address statedump events of an object into all
+ * sessions owned by the caller thread for which statedump is pending,
+ * skipping sessions which only requested objects loaded since their
+ * previous statedump.
+ */
+static
+void trace_baddr(struct lttng_ust_dl_node *e, void *owner)
+{
+	struct cds_list_head *sessionsp;
+	struct lttng_session *session;
 
-	if (bin_data->has_debug_link)
-		trace_statedump_event(trace_debug_link_cb, owner, bin_data);
+	sessionsp = _lttng_get_sessions();
+	cds_list_for_each_entry(session, sessionsp, node) {
+		if (session->owner != owner)
+			continue;
+		if (!session->statedump_pending)
+			continue;
+		if (session->statedump_incremental
+				&& e->generation <= session->statedump_generation)
+			continue;
+		trace_bin_info_cb(session, &e->bin_data);
+		if (e->bin_data.has_build_id)
+			trace_build_id_cb(session, &e->bin_data);
+		if (e->bin_data.has_debug_link)
+			trace_debug_link_cb(session, &e->bin_data);
+	}
 }
 
 static
@@ -356,9 +946,9 @@ void trace_statedump_start(void *owner)
 }
 
 static
-void trace_statedump_end(void *owner)
+void trace_statedump_end(void *owner, uint64_t *generation)
 {
-	trace_statedump_event(trace_end_cb, owner, NULL);
+	trace_statedump_event(trace_end_cb, owner, generation);
 }
 
 static
@@ -532,27 +1122,158 @@ end:
 }
 
 static
-void ust_dl_table_statedump(void *owner)
+void dl_state_snapshot_destroy(struct dl_state_snapshot *snapshot)
 {
-	unsigned int i;
+	size_t i;
 
-	if (ust_lock())
-		goto end;
+	for (i = 0; i < snapshot->nr_entries; i++)
+		free_bin_data(&snapshot->entries[i].bin_data);
+	free(snapshot->entries);
+	snapshot->entries = NULL;
+	snapshot->nr_entries = 0;
+}
+
+/*
+ * Copy the traced entries of the dl_state_table. Called with the
+ * ust_lock held.
+ */
+static
+int dl_state_snapshot_create(struct dl_state_snapshot *snapshot)
+{
+	size_t nr_entries = 0;
+	unsigned int i;
 
-	/* Statedump each traced table entry into session for owner. */
 	for (i = 0; i < UST_DL_STATE_TABLE_SIZE; i++) {
-		struct cds_hlist_head *head;
 		struct lttng_ust_dl_node *e;
 
-		head = &dl_state_table[i];
-		cds_hlist_for_each_entry_2(e, head, node) {
+		cds_hlist_for_each_entry_2(e, &dl_state_table[i], node) {
 			if (e->traced)
-				trace_baddr(&e->bin_data, owner);
+				nr_entries++;
 		}
 	}
+	snapshot->generation = dl_state_generation;
+	snapshot->nr_entries = 0;
+	snapshot->entries = NULL;
+	if (!nr_entries)
+		return 0;
+	snapshot->entries = zmalloc(nr_entries * sizeof(*snapshot->entries));
+	if (!snapshot->entries)
+		return -1;
+	for (i = 0; i < UST_DL_STATE_TABLE_SIZE; i++) {
+		struct lttng_ust_dl_node *e;
 
-end:
+		cds_hlist_for_each_entry_2(e, &dl_state_table[i], node) {
+			struct lttng_ust_dl_node *copy;
+
+			if (!e->traced)
+				continue;
+			copy = &snapshot->entries[snapshot->nr_entries++];
+			copy->generation = e->generation;
+			if (copy_bin_data(&copy->bin_data, &e->bin_data)) {
+				dl_state_snapshot_destroy(snapshot);
+				return -1;
+			}
+		}
+	}
+	return 0;
+}
+
+/*
+ * Statedump each traced table entry into sessions of owner. The table
+ * is copied with the ust_lock held, and events are then emitted in
+ * chunks, releasing the ust_lock in between, so dlopen/dlclose and fork
+ * in the application are not blocked for the whole statedump.
+ *
+ * Returns the generation of the table covered by the statedump through
+ * `generation`.
+ */
+static
+int ust_dl_table_statedump(void *owner, uint64_t *generation)
+{
+	struct dl_state_snapshot snapshot;
+	size_t i, cache_len;
+	char *cache_buf;
+	int ret;
+
+	if (ust_lock()) {
+		ust_unlock();
+		return -1;
+	}
+	ret = dl_state_snapshot_create(&snapshot);
+	(void) elf_cache_serialize(&cache_buf, &cache_len);
 	ust_unlock();
+	if (cache_buf) {
+		elf_cache_write(cache_buf, cache_len);
+		free(cache_buf);
+	}
+	if (ret)
+		return ret;
+
+	for (i = 0; i < snapshot.nr_entries; i += UST_DL_STATEDUMP_CHUNK) {
+		size_t j, end;
+
+		if (ust_lock()) {
+			ust_unlock();
+			ret = -1;
+			goto end;
+		}
+		end = min_t(size_t, i + UST_DL_STATEDUMP_CHUNK,
+				snapshot.nr_entries);
+		for (j = i; j < end; j++)
+			trace_baddr(&snapshot.entries[j], owner);
+		ust_unlock();
+	}
+	*generation = snapshot.generation;
+end:
+	dl_state_snapshot_destroy(&snapshot);
+	return ret;
+}
+
+int lttng_ust_dl_register_update_cb(void (*func)(void *priv), void *priv)
+{
+	unsigned int i;
+	int ret = -1;
+
+	pthread_mutex_lock(&dl_update_cbs_mutex);
+	for (i = 0; i < UST_DL_UPDATE_MAX_CBS; i++) {
+		if (dl_update_cbs[i].func)
+			continue;
+		dl_update_cbs[i].func = func;
+		dl_update_cbs[i].priv = priv;
+		ret = 0;
+		break;
+	}
+	pthread_mutex_unlock(&dl_update_cbs_mutex);
+	return ret;
+}
+
+void lttng_ust_dl_unregister_update_cb(void (*func)(void *priv), void *priv)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&dl_update_cbs_mutex);
+	for (i = 0; i < UST_DL_UPDATE_MAX_CBS; i++) {
+		if (dl_update_cbs[i].func != func
+				|| dl_update_cbs[i].priv != priv)
+			continue;
+		dl_update_cbs[i].func = NULL;
+		dl_update_cbs[i].priv = NULL;
+		break;
+	}
+	pthread_mutex_unlock(&dl_update_cbs_mutex);
+}
+
+static
+void dl_update_notify(void)
+{
+	unsigned int i;
+
+	pthread_mutex_lock(&dl_update_cbs_mutex);
+	for (i = 0; i < UST_DL_UPDATE_MAX_CBS; i++) {
+		if (dl_update_cbs[i].func)
+			dl_update_cbs[i].func(dl_update_cbs[i].priv);
+	}
+	pthread_mutex_unlock(&dl_update_cbs_mutex);
 }
 
 void lttng_ust_dl_update(void *ip)
@@ -560,7 +1281,7 @@ void lttng_ust_dl_update(void *ip)
 	struct dl_iterate_data data;
 
 	if (lttng_getenv("LTTNG_UST_WITHOUT_BADDR_STATEDUMP"))
-		return;
+		goto notify;
 
 	/*
 	 * Fixup lttng-ust TLS when called from dlopen/dlclose
@@ -583,6 +1304,8 @@ void lttng_ust_dl_update(void *ip)
 	if (data.first)
 		iter_begin(&data);
 	iter_end(&data, ip);
+notify:
+	dl_update_notify();
 }
 
 /*
@@ -591,13 +1314,12 @@ void lttng_ust_dl_update(void *ip)
  * executable itself.
  */
 static
-int do_baddr_statedump(void *owner)
+int do_baddr_statedump(void *owner, uint64_t *generation)
 {
 	if (lttng_getenv("LTTNG_UST_WITHOUT_BADDR_STATEDUMP"))
-		return 0;
+		return -1;
 	lttng_ust_dl_update(LTTNG_UST_CALLER_IP());
-	ust_dl_table_statedump(owner);
-	return 0;
+	return ust_dl_table_statedump(owner, generation);
 }
 
 static
@@ -610,6 +1332,32 @@ int do_procname_statedump(void *owner)
 	return 0;
 }
 
+static
+void trace_callstack(uint32_t id, const unsigned long *ips,
+		uint32_t nr_ips, void *owner)
+{
+	struct callstack_data data = {
+		.id = id,
+		.ips = ips,
+		.nr_ips = nr_ips,
+	};
+
+	trace_statedump_event(callstack_cb, owner, &data);
+}
+
+/*
+ * Emit the definition of the stacks already known to the callstack
+ * context, which were emitted before the sessions started.
+ */
+static
+int do_callstack_statedump(void *owner)
+{
+	ust_lock_nocheck();
+	lttng_context_callstack_for_each(trace_callstack, owner);
+	ust_unlock();
+	return 0;
+}
+
 /*
  * Generate a statedump of a given traced application. A statedump is
  * delimited by start and end events. For a given (process, session)
@@ -621,18 +1369,26 @@ int do_procname_statedump(void *owner)
  * Grab the ust_lock outside of the RCU read-side lock because we
  * perform synchronize_rcu with the ust_lock held, which can trigger
  * deadlocks otherwise.
+ *
+ * Sessions which requested an incremental statedump only get the
+ * base address events of the objects loaded since their previous
+ * statedump, still delimited by start and end events.
  */
 int do_lttng_ust_statedump(void *owner)
 {
+	uint64_t generation;
+	int baddr_ret;
+
 	ust_lock_nocheck();
 	trace_statedump_start(owner);
 	ust_unlock();
 
 	do_procname_statedump(owner);
-	do_baddr_statedump(owner);
+	baddr_ret = do_baddr_statedump(owner, &generation);
+	do_callstack_statedump(owner);
 
 	ust_lock_nocheck();
-	trace_statedump_end(owner);
+	trace_statedump_end(owner, baddr_ret ? NULL : &generation);
 	ust_unlock();
 
 	return 0;
@@ -668,4 +1424,6 @@ void lttng_ust_statedump_destroy(void)
 	__tracepoints__ptrs_destroy();
 	__tracepoints__destroy();
 	ust_dl_state_destroy();
+	elf_cache_save();
+	elf_cache_destroy();
 }
@@ -26,6 +26,7 @@
  */
 
 #include <stdint.h>
+#include <sys/types.h>
 
 #include <urcu/list.h>
 #include <urcu/hlist.h>
@@ -44,6 +45,59 @@ struct lttng_event_enabler {
 	struct lttng_ctx *ctx;
 };
 
+/*
+ * Aggregation of the captures of an event notifier into a counter, see
+ * LTTNG_UST_EVENT_NOTIFIER_ACTION_MAP.
+ */
+struct lttng_event_notifier_map {
+	struct lttng_counter *counter;	/* RCU, NULL until attached. */
+	size_t nr_dimensions;
+	size_t dimension_size[LTTNG_UST_COUNTER_DIMENSION_MAX];
+	enum lttng_ust_map_op op;
+	int64_t bucket_min;
+	uint64_t bucket_width;
+};
+
+/*
+ * Rate policy of an event notifier enabler, see
+ * enum lttng_ust_event_notifier_rate_policy. The state is shared by
+ * the event notifiers of the enabler, so that the policy applies to the
+ * trigger as a whole whatever the number of tracepoints it matches. It
+ * is updated with atomic operations by the probes.
+ */
+struct lttng_event_notifier_rate {
+	enum lttng_ust_event_notifier_rate_policy policy;
+	uint32_t count;
+	uint64_t window_ns;
+
+	/* Index of the current window (high half) and its hits (low half). */
+	unsigned long window_hits;
+	unsigned long hits;		/* Every nth: hits since creation. */
+	unsigned long coalesced;	/* Coalesce: hits not notified yet. */
+};
+
+/*
+ * The rate window index and its hit count share an unsigned long, so
+ * they can be updated with a single cmpxchg. The hit count saturates at
+ * LTTNG_EVENT_NOTIFIER_RATE_HITS_MASK, which bounds the count of the
+ * rate limit policy.
+ */
+#define LTTNG_EVENT_NOTIFIER_RATE_HITS_BITS	(CAA_BITS_PER_LONG / 2)
+#define LTTNG_EVENT_NOTIFIER_RATE_HITS_MASK	\
+	((1UL << LTTNG_EVENT_NOTIFIER_RATE_HITS_BITS) - 1)
+
+/*
+ * Session actions of an event notifier, see
+ * LTTNG_UST_EVENT_NOTIFIER_ACTION_SESSION.
+ */
+struct lttng_event_notifier_session_action {
+	struct lttng_session *session;	/* RCU, NULL until attached. */
+	unsigned int ops;		/* Mask of enum lttng_ust_session_action_op */
+	unsigned int freeze_id;		/* Id of the freeze in the channels. */
+	pid_t owner_pid;		/* Process which attached the actions. */
+	int armed;			/* Cleared by the hit running the actions. */
+};
+
 struct lttng_event_notifier_enabler {
 	struct lttng_enabler base;
 	uint64_t error_counter_index;
@@ -52,6 +106,11 @@ struct lttng_event_notifier_enabler {
 	struct lttng_event_notifier_group *group; /* weak ref */
 	uint64_t user_token;		/* User-provided token */
 	uint64_t num_captures;
+	enum lttng_ust_event_notifier_action action;
+	struct lttng_event_notifier_map map;	/* Map action only. */
+	struct lttng_event_notifier_rate rate;	/* Shared by its event notifiers. */
+	/* Session action only. */
+	struct lttng_event_notifier_session_action session_action;
 };
 
 enum lttng_ust_bytecode_node_type {
@@ -235,6 +294,72 @@ int lttng_event_notifier_enabler_attach_capture_bytecode(
 		struct lttng_event_notifier_enabler *event_notifier_enabler,
 		struct lttng_ust_bytecode_node *bytecode);
 
+/*
+ * Attach the counter updated by the map action of a `struct
+ * lttng_event_notifier_enabler`. The enabler owns the counter on
+ * success.
+ */
+LTTNG_HIDDEN
+int lttng_event_notifier_enabler_attach_map_counter(
+		struct lttng_event_notifier_enabler *event_notifier_enabler,
+		struct lttng_counter *counter,
+		size_t nr_dimensions,
+		const struct lttng_counter_dimension *dimensions);
+
+/*
+ * Attach the counter of the records lost by each event of a `struct
+ * lttng_channel`. The channel owns the counter on success.
+ */
+LTTNG_HIDDEN
+int lttng_channel_attach_drop_counter(struct lttng_channel *lttng_chan,
+		struct lttng_counter *counter, size_t len);
+
+/*
+ * Set the threshold of the map counter of a `struct
+ * lttng_event_notifier_enabler`, see LTTNG_UST_MAP_THRESHOLD.
+ */
+LTTNG_HIDDEN
+int lttng_event_notifier_enabler_set_map_threshold(
+		struct lttng_event_notifier_enabler *event_notifier_enabler,
+		int64_t threshold);
+
+/*
+ * Attach the session acted upon by the session action of a `struct
+ * lttng_event_notifier_enabler`, and arm the action. The caller holds a
+ * reference on the session until it is detached.
+ */
+LTTNG_HIDDEN
+int lttng_event_notifier_enabler_attach_session_action(
+		struct lttng_event_notifier_enabler *event_notifier_enabler,
+		struct lttng_session *session, unsigned int ops,
+		unsigned int freeze_id);
+
+/*
+ * Re-arm the session action of a `struct lttng_event_notifier_enabler`
+ * after it ran, resuming recording in the channels it froze.
+ */
+LTTNG_HIDDEN
+int lttng_event_notifier_enabler_rearm_session_action(
+		struct lttng_event_notifier_enabler *event_notifier_enabler);
+
+/*
+ * Account the hits coalesced by the rate policy of a `struct
+ * lttng_event_notifier_enabler` which were not notified yet as
+ * suppressed hits, when the enabler is released or destroyed.
+ */
+LTTNG_HIDDEN
+void lttng_event_notifier_enabler_rate_flush(
+		struct lttng_event_notifier_enabler *event_notifier_enabler);
+
+/*
+ * Detach the session of the session action of a `struct
+ * lttng_event_notifier_enabler`, undoing the actions which ran. Returns
+ * the session, on which the caller can drop its reference, or NULL.
+ */
+LTTNG_HIDDEN
+struct lttng_session *lttng_event_notifier_enabler_detach_session_action(
+		struct lttng_event_notifier_enabler *event_notifier_enabler);
+
 /*
  * Attach exclusion list to `struct lttng_event_notifier_enabler` and all
  * event notifiers related to this enabler.
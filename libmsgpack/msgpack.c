@@ -51,9 +51,13 @@
 #define MSGPACK_FIXARRAY_MAX_COUNT	15
 #define MSGPACK_FIXSTR_MAX_LENGTH	31
 
+/* Largest encoding of an integer: the type byte followed by 64 bits. */
+#define MSGPACK_INTEGER_MAX_LEN		9
+
 #ifdef __KERNEL__
 #include <linux/bug.h>
 #include <linux/string.h>
+#include <linux/swab.h>
 #include <linux/types.h>
 
 #include <lttng/msgpack.h>
@@ -72,11 +76,17 @@
 #define byteswap_host_to_be32(_tmp) cpu_to_be32(_tmp)
 #define byteswap_host_to_be64(_tmp) cpu_to_be64(_tmp)
 
+#define byteswap_16(_tmp) swab16(_tmp)
+#define byteswap_32(_tmp) swab32(_tmp)
+#define byteswap_64(_tmp) swab64(_tmp)
+
 #define lttng_msgpack_assert(cond) WARN_ON(!(cond))
 
 #else /* __KERNEL__ */
 
 #include <lttng/ust-endian.h>
+#include <byteswap.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 
@@ -86,6 +96,10 @@
 #define byteswap_host_to_be32(_tmp) htobe32(_tmp)
 #define byteswap_host_to_be64(_tmp) htobe64(_tmp)
 
+#define byteswap_16(_tmp) bswap_16(_tmp)
+#define byteswap_32(_tmp) bswap_32(_tmp)
+#define byteswap_64(_tmp) bswap_64(_tmp)
+
 #define lttng_msgpack_assert(cond) ({ \
 	if (!(cond)) \
 		fprintf(stderr, "Assertion failed. %s:%d\n", __FILE__, __LINE__); \
@@ -312,6 +326,185 @@ end:
 	return ret;
 }
 
+/*
+ * Unchecked integer encoders used by the sequence fast path: the caller
+ * made sure that MSGPACK_INTEGER_MAX_LEN bytes are available at `p`.
+ * They return the position following the encoded integer and produce
+ * the same encoding as lttng_msgpack_write_{un,}signed_integer().
+ */
+static inline uint8_t *lttng_msgpack_encode_unsigned_unchecked(
+		uint8_t *p, uint64_t value)
+{
+	if (value <= MSGPACK_FIXINT_MAX) {
+		*p++ = (uint8_t) value;
+	} else if (value <= UINT8_MAX) {
+		*p++ = MSGPACK_UINT8_ID;
+		*p++ = (uint8_t) value;
+	} else if (value <= UINT16_MAX) {
+		uint16_t be = byteswap_host_to_be16((uint16_t) value);
+
+		*p++ = MSGPACK_UINT16_ID;
+		memcpy(p, &be, sizeof(be));
+		p += sizeof(be);
+	} else if (value <= UINT32_MAX) {
+		uint32_t be = byteswap_host_to_be32((uint32_t) value);
+
+		*p++ = MSGPACK_UINT32_ID;
+		memcpy(p, &be, sizeof(be));
+		p += sizeof(be);
+	} else {
+		uint64_t be = byteswap_host_to_be64(value);
+
+		*p++ = MSGPACK_UINT64_ID;
+		memcpy(p, &be, sizeof(be));
+		p += sizeof(be);
+	}
+	return p;
+}
+
+static inline uint8_t *lttng_msgpack_encode_signed_unchecked(
+		uint8_t *p, int64_t value)
+{
+	if (value >= MSGPACK_FIXINT_MIN && value <= MSGPACK_FIXINT_MAX) {
+		*p++ = (uint8_t) value;
+	} else if (value >= INT8_MIN && value <= INT8_MAX) {
+		*p++ = MSGPACK_INT8_ID;
+		*p++ = (uint8_t) value;
+	} else if (value >= INT16_MIN && value <= INT16_MAX) {
+		uint16_t be = byteswap_host_to_be16((uint16_t) value);
+
+		*p++ = MSGPACK_INT16_ID;
+		memcpy(p, &be, sizeof(be));
+		p += sizeof(be);
+	} else if (value >= INT32_MIN && value <= INT32_MAX) {
+		uint32_t be = byteswap_host_to_be32((uint32_t) value);
+
+		*p++ = MSGPACK_INT32_ID;
+		memcpy(p, &be, sizeof(be));
+		p += sizeof(be);
+	} else {
+		uint64_t be = byteswap_host_to_be64((uint64_t) value);
+
+		*p++ = MSGPACK_INT64_ID;
+		memcpy(p, &be, sizeof(be));
+		p += sizeof(be);
+	}
+	return p;
+}
+
+#define byteswap_8(_tmp) (_tmp)
+
+/*
+ * Encode `_nr_elem` elements of type `_type` read from `_src`. The
+ * element type is fixed for the whole loop, so the byte order test is
+ * hoisted out of it and the loads and byte swaps can be vectorized.
+ */
+#define lttng_msgpack_encode_sequence_loop(_p, _src, _nr_elem, _type,	\
+		_swap, _reverse, _encode)				\
+	do {								\
+		size_t _i;						\
+									\
+		for (_i = 0; _i < (_nr_elem); _i++) {			\
+			_type _v;					\
+									\
+			memcpy(&_v, (_src) + _i * sizeof(_type),	\
+				sizeof(_type));				\
+			if (_reverse)					\
+				_v = (_type) _swap(_v);			\
+			(_p) = _encode((_p), _v);			\
+		}							\
+	} while (0)
+
+static uint8_t *lttng_msgpack_encode_sequence_unchecked(uint8_t *p,
+		const struct lttng_msgpack_integer_layout *layout,
+		const uint8_t *src, size_t nr_elem)
+{
+	bool reverse = layout->reverse_byte_order;
+
+	switch (layout->size) {
+	case 1:
+		if (layout->is_signed)
+			lttng_msgpack_encode_sequence_loop(p, src, nr_elem,
+				int8_t, byteswap_8, false,
+				lttng_msgpack_encode_signed_unchecked);
+		else
+			lttng_msgpack_encode_sequence_loop(p, src, nr_elem,
+				uint8_t, byteswap_8, false,
+				lttng_msgpack_encode_unsigned_unchecked);
+		break;
+	case 2:
+		if (layout->is_signed)
+			lttng_msgpack_encode_sequence_loop(p, src, nr_elem,
+				int16_t, byteswap_16, reverse,
+				lttng_msgpack_encode_signed_unchecked);
+		else
+			lttng_msgpack_encode_sequence_loop(p, src, nr_elem,
+				uint16_t, byteswap_16, reverse,
+				lttng_msgpack_encode_unsigned_unchecked);
+		break;
+	case 4:
+		if (layout->is_signed)
+			lttng_msgpack_encode_sequence_loop(p, src, nr_elem,
+				int32_t, byteswap_32, reverse,
+				lttng_msgpack_encode_signed_unchecked);
+		else
+			lttng_msgpack_encode_sequence_loop(p, src, nr_elem,
+				uint32_t, byteswap_32, reverse,
+				lttng_msgpack_encode_unsigned_unchecked);
+		break;
+	case 8:
+		if (layout->is_signed)
+			lttng_msgpack_encode_sequence_loop(p, src, nr_elem,
+				int64_t, byteswap_64, reverse,
+				lttng_msgpack_encode_signed_unchecked);
+		else
+			lttng_msgpack_encode_sequence_loop(p, src, nr_elem,
+				uint64_t, byteswap_64, reverse,
+				lttng_msgpack_encode_unsigned_unchecked);
+		break;
+	}
+	return p;
+}
+
+/* Element read of the bounds-checked path, taken near the buffer end. */
+static int64_t lttng_msgpack_load_element(const uint8_t *src,
+		const struct lttng_msgpack_integer_layout *layout)
+{
+	bool reverse = layout->reverse_byte_order;
+
+	switch (layout->size) {
+	case 1:
+		return layout->is_signed ? (int64_t) (int8_t) *src : *src;
+	case 2:
+	{
+		uint16_t tmp;
+
+		memcpy(&tmp, src, sizeof(tmp));
+		if (reverse)
+			tmp = byteswap_16(tmp);
+		return layout->is_signed ? (int64_t) (int16_t) tmp : tmp;
+	}
+	case 4:
+	{
+		uint32_t tmp;
+
+		memcpy(&tmp, src, sizeof(tmp));
+		if (reverse)
+			tmp = byteswap_32(tmp);
+		return layout->is_signed ? (int64_t) (int32_t) tmp : tmp;
+	}
+	default:
+	{
+		uint64_t tmp;
+
+		memcpy(&tmp, src, sizeof(tmp));
+		if (reverse)
+			tmp = byteswap_64(tmp);
+		return (int64_t) tmp;
+	}
+	}
+}
+
 int lttng_msgpack_begin_map(struct lttng_msgpack_writer *writer, size_t count)
 {
 	int ret;
@@ -367,9 +560,18 @@ int lttng_msgpack_end_array(struct lttng_msgpack_writer *writer)
 
 int lttng_msgpack_write_str(struct lttng_msgpack_writer *writer,
 		const char *str)
+{
+	return lttng_msgpack_write_str_len(writer, str, strlen(str));
+}
+
+/*
+ * Write the `length` first bytes of `str`, for callers which already
+ * know the string length. `str` must not hold a null byte in that range.
+ */
+int lttng_msgpack_write_str_len(struct lttng_msgpack_writer *writer,
+		const char *str, size_t length)
 {
 	int ret;
-	size_t length = strlen(str);
 
 	if (length >= (1 << 16)) {
 		ret = -1;
@@ -498,6 +700,59 @@ int lttng_msgpack_write_double(struct lttng_msgpack_writer *writer, double value
 	return lttng_msgpack_encode_f64(writer, value);
 }
 
+/*
+ * Write an array holding the `nr_elem` integers described by `layout`
+ * starting at `ptr`. When the worst-case encoding of the whole sequence
+ * fits in the buffer, the elements are encoded without bounds checks.
+ */
+int lttng_msgpack_write_integer_sequence(struct lttng_msgpack_writer *writer,
+		const struct lttng_msgpack_integer_layout *layout,
+		const void *ptr, size_t nr_elem)
+{
+	const uint8_t *src = ptr;
+	size_t i;
+	int ret;
+
+	switch (layout->size) {
+	case 1:
+	case 2:
+	case 4:
+	case 8:
+		break;
+	default:
+		ret = -1;
+		goto end;
+	}
+
+	ret = lttng_msgpack_begin_array(writer, nr_elem);
+	if (ret)
+		goto end;
+
+	if (nr_elem <= (writer->end_write_pos - writer->write_pos) /
+			MSGPACK_INTEGER_MAX_LEN) {
+		writer->write_pos = lttng_msgpack_encode_sequence_unchecked(
+				writer->write_pos, layout, src, nr_elem);
+	} else {
+		for (i = 0; i < nr_elem; i++) {
+			int64_t value = lttng_msgpack_load_element(src, layout);
+
+			if (layout->is_signed)
+				ret = lttng_msgpack_write_signed_integer(writer,
+						value);
+			else
+				ret = lttng_msgpack_write_unsigned_integer(writer,
+						(uint64_t) value);
+			if (ret)
+				goto end;
+			src += layout->size;
+		}
+	}
+
+	ret = lttng_msgpack_end_array(writer);
+end:
+	return ret;
+}
+
 void lttng_msgpack_writer_init(struct lttng_msgpack_writer *writer,
 		uint8_t *buffer, size_t size)
 {
@@ -36,6 +36,17 @@ struct lttng_msgpack_writer {
 	uint8_t map_nesting;
 };
 
+/*
+ * Layout of the elements of an integer sequence. Computed once per
+ * sequence by the caller so that the encoder does not look at the
+ * element type for every element.
+ */
+struct lttng_msgpack_integer_layout {
+	uint8_t size;			/* Element size, in bytes: 1, 2, 4 or 8. */
+	uint8_t is_signed;
+	uint8_t reverse_byte_order;	/* Elements are not in host byte order. */
+};
+
 void lttng_msgpack_writer_init(
 		struct lttng_msgpack_writer *writer,
 		uint8_t *buffer, size_t size);
@@ -52,6 +63,11 @@ int lttng_msgpack_write_signed_integer(
 int lttng_msgpack_write_double(struct lttng_msgpack_writer *writer, double value);
 int lttng_msgpack_write_str(struct lttng_msgpack_writer *writer,
 		const char *value);
+int lttng_msgpack_write_str_len(struct lttng_msgpack_writer *writer,
+		const char *value, size_t len);
+int lttng_msgpack_write_integer_sequence(struct lttng_msgpack_writer *writer,
+		const struct lttng_msgpack_integer_layout *layout,
+		const void *ptr, size_t nr_elem);
 int lttng_msgpack_begin_map(struct lttng_msgpack_writer *writer, size_t count);
 int lttng_msgpack_end_map(struct lttng_msgpack_writer *writer);
 int lttng_msgpack_begin_array(
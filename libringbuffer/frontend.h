@@ -139,6 +139,11 @@ extern int lib_ring_buffer_snapshot_sample_positions(
 				    unsigned long *consumed,
 				    unsigned long *produced,
 				    struct lttng_ust_shm_handle *handle);
+extern int lib_ring_buffer_snapshot_trigger_positions(
+				    struct lttng_ust_lib_ring_buffer *buf,
+				    unsigned long *consumed,
+				    unsigned long *produced,
+				    struct lttng_ust_shm_handle *handle);
 extern void lib_ring_buffer_move_consumer(struct lttng_ust_lib_ring_buffer *buf,
 					  unsigned long consumed_new,
 					  struct lttng_ust_shm_handle *handle);
@@ -180,6 +185,35 @@ void lib_ring_buffer_put_next_subbuf(struct lttng_ust_lib_ring_buffer *buf,
 			handle);
 }
 
+/*
+ * Actions run on the buffers of a channel when a trigger fires in the
+ * traced process, and undone when the trigger is re-armed.
+ */
+enum lib_ring_buffer_trigger_action {
+	/* Stop recording in the channel. */
+	RING_BUFFER_TRIGGER_FREEZE = (1U << 0),
+	/* Switch the current sub-buffer of each buffer. */
+	RING_BUFFER_TRIGGER_SWITCH = (1U << 1),
+	/* Sample the consumed and produced positions of each buffer. */
+	RING_BUFFER_TRIGGER_SAMPLE = (1U << 2),
+};
+
+/*
+ * Each trigger freezing a channel is identified by a freeze id, so
+ * that a channel shared by several triggers, possibly of several
+ * processes, is recording only once all of them are reset.
+ */
+#define RING_BUFFER_TRIGGER_FREEZE_ID_MAX	32
+
+extern void lib_ring_buffer_channel_trigger(struct channel *chan,
+		struct lttng_ust_shm_handle *handle, unsigned int actions,
+		unsigned int freeze_id);
+extern void lib_ring_buffer_channel_trigger_reset(struct channel *chan,
+		struct lttng_ust_shm_handle *handle, unsigned int actions,
+		unsigned int freeze_id);
+extern void lib_ring_buffer_channel_thaw(struct channel *chan,
+		uint32_t freeze_mask);
+
 extern void channel_reset(struct channel *chan);
 extern void lib_ring_buffer_reset(struct lttng_ust_lib_ring_buffer *buf,
 				  struct lttng_ust_shm_handle *handle);
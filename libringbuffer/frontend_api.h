@@ -164,7 +164,8 @@ int lib_ring_buffer_reserve(const struct lttng_ust_lib_ring_buffer_config *confi
 	unsigned long o_begin, o_end, o_old;
 	size_t before_hdr_pad = 0;
 
-	if (caa_unlikely(uatomic_read(&chan->record_disabled)))
+	if (caa_unlikely(uatomic_read(&chan->record_disabled)
+			|| CMM_LOAD_SHARED(chan->u.s.trigger_frozen)))
 		return -EAGAIN;
 
 	if (config->alloc == RING_BUFFER_ALLOC_PER_CPU)
@@ -75,6 +75,7 @@ struct channel {
 	union {
 		struct {
 			int32_t blocking_timeout_ms;
+			uint32_t trigger_frozen; /* Freeze ids of the triggers */
 		} s;
 		char padding[RB_CHANNEL_PADDING];
 	} u;
@@ -102,7 +103,7 @@ struct commit_counters_cold {
 
 /* ring buffer state */
 #define RB_CRASH_DUMP_ABI_LEN		256
-#define RB_RING_BUFFER_PADDING		60
+#define RB_RING_BUFFER_PADDING		40
 
 #define RB_CRASH_DUMP_ABI_MAGIC_LEN	16
 
@@ -235,6 +236,9 @@ struct lttng_ust_lib_ring_buffer {
 	unsigned int get_subbuf:1;	/* Sub-buffer being held by reader */
 	/* shmp pointer to self */
 	DECLARE_SHMP(struct lttng_ust_lib_ring_buffer, self);
+	unsigned long trigger_consumed;	/* Consumer count sampled by trigger */
+	unsigned long trigger_produced;	/* Producer count sampled by trigger */
+	int trigger_sampled;		/* Trigger positions are valid */
 	char padding[RB_RING_BUFFER_PADDING];
 } __attribute__((aligned(CAA_CACHE_LINE_SIZE)));
 
@@ -1383,6 +1383,147 @@ int lib_ring_buffer_snapshot_sample_positions(
 	return 0;
 }
 
+/**
+ * lib_ring_buffer_snapshot_trigger_positions - get the trigger sample
+ * @buf: ring buffer
+ * @consumed: consumed byte count sampled by the trigger
+ * @produced: produced byte count sampled by the trigger
+ *
+ * Returns the positions sampled by the last RING_BUFFER_TRIGGER_SAMPLE
+ * action on the buffer, or -ENODATA if it has not been sampled since
+ * the trigger was last reset.
+ */
+int lib_ring_buffer_snapshot_trigger_positions(
+			     struct lttng_ust_lib_ring_buffer *buf,
+			     unsigned long *consumed, unsigned long *produced,
+			     struct lttng_ust_shm_handle *handle)
+{
+	if (!CMM_LOAD_SHARED(buf->trigger_sampled))
+		return -ENODATA;
+	/* Read trigger_sampled before the positions. */
+	cmm_smp_rmb();
+	*consumed = CMM_LOAD_SHARED(buf->trigger_consumed);
+	*produced = CMM_LOAD_SHARED(buf->trigger_produced);
+	return 0;
+}
+
+static
+void lib_ring_buffer_trigger(struct lttng_ust_lib_ring_buffer *buf,
+		unsigned int actions, struct lttng_ust_shm_handle *handle)
+{
+	unsigned long consumed, produced;
+
+	if (actions & RING_BUFFER_TRIGGER_SWITCH)
+		lib_ring_buffer_switch_slow(buf, SWITCH_ACTIVE, handle);
+	if ((actions & RING_BUFFER_TRIGGER_SAMPLE) &&
+			!lib_ring_buffer_snapshot_sample_positions(buf,
+				&consumed, &produced, handle)) {
+		CMM_STORE_SHARED(buf->trigger_consumed, consumed);
+		CMM_STORE_SHARED(buf->trigger_produced, produced);
+		/* Write the positions before trigger_sampled. */
+		cmm_smp_wmb();
+		CMM_STORE_SHARED(buf->trigger_sampled, 1);
+	}
+}
+
+/**
+ * lib_ring_buffer_channel_trigger - run trigger actions on a channel
+ * @chan: channel
+ * @handle: shared-memory handle
+ * @actions: mask of enum lib_ring_buffer_trigger_action
+ * @freeze_id: id of the trigger freezing the channel
+ *
+ * Freezing disables recording for the whole channel, including buffers
+ * mapped afterwards, until all the freeze ids which froze it are reset
+ * or thawed. Switching and sampling apply to the buffers mapped in the
+ * process. Only lock-free operations are performed, so this can be
+ * called from a probe.
+ */
+void lib_ring_buffer_channel_trigger(struct channel *chan,
+		struct lttng_ust_shm_handle *handle, unsigned int actions,
+		unsigned int freeze_id)
+{
+	const struct lttng_ust_lib_ring_buffer_config *config = &chan->backend.config;
+	int cpu;
+
+	/*
+	 * The freeze state is the mask itself, which is checked on
+	 * reserve, so a process terminating at any point while freezing
+	 * a shared channel leaves it in a state which can be thawed.
+	 */
+	if (actions & RING_BUFFER_TRIGGER_FREEZE)
+		uatomic_or(&chan->u.s.trigger_frozen, 1U << freeze_id);
+	if (!(actions & (RING_BUFFER_TRIGGER_SWITCH | RING_BUFFER_TRIGGER_SAMPLE)))
+		return;
+	if (config->alloc == RING_BUFFER_ALLOC_PER_CPU) {
+		for_each_channel_cpu(cpu, chan) {
+			struct lttng_ust_lib_ring_buffer *buf =
+				shmp(handle, chan->backend.buf[cpu].shmp);
+
+			if (buf)
+				lib_ring_buffer_trigger(buf, actions, handle);
+		}
+	} else {
+		struct lttng_ust_lib_ring_buffer *buf =
+			shmp(handle, chan->backend.buf[0].shmp);
+
+		if (buf)
+			lib_ring_buffer_trigger(buf, actions, handle);
+	}
+}
+
+/**
+ * lib_ring_buffer_channel_trigger_reset - undo trigger actions
+ * @chan: channel
+ * @handle: shared-memory handle
+ * @actions: mask of the actions run by lib_ring_buffer_channel_trigger
+ * @freeze_id: id of the trigger which froze the channel
+ *
+ * Withdraws the freeze of the trigger from the channel, which resumes
+ * recording unless frozen by other triggers, and invalidates the
+ * trigger samples of its buffers.
+ */
+void lib_ring_buffer_channel_trigger_reset(struct channel *chan,
+		struct lttng_ust_shm_handle *handle, unsigned int actions,
+		unsigned int freeze_id)
+{
+	const struct lttng_ust_lib_ring_buffer_config *config = &chan->backend.config;
+	int cpu;
+
+	if (actions & RING_BUFFER_TRIGGER_FREEZE)
+		lib_ring_buffer_channel_thaw(chan, 1U << freeze_id);
+	if (!(actions & RING_BUFFER_TRIGGER_SAMPLE))
+		return;
+	if (config->alloc == RING_BUFFER_ALLOC_PER_CPU) {
+		for_each_channel_cpu(cpu, chan) {
+			struct lttng_ust_lib_ring_buffer *buf =
+				shmp(handle, chan->backend.buf[cpu].shmp);
+
+			if (buf)
+				CMM_STORE_SHARED(buf->trigger_sampled, 0);
+		}
+	} else {
+		struct lttng_ust_lib_ring_buffer *buf =
+			shmp(handle, chan->backend.buf[0].shmp);
+
+		if (buf)
+			CMM_STORE_SHARED(buf->trigger_sampled, 0);
+	}
+}
+
+/**
+ * lib_ring_buffer_channel_thaw - withdraw trigger freezes
+ * @chan: channel
+ * @freeze_mask: mask of the freeze ids to withdraw
+ *
+ * Also used by the consumer to recover the channels frozen by the
+ * triggers of a process which terminated without resetting them.
+ */
+void lib_ring_buffer_channel_thaw(struct channel *chan, uint32_t freeze_mask)
+{
+	uatomic_and(&chan->u.s.trigger_frozen, ~freeze_mask);
+}
+
 /**
  * lib_ring_buffer_move_consumer - move consumed counter forward
  * @buf: ring buffer
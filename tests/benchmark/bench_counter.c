@@ -0,0 +1,202 @@
+/* SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * bench_counter.c
+ *
+ * Compare the cost of the per-CPU counter add of libcounter, a single
+ * atomic add, with a cmpxchg loop on the same per-CPU counter, for each
+ * counter size:
+ *
+ *   ./bench_counter [nr_threads] [nr_adds_per_thread] [global_sum_step]
+ */
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "../../libcounter/counter.h"
+#include "../../libcounter/counter-api.h"
+#include "../../libcounter/smp.h"
+
+#define NR_ELEM	64
+
+static const struct lib_counter_config configs[] = {
+	{ COUNTER_ALLOC_PER_CPU | COUNTER_ALLOC_GLOBAL, COUNTER_SYNC_PER_CPU,
+		COUNTER_ARITHMETIC_MODULAR, COUNTER_SIZE_8_BIT },
+	{ COUNTER_ALLOC_PER_CPU | COUNTER_ALLOC_GLOBAL, COUNTER_SYNC_PER_CPU,
+		COUNTER_ARITHMETIC_MODULAR, COUNTER_SIZE_16_BIT },
+	{ COUNTER_ALLOC_PER_CPU | COUNTER_ALLOC_GLOBAL, COUNTER_SYNC_PER_CPU,
+		COUNTER_ARITHMETIC_MODULAR, COUNTER_SIZE_32_BIT },
+	{ COUNTER_ALLOC_PER_CPU | COUNTER_ALLOC_GLOBAL, COUNTER_SYNC_PER_CPU,
+		COUNTER_ARITHMETIC_MODULAR, COUNTER_SIZE_64_BIT },
+};
+
+struct bench {
+	const struct lib_counter_config *config;
+	struct lib_counter *counter;
+	unsigned long nr_adds;
+	int use_cmpxchg;
+};
+
+static
+uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*
+ * Reference cmpxchg loop on the per-CPU counter. It does not carry to
+ * the global counter, which is equivalent for modular totals.
+ */
+static
+int counter_add_cmpxchg(const struct lib_counter_config *config,
+		struct lib_counter *counter, const size_t *index, int64_t v)
+{
+	return __lttng_counter_add(config, COUNTER_ALLOC_PER_CPU,
+			COUNTER_SYNC_GLOBAL, counter, index, v, NULL);
+}
+
+static
+void *bench_thread(void *arg)
+{
+	struct bench *bench = arg;
+	unsigned long i;
+	size_t index;
+
+	for (i = 0; i < bench->nr_adds; i++) {
+		index = i % NR_ELEM;
+		if (bench->use_cmpxchg)
+			(void) counter_add_cmpxchg(bench->config,
+					bench->counter, &index, 1);
+		else
+			(void) lttng_counter_add(bench->config,
+					bench->counter, &index, 1);
+	}
+	return NULL;
+}
+
+static
+int create_shm(void)
+{
+	char name[64];
+	int fd;
+
+	snprintf(name, sizeof(name), "/lttng-ust-bench-counter-%d",
+		(int) getpid());
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+	if (fd >= 0)
+		(void) shm_unlink(name);
+	return fd;
+}
+
+static
+struct lib_counter *create_counter(const struct lib_counter_config *config,
+		int64_t global_sum_step)
+{
+	struct lib_counter *counter = NULL;
+	int nr_cpus = lttng_counter_num_possible_cpus();
+	size_t max_nr_elem = NR_ELEM;
+	int global_fd, *cpu_fds, i;
+
+	cpu_fds = calloc(nr_cpus, sizeof(*cpu_fds));
+	if (!cpu_fds)
+		return NULL;
+	global_fd = create_shm();
+	for (i = 0; i < nr_cpus; i++)
+		cpu_fds[i] = create_shm();
+	counter = lttng_counter_create(config, 1, &max_nr_elem,
+			global_sum_step, global_fd, nr_cpus, cpu_fds, true);
+	if (global_fd >= 0)
+		close(global_fd);
+	for (i = 0; i < nr_cpus; i++) {
+		if (cpu_fds[i] >= 0)
+			close(cpu_fds[i]);
+	}
+	free(cpu_fds);
+	return counter;
+}
+
+/*
+ * Returns the time per add in ns, or -1 if the total is wrong. Counters
+ * are modular, so the total is only checked modulo the counter width.
+ */
+static
+double run(const struct lib_counter_config *config, int nr_threads,
+		unsigned long nr_adds, int64_t global_sum_step,
+		int use_cmpxchg)
+{
+	struct bench bench;
+	pthread_t *threads;
+	uint64_t start, duration;
+	uint64_t total = 0, expected, mask;
+	size_t index;
+	int i;
+
+	bench.config = config;
+	bench.nr_adds = nr_adds;
+	bench.use_cmpxchg = use_cmpxchg;
+	bench.counter = create_counter(config, global_sum_step);
+	if (!bench.counter)
+		return -1;
+	threads = calloc(nr_threads, sizeof(*threads));
+	if (!threads)
+		abort();
+
+	start = now_ns();
+	for (i = 0; i < nr_threads; i++) {
+		if (pthread_create(&threads[i], NULL, bench_thread, &bench))
+			abort();
+	}
+	for (i = 0; i < nr_threads; i++)
+		pthread_join(threads[i], NULL);
+	duration = now_ns() - start;
+
+	for (index = 0; index < NR_ELEM; index++) {
+		bool overflow, underflow;
+		int64_t value;
+
+		if (lttng_counter_aggregate(config, bench.counter, &index,
+				&value, &overflow, &underflow))
+			abort();
+		total += value;
+	}
+	lttng_counter_destroy(bench.counter);
+	free(threads);
+	expected = (uint64_t) nr_adds * nr_threads;
+	mask = config->counter_size == COUNTER_SIZE_64_BIT ? UINT64_MAX :
+		(1ULL << (config->counter_size * CHAR_BIT)) - 1;
+	if ((total - expected) & mask)
+		return -1;
+	return (double) duration / nr_adds;
+}
+
+int main(int argc, char **argv)
+{
+	int nr_threads = argc > 1 ? atoi(argv[1]) : 1;
+	unsigned long nr_adds = argc > 2 ? strtoul(argv[2], NULL, 10) : 10000000;
+	int64_t global_sum_step = argc > 3 ? strtoll(argv[3], NULL, 10) : 100;
+	unsigned int i;
+
+	printf("%d threads, %lu adds per thread, global sum step %" PRId64 "\n",
+		nr_threads, nr_adds, global_sum_step);
+	printf("size  cmpxchg (ns/add)  lttng_counter_add (ns/add)\n");
+	for (i = 0; i < sizeof(configs) / sizeof(configs[0]); i++) {
+		printf("%2d    %16.2f  %26.2f\n",
+			configs[i].counter_size * CHAR_BIT,
+			run(&configs[i], nr_threads, nr_adds,
+				global_sum_step, 1),
+			run(&configs[i], nr_threads, nr_adds,
+				global_sum_step, 0));
+	}
+	return EXIT_SUCCESS;
+}
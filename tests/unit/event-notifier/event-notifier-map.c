@@ -0,0 +1,192 @@
+/* SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * event-notifier-map.c
+ *
+ * Unit tests of the value capture of the event notifier map action.
+ */
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+/*
+ * The map action is applied by static functions of the notification
+ * code, built here against fake counters and captures.
+ */
+#include "event-notifier-notification.c"
+
+#include "tap.h"
+
+#define ERROR_COUNTER_LEN	8
+#define ERROR_COUNTER_INDEX	5
+#define NR_BUCKETS		10
+#define BUCKET_WIDTH		10
+
+static int64_t errors[ERROR_COUNTER_LEN];
+static int64_t buckets[NR_BUCKETS];
+static int64_t sum;
+static unsigned int nr_adds;
+
+static
+int fake_error_counter_add(struct lib_counter *counter,
+		const size_t *dimension_indexes, int64_t v)
+{
+	if (dimension_indexes[0] >= ERROR_COUNTER_LEN)
+		return -EOVERFLOW;
+	errors[dimension_indexes[0]] += v;
+	return 0;
+}
+
+static
+int fake_map_counter_add(struct lib_counter *counter,
+		const size_t *dimension_indexes, int64_t v)
+{
+	nr_adds++;
+	if (dimension_indexes[0] >= NR_BUCKETS)
+		return -EOVERFLOW;
+	buckets[dimension_indexes[0]] += v;
+	return 0;
+}
+
+static
+int fake_sum_counter_add(struct lib_counter *counter,
+		const size_t *dimension_indexes, int64_t v)
+{
+	nr_adds++;
+	sum += v;
+	return 0;
+}
+
+static struct lttng_counter_ops error_counter_ops = {
+	.counter_add = fake_error_counter_add,
+};
+static struct lttng_counter_ops map_counter_ops = {
+	.counter_add = fake_map_counter_add,
+};
+static struct lttng_counter_ops sum_counter_ops = {
+	.counter_add = fake_sum_counter_add,
+};
+
+static struct lttng_counter error_counter = { .ops = &error_counter_ops };
+static struct lttng_counter map_counter;
+
+static struct lttng_event_notifier_group group;
+static struct lttng_event_notifier_map map;
+static struct lttng_event_notifier event_notifier;
+static struct lttng_bytecode_runtime capture_runtime;
+static struct lttng_interpreter_output capture_output;
+
+/* Session actions are not exercised. */
+void lttng_session_trigger(struct lttng_session *session, unsigned int ops,
+		unsigned int freeze_id)
+{
+}
+
+static
+uint64_t fake_capture(void *interpreter_data,
+		const char *interpreter_stack_data,
+		struct lttng_interpreter_output *output)
+{
+	*output = capture_output;
+	return LTTNG_INTERPRETER_RECORD_FLAG;
+}
+
+static
+void setup(enum lttng_ust_map_op op)
+{
+	memset(errors, 0, sizeof(errors));
+	memset(buckets, 0, sizeof(buckets));
+	sum = 0;
+	nr_adds = 0;
+
+	group.error_counter = &error_counter;
+	group.error_counter_len = ERROR_COUNTER_LEN;
+
+	map_counter.ops = op == LTTNG_UST_MAP_OP_SUM ?
+		&sum_counter_ops : &map_counter_ops;
+	memset(&map, 0, sizeof(map));
+	map.counter = &map_counter;
+	map.op = op;
+	if (op == LTTNG_UST_MAP_OP_HIST_LINEAR) {
+		map.nr_dimensions = 1;
+		map.dimension_size[0] = NR_BUCKETS;
+		map.bucket_min = 0;
+		map.bucket_width = BUCKET_WIDTH;
+	}
+
+	memset(&event_notifier, 0, sizeof(event_notifier));
+	event_notifier.error_counter_index = ERROR_COUNTER_INDEX;
+	event_notifier.group = &group;
+	event_notifier.map = &map;
+	event_notifier.num_captures = 1;
+	CDS_INIT_LIST_HEAD(&event_notifier.capture_bytecode_runtime_head);
+	capture_runtime.interpreter_funcs.capture = fake_capture;
+	cds_list_add(&capture_runtime.node,
+		&event_notifier.capture_bytecode_runtime_head);
+}
+
+static
+void update_double(double d)
+{
+	capture_output.type = LTTNG_INTERPRETER_TYPE_DOUBLE;
+	capture_output.u.d = d;
+	lttng_event_notifier_map_update(&event_notifier, NULL);
+}
+
+static
+void test_map_value(void)
+{
+	struct lttng_interpreter_output output = {
+		.type = LTTNG_INTERPRETER_TYPE_DOUBLE,
+	};
+	int64_t value;
+
+	output.u.d = -9223372036854775808.0;
+	ok(!map_value(&output, &value) && value == INT64_MIN,
+		"Double -2^63 converts to INT64_MIN");
+	output.u.d = 9223372036854775807.0;	/* Rounds to 2^63. */
+	ok(map_value(&output, &value), "Double 2^63 is out of range");
+	output.u.d = -42.9;
+	ok(!map_value(&output, &value) && value == -42,
+		"Double converts towards zero");
+}
+
+static
+void test_hist_overflow(void)
+{
+	setup(LTTNG_UST_MAP_OP_HIST_LINEAR);
+	update_double(25.0);
+	ok(buckets[2] == 1 && nr_adds == 1, "Double in range is bucketed");
+	update_double(NAN);
+	update_double(INFINITY);
+	update_double(-INFINITY);
+	update_double(1e300);
+	ok(buckets[NR_BUCKETS - 1] == 4 && nr_adds == 5,
+		"NaN, infinities and out of range doubles go to the overflow bucket");
+	ok(errors[ERROR_COUNTER_INDEX] == 0,
+		"Overflow bucket values are not errors");
+}
+
+static
+void test_sum_error(void)
+{
+	setup(LTTNG_UST_MAP_OP_SUM);
+	update_double(42.9);
+	ok(sum == 42 && nr_adds == 1, "Double in range is summed");
+	update_double(NAN);
+	update_double(INFINITY);
+	update_double(-9.3e18);
+	ok(sum == 42 && nr_adds == 1 && errors[ERROR_COUNTER_INDEX] == 3,
+		"NaN, infinities and out of range doubles are not summed");
+}
+
+int main(void)
+{
+	plan_tests(8);
+
+	test_map_value();
+	test_hist_overflow();
+	test_sum_error();
+
+	return exit_status();
+}
@@ -0,0 +1,195 @@
+/* SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * event-notifier-rate.c
+ *
+ * Unit tests of the rate policies of event notifiers.
+ */
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * The rate policies are applied by static functions of the
+ * notification code, built here against a fake error counter and a
+ * notification pipe.
+ */
+#include "event-notifier-notification.c"
+
+#include "tap.h"
+
+#define ERROR_COUNTER_LEN	8
+#define ERROR_COUNTER_INDEX	3
+#define LONG_WINDOW_NS		3600000000000ULL	/* 1 hour */
+#define SHORT_WINDOW_NS		50000000ULL		/* 50 ms */
+
+static int64_t errors[ERROR_COUNTER_LEN];
+
+static
+int fake_counter_add(struct lib_counter *counter,
+		const size_t *dimension_indexes, int64_t v)
+{
+	if (dimension_indexes[0] >= ERROR_COUNTER_LEN)
+		return -EOVERFLOW;
+	errors[dimension_indexes[0]] += v;
+	return 0;
+}
+
+static struct lttng_counter_ops fake_counter_ops = {
+	.counter_add = fake_counter_add,
+};
+
+static struct lttng_counter error_counter = {
+	.ops = &fake_counter_ops,
+};
+
+static struct lttng_event_notifier_group group;
+static struct lttng_event_notifier_enabler enabler;
+static struct lttng_event_notifier event_notifier;
+static int notification_pipe[2];
+
+/* Session actions are not exercised. */
+void lttng_session_trigger(struct lttng_session *session, unsigned int ops,
+		unsigned int freeze_id)
+{
+}
+
+static
+void setup(enum lttng_ust_event_notifier_rate_policy policy,
+		uint32_t count, uint64_t window_ns)
+{
+	memset(errors, 0, sizeof(errors));
+	memset(&enabler.rate, 0, sizeof(enabler.rate));
+	enabler.rate.policy = policy;
+	enabler.rate.count = count;
+	enabler.rate.window_ns = window_ns;
+	enabler.group = &group;
+	enabler.error_counter_index = ERROR_COUNTER_INDEX;
+
+	memset(&event_notifier, 0, sizeof(event_notifier));
+	event_notifier.user_token = 42;
+	event_notifier.error_counter_index = ERROR_COUNTER_INDEX;
+	event_notifier.group = &group;
+	event_notifier.rate = policy == LTTNG_UST_EVENT_NOTIFIER_RATE_NONE ?
+		NULL : &enabler.rate;
+	CDS_INIT_LIST_HEAD(&event_notifier.capture_bytecode_runtime_head);
+}
+
+static
+void send_hits(unsigned int nr_hits)
+{
+	while (nr_hits--)
+		lttng_event_notifier_notification_send(&event_notifier, NULL);
+}
+
+/*
+ * Drain the notification pipe. Returns the number of notifications,
+ * and the sum of their hit counts in `nr_hits`.
+ */
+static
+unsigned int read_notifications(uint64_t *nr_hits)
+{
+	struct lttng_ust_event_notifier_notification notif;
+	unsigned int nr = 0;
+
+	*nr_hits = 0;
+	while (read(notification_pipe[0], &notif, sizeof(notif))
+			== sizeof(notif)) {
+		nr++;
+		*nr_hits += notif.nr_hits;
+	}
+	return nr;
+}
+
+static
+void test_no_policy(void)
+{
+	uint64_t nr_hits;
+
+	setup(LTTNG_UST_EVENT_NOTIFIER_RATE_NONE, 0, 0);
+	send_hits(10);
+	ok(read_notifications(&nr_hits) == 10 && nr_hits == 10
+		&& errors[ERROR_COUNTER_INDEX] == 0,
+		"Every hit is notified without rate policy");
+}
+
+static
+void test_limit(void)
+{
+	uint64_t nr_hits;
+
+	setup(LTTNG_UST_EVENT_NOTIFIER_RATE_LIMIT, 3, LONG_WINDOW_NS);
+	send_hits(10);
+	ok(read_notifications(&nr_hits) == 3 && nr_hits == 3,
+		"Limit notifies the first hits of a window");
+	ok(errors[ERROR_COUNTER_INDEX] == 7,
+		"Limit counts the suppressed hits as errors");
+}
+
+static
+void test_every_nth(void)
+{
+	uint64_t nr_hits;
+
+	setup(LTTNG_UST_EVENT_NOTIFIER_RATE_EVERY_NTH, 4, 0);
+	send_hits(10);
+	/* Hits 1, 5 and 9. */
+	ok(read_notifications(&nr_hits) == 3 && nr_hits == 3,
+		"Every nth notifies the first hit, then every nth hit");
+	ok(errors[ERROR_COUNTER_INDEX] == 7,
+		"Every nth counts the suppressed hits as errors");
+}
+
+static
+void test_coalesce(void)
+{
+	const struct timespec wait = {
+		.tv_sec = 0,
+		.tv_nsec = 2 * SHORT_WINDOW_NS,
+	};
+	uint64_t nr_hits;
+
+	setup(LTTNG_UST_EVENT_NOTIFIER_RATE_COALESCE, 0, SHORT_WINDOW_NS);
+	send_hits(5);
+	ok(read_notifications(&nr_hits) == 1 && nr_hits == 1
+		&& errors[ERROR_COUNTER_INDEX] == 0,
+		"Coalesce notifies the first hit of a window");
+	(void) nanosleep(&wait, NULL);
+	send_hits(1);
+	ok(read_notifications(&nr_hits) == 1 && nr_hits == 5,
+		"Coalesce reports the hits since the previous notification");
+
+	setup(LTTNG_UST_EVENT_NOTIFIER_RATE_COALESCE, 0, LONG_WINDOW_NS);
+	send_hits(6);
+	(void) read_notifications(&nr_hits);
+	lttng_event_notifier_enabler_rate_flush(&enabler);
+	ok(errors[ERROR_COUNTER_INDEX] == 5 && enabler.rate.coalesced == 0,
+		"Release counts the hits not notified yet as errors");
+	lttng_event_notifier_enabler_rate_flush(&enabler);
+	ok(errors[ERROR_COUNTER_INDEX] == 5,
+		"Release counts the hits not notified yet once");
+}
+
+int main(void)
+{
+	plan_tests(9);
+
+	if (pipe(notification_pipe)
+			|| fcntl(notification_pipe[0], F_SETFL, O_NONBLOCK)
+			|| fcntl(notification_pipe[1], F_SETFL, O_NONBLOCK)) {
+		diag("Unable to create the notification pipe");
+		return exit_status();
+	}
+	group.notification_fd = notification_pipe[1];
+	group.error_counter = &error_counter;
+	group.error_counter_len = ERROR_COUNTER_LEN;
+
+	test_no_policy();
+	test_limit();
+	test_every_nth();
+	test_coalesce();
+
+	return exit_status();
+}
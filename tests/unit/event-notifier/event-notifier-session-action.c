@@ -0,0 +1,133 @@
+/* SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * event-notifier-session-action.c
+ *
+ * Unit tests of the one-shot session actions of event notifiers.
+ */
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+/*
+ * Session actions are run by the notification code, built here against
+ * a notification pipe and a session trigger recording its calls.
+ */
+#include "event-notifier-notification.c"
+
+#include "tap.h"
+
+#define SESSION_ACTION_OPS	(LTTNG_UST_SESSION_ACTION_FREEZE \
+					| LTTNG_UST_SESSION_ACTION_SWITCH)
+#define SESSION_ACTION_FREEZE_ID	12
+
+static struct lttng_session session;
+static struct lttng_event_notifier_group group;
+static struct lttng_event_notifier_session_action action;
+static struct lttng_event_notifier event_notifier;
+static int notification_pipe[2];
+
+static unsigned int nr_triggers;
+static unsigned int trigger_ops;
+static unsigned int trigger_freeze_id;
+
+void lttng_session_trigger(struct lttng_session *trigger_session,
+		unsigned int ops, unsigned int freeze_id)
+{
+	if (trigger_session != &session)
+		return;
+	nr_triggers++;
+	trigger_ops = ops;
+	trigger_freeze_id = freeze_id;
+}
+
+static
+void send_hits(unsigned int nr_hits)
+{
+	while (nr_hits--)
+		lttng_event_notifier_session_action_run(&event_notifier, NULL);
+}
+
+/*
+ * Drain the notification pipe. Returns the number of notifications
+ * flagged as session actions, and of the others in `nr_other`.
+ */
+static
+unsigned int read_notifications(unsigned int *nr_other)
+{
+	struct lttng_ust_event_notifier_notification notif;
+	unsigned int nr = 0;
+
+	*nr_other = 0;
+	while (read(notification_pipe[0], &notif, sizeof(notif))
+			== sizeof(notif)) {
+		if (notif.flags
+				& LTTNG_UST_EVENT_NOTIFIER_NOTIFICATION_FLAG_SESSION_ACTION)
+			nr++;
+		else
+			(*nr_other)++;
+	}
+	return nr;
+}
+
+static
+void test_one_shot(void)
+{
+	unsigned int nr_other;
+
+	action.session = &session;
+	action.ops = SESSION_ACTION_OPS;
+	action.freeze_id = SESSION_ACTION_FREEZE_ID;
+	action.armed = 1;
+
+	send_hits(5);
+	ok(nr_triggers == 1 && trigger_ops == SESSION_ACTION_OPS
+		&& trigger_freeze_id == SESSION_ACTION_FREEZE_ID,
+		"The first hit runs the actions with the freeze id of the action");
+	ok(read_notifications(&nr_other) == 1 && nr_other == 0,
+		"The first hit is notified as a session action");
+	ok(!action.armed, "Running the actions disarms the action");
+
+	/* As done by lttng_event_notifier_enabler_rearm_session_action. */
+	CMM_STORE_SHARED(action.armed, 1);
+	send_hits(3);
+	ok(nr_triggers == 2 && read_notifications(&nr_other) == 1,
+		"The first hit after a re-arm runs the actions again");
+}
+
+static
+void test_detached(void)
+{
+	unsigned int nr_other;
+
+	nr_triggers = 0;
+	action.session = NULL;
+	action.armed = 1;
+	send_hits(2);
+	ok(nr_triggers == 0 && read_notifications(&nr_other) == 0,
+		"An action detached from its session does not run");
+}
+
+int main(void)
+{
+	plan_tests(5);
+
+	if (pipe(notification_pipe)
+			|| fcntl(notification_pipe[0], F_SETFL, O_NONBLOCK)
+			|| fcntl(notification_pipe[1], F_SETFL, O_NONBLOCK)) {
+		diag("Unable to create the notification pipe");
+		return exit_status();
+	}
+	group.notification_fd = notification_pipe[1];
+
+	event_notifier.user_token = 42;
+	event_notifier.group = &group;
+	event_notifier.session_action = &action;
+	CDS_INIT_LIST_HEAD(&event_notifier.capture_bytecode_runtime_head);
+
+	test_one_shot();
+	test_detached();
+
+	return exit_status();
+}
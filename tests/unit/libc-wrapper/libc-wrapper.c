@@ -0,0 +1,150 @@
+/* SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * libc-wrapper.c
+ *
+ * Check the sampling and aggregation modes of the libc malloc wrapper,
+ * which must be preloaded. Each mode is run in a child process started
+ * with the environment enabling it, with probes connected to the
+ * wrapper tracepoints in place of a tracing session.
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <urcu/uatomic.h>
+#include <lttng/tracepoint.h>
+
+#include "tap.h"
+
+#define NR_ALLOCS		10000
+
+/* Child exit status bits. */
+#define FAIL_NO_SAMPLE		(1 << 0)
+#define FAIL_NO_SUMMARY		(1 << 1)
+#define FAIL_SUMMARY_THREAD	(1 << 2)
+#define FAIL_SAMPLE		(1 << 3)
+
+static unsigned long nr_samples, nr_summaries, nr_app_summaries;
+static pid_t app_tid;
+
+static
+void sampled_alloc_probe(void *data, size_t size, void *ptr,
+		uint64_t weight, void *ip)
+{
+	uatomic_inc(&nr_samples);
+}
+
+static
+void alloc_summary_probe(void *data, void *ip, uint64_t size_max,
+		uint64_t samples, uint64_t bytes, uint64_t freed_samples,
+		uint64_t live_bytes)
+{
+	if (syscall(SYS_gettid) == app_tid)
+		uatomic_inc(&nr_app_summaries);
+	uatomic_inc(&nr_summaries);
+}
+
+static
+void register_probes(void)
+{
+	app_tid = syscall(SYS_gettid);
+	if (__tracepoint_probe_register("lttng_ust_libc:sampled_alloc",
+			(void (*)(void)) sampled_alloc_probe, NULL,
+			"size_t, size, void *, ptr, uint64_t, weight, void *, ip"))
+		exit(EXIT_FAILURE);
+	if (__tracepoint_probe_register("lttng_ust_libc:alloc_summary",
+			(void (*)(void)) alloc_summary_probe, NULL,
+			"void *, ip, uint64_t, size_max, uint64_t, samples, "
+			"uint64_t, bytes, uint64_t, freed_samples, "
+			"uint64_t, live_bytes"))
+		exit(EXIT_FAILURE);
+}
+
+static
+int run_sample(void)
+{
+	int i;
+
+	register_probes();
+	for (i = 0; i < NR_ALLOCS; i++)
+		free(malloc(4096));
+	return uatomic_read(&nr_samples) ? 0 : FAIL_NO_SAMPLE;
+}
+
+static
+int run_aggregate(void)
+{
+	int i, ret = 0;
+
+	register_probes();
+	/*
+	 * The allocation path only wakes up the flusher once a period
+	 * elapsed: keep allocating until a summary is emitted.
+	 */
+	for (i = 0; i < NR_ALLOCS && !uatomic_read(&nr_summaries); i++) {
+		free(malloc(65536));
+		usleep(1000);
+	}
+	if (!uatomic_read(&nr_summaries))
+		ret |= FAIL_NO_SUMMARY;
+	if (uatomic_read(&nr_app_summaries))
+		ret |= FAIL_SUMMARY_THREAD;
+	if (uatomic_read(&nr_samples))
+		ret |= FAIL_SAMPLE;
+	return ret;
+}
+
+/*
+ * Run this test in `mode` in a child process with `name` set to
+ * `value` in its environment. Returns the exit status of the child, or
+ * all failure bits if it did not exit.
+ */
+static
+int run_child(const char *mode, const char *name, const char *value)
+{
+	pid_t pid;
+	int status;
+
+	pid = fork();
+	if (pid < 0)
+		return -1;
+	if (pid == 0) {
+		setenv(name, value, 1);
+		setenv("LTTNG_UST_LIBC_AGGREGATE_PERIOD_MS", "10", 1);
+		execl("/proc/self/exe", "libc-wrapper", mode, NULL);
+		_exit(EXIT_FAILURE);
+	}
+	if (waitpid(pid, &status, 0) != pid || !WIFEXITED(status))
+		return -1;
+	return WEXITSTATUS(status);
+}
+
+int main(int argc, char **argv)
+{
+	int ret;
+
+	if (argc > 1 && !strcmp(argv[1], "sample"))
+		return run_sample();
+	if (argc > 1 && !strcmp(argv[1], "aggregate"))
+		return run_aggregate();
+
+	plan_tests(4);
+
+	ret = run_child("sample", "LTTNG_UST_LIBC_SAMPLE_BYTES", "16384");
+	ok(ret == 0, "LTTNG_UST_LIBC_SAMPLE_BYTES enables sampled allocation events");
+
+	ret = run_child("aggregate", "LTTNG_UST_LIBC_AGGREGATE", "1");
+	ok(!(ret & FAIL_NO_SUMMARY),
+		"LTTNG_UST_LIBC_AGGREGATE emits periodic allocation summaries");
+	ok(!(ret & FAIL_SUMMARY_THREAD),
+		"Periodic summaries are not emitted from the allocating thread");
+	ok(!(ret & FAIL_SAMPLE),
+		"Sampled allocations are not traced one by one when aggregating");
+
+	return EXIT_SUCCESS;
+}
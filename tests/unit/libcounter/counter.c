@@ -0,0 +1,496 @@
+/* SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * counter.c
+ *
+ * Unit tests of libcounter.
+ */
+
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <urcu/uatomic.h>
+
+#include "libcounter/counter.h"
+#include "libcounter/counter-api.h"
+#include "libcounter/smp.h"
+
+#include "tap.h"
+
+#define NR_ELEM			200
+#define GLOBAL_SUM_STEP		16
+#define NR_ADD_THREADS		4
+#define NR_ADDS			200000
+#define NR_ROWS			3
+#define NR_COLUMNS		400
+#define RANGE_START		37
+#define RANGE_LEN		1100
+#define THRESHOLD		40
+#define THRESHOLD_INDEX		3
+#define THRESHOLD_OTHER_INDEX	4
+
+/* Provided by liblttng-ust, which is not linked: use sched_getcpu(). */
+int (*lttng_get_cpu)(void);
+
+static const struct lib_counter_config config_32 = {
+	COUNTER_ALLOC_PER_CPU | COUNTER_ALLOC_GLOBAL, COUNTER_SYNC_PER_CPU,
+	COUNTER_ARITHMETIC_MODULAR, COUNTER_SIZE_32_BIT,
+};
+
+static const struct lib_counter_config config_8 = {
+	COUNTER_ALLOC_PER_CPU | COUNTER_ALLOC_GLOBAL, COUNTER_SYNC_PER_CPU,
+	COUNTER_ARITHMETIC_MODULAR, COUNTER_SIZE_8_BIT,
+};
+
+static int64_t values[NR_ROWS * NR_COLUMNS];
+static bool overflow[NR_ROWS * NR_COLUMNS], underflow[NR_ROWS * NR_COLUMNS];
+
+static
+int create_shm(void)
+{
+	static int nr_shm;
+	char name[64];
+	int fd;
+
+	snprintf(name, sizeof(name), "/lttng-ust-test-counter-%d-%d",
+		(int) getpid(), nr_shm++);
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+	if (fd >= 0)
+		(void) shm_unlink(name);
+	return fd;
+}
+
+static
+struct lib_counter *create_counter_dimensions(
+		const struct lib_counter_config *config, size_t nr_dimensions,
+		size_t *max_nr_elem, int64_t global_sum_step)
+{
+	struct lib_counter *counter;
+	int nr_cpus = lttng_counter_num_possible_cpus();
+	int global_fd, *cpu_fds, i;
+
+	cpu_fds = calloc(nr_cpus, sizeof(*cpu_fds));
+	if (!cpu_fds)
+		return NULL;
+	global_fd = create_shm();
+	for (i = 0; i < nr_cpus; i++)
+		cpu_fds[i] = create_shm();
+	counter = lttng_counter_create(config, nr_dimensions, max_nr_elem,
+			global_sum_step, global_fd, nr_cpus, cpu_fds, true);
+	if (global_fd >= 0)
+		close(global_fd);
+	for (i = 0; i < nr_cpus; i++) {
+		if (cpu_fds[i] >= 0)
+			close(cpu_fds[i]);
+	}
+	free(cpu_fds);
+	return counter;
+}
+
+static
+struct lib_counter *create_counter(const struct lib_counter_config *config,
+		size_t nr_elem, int64_t global_sum_step)
+{
+	return create_counter_dimensions(config, 1, &nr_elem, global_sum_step);
+}
+
+static
+void add_n(const struct lib_counter_config *config,
+		struct lib_counter *counter, size_t index, int64_t v,
+		unsigned int n)
+{
+	while (n--)
+		(void) lttng_counter_add(config, counter, &index, v);
+}
+
+static
+void add_n_index(const struct lib_counter_config *config,
+		struct lib_counter *counter, const size_t *dimension_indexes,
+		unsigned int n)
+{
+	while (n--)
+		(void) lttng_counter_add(config, counter, dimension_indexes, 1);
+}
+
+static
+bool all_flags_clear(const bool *flags, size_t nr_elem)
+{
+	size_t i;
+
+	for (i = 0; i < nr_elem; i++) {
+		if (flags[i])
+			return false;
+	}
+	return true;
+}
+
+struct delta_add {
+	struct lib_counter *counter;
+	int done;
+};
+
+static
+void *delta_add_thread(void *arg)
+{
+	struct delta_add *add = arg;
+	size_t i;
+
+	for (i = 0; i < NR_ADDS; i++) {
+		size_t index = i % NR_ELEM;
+
+		(void) lttng_counter_add(&config_32, add->counter, &index, 1);
+	}
+	uatomic_inc(&add->done);
+	return NULL;
+}
+
+static
+void test_delta_range(void)
+{
+	static int64_t totals[NR_ELEM];
+	pthread_t threads[NR_ADD_THREADS];
+	struct lib_counter *counter;
+	struct delta_add add = { 0 };
+	size_t start = 0, i;
+	bool ok_deltas = true;
+	int ret;
+
+	counter = create_counter(&config_32, NR_ELEM, GLOBAL_SUM_STEP);
+	if (!counter) {
+		fail("Create counter");
+		return;
+	}
+	for (i = 0; i < NR_ELEM; i++)
+		add_n(&config_32, counter, i, 1, i + 1);
+	ret = lttng_counter_aggregate_delta_range(&config_32, counter, &start,
+			NR_ELEM, values, overflow, underflow);
+	for (i = 0; i < NR_ELEM; i++)
+		ok_deltas &= values[i] == (int64_t) i + 1;
+	ok(!ret && ok_deltas, "Delta read returns the counts since creation");
+
+	ret = lttng_counter_aggregate_delta_range(&config_32, counter, &start,
+			NR_ELEM, values, overflow, underflow);
+	ok_deltas = true;
+	for (i = 0; i < NR_ELEM; i++)
+		ok_deltas &= values[i] == 0;
+	ok(!ret && ok_deltas, "Delta read resets the counters");
+
+	add_n(&config_32, counter, 7, -1, 40);
+	ret = lttng_counter_aggregate_range(&config_32, counter, &start,
+			NR_ELEM, values, overflow, underflow);
+	ok(!ret && values[7] == -40 && values[6] == 0 && values[8] == 0,
+		"Counters keep counting after a delta read");
+	(void) lttng_counter_aggregate_delta_range(&config_32, counter,
+			&start, NR_ELEM, values, overflow, underflow);
+
+	/* Scrape deltas while other threads add, with carries. */
+	add.counter = counter;
+	for (i = 0; i < NR_ADD_THREADS; i++)
+		pthread_create(&threads[i], NULL, delta_add_thread, &add);
+	while (uatomic_read(&add.done) < NR_ADD_THREADS) {
+		if (lttng_counter_aggregate_delta_range(&config_32, counter,
+				&start, NR_ELEM, values, overflow, underflow))
+			break;
+		for (i = 0; i < NR_ELEM; i++)
+			totals[i] += values[i];
+	}
+	for (i = 0; i < NR_ADD_THREADS; i++)
+		pthread_join(threads[i], NULL);
+	ret = lttng_counter_aggregate_delta_range(&config_32, counter, &start,
+			NR_ELEM, values, overflow, underflow);
+	ok_deltas = true;
+	for (i = 0; i < NR_ELEM; i++) {
+		size_t expected = NR_ADDS / NR_ELEM
+			+ (i < NR_ADDS % NR_ELEM ? 1 : 0);
+
+		totals[i] += values[i];
+		ok_deltas &= totals[i] == (int64_t) (expected * NR_ADD_THREADS);
+	}
+	ok(!ret && ok_deltas, "Deltas read concurrently with adds sum up to the counts");
+	lttng_counter_destroy(counter);
+
+	/* An 8-bit counter wraps at 128 without global sum step. */
+	counter = create_counter(&config_8, NR_ELEM, 0);
+	if (!counter) {
+		fail("Create counter");
+		return;
+	}
+	add_n(&config_8, counter, 65, 1, 130);
+	ret = lttng_counter_aggregate_delta_range(&config_8, counter, &start,
+			NR_ELEM, values, overflow, underflow);
+	ok(!ret && overflow[65] && !overflow[64] && !overflow[66],
+		"Delta read returns the overflow of an element");
+	ret = lttng_counter_aggregate_delta_range(&config_8, counter, &start,
+			NR_ELEM, values, overflow, underflow);
+	ok(!ret && all_flags_clear(overflow, NR_ELEM),
+		"Delta read clears the overflow of an element");
+	lttng_counter_destroy(counter);
+}
+
+/* Element i of the range tests is incremented (i % 7) + 1 times. */
+static
+int64_t range_count(size_t i)
+{
+	return (i % 7) + 1;
+}
+
+static
+void test_read_range(void)
+{
+	static int64_t sums[NR_ROWS * NR_COLUMNS];
+	size_t max_nr_elem[2] = { NR_ROWS, NR_COLUMNS };
+	size_t start[2] = { 0, RANGE_START };
+	struct lib_counter *counter;
+	bool ok_values = true, ok_flags = true;
+	int ret, cpu, nr_cpus = lttng_counter_num_possible_cpus();
+	size_t i;
+
+	counter = create_counter_dimensions(&config_32, 2, max_nr_elem,
+			GLOBAL_SUM_STEP);
+	if (!counter) {
+		fail("Create counter");
+		return;
+	}
+	for (i = 0; i < NR_ROWS * NR_COLUMNS; i++) {
+		size_t index[2] = { i / NR_COLUMNS, i % NR_COLUMNS };
+
+		add_n_index(&config_32, counter, index, range_count(i));
+	}
+
+	/*
+	 * The range starts within a bitmap word, and crosses rows, bitmap
+	 * words and the chunks the ranges are summed by.
+	 */
+	ret = lttng_counter_aggregate_range(&config_32, counter, start,
+			RANGE_LEN, values, overflow, underflow);
+	for (i = 0; i < RANGE_LEN; i++) {
+		ok_values &= values[i] == range_count(RANGE_START + i);
+		ok_flags &= !overflow[i] && !underflow[i];
+	}
+	ok(!ret && ok_values && ok_flags,
+		"Aggregate range at an offset across rows and words");
+
+	/* The global and per-CPU counters add up to the aggregate. */
+	ret = lttng_counter_read_range(&config_32, counter, start, RANGE_LEN,
+			-1, sums, overflow, underflow);
+	for (cpu = 0; !ret && cpu < nr_cpus; cpu++) {
+		ret = lttng_counter_read_range(&config_32, counter, start,
+				RANGE_LEN, cpu, values, overflow, underflow);
+		for (i = 0; i < RANGE_LEN; i++)
+			sums[i] += values[i];
+	}
+	ok_values = true;
+	for (i = 0; i < RANGE_LEN; i++)
+		ok_values &= sums[i] == range_count(RANGE_START + i);
+	ok(!ret && ok_values, "Read ranges of the global and per-CPU counters");
+
+	start[0] = NR_ROWS - 1;
+	start[1] = NR_COLUMNS - 1;
+	ret = lttng_counter_aggregate_range(&config_32, counter, start,
+			2, values, overflow, underflow);
+	ok(ret == -EOVERFLOW, "Range beyond the last element is rejected");
+	ret = lttng_counter_read_range(&config_32, counter, start, 1,
+			nr_cpus, values, overflow, underflow);
+	ok(ret == -EINVAL, "Range of a CPU which does not exist is rejected");
+	lttng_counter_destroy(counter);
+}
+
+/*
+ * Check the flags of the range [start, start + len) of an 8-bit counter
+ * where the elements of of_index overflowed and the elements of
+ * uf_index underflowed.
+ */
+static
+bool check_range_flags(struct lib_counter *counter, size_t start, size_t len,
+		const size_t *of_index, size_t nr_of,
+		const size_t *uf_index, size_t nr_uf)
+{
+	bool expect_of[NR_ELEM] = { 0 }, expect_uf[NR_ELEM] = { 0 };
+	size_t i;
+
+	for (i = 0; i < nr_of; i++)
+		expect_of[of_index[i]] = true;
+	for (i = 0; i < nr_uf; i++)
+		expect_uf[uf_index[i]] = true;
+	if (lttng_counter_aggregate_range(&config_8, counter, &start, len,
+			values, overflow, underflow))
+		return false;
+	for (i = 0; i < len; i++) {
+		if (overflow[i] != expect_of[start + i]
+				|| underflow[i] != expect_uf[start + i])
+			return false;
+	}
+	return true;
+}
+
+static
+void test_range_flags(void)
+{
+	/* Around the bitmap word boundaries of 32-bit and 64-bit longs. */
+	static const size_t of_index[] = { 0, 31, 32, 63, 64, 100, 128, 199 };
+	static const size_t uf_index[] = { 1, 62, 65, 127, 129 };
+	struct lib_counter *counter;
+	size_t i;
+
+	counter = create_counter(&config_8, NR_ELEM, 0);
+	if (!counter) {
+		fail("Create counter");
+		return;
+	}
+	/* An 8-bit counter wraps after 128 increments or decrements. */
+	for (i = 0; i < CAA_ARRAY_SIZE(of_index); i++)
+		add_n(&config_8, counter, of_index[i], 1, 130);
+	for (i = 0; i < CAA_ARRAY_SIZE(uf_index); i++)
+		add_n(&config_8, counter, uf_index[i], -1, 130);
+
+	ok(check_range_flags(counter, 0, NR_ELEM, of_index,
+			CAA_ARRAY_SIZE(of_index), uf_index,
+			CAA_ARRAY_SIZE(uf_index)),
+		"Flags of the whole counter");
+	ok(check_range_flags(counter, 37, 150, of_index,
+			CAA_ARRAY_SIZE(of_index), uf_index,
+			CAA_ARRAY_SIZE(uf_index)),
+		"Flags of a range starting within a word");
+	ok(check_range_flags(counter, 63, 3, of_index,
+			CAA_ARRAY_SIZE(of_index), uf_index,
+			CAA_ARRAY_SIZE(uf_index)),
+		"Flags of a short range across a word boundary");
+	ok(check_range_flags(counter, 129, NR_ELEM - 129, of_index,
+			CAA_ARRAY_SIZE(of_index), uf_index,
+			CAA_ARRAY_SIZE(uf_index)),
+		"Flags of a range ending at the last element");
+	ok(check_range_flags(counter, 2, 29, of_index,
+			CAA_ARRAY_SIZE(of_index), uf_index,
+			CAA_ARRAY_SIZE(uf_index)),
+		"Flags of a range without flags set");
+	lttng_counter_destroy(counter);
+}
+
+struct threshold_fire {
+	unsigned int nr_fired;
+	size_t index;
+	int64_t value;
+};
+
+static
+void threshold_cb(struct lib_counter *counter,
+		const size_t *dimension_indexes, int64_t value, void *priv)
+{
+	struct threshold_fire *fire = priv;
+
+	fire->nr_fired++;
+	fire->index = dimension_indexes[0];
+	fire->value = value;
+}
+
+/*
+ * Increment an element until the threshold fires. Without migration,
+ * a carry happens within GLOBAL_SUM_STEP + 1 adds, and within that many
+ * adds on each CPU otherwise. Returns the number of adds.
+ */
+static
+unsigned int add_until_fired(struct lib_counter *counter, size_t index,
+		struct threshold_fire *fire)
+{
+	unsigned int nr_fired = fire->nr_fired, nr_adds = 0, max_adds;
+
+	max_adds = THRESHOLD
+		+ (GLOBAL_SUM_STEP + 1) * lttng_counter_num_possible_cpus();
+	while (fire->nr_fired == nr_fired && nr_adds < max_adds) {
+		(void) lttng_counter_add(&config_32, counter, &index, 1);
+		nr_adds++;
+	}
+	return nr_adds;
+}
+
+static
+void test_threshold(void)
+{
+	struct threshold_fire fire = { 0 }, other_fire = { 0 };
+	struct lib_counter *counter;
+	size_t index = THRESHOLD_INDEX;
+	unsigned int nr_adds;
+	int ret;
+
+	/* Thresholds are evaluated at carry points only. */
+	counter = create_counter(&config_32, NR_ELEM, 0);
+	if (!counter) {
+		fail("Create counter");
+		return;
+	}
+	ok(lttng_counter_set_threshold(&config_32, counter, THRESHOLD,
+			threshold_cb, &fire) == -EINVAL,
+		"Threshold requires a global sum step");
+	lttng_counter_destroy(counter);
+
+	counter = create_counter(&config_32, NR_ELEM, GLOBAL_SUM_STEP);
+	if (!counter) {
+		fail("Create counter");
+		return;
+	}
+	ret = lttng_counter_set_threshold(&config_32, counter,
+			GLOBAL_SUM_STEP / 2, threshold_cb, &other_fire);
+	ok(!ret && lttng_counter_set_threshold(&config_32, counter, THRESHOLD,
+			threshold_cb, &fire) == -EBUSY,
+		"Threshold is set once");
+	/* No per-CPU counter goes beyond the global sum step. */
+	add_n(&config_32, counter, THRESHOLD_INDEX, 1, GLOBAL_SUM_STEP);
+	ok(other_fire.nr_fired == 0,
+		"Threshold is not evaluated before a carry");
+	lttng_counter_destroy(counter);
+
+	counter = create_counter(&config_32, NR_ELEM, GLOBAL_SUM_STEP);
+	if (!counter) {
+		fail("Create counter");
+		return;
+	}
+	(void) lttng_counter_set_threshold(&config_32, counter, THRESHOLD,
+			threshold_cb, &fire);
+	/* Carries happen below the threshold. */
+	add_n(&config_32, counter, THRESHOLD_INDEX, 1, THRESHOLD - 1);
+	ok(fire.nr_fired == 0, "Threshold does not fire below its value");
+
+	nr_adds = add_until_fired(counter, THRESHOLD_INDEX, &fire)
+		+ THRESHOLD - 1;
+	ok(fire.nr_fired == 1 && fire.index == THRESHOLD_INDEX
+		&& fire.value == (int64_t) nr_adds && fire.value >= THRESHOLD,
+		"Threshold fires at the carry with the sum of the element");
+
+	add_n(&config_32, counter, THRESHOLD_INDEX, 1, 10 * GLOBAL_SUM_STEP);
+	ok(fire.nr_fired == 1, "Threshold fires once per crossing");
+
+	(void) add_until_fired(counter, THRESHOLD_OTHER_INDEX, &fire);
+	ok(fire.nr_fired == 2 && fire.index == THRESHOLD_OTHER_INDEX,
+		"Threshold fires for each element");
+
+	ret = lttng_counter_clear(&config_32, counter, &index);
+	nr_adds = add_until_fired(counter, THRESHOLD_INDEX, &fire);
+	ok(!ret && fire.nr_fired == 3 && fire.index == THRESHOLD_INDEX
+		&& fire.value == (int64_t) nr_adds,
+		"Clearing an element re-arms its threshold");
+
+	add_n(&config_32, counter, THRESHOLD_OTHER_INDEX, 1,
+		10 * GLOBAL_SUM_STEP);
+	ok(fire.nr_fired == 3,
+		"Clearing an element keeps the thresholds of the others");
+	lttng_counter_destroy(counter);
+}
+
+int main(void)
+{
+	plan_tests(24);
+
+	test_delta_range();
+	test_read_range();
+	test_range_flags();
+	test_threshold();
+
+	return exit_status();
+}
@@ -0,0 +1,201 @@
+/*
+ * msgpack-bench.c
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; only
+ * version 2.1 of the License.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Compare the encoding of integer sequence captures one element at a
+ * time, as event notifier captures used to be encoded, with the
+ * encoding of the whole sequence from its precomputed layout, for each
+ * element size:
+ *
+ *   ./msgpack-bench [iterations] [nr_elem]
+ */
+
+#include <byteswap.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../../libmsgpack/msgpack.h"
+
+#define BUFFER_SIZE	4096
+
+static
+uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Element read of the per-element path, which switches on the size. */
+static
+int64_t load_element(const uint8_t *ptr,
+		const struct lttng_msgpack_integer_layout *layout)
+{
+	switch (layout->size) {
+	case 1:
+		return layout->is_signed ? (int64_t) (int8_t) *ptr : *ptr;
+	case 2:
+	{
+		uint16_t tmp;
+
+		memcpy(&tmp, ptr, sizeof(tmp));
+		if (layout->reverse_byte_order)
+			tmp = bswap_16(tmp);
+		return layout->is_signed ? (int64_t) (int16_t) tmp : tmp;
+	}
+	case 4:
+	{
+		uint32_t tmp;
+
+		memcpy(&tmp, ptr, sizeof(tmp));
+		if (layout->reverse_byte_order)
+			tmp = bswap_32(tmp);
+		return layout->is_signed ? (int64_t) (int32_t) tmp : tmp;
+	}
+	case 8:
+	{
+		uint64_t tmp;
+
+		memcpy(&tmp, ptr, sizeof(tmp));
+		if (layout->reverse_byte_order)
+			tmp = bswap_64(tmp);
+		return (int64_t) tmp;
+	}
+	default:
+		abort();
+	}
+}
+
+static
+size_t encode_per_element(uint8_t *buf,
+		const struct lttng_msgpack_integer_layout *layout,
+		const uint8_t *ptr, size_t nr_elem)
+{
+	struct lttng_msgpack_writer writer;
+	size_t i, len;
+
+	lttng_msgpack_writer_init(&writer, buf, BUFFER_SIZE);
+	lttng_msgpack_begin_array(&writer, nr_elem);
+	for (i = 0; i < nr_elem; i++) {
+		if (layout->is_signed)
+			lttng_msgpack_write_signed_integer(&writer,
+				load_element(ptr, layout));
+		else
+			lttng_msgpack_write_unsigned_integer(&writer,
+				(uint64_t) load_element(ptr, layout));
+		ptr += layout->size;
+	}
+	lttng_msgpack_end_array(&writer);
+	len = writer.write_pos - writer.buffer;
+	lttng_msgpack_writer_fini(&writer);
+	return len;
+}
+
+static
+size_t encode_sequence(uint8_t *buf,
+		const struct lttng_msgpack_integer_layout *layout,
+		const uint8_t *ptr, size_t nr_elem)
+{
+	struct lttng_msgpack_writer writer;
+	size_t len;
+
+	lttng_msgpack_writer_init(&writer, buf, BUFFER_SIZE);
+	lttng_msgpack_write_integer_sequence(&writer, layout, ptr, nr_elem);
+	len = writer.write_pos - writer.buffer;
+	lttng_msgpack_writer_fini(&writer);
+	return len;
+}
+
+/*
+ * Returns the time per sequence in ns, or -1 if the two encodings
+ * differ.
+ */
+static
+double run(const struct lttng_msgpack_integer_layout *layout,
+		const uint8_t *values, size_t nr_elem, unsigned long iterations,
+		int per_element)
+{
+	uint8_t buf[BUFFER_SIZE], expected[BUFFER_SIZE];
+	size_t len, expected_len;
+	uint64_t start, duration;
+	unsigned long i;
+
+	expected_len = encode_per_element(expected, layout, values, nr_elem);
+	start = now_ns();
+	for (i = 0; i < iterations; i++) {
+		if (per_element)
+			len = encode_per_element(buf, layout, values, nr_elem);
+		else
+			len = encode_sequence(buf, layout, values, nr_elem);
+		/* Keep the encoding from being optimized away. */
+		__asm__ __volatile__ ("" : : "r" (buf) : "memory");
+	}
+	duration = now_ns() - start;
+	if (len != expected_len || memcmp(buf, expected, len))
+		return -1;
+	return (double) duration / iterations;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 1000000;
+	size_t nr_elem = argc > 2 ? strtoul(argv[2], NULL, 10) : 64;
+	unsigned int size, reverse;
+	uint8_t *values;
+	size_t i;
+
+	if (!iterations)
+		iterations = 1;
+	/* Keep the worst-case encoding within the capture buffer. */
+	if (nr_elem > (BUFFER_SIZE - 3) / 9) {
+		fprintf(stderr, "At most %d elements per sequence\n",
+			(BUFFER_SIZE - 3) / 9);
+		return EXIT_FAILURE;
+	}
+	values = malloc(nr_elem * sizeof(uint64_t));
+	if (!values)
+		return EXIT_FAILURE;
+	/* Values spread over all the msgpack integer encodings. */
+	srand(42);
+	for (i = 0; i < nr_elem * sizeof(uint64_t); i++)
+		values[i] = (uint8_t) (rand() >> (i % 8));
+
+	printf("%lu iterations, %zu elements per sequence\n",
+		iterations, nr_elem);
+	printf("size  swapped  per element (ns/seq)  sequence (ns/seq)\n");
+	for (size = 1; size <= 8; size *= 2) {
+		for (reverse = 0; reverse <= (size > 1); reverse++) {
+			struct lttng_msgpack_integer_layout layout = {
+				.size = size,
+				.is_signed = 1,
+				.reverse_byte_order = reverse,
+			};
+
+			printf("%2u    %7s  %20.2f  %17.2f\n", size * 8,
+				reverse ? "yes" : "no",
+				run(&layout, values, nr_elem, iterations, 1),
+				run(&layout, values, nr_elem, iterations, 0));
+		}
+	}
+	free(values);
+	return EXIT_SUCCESS;
+}
@@ -29,7 +29,7 @@
 #include "../../libmsgpack/msgpack.h"
 
 #define BUFFER_SIZE 4096
-#define NUM_TESTS 23
+#define NUM_TESTS 27
 
 
 /*
@@ -160,6 +160,24 @@ static const uint8_t COMPLETE_CAPTURE_EXPECTED[] = { 0x95, 0xa8, 0x6d, 0x65,
 		0x2c, 0x64, 0xdd, 0x2f, 0x1a, 0x9f, 0xbe, 0x92, 0xcd, 0x07,
 		0xbc, 0xcd, 0x07, 0xcb };
 
+/*
+ * [1, -1, -33, 200, -129] as signed integers: unlike json2msgpack, 200
+ * is encoded as an int16 rather than an uint8.
+ */
+static const uint8_t INT_SEQUENCE_EXPECTED[] = { 0x95, 0x01, 0xff, 0xd0,
+		0xdf, 0xd1, 0x00, 0xc8, 0xd1, 0xff, 0x7f };
+
+/*
+ * echo '[1980, 1995, 65535]' | json2msgpack | xxd -i
+ */
+static const uint8_t UINT_SEQUENCE_EXPECTED[] = { 0x93, 0xcd, 0x07, 0xbc,
+		0xcd, 0x07, 0xcb, 0xcd, 0xff, 0xff };
+
+/*
+ * echo '"bye"' | json2msgpack | xxd -i
+ */
+static const uint8_t STRING_BYE_LEN_EXPECTED[] = { 0xa3, 0x62, 0x79, 0x65 };
+
 static void string_test(uint8_t *buf, const char *value)
 {
 	struct lttng_msgpack_writer writer;
@@ -260,6 +278,51 @@ static void complete_capture_test(uint8_t *buf)
 	lttng_msgpack_writer_fini(&writer);
 }
 
+static void int_sequence_test(uint8_t *buf, size_t size)
+{
+	static const int16_t values[] = { 1, -1, -33, 200, -129 };
+	struct lttng_msgpack_integer_layout layout = {
+		.size = sizeof(values[0]),
+		.is_signed = 1,
+		.reverse_byte_order = 0,
+	};
+	struct lttng_msgpack_writer writer;
+
+	/* A buffer too small for the worst case takes the checked path. */
+	lttng_msgpack_writer_init(&writer, buf, size);
+	lttng_msgpack_write_integer_sequence(&writer, &layout, values, 5);
+	lttng_msgpack_writer_fini(&writer);
+}
+
+static void uint_sequence_reversed_test(uint8_t *buf)
+{
+	/* 1980, 1995 and 65535 in the reverse of the host byte order. */
+	uint32_t values[] = { 1980, 1995, 65535 };
+	struct lttng_msgpack_integer_layout layout = {
+		.size = sizeof(values[0]),
+		.is_signed = 0,
+		.reverse_byte_order = 1,
+	};
+	struct lttng_msgpack_writer writer;
+	int i;
+
+	for (i = 0; i < 3; i++)
+		values[i] = __builtin_bswap32(values[i]);
+
+	lttng_msgpack_writer_init(&writer, buf, BUFFER_SIZE);
+	lttng_msgpack_write_integer_sequence(&writer, &layout, values, 3);
+	lttng_msgpack_writer_fini(&writer);
+}
+
+static void string_len_test(uint8_t *buf)
+{
+	struct lttng_msgpack_writer writer;
+
+	lttng_msgpack_writer_init(&writer, buf, BUFFER_SIZE);
+	lttng_msgpack_write_str_len(&writer, "byebye", 3);
+	lttng_msgpack_writer_fini(&writer);
+}
+
 static void nil_test(uint8_t *buf)
 {
 	struct lttng_msgpack_writer writer;
@@ -382,5 +445,22 @@ int main(int argc, char *argv[])
 	ok(memcmp(buf, COMPLETE_CAPTURE_EXPECTED, sizeof(COMPLETE_CAPTURE_EXPECTED)) == 0,
 		"Complete capture object");
 
+	int_sequence_test(buf, BUFFER_SIZE);
+	ok(memcmp(buf, INT_SEQUENCE_EXPECTED, sizeof(INT_SEQUENCE_EXPECTED)) == 0,
+		"Signed integer sequence object");
+
+	memset(buf, 0, sizeof(INT_SEQUENCE_EXPECTED));
+	int_sequence_test(buf, sizeof(INT_SEQUENCE_EXPECTED));
+	ok(memcmp(buf, INT_SEQUENCE_EXPECTED, sizeof(INT_SEQUENCE_EXPECTED)) == 0,
+		"Signed integer sequence object in an exact-size buffer");
+
+	uint_sequence_reversed_test(buf);
+	ok(memcmp(buf, UINT_SEQUENCE_EXPECTED, sizeof(UINT_SEQUENCE_EXPECTED)) == 0,
+		"Byte-swapped unsigned integer sequence object");
+
+	string_len_test(buf);
+	ok(memcmp(buf, STRING_BYE_LEN_EXPECTED, sizeof(STRING_BYE_LEN_EXPECTED)) == 0,
+		"String of known length object");
+
 	return EXIT_SUCCESS;
 }
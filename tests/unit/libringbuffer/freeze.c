@@ -0,0 +1,132 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ *
+ * freeze.c
+ *
+ * Unit tests of the freeze ids of the trigger freezes of a channel.
+ */
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Built with the consumer control code, which creates the channel and
+ * gives access to the ring buffer channel behind it.
+ */
+#include "liblttng-ust-ctl/ustctl.c"
+
+#include "tap.h"
+
+#define SHM_PATH	"/ust-freeze-test"
+#define SUBBUF_SIZE	4096
+#define NUM_SUBBUF	2
+
+static
+struct ustctl_consumer_channel *create_channel(void)
+{
+	struct ustctl_consumer_channel_attr attr = {
+		.type = LTTNG_UST_CHAN_METADATA,
+		.subbuf_size = SUBBUF_SIZE,
+		.num_subbuf = NUM_SUBBUF,
+		.output = LTTNG_UST_MMAP,
+	};
+	struct ustctl_consumer_channel *chan;
+	int shmfd;
+
+	shmfd = shm_open(SHM_PATH, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+	if (shmfd < 0)
+		return NULL;
+	(void) shm_unlink(SHM_PATH);
+	chan = ustctl_create_channel(&attr, &shmfd, 1);
+	if (!chan)
+		(void) close(shmfd);
+	return chan;
+}
+
+/* Whether a record can be written in the channel. */
+static
+bool records(struct ustctl_consumer_channel *chan)
+{
+	return ustctl_write_one_packet_to_channel(chan, "x", 1) == 1;
+}
+
+static
+void freeze(struct ustctl_consumer_channel *chan, unsigned int freeze_id)
+{
+	lib_ring_buffer_channel_trigger(chan->chan->chan, chan->chan->handle,
+		RING_BUFFER_TRIGGER_FREEZE, freeze_id);
+}
+
+static
+void reset(struct ustctl_consumer_channel *chan, unsigned int freeze_id)
+{
+	lib_ring_buffer_channel_trigger_reset(chan->chan->chan,
+		chan->chan->handle, RING_BUFFER_TRIGGER_FREEZE, freeze_id);
+}
+
+static
+void test_reset(struct ustctl_consumer_channel *chan)
+{
+	ok(records(chan), "A channel which is not frozen records");
+
+	freeze(chan, 3);
+	ok(!records(chan), "A frozen channel discards records");
+
+	freeze(chan, 7);
+	reset(chan, 3);
+	ok(!records(chan),
+		"A channel stays frozen until the reset of all its freeze ids");
+
+	reset(chan, 7);
+	ok(records(chan), "Resetting the last freeze id resumes recording");
+
+	freeze(chan, 5);
+	freeze(chan, 5);
+	reset(chan, 5);
+	ok(records(chan), "A freeze id freezes a channel only once");
+
+	lib_ring_buffer_channel_trigger(chan->chan->chan, chan->chan->handle,
+		RING_BUFFER_TRIGGER_SWITCH, 9);
+	ok(records(chan), "Triggers which do not freeze keep recording");
+	reset(chan, 9);
+}
+
+static
+void test_thaw(struct ustctl_consumer_channel *chan)
+{
+	freeze(chan, 0);
+	freeze(chan, RING_BUFFER_TRIGGER_FREEZE_ID_MAX - 1);
+	ok(ustctl_channel_thaw(chan, 1U << 0) == 0 && !records(chan),
+		"Thawing some freeze ids keeps the others");
+	ok(ustctl_channel_thaw(chan,
+			1U << (RING_BUFFER_TRIGGER_FREEZE_ID_MAX - 1)) == 0
+		&& records(chan),
+		"Thawing the last freeze id resumes recording");
+
+	freeze(chan, 2);
+	freeze(chan, 4);
+	ok(ustctl_channel_thaw(chan, UINT32_MAX) == 0 && records(chan),
+		"The consumer thaws all the freeze ids of a channel at once");
+
+	ok(ustctl_channel_thaw(NULL, UINT32_MAX) == -EINVAL,
+		"Thawing requires a channel");
+}
+
+int main(void)
+{
+	struct ustctl_consumer_channel *chan;
+
+	plan_tests(10);
+
+	chan = create_channel();
+	if (!chan) {
+		diag("Cannot create a channel");
+		return exit_status();
+	}
+	test_reset(chan);
+	test_thaw(chan);
+	ustctl_destroy_channel(chan);
+
+	return exit_status();
+}
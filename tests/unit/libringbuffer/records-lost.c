@@ -0,0 +1,372 @@
+/* SPDX-License-Identifier: GPL-2.0-only
+ *
+ * records-lost.c
+ *
+ * Unit tests of the per-event drop counter of channels, against the
+ * lost record counters of the ring buffers.
+ */
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdint.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Built with the consumer control code, which creates the channels and
+ * the drop counter, and gives access to the client of the channels.
+ */
+#include "liblttng-ust-ctl/ustctl.c"
+
+#include "tap.h"
+
+#define SHM_PATH	"/ust-records-lost-test"
+#define SUBBUF_SIZE	4096
+#define NUM_SUBBUF	2
+#define RECORD_LEN	100
+/* Fill the buffers at most twice over. */
+#define MAX_RECORDS	(2 * NUM_SUBBUF * SUBBUF_SIZE / RECORD_LEN)
+#define NR_EVENT_IDS	8
+
+enum records_lost {
+	RECORDS_LOST_FULL,
+	RECORDS_LOST_WRAP,
+	RECORDS_LOST_BIG,
+};
+
+static char payload[RECORD_LEN];
+static struct lttng_stack_ctx stack_ctx;
+
+static
+int create_shm(void)
+{
+	int fd;
+
+	fd = shm_open(SHM_PATH, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+	if (fd >= 0)
+		(void) shm_unlink(SHM_PATH);
+	return fd;
+}
+
+static
+void close_fds(int *fds, int nr_fds)
+{
+	int i;
+
+	for (i = 0; i < nr_fds; i++) {
+		if (fds[i] >= 0)
+			(void) close(fds[i]);
+	}
+}
+
+static
+struct ustctl_consumer_channel *create_channel(int overwrite)
+{
+	struct ustctl_consumer_channel_attr attr = {
+		.type = LTTNG_UST_CHAN_PER_CPU,
+		.subbuf_size = SUBBUF_SIZE,
+		.num_subbuf = NUM_SUBBUF,
+		.overwrite = overwrite,
+		.output = LTTNG_UST_MMAP,
+	};
+	struct ustctl_consumer_channel *chan;
+	int nr_fds = ustctl_get_nr_stream_per_channel(), *fds, i;
+
+	fds = calloc(nr_fds, sizeof(*fds));
+	if (!fds)
+		return NULL;
+	for (i = 0; i < nr_fds; i++)
+		fds[i] = create_shm();
+	chan = ustctl_create_channel(&attr, fds, nr_fds);
+	if (chan) {
+		/* Set by the application from the metadata otherwise. */
+		chan->chan->header_type = 1;	/* compact */
+	} else {
+		close_fds(fds, nr_fds);
+	}
+	free(fds);
+	return chan;
+}
+
+static
+struct ustctl_daemon_counter *create_drop_counter(void)
+{
+	struct ustctl_counter_dimension dimension = {
+		.size = NR_EVENT_IDS,
+	};
+	struct ustctl_daemon_counter *counter;
+	int nr_fds = ustctl_get_nr_cpu_per_counter(), *fds, i;
+
+	fds = calloc(nr_fds, sizeof(*fds));
+	if (!fds)
+		return NULL;
+	for (i = 0; i < nr_fds; i++)
+		fds[i] = create_shm();
+	counter = ustctl_create_counter(1, &dimension, 0, -1, nr_fds, fds,
+			USTCTL_COUNTER_BITNESS_32,
+			USTCTL_COUNTER_ARITHMETIC_MODULAR,
+			USTCTL_COUNTER_ALLOC_PER_CPU);
+	close_fds(fds, nr_fds);
+	free(fds);
+	return counter;
+}
+
+/*
+ * The application maps the shared memory of the counter of the session
+ * daemon. Both are in this process, so share the counter itself.
+ */
+static
+void attach_drop_counter(struct ustctl_consumer_channel *chan,
+		struct ustctl_daemon_counter *daemon_counter,
+		struct lttng_counter *counter)
+{
+	counter->counter = daemon_counter->counter;
+	counter->ops = (struct lttng_counter_ops *) daemon_counter->ops;
+	chan->chan->drop_counter_len = NR_EVENT_IDS;
+	chan->chan->drop_counter = counter;
+}
+
+static
+int reserve(struct ustctl_consumer_channel *chan,
+		struct lttng_ust_lib_ring_buffer_ctx *ctx,
+		uint32_t event_id, size_t len)
+{
+	lib_ring_buffer_ctx_init(ctx, chan->chan->chan, NULL, len,
+		sizeof(char), -1, chan->chan->handle, &stack_ctx);
+	return chan->chan->ops->event_reserve(ctx, event_id);
+}
+
+static
+void commit(struct ustctl_consumer_channel *chan,
+		struct lttng_ust_lib_ring_buffer_ctx *ctx, size_t len)
+{
+	chan->chan->ops->event_write(ctx, payload, len);
+	chan->chan->ops->event_commit(ctx);
+}
+
+static
+int write_record(struct ustctl_consumer_channel *chan, uint32_t event_id,
+		size_t len)
+{
+	struct lttng_ust_lib_ring_buffer_ctx ctx;
+	int ret;
+
+	ret = reserve(chan, &ctx, event_id, len);
+	if (!ret)
+		commit(chan, &ctx, len);
+	return ret;
+}
+
+/* Write records until one is lost, returning the error. */
+static
+int write_until_lost(struct ustctl_consumer_channel *chan, uint32_t event_id)
+{
+	int ret = 0, i;
+
+	for (i = 0; !ret && i < MAX_RECORDS; i++)
+		ret = write_record(chan, event_id, RECORD_LEN);
+	return ret;
+}
+
+/* Write n records which are all lost with the error `expected`. */
+static
+bool write_lost(struct ustctl_consumer_channel *chan, uint32_t event_id,
+		size_t len, unsigned int n, int expected)
+{
+	bool lost = true;
+
+	while (n--)
+		lost &= write_record(chan, event_id, len) == expected;
+	return lost;
+}
+
+/* Sum of a lost record counter over the buffers of the channel. */
+static
+unsigned long records_lost(struct ustctl_consumer_channel *consumer_chan,
+		enum records_lost type)
+{
+	struct channel *chan = consumer_chan->chan->chan;
+	const struct lttng_ust_lib_ring_buffer_config *config =
+		&chan->backend.config;
+	unsigned long sum = 0;
+	int cpu;
+
+	for_each_channel_cpu(cpu, chan) {
+		struct lttng_ust_lib_ring_buffer *buf =
+			shmp(chan->handle, chan->backend.buf[cpu].shmp);
+
+		if (!buf)
+			continue;
+		switch (type) {
+		case RECORDS_LOST_FULL:
+			sum += lib_ring_buffer_get_records_lost_full(config, buf);
+			break;
+		case RECORDS_LOST_WRAP:
+			sum += lib_ring_buffer_get_records_lost_wrap(config, buf);
+			break;
+		case RECORDS_LOST_BIG:
+			sum += lib_ring_buffer_get_records_lost_big(config, buf);
+			break;
+		}
+	}
+	return sum;
+}
+
+/*
+ * Check the drop counts of the event IDs, and that they sum up to the
+ * lost record counter of the channel.
+ */
+static
+bool check_drops(struct ustctl_daemon_counter *counter,
+		const int64_t *expected, unsigned long nr_lost)
+{
+	int64_t sum = 0;
+	size_t i;
+
+	for (i = 0; i < NR_EVENT_IDS; i++) {
+		bool overflow, underflow;
+		int64_t value;
+
+		if (ustctl_counter_aggregate(counter, &i, &value, &overflow,
+				&underflow) || value != expected[i])
+			return false;
+		sum += value;
+	}
+	return sum == (int64_t) nr_lost;
+}
+
+struct drop_test {
+	struct ustctl_consumer_channel *chan;
+	struct ustctl_daemon_counter *daemon_counter;
+	struct lttng_counter counter;
+};
+
+static
+bool drop_test_init(struct drop_test *test, int overwrite)
+{
+	test->chan = create_channel(overwrite);
+	if (!test->chan)
+		goto error;
+	test->daemon_counter = create_drop_counter();
+	if (!test->daemon_counter)
+		goto error_counter;
+	attach_drop_counter(test->chan, test->daemon_counter, &test->counter);
+	return true;
+
+error_counter:
+	ustctl_destroy_channel(test->chan);
+error:
+	fail("Create a channel with a drop counter");
+	return false;
+}
+
+static
+void drop_test_fini(struct drop_test *test)
+{
+	test->chan->chan->drop_counter = NULL;
+	ustctl_destroy_channel(test->chan);
+	ustctl_destroy_counter(test->daemon_counter);
+}
+
+static
+void test_full(void)
+{
+	const int64_t expected[NR_EVENT_IDS] = { 1, 3, 5 };
+	struct drop_test test;
+	bool lost;
+
+	if (!drop_test_init(&test, 0))
+		return;
+	lost = write_until_lost(test.chan, 0) == -ENOBUFS;
+	lost &= write_lost(test.chan, 1, RECORD_LEN, 3, -ENOBUFS);
+	lost &= write_lost(test.chan, 2, RECORD_LEN, 5, -ENOBUFS);
+	ok(lost && check_drops(test.daemon_counter, expected,
+			records_lost(test.chan, RECORDS_LOST_FULL))
+		&& !records_lost(test.chan, RECORDS_LOST_WRAP)
+		&& !records_lost(test.chan, RECORDS_LOST_BIG),
+		"Drop counts match the records lost in full buffers");
+
+	/* Frozen: the records are discarded, but not lost. */
+	lib_ring_buffer_channel_trigger(test.chan->chan->chan,
+		test.chan->chan->handle, RING_BUFFER_TRIGGER_FREEZE, 0);
+	lost = write_lost(test.chan, 3, RECORD_LEN, 2, -EAGAIN);
+	ok(lost && check_drops(test.daemon_counter, expected,
+			records_lost(test.chan, RECORDS_LOST_FULL)),
+		"Records discarded by a frozen channel are not counted");
+	drop_test_fini(&test);
+}
+
+static
+void test_big(void)
+{
+	const int64_t expected[NR_EVENT_IDS] = { [4] = 2 };
+	struct drop_test test;
+	bool lost;
+
+	if (!drop_test_init(&test, 0))
+		return;
+	lost = write_lost(test.chan, 4, SUBBUF_SIZE, 2, -ENOSPC);
+	lost &= write_record(test.chan, 5, RECORD_LEN) == 0;
+	ok(lost && check_drops(test.daemon_counter, expected,
+			records_lost(test.chan, RECORDS_LOST_BIG))
+		&& !records_lost(test.chan, RECORDS_LOST_FULL),
+		"Drop counts match the records lost for being too big");
+	drop_test_fini(&test);
+}
+
+static
+void test_wrap(void)
+{
+	const int64_t expected[NR_EVENT_IDS] = { [6] = 1, [7] = 2 };
+	struct lttng_ust_lib_ring_buffer_ctx ctx;
+	struct drop_test test;
+	bool lost;
+
+	if (!drop_test_init(&test, 1))
+		return;
+	/*
+	 * Writers wrapping around the buffer while this record is not
+	 * committed cannot switch to its sub-buffer.
+	 */
+	if (reserve(test.chan, &ctx, 5, RECORD_LEN)) {
+		fail("Reserve a record");
+		drop_test_fini(&test);
+		return;
+	}
+	lost = write_until_lost(test.chan, 6) == -EIO;
+	lost &= write_lost(test.chan, 7, RECORD_LEN, 2, -EIO);
+	commit(test.chan, &ctx, RECORD_LEN);
+	ok(lost && check_drops(test.daemon_counter, expected,
+			records_lost(test.chan, RECORDS_LOST_WRAP))
+		&& !records_lost(test.chan, RECORDS_LOST_FULL),
+		"Drop counts match the records lost in nested wrap-arounds");
+	drop_test_fini(&test);
+}
+
+/* Keep the records of a test in the buffer of a single CPU. */
+static
+void pin_cpu(void)
+{
+	cpu_set_t set;
+	int cpu;
+
+	cpu = sched_getcpu();
+	if (cpu < 0)
+		return;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	if (sched_setaffinity(0, sizeof(set), &set))
+		diag("Cannot pin the test to a CPU");
+}
+
+int main(void)
+{
+	plan_tests(4);
+
+	pin_cpu();
+	test_full();
+	test_big();
+	test_wrap();
+
+	return exit_status();
+}
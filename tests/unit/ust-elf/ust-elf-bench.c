@@ -0,0 +1,91 @@
+/* SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * ust-elf-bench.c
+ *
+ * Measure the time taken by the ELF parser to extract the information
+ * needed by the base address statedump (memsz, build ID, debug link,
+ * PIC) from a corpus of ELF files, e.g.:
+ *
+ *   ./ust-elf-bench 100 /usr/lib/x86_64-linux-gnu/lib*.so*
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <lttng/ust-elf.h>
+
+static
+uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Returns 0 on success, -1 if the file cannot be parsed. */
+static
+int parse_elf(const char *path)
+{
+	struct lttng_ust_elf *elf;
+	uint64_t memsz;
+	uint8_t *build_id = NULL;
+	size_t build_id_len;
+	char *dbg_file = NULL;
+	uint32_t crc;
+	int found, ret = -1;
+
+	elf = lttng_ust_elf_create(path);
+	if (!elf)
+		return -1;
+	if (lttng_ust_elf_get_memsz(elf, &memsz))
+		goto end;
+	if (lttng_ust_elf_get_build_id(elf, &build_id, &build_id_len, &found))
+		goto end;
+	if (lttng_ust_elf_get_debug_link(elf, &dbg_file, &crc, &found))
+		goto end;
+	(void) lttng_ust_elf_is_pic(elf);
+	ret = 0;
+end:
+	free(build_id);
+	free(dbg_file);
+	lttng_ust_elf_destroy(elf);
+	return ret;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long iterations, i;
+	uint64_t total_ns = 0;
+	int nr_files = 0, f;
+
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s <iterations> <elf file>...\n",
+			argv[0]);
+		return EXIT_FAILURE;
+	}
+	iterations = strtoul(argv[1], NULL, 10);
+	if (!iterations)
+		iterations = 1;
+
+	for (f = 2; f < argc; f++) {
+		uint64_t start, duration;
+
+		/* Skip files which are not ELF, and warm the page cache. */
+		if (parse_elf(argv[f]))
+			continue;
+		start = now_ns();
+		for (i = 0; i < iterations; i++)
+			(void) parse_elf(argv[f]);
+		duration = now_ns() - start;
+		printf("%10.2f us  %s\n",
+			(double) duration / iterations / 1000.0, argv[f]);
+		total_ns += duration;
+		nr_files++;
+	}
+	printf("%d files, %.2f us per statedump of the whole corpus\n",
+		nr_files, (double) total_ns / iterations / 1000.0);
+	return EXIT_SUCCESS;
+}
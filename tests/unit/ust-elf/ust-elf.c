@@ -21,14 +21,21 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
 #include <lttng/ust-elf.h>
 #include "tap.h"
 
 #define NUM_ARCH 4
-#define NUM_TESTS_PER_ARCH 11
+#define NUM_TESTS_PER_ARCH 13
 #define NUM_TESTS_PIC 3
-#define NUM_TESTS (NUM_ARCH * NUM_TESTS_PER_ARCH) + NUM_TESTS_PIC + 1
+#define NUM_TESTS_CORRUPT 2
+#define NUM_TESTS (NUM_ARCH * NUM_TESTS_PER_ARCH) + NUM_TESTS_PIC + \
+	NUM_TESTS_CORRUPT + 1
+
+/* Offsets of e_phoff and e_shoff in the ELF64 file header. */
+#define ELF64_PHOFF_OFFSET 32
+#define ELF64_SHOFF_OFFSET 40
 
 /*
  * Expected memsz were computed using libelf, build ID and debug link
@@ -44,6 +51,16 @@
 #define ARMEB_CRC 0x9d40261b
 #define AARCH64_BE_CRC 0x2b8cedce
 
+#define X86_MAIN_ADDR 0x080483cb
+#define X86_64_MAIN_ADDR 0x4004b6
+#define ARMEB_MAIN_ADDR 0x83dc
+#define AARCH64_BE_MAIN_ADDR 0x400548
+
+#define X86_MAIN_SIZE 13
+#define X86_64_MAIN_SIZE 11
+#define ARMEB_MAIN_SIZE 32
+#define AARCH64_BE_MAIN_SIZE 16
+
 #define BUILD_ID_LEN 20
 #define DBG_FILE "main.elf.debug"
 
@@ -64,9 +81,32 @@ static const uint8_t aarch64_be_build_id[BUILD_ID_LEN] = {
 	0xfa, 0x27, 0x2e, 0xa9, 0x2f, 0xd2, 0xe4, 0xf7, 0xb6, 0x60
 };
 
+struct find_symbol_data {
+	const char *name;
+	uint64_t addr;
+	uint64_t size;
+	int found;
+};
+
+static
+int find_symbol_cb(const char *name, uint64_t addr, uint64_t size,
+		void *priv)
+{
+	struct find_symbol_data *data = priv;
+
+	if (strcmp(name, data->name)) {
+		return 0;
+	}
+	data->addr = addr;
+	data->size = size;
+	data->found = 1;
+	return 1;
+}
+
 static
 void test_elf(const char *test_dir, const char *arch, uint64_t exp_memsz,
-		const uint8_t *exp_build_id, uint32_t exp_crc)
+		const uint8_t *exp_build_id, uint32_t exp_crc,
+		uint64_t exp_main_addr, uint64_t exp_main_size)
 {
 	char path[PATH_MAX];
 	struct lttng_ust_elf *elf = NULL;
@@ -78,6 +118,7 @@ void test_elf(const char *test_dir, const char *arch, uint64_t exp_memsz,
 	int has_debug_link = 0;
 	char *dbg_file = NULL;
 	uint32_t crc = 0;
+	struct find_symbol_data main_sym = { .name = "main" };
 
 	diag("Testing %s support", arch);
 
@@ -112,6 +153,14 @@ void test_elf(const char *test_dir, const char *arch, uint64_t exp_memsz,
 		"debug link crc - expected: %#x, got: %#x",
 		exp_crc, crc);
 
+	ret = lttng_ust_elf_for_each_func_symbol(elf, find_symbol_cb,
+					&main_sym);
+	ok(ret == 0 && main_sym.found,
+		"lttng_ust_elf_for_each_func_symbol found main");
+	ok(main_sym.addr == exp_main_addr && main_sym.size == exp_main_size,
+		"main symbol - expected: %#lx/%lu, got: %#lx/%lu",
+		exp_main_addr, exp_main_size, main_sym.addr, main_sym.size);
+
 	free(build_id);
 	free(dbg_file);
 	lttng_ust_elf_destroy(elf);
@@ -146,6 +195,86 @@ void test_pic(const char *test_dir)
 	lttng_ust_elf_destroy(elf);
 }
 
+/*
+ * Copy the x86_64 test file into `path`, with the 64-bit header field
+ * at `field_offset` replaced by `value`, in native byte order.
+ */
+static
+int write_corrupt_elf(const char *test_dir, char *path, long field_offset,
+		uint64_t value)
+{
+	char src_path[PATH_MAX];
+	char buf[4096];
+	FILE *src, *dst = NULL;
+	size_t len;
+	int fd, ret = -1;
+
+	snprintf(src_path, PATH_MAX, "%s/data/x86_64/main.elf", test_dir);
+	src = fopen(src_path, "r");
+	if (!src) {
+		return -1;
+	}
+	fd = mkstemp(path);
+	if (fd < 0) {
+		goto end;
+	}
+	dst = fdopen(fd, "w");
+	if (!dst) {
+		close(fd);
+		goto end;
+	}
+	while ((len = fread(buf, 1, sizeof(buf), src)) > 0) {
+		if (fwrite(buf, 1, len, dst) != len) {
+			goto end;
+		}
+	}
+	if (fseek(dst, field_offset, SEEK_SET)
+			|| fwrite(&value, sizeof(value), 1, dst) != 1) {
+		goto end;
+	}
+	ret = 0;
+end:
+	if (dst && fclose(dst)) {
+		ret = -1;
+	}
+	fclose(src);
+	return ret;
+}
+
+/*
+ * Header table offsets close to UINT64_MAX make the offset of their
+ * entries wrap around to within the file.
+ */
+static
+void test_corrupt(const char *test_dir)
+{
+	char path[] = "/tmp/lttng-ust-elf-XXXXXX";
+	struct lttng_ust_elf *elf;
+	uint64_t memsz;
+
+	if (write_corrupt_elf(test_dir, path, ELF64_SHOFF_OFFSET,
+			UINT64_MAX - 15)) {
+		fail("Create corrupt ELF file");
+	} else {
+		elf = lttng_ust_elf_create(path);
+		ok(elf == NULL, "Wrapping section header offset is rejected");
+		lttng_ust_elf_destroy(elf);
+		(void) unlink(path);
+	}
+
+	strcpy(path, "/tmp/lttng-ust-elf-XXXXXX");
+	if (write_corrupt_elf(test_dir, path, ELF64_PHOFF_OFFSET,
+			UINT64_MAX - 15)) {
+		fail("Create corrupt ELF file");
+	} else {
+		elf = lttng_ust_elf_create(path);
+		ok(!elf || lttng_ust_elf_get_memsz(elf, &memsz),
+			"Wrapping program header offset is rejected");
+		lttng_ust_elf_destroy(elf);
+		(void) unlink(path);
+	}
+}
+
 int main(int argc, char **argv)
 {
 	const char *test_dir;
@@ -159,12 +288,16 @@ int main(int argc, char **argv)
 		test_dir = argv[1];
 	}
 
-	test_elf(test_dir, "x86", X86_MEMSZ, x86_build_id, X86_CRC);
-	test_elf(test_dir, "x86_64", X86_64_MEMSZ, x86_64_build_id, X86_64_CRC);
-	test_elf(test_dir, "armeb", ARMEB_MEMSZ, armeb_build_id, ARMEB_CRC);
+	test_elf(test_dir, "x86", X86_MEMSZ, x86_build_id, X86_CRC,
+		X86_MAIN_ADDR, X86_MAIN_SIZE);
+	test_elf(test_dir, "x86_64", X86_64_MEMSZ, x86_64_build_id, X86_64_CRC,
+		X86_64_MAIN_ADDR, X86_64_MAIN_SIZE);
+	test_elf(test_dir, "armeb", ARMEB_MEMSZ, armeb_build_id, ARMEB_CRC,
+		ARMEB_MAIN_ADDR, ARMEB_MAIN_SIZE);
 	test_elf(test_dir, "aarch64_be", AARCH64_BE_MEMSZ, aarch64_be_build_id,
-		AARCH64_BE_CRC);
+		AARCH64_BE_CRC, AARCH64_BE_MAIN_ADDR, AARCH64_BE_MAIN_SIZE);
 	test_pic(test_dir);
+	test_corrupt(test_dir);
 
 	return exit_status();
 }
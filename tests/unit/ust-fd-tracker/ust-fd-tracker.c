@@ -0,0 +1,122 @@
+/* SPDX-License-Identifier: LGPL-2.1-only
+ *
+ * ust-fd-tracker.c
+ *
+ * Stress the lock-free path of application close() against lttng-ust
+ * threads adding and removing file descriptors from the fd tracker.
+ * Application closes of their own file descriptors must succeed, closes
+ * of the file descriptors owned by lttng-ust must fail with EBADF, and
+ * the lttng-ust threads waiting for the application closers must make
+ * progress.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <urcu/uatomic.h>
+#include <ust-fd.h>
+
+#include "tap.h"
+
+#define NR_APP_THREADS		4
+#define NR_UST_THREADS		2
+#define NR_APP_LOOPS		100000
+#define NR_UST_FDS		4
+
+static int ust_fds[NR_UST_FDS];
+static int app_done;
+static unsigned long nr_app_failures, nr_app_ust_closes, nr_ust_loops;
+
+static
+void *app_thread(void *arg)
+{
+	unsigned long i, failures = 0, ust_closes = 0;
+
+	for (i = 0; i < NR_APP_LOOPS; i++) {
+		int fd;
+
+		fd = open("/dev/null", O_RDONLY);
+		if (fd < 0 || lttng_ust_safe_close_fd(fd, close))
+			failures++;
+		if (!lttng_ust_safe_close_fd(ust_fds[i % NR_UST_FDS], close)
+				|| errno != EBADF)
+			ust_closes++;
+	}
+	uatomic_add(&nr_app_failures, failures);
+	uatomic_add(&nr_app_ust_closes, ust_closes);
+	return NULL;
+}
+
+static
+void *ust_thread(void *arg)
+{
+	unsigned long loops = 0;
+
+	while (!uatomic_read(&app_done)) {
+		int fd;
+
+		lttng_ust_lock_fd_tracker();
+		fd = open("/dev/null", O_RDONLY);
+		if (fd >= 0)
+			fd = lttng_ust_add_fd_to_tracker(fd);
+		lttng_ust_unlock_fd_tracker();
+		if (fd < 0)
+			break;
+		lttng_ust_lock_fd_tracker();
+		lttng_ust_delete_fd_from_tracker(fd);
+		(void) close(fd);
+		lttng_ust_unlock_fd_tracker();
+		loops++;
+	}
+	uatomic_add(&nr_ust_loops, loops);
+	return NULL;
+}
+
+int main(void)
+{
+	pthread_t app_tids[NR_APP_THREADS], ust_tids[NR_UST_THREADS];
+	int i, nr_open = 0;
+
+	plan_tests(4);
+
+	lttng_ust_lock_fd_tracker();
+	for (i = 0; i < NR_UST_FDS; i++) {
+		int fd;
+
+		fd = open("/dev/null", O_RDONLY);
+		if (fd >= 0)
+			fd = lttng_ust_add_fd_to_tracker(fd);
+		ust_fds[i] = fd;
+	}
+	lttng_ust_unlock_fd_tracker();
+
+	for (i = 0; i < NR_UST_THREADS; i++)
+		pthread_create(&ust_tids[i], NULL, ust_thread, NULL);
+	for (i = 0; i < NR_APP_THREADS; i++)
+		pthread_create(&app_tids[i], NULL, app_thread, NULL);
+	for (i = 0; i < NR_APP_THREADS; i++)
+		pthread_join(app_tids[i], NULL);
+	uatomic_set(&app_done, 1);
+	for (i = 0; i < NR_UST_THREADS; i++)
+		pthread_join(ust_tids[i], NULL);
+
+	ok(nr_app_failures == 0,
+		"Application closes of their own fds succeed (%lu failures)",
+		nr_app_failures);
+	ok(nr_app_ust_closes == 0,
+		"Application closes of lttng-ust fds fail with EBADF (%lu closed)",
+		nr_app_ust_closes);
+	ok(nr_ust_loops > 0,
+		"lttng-ust threads add and remove fds concurrently (%lu loops)",
+		nr_ust_loops);
+	for (i = 0; i < NR_UST_FDS; i++) {
+		if (ust_fds[i] >= 0 && fcntl(ust_fds[i], F_GETFD) >= 0)
+			nr_open++;
+	}
+	ok(nr_open == NR_UST_FDS, "lttng-ust fds are still open");
+
+	return EXIT_SUCCESS;
+}